@@ -1,12 +1,30 @@
-from ndb.commands import (StValues, OArrCmd, IArrCmd,
-                          SortedIArrCmd, StringArrCmd, SortedStrArrCmd)
+from ndb.commands import (StValues, OArrCmd, IArrCmd, FArrCmd,
+                          SortedIArrCmd, StringArrCmd, SortedStrArrCmd, SortedFArrCmd)
 from ndb.client import NdbClient
 from ndb.common import raise_if, raise_if_empty, raise_if_equal, raise_if_lt
 from typing import List
 from abc import ABC, abstractmethod
 
 
+async def _setOperation(client: NdbClient, cmdReq: str, cmdRsp: str, srcs, dest: str, body = None) -> List | int:
+  "Returns the items, or with dest, the number of items stored in dest"
+  if body is None:
+    raise_if_lt(len(srcs), 2, 'Requires at least two arrays')
+    for src in srcs:
+      raise_if_empty(src)
+    body = {'srcs':list(srcs)}
+
+  if dest is not None:
+    raise_if_empty(dest)
+    body['dest'] = dest
+
+  rsp = await client.sendCmd(cmdReq, cmdRsp, body)
+  return rsp[cmdRsp]['items'] if dest is None else rsp[cmdRsp]['used']
+
+
 class _Arrays(ABC):
+  # valid for create(), string arrays also have 'arena'
+  layouts = ('vector', 'paged')
 
   def __init__(self, client: NdbClient):
     self.client = client
@@ -18,10 +36,16 @@ class _Arrays(ABC):
     return
 
 
-  async def create(self, name: str, capacity: int) -> None:
+  async def create(self, name: str, capacity: int, layout: str = 'vector', growable = False) -> None:
+    """ layout is one of layouts. Paged allocates memory as values are set, for large sparse arrays.
+    A growable array's capacity increases as values are set, so capacity can be 0 """
     raise_if_empty(name)
-    raise_if(capacity, 'must be > 0', lambda v: v <= 0)
-    await self.client.sendCmd(self.cmds.CREATE_REQ, self.cmds.CREATE_RSP, {'name':name, 'len':capacity})
+    raise_if(capacity, 'must be > 0' if not growable else 'must be >= 0', lambda v: v < 0 or (v == 0 and not growable))
+    raise_if(layout, f'not one of {self.layouts}', lambda v: v not in self.layouts)
+    args = {'name':name, 'len':capacity, 'layout':layout}
+    if growable:
+      args['growable'] = True
+    await self.client.sendCmd(self.cmds.CREATE_REQ, self.cmds.CREATE_RSP, args)
 
 
   async def delete(self, name: str) -> None:
@@ -43,6 +67,21 @@ class _Arrays(ABC):
     raise_if_empty(name)
     rsp = await self.client.sendCmd(self.cmds.USED_REQ, self.cmds.USED_RSP, {'name':name})
     return rsp[self.cmds.USED_RSP]['used']
+
+
+  async def reserve(self, name: str, capacity: int) -> int:
+    "Increases the capacity to at least 'capacity', returns the capacity"
+    raise_if_empty(name)
+    raise_if_lt(capacity, 0, 'capacity < 0')
+    rsp = await self.client.sendCmd(self.cmds.RESERVE_REQ, self.cmds.RESERVE_RSP, {'name':name, 'len':capacity})
+    return rsp[self.cmds.RESERVE_RSP]['len']
+
+
+  async def shrink(self, name: str) -> int:
+    "Reduces the capacity to the values held, returns the capacity"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.SHRINK_REQ, self.cmds.SHRINK_RSP, {'name':name})
+    return rsp[self.cmds.SHRINK_RSP]['len']
   
 
   async def swap(self, name: str, posA: int, posB: int) -> None:
@@ -139,7 +178,59 @@ class ObjArrays(_Arrays):
 
 #region IArray
 
-class IntArrays(_Arrays):
+class _AggregateArrays(_Arrays):
+  "Unsorted arrays of numbers, with aggregates over a range of positions"
+
+  def __init__(self, client: NdbClient):
+    super().__init__(client)
+
+
+  async def sum(self, name: str, start = 0, stop = None) -> int | float:
+    "Sum of positions [start, stop). For int arrays, a sum beyond 64-bit is returned as a float"
+    rsp = await self._aggregate(self.cmds.SUM_REQ, self.cmds.SUM_RSP, name, start, stop)
+    return rsp['sum']
+
+
+  async def avg(self, name: str, start = 0, stop = None) -> float:
+    "Mean of positions [start, stop)"
+    rsp = await self._aggregate(self.cmds.AVG_REQ, self.cmds.AVG_RSP, name, start, stop)
+    return rsp['avg']
+
+
+  async def min(self, name: str, start = 0, stop = None) -> tuple:
+    "The minimum in positions [start, stop) and the position of its first occurrence, as (item, pos)"
+    rsp = await self._aggregate(self.cmds.MIN_REQ, self.cmds.MIN_RSP, name, start, stop)
+    return (rsp['item'], rsp['pos'])
+
+
+  async def max(self, name: str, start = 0, stop = None) -> tuple:
+    "The maximum in positions [start, stop) and the position of its first occurrence, as (item, pos)"
+    rsp = await self._aggregate(self.cmds.MAX_REQ, self.cmds.MAX_RSP, name, start, stop)
+    return (rsp['item'], rsp['pos'])
+
+
+  async def _aggregate(self, reqName: str, rspName: str, name: str | None, start: int, stop, body = None) -> dict:
+    "name is None for commands on two arrays, which are in body"
+    if name is not None:
+      raise_if_empty(name)
+
+    if stop is None:
+      rng = [start]
+    elif start >= stop:
+      raise ValueError('start >= stop')
+    else:
+      rng = [start, stop]
+
+    body = {} if body is None else body
+    body['rng'] = rng
+    if name is not None:
+      body['name'] = name
+
+    rsp = await self.client.sendCmd(reqName, rspName, body)
+    return rsp[rspName]
+
+
+class IntArrays(_AggregateArrays):
   def __init__(self, client: NdbClient):
     super().__init__(client)
 
@@ -180,12 +271,140 @@ class IntArrays(_Arrays):
         
     rsp = await self.client.sendCmd(reqName, rspName, {'name':name, 'rng':rng})
     return rsp[rspName]['items']
+
+
+  async def count_eq(self, name: str, item: int, start = 0, stop = None) -> int:
+    "Number of items equal to item in positions [start, stop)"
+    rsp = await self._aggregate(self.cmds.COUNT_EQ_REQ, self.cmds.COUNT_EQ_RSP, name, start, stop, {'item':item})
+    return rsp['count']
+
+
+  async def histogram(self, name: str, min: int, max: int, buckets: int, start = 0, stop = None) -> dict:
+    """Counts of items in positions [start, stop), in buckets of equal width over [min, max].
+    Returns a dict with 'counts', 'width', and 'below' and 'above', the number of items outside [min, max]"""
+    raise_if_lt(buckets, 1, 'buckets must be > 0')
+    raise_if_lt(max, min, 'max < min')
+    rsp = await self._aggregate(self.cmds.HISTOGRAM_REQ, self.cmds.HISTOGRAM_RSP, name, start, stop, {'min':min, 'max':max, 'buckets':buckets})
+    return {'counts':rsp['counts'], 'width':rsp['width'], 'below':rsp['below'], 'above':rsp['above']}
+
+
+  async def sort(self, name: str, desc = False) -> None:
+    "Sorts the items in positions [0, used)"
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.SORT_REQ, self.cmds.SORT_RSP, {'name':name, 'desc':desc})
+
+
+  async def unique(self, name: str) -> int:
+    "Removes repeated items in positions [0, used), keeping the first of each. Returns used"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.UNIQUE_REQ, self.cmds.UNIQUE_RSP, {'name':name})
+    return rsp[self.cmds.UNIQUE_RSP]['used']
+
+
+  async def to_sorted(self, name: str, dest: str, unique = False) -> int:
+    "Stores the items in positions [0, used), sorted, as the sorted array dest, replacing it if it exists. Returns the number of items stored"
+    raise_if_empty(name)
+    raise_if_empty(dest)
+    rsp = await self.client.sendCmd(self.cmds.TO_SORTED_REQ, self.cmds.TO_SORTED_RSP, {'name':name, 'dest':dest, 'unique':unique})
+    return rsp[self.cmds.TO_SORTED_RSP]['used']
+
+
+#endregion
+
+
+#region FArray
+
+class FloatArrays(_AggregateArrays):
+  def __init__(self, client: NdbClient):
+    super().__init__(client)
+
+
+  # override of base class 
+  def getCommandNames(self) -> FArrCmd:
+    return FArrCmd()
   
+
+  async def set(self, name: str, item: float, pos = None) -> None:
+    raise_if_empty(name)
+    await self._doUnsortedSet(name, item, pos)    
+
+
+  async def set_rng(self, name: str, items: List[float], pos = None) -> None:
+    raise_if_empty(name)
+    await self._doSetRng(name, items, pos)
+
+
+  async def get(self, name: str, pos: int) -> float:
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.GET_REQ, self.cmds.GET_RSP, {'name':name, 'pos':pos})
+    return rsp[self.cmds.GET_RSP]['item']
+
+
+  async def get_rng(self, name: str, start: int, stop = None) -> List[float]:
+    raise_if_empty(name)
+
+    reqName = self.cmds.GET_RNG_REQ
+    rspName = self.cmds.GET_RNG_RSP
+
+    if stop == None:
+      rng = [start]
+    elif start > stop:
+      raise ValueError('start > stop')
+    else:
+      rng = [start, stop]
+        
+    rsp = await self.client.sendCmd(reqName, rspName, {'name':name, 'rng':rng})
+    return rsp[rspName]['items']
+
+
+  async def dot(self, arrA: str, arrB: str, start = 0, stop = None) -> float:
+    "Dot product of positions [start, stop) of both arrays, with stop limited to the smaller capacity"
+    raise_if_empty(arrA)
+    raise_if_empty(arrB)
+    rsp = await self._aggregate(self.cmds.DOT_REQ, self.cmds.DOT_RSP, None, start, stop, {'srcA':arrA, 'srcB':arrB})
+    return rsp['dot']
+
+
+  async def add(self, name: str, value: float = None, src: str = None, start = 0, stop = None) -> None:
+    "Adds value, or the item at the same position in src, to each item in positions [start, stop)"
+    await self._elementwise(self.cmds.ADD_REQ, self.cmds.ADD_RSP, name, value, src, start, stop)
+
+
+  async def sub(self, name: str, value: float = None, src: str = None, start = 0, stop = None) -> None:
+    "Subtracts value, or the item at the same position in src, from each item in positions [start, stop)"
+    await self._elementwise(self.cmds.SUB_REQ, self.cmds.SUB_RSP, name, value, src, start, stop)
+
+
+  async def mul(self, name: str, value: float = None, src: str = None, start = 0, stop = None) -> None:
+    "Multiplies each item in positions [start, stop) by value, or by the item at the same position in src"
+    await self._elementwise(self.cmds.MUL_REQ, self.cmds.MUL_RSP, name, value, src, start, stop)
+
+
+  async def div(self, name: str, value: float = None, src: str = None, start = 0, stop = None) -> None:
+    "Divides each item in positions [start, stop) by value, or by the item at the same position in src. Division by zero fails"
+    await self._elementwise(self.cmds.DIV_REQ, self.cmds.DIV_RSP, name, value, src, start, stop)
+
+
+  async def _elementwise(self, reqName: str, rspName: str, name: str, value, src: str, start: int, stop) -> None:
+    raise_if_empty(name)
+
+    if (value is None) == (src is None):
+      raise ValueError('Requires one of value or src')
+    elif src is not None:
+      raise_if_empty(src)
+      body = {'src':src}
+    else:
+      body = {'value':value}
+
+    await self._aggregate(reqName, rspName, name, start, stop, body)
+
 #endregion
 
 
 #region StrArray
 class StringArrays(_Arrays):
+  layouts = ('vector', 'paged', 'arena')
+
   def __init__(self, client: NdbClient):
     super().__init__(client)
 
@@ -226,6 +445,27 @@ class StringArrays(_Arrays):
         
     rsp = await self.client.sendCmd(reqName, rspName, {'name':name, 'rng':rng})
     return rsp[rspName]['items']
+
+
+  async def sort(self, name: str, desc = False) -> None:
+    "Sorts the items in positions [0, used)"
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.SORT_REQ, self.cmds.SORT_RSP, {'name':name, 'desc':desc})
+
+
+  async def unique(self, name: str) -> int:
+    "Removes repeated items in positions [0, used), keeping the first of each. Returns used"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.UNIQUE_REQ, self.cmds.UNIQUE_RSP, {'name':name})
+    return rsp[self.cmds.UNIQUE_RSP]['used']
+
+
+  async def to_sorted(self, name: str, dest: str, unique = False) -> int:
+    "Stores the items in positions [0, used), sorted, as the sorted array dest, replacing it if it exists. Returns the number of items stored"
+    raise_if_empty(name)
+    raise_if_empty(dest)
+    rsp = await self.client.sendCmd(self.cmds.TO_SORTED_REQ, self.cmds.TO_SORTED_RSP, {'name':name, 'dest':dest, 'unique':unique})
+    return rsp[self.cmds.TO_SORTED_RSP]['used']
 #endregion
 
 
@@ -234,10 +474,17 @@ class StringArrays(_Arrays):
 #
 
 class SortedArray(_Arrays):
+  layouts = ('vector', 'blocked')
+
   def __init__(self, client: NdbClient):
     super().__init__(client)
 
 
+  async def create(self, name: str, capacity: int, layout: str = 'vector', growable = False) -> None:
+    "layout is one of layouts. Blocked has faster inserts into large arrays."
+    await super().create(name, capacity, layout, growable)
+
+
   async def min(self, name: str, n = 1) -> List[int] | List[str]:
     raise_if_empty(name)
     raise_if_lt(n, 1, 'n must be > 0')
@@ -252,6 +499,41 @@ class SortedArray(_Arrays):
     return rsp[self.cmds.MAX_RSP]['items']
 
 
+  async def lower_bound(self, name: str, item: int | str) -> int:
+    "Position of the first item not less than item, which is also the number of items less than item (its rank)"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.LOWER_BOUND_REQ, self.cmds.LOWER_BOUND_RSP, {'name':name, 'item':item})
+    return rsp[self.cmds.LOWER_BOUND_RSP]['pos']
+
+
+  async def upper_bound(self, name: str, item: int | str) -> int:
+    "Position of the first item greater than item"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.UPPER_BOUND_REQ, self.cmds.UPPER_BOUND_RSP, {'name':name, 'item':item})
+    return rsp[self.cmds.UPPER_BOUND_RSP]['pos']
+
+
+  async def count_rng(self, name: str, min: int | str, max: int | str) -> int:
+    "Number of items in [min, max]"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.COUNT_RNG_REQ, self.cmds.COUNT_RNG_RSP, {'name':name, 'min':min, 'max':max})
+    return rsp[self.cmds.COUNT_RNG_RSP]['count']
+
+
+  async def find_rng(self, name: str, min: int | str, max: int | str) -> List[int] | List[str]:
+    "Items in [min, max]"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.FIND_RNG_REQ, self.cmds.FIND_RNG_RSP, {'name':name, 'min':min, 'max':max})
+    return rsp[self.cmds.FIND_RNG_RSP]['items']
+
+
+  async def contains(self, name: str, items: List[int] | List[str]) -> List[bool]:
+    "For each item, True if it is in the array"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.CONTAINS_REQ, self.cmds.CONTAINS_RSP, {'name':name, 'items':items})
+    return rsp[self.cmds.CONTAINS_RSP]['contains']
+
+
 #region Sorted IArray
 
 class SortedIntArrays(SortedArray):
@@ -269,9 +551,10 @@ class SortedIntArrays(SortedArray):
     await self.client.sendCmd(self.cmds.SET_REQ, self.cmds.SET_RSP, {'name':name, 'item':item})
 
 
-  async def set_rng(self, name: str, items: List[int]) -> None:
+  async def set_rng(self, name: str, items: List[int], sorted = False) -> None:
+    "sorted: the items are already sorted, the server checks rather than sorts"
     raise_if_empty(name)
-    await self.client.sendCmd(self.cmds.SET_RNG_REQ, self.cmds.SET_RNG_RSP, {'name':name, 'items':items})
+    await self.client.sendCmd(self.cmds.SET_RNG_REQ, self.cmds.SET_RNG_RSP, {'name':name, 'items':items, 'sorted':sorted})
 
 
   async def get(self, name: str, pos: int) -> int:
@@ -297,12 +580,22 @@ class SortedIntArrays(SortedArray):
     return rsp[rspName]['items']
   
 
-  async def intersect(self, arrA: str, arrB: str) -> List[int]:
+  async def intersect(self, arrA: str, arrB: str, *others: str, dest: str = None) -> List[int] | int:
     raise_if_empty(arrA)
     raise_if_empty(arrB)
-    raise_if_equal(arrA, arrB, 'Intersect on the same arrays')
-    rsp = await self.client.sendCmd(self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, {'srcA':arrA, 'srcB':arrB})
-    return rsp[self.cmds.INTERSECT_RSP]['items']
+    if others:
+      return await _setOperation(self.client, self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, (arrA, arrB) + others, dest)
+    else:
+      raise_if_equal(arrA, arrB, 'Intersect on the same arrays')
+      return await _setOperation(self.client, self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, None, dest, {'srcA':arrA, 'srcB':arrB})
+
+
+  async def union(self, *srcs: str, dest: str = None) -> List[int] | int:
+    return await _setOperation(self.client, self.cmds.UNION_REQ, self.cmds.UNION_RSP, srcs, dest)
+
+
+  async def diff(self, *srcs: str, dest: str = None) -> List[int] | int:
+    return await _setOperation(self.client, self.cmds.DIFF_REQ, self.cmds.DIFF_RSP, srcs, dest)
   
 
   async def swap(self, name: str, posA: int, posB: int) -> int:
@@ -313,7 +606,9 @@ class SortedIntArrays(SortedArray):
 
 #region Sorted SArray
 
-class SortedStrArrays(_Arrays):
+class SortedStrArrays(SortedArray):
+  layouts = ('vector', 'blocked', 'arena', 'frontcoded')
+
   def __init__(self, client: NdbClient):
     super().__init__(client)
 
@@ -321,16 +616,17 @@ class SortedStrArrays(_Arrays):
   # override of base class 
   def getCommandNames(self) -> SortedStrArrCmd:
     return SortedStrArrCmd()
-  
+
 
   async def set(self, name: str, item: str) -> None:
     raise_if_empty(name)
     await self.client.sendCmd(self.cmds.SET_REQ, self.cmds.SET_RSP, {'name':name, 'item':item})
 
 
-  async def set_rng(self, name: str, items: List[str]) -> None:
+  async def set_rng(self, name: str, items: List[str], sorted = False) -> None:
+    "sorted: the items are already sorted, the server checks rather than sorts"
     raise_if_empty(name)
-    await self.client.sendCmd(self.cmds.SET_RNG_REQ, self.cmds.SET_RNG_RSP, {'name':name, 'items':items})
+    await self.client.sendCmd(self.cmds.SET_RNG_REQ, self.cmds.SET_RNG_RSP, {'name':name, 'items':items, 'sorted':sorted})
 
 
   async def get(self, name: str, pos: int) -> str:
@@ -354,17 +650,117 @@ class SortedStrArrays(_Arrays):
         
     rsp = await self.client.sendCmd(reqName, rspName, {'name':name, 'rng':rng})
     return rsp[rspName]['items']
+
+
+  async def prefix(self, name: str, prefix: str, n: int = None) -> List[str]:
+    "Items beginning with prefix, the first n if n is set"
+    raise_if_empty(name)
+    body = {'name':name, 'prefix':prefix}
+
+    if n is not None:
+      raise_if_lt(n, 0, 'n must be >= 0')
+      body['n'] = n
+
+    rsp = await self.client.sendCmd(self.cmds.PREFIX_REQ, self.cmds.PREFIX_RSP, body)
+    return rsp[self.cmds.PREFIX_RSP]['items']
+
+
+  async def count_prefix(self, name: str, prefix: str) -> int:
+    "Number of items beginning with prefix"
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.PREFIX_REQ, self.cmds.PREFIX_RSP, {'name':name, 'prefix':prefix, 'n':0})
+    return rsp[self.cmds.PREFIX_RSP]['count']
   
 
-  async def intersect(self, arrA: str, arrB: str) -> List[str]:
+  async def intersect(self, arrA: str, arrB: str, *others: str, dest: str = None) -> List[str] | int:
     raise_if_empty(arrA)
     raise_if_empty(arrB)
-    raise_if_equal(arrA, arrB, 'Intersect on the same arrays')
-    rsp = await self.client.sendCmd(self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, {'srcA':arrA, 'srcB':arrB})
-    return rsp[self.cmds.INTERSECT_RSP]['items']
+    if others:
+      return await _setOperation(self.client, self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, (arrA, arrB) + others, dest)
+    else:
+      raise_if_equal(arrA, arrB, 'Intersect on the same arrays')
+      return await _setOperation(self.client, self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, None, dest, {'srcA':arrA, 'srcB':arrB})
+
+
+  async def union(self, *srcs: str, dest: str = None) -> List[str] | int:
+    return await _setOperation(self.client, self.cmds.UNION_REQ, self.cmds.UNION_RSP, srcs, dest)
+
+
+  async def diff(self, *srcs: str, dest: str = None) -> List[str] | int:
+    return await _setOperation(self.client, self.cmds.DIFF_REQ, self.cmds.DIFF_RSP, srcs, dest)
   
 
   async def swap(self, name: str, posA: int, posB: int) -> int:
     raise NotImplementedError('Swap not permitted on sorted array')
 
-#endregion
\ No newline at end of file
+#endregion
+
+
+#region Sorted FArray
+
+class SortedFloatArrays(SortedArray):
+  def __init__(self, client: NdbClient):
+    super().__init__(client)
+
+
+  # override of base class 
+  def getCommandNames(self) -> SortedFArrCmd:
+    return SortedFArrCmd()
+  
+
+  async def set(self, name: str, item: float) -> None:
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.SET_REQ, self.cmds.SET_RSP, {'name':name, 'item':item})
+
+
+  async def set_rng(self, name: str, items: List[float], sorted = False) -> None:
+    "sorted: the items are already sorted, the server checks rather than sorts"
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.SET_RNG_REQ, self.cmds.SET_RNG_RSP, {'name':name, 'items':items, 'sorted':sorted})
+
+
+  async def get(self, name: str, pos: int) -> float:
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.GET_REQ, self.cmds.GET_RSP, {'name':name, 'pos':pos})
+    return rsp[self.cmds.GET_RSP]['item']
+
+
+  async def get_rng(self, name: str, start: int, stop = None) -> List[float]:
+    raise_if_empty(name)
+
+    reqName = self.cmds.GET_RNG_REQ
+    rspName = self.cmds.GET_RNG_RSP
+
+    if stop == None:
+      rng = [start]
+    elif start > stop:
+      raise ValueError('start > stop')
+    else:
+      rng = [start, stop]
+        
+    rsp = await self.client.sendCmd(reqName, rspName, {'name':name, 'rng':rng})
+    return rsp[rspName]['items']
+  
+
+  async def intersect(self, arrA: str, arrB: str, *others: str, dest: str = None) -> List[float] | int:
+    raise_if_empty(arrA)
+    raise_if_empty(arrB)
+    if others:
+      return await _setOperation(self.client, self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, (arrA, arrB) + others, dest)
+    else:
+      raise_if_equal(arrA, arrB, 'Intersect on the same arrays')
+      return await _setOperation(self.client, self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, None, dest, {'srcA':arrA, 'srcB':arrB})
+
+
+  async def union(self, *srcs: str, dest: str = None) -> List[float] | int:
+    return await _setOperation(self.client, self.cmds.UNION_REQ, self.cmds.UNION_RSP, srcs, dest)
+
+
+  async def diff(self, *srcs: str, dest: str = None) -> List[float] | int:
+    return await _setOperation(self.client, self.cmds.DIFF_REQ, self.cmds.DIFF_RSP, srcs, dest)
+  
+
+  async def swap(self, name: str, posA: int, posB: int) -> int:
+    raise NotImplementedError('Swap not permitted on sorted array')
+
+#endregion
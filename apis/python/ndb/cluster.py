@@ -0,0 +1,104 @@
+from ndb.commands import (StValues, KvCmds)
+from ndb.client import NdbClient
+from ndb.common import ResponseError
+from ndb.sv import SV
+from typing import Any
+
+
+SLOT_COUNT = 16384
+
+
+def _crc16(data: bytes) -> int:
+  "CRC16-CCITT (XMODEM), as the server"
+  crc = 0
+  for b in data:
+    crc ^= b << 8
+    for _ in range(8):
+      crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+      crc &= 0xFFFF
+  return crc
+
+
+def key_slot(key: str) -> int:
+  "The key's hash slot. If the key has a non-empty {tag}, only the tag is hashed."
+  open = key.find('{')
+  if open != -1:
+    close = key.find('}', open + 1)
+    if close > open + 1:
+      key = key[open+1:close]
+  return _crc16(key.encode()) % SLOT_COUNT
+
+
+class ClusterKV:
+  """
+  Key Value for a cluster. Requests are sent to the node which owns each key's slot,
+  following redirects when slots move. Each request is for one key.
+  """
+
+  def __init__(self):
+    self.cmds = KvCmds()
+    self.clients = {}   # by node address
+    self.slots = [None] * SLOT_COUNT
+
+
+  async def open(self, node: str) -> None:
+    "node is any node's 'ip:port'"
+    await self.refresh(node)
+
+
+  async def close(self) -> None:
+    for client in self.clients.values():
+      await client.close()
+    self.clients.clear()
+
+
+  async def refresh(self, node: str) -> None:
+    "Reads the slot map from node"
+    slots = await SV(await self._client(node)).cluster_slots()
+    for rng in slots['slots']:
+      for slot in range(rng['start'], rng['end'] + 1):
+        self.slots[slot] = rng['node']
+
+
+  async def set(self, key: str, value: Any) -> None:
+    await self._send(key, self.cmds.SET_REQ, self.cmds.SET_RSP, {'keys':{key:value}})
+
+
+  async def get(self, key: str) -> Any:
+    rsp = await self._send(key, self.cmds.GET_REQ, self.cmds.GET_RSP, {'keys':[key]})
+    return rsp[self.cmds.GET_RSP]['keys'].get(key)
+
+
+  async def rmv(self, key: str) -> None:
+    await self._send(key, self.cmds.RMV_REQ, self.cmds.RMV_RSP, {'keys':[key]})
+
+
+  async def _client(self, node: str) -> NdbClient:
+    if node not in self.clients:
+      client = NdbClient()
+      await client.open(f'ws://{node}')
+      self.clients[node] = client
+    return self.clients[node]
+
+
+  async def _send(self, key: str, cmdReq: str, cmdRsp: str, body: dict, maxRedirects = 5):
+    node = self.slots[key_slot(key)]
+
+    for _ in range(maxRedirects):
+      client = await self._client(node)
+      rsp = await client.sendCmd(cmdReq, cmdRsp, body, checkStatus=False)
+      st = rsp[cmdRsp]['st']
+
+      if st == StValues.ST_MOVED:
+        # the slot has a new owner
+        node = rsp[cmdRsp]['node']
+        self.slots[rsp[cmdRsp]['slot']] = node
+      elif st == StValues.ST_ASK:
+        # the slot is migrating, only this request is redirected
+        node = rsp[cmdRsp]['node']
+      elif st != StValues.ST_SUCCESS:
+        raise ResponseError(rsp[cmdRsp])
+      else:
+        return rsp
+
+    raise ResponseError(rsp[cmdRsp])
@@ -5,12 +5,18 @@ class StValues:
     ST_SUCCESS        - Command success
     ST_SAVE_COMPLETE  - KV_SAVE success, data persisted
     ST_SAVE_ERROR     - KV_SAVE fail
+    ST_SAVE_STARTED   - KV_SAVE background save started
     ST_LOAD_COMPLETE  - KV_LOAD success, data available
+    ST_MOVED          - Cluster: the key's slot is owned by another node
+    ST_ASK            - Cluster: the key's slot is migrating, send this request to another node
   """
   ST_SUCCESS = 1
   ST_SAVE_COMPLETE = 120
   ST_SAVE_ERROR = 123
+  ST_SAVE_STARTED = 125
   ST_LOAD_COMPLETE = 141
+  ST_MOVED = 171
+  ST_ASK = 172
 
 
 class Fields:
@@ -20,6 +26,12 @@ class Fields:
 class SvCmds:
   INFO_REQ    = 'SV_INFO'
   INFO_RSP    = 'SV_INFO_RSP'
+  CLUSTER_SLOTS_REQ   = 'SV_CLUSTER_SLOTS'
+  CLUSTER_SLOTS_RSP   = 'SV_CLUSTER_SLOTS_RSP'
+  CLUSTER_MIGRATE_REQ = 'SV_CLUSTER_MIGRATE'
+  CLUSTER_MIGRATE_RSP = 'SV_CLUSTER_MIGRATE_RSP'
+  CLUSTER_SETSLOT_REQ = 'SV_CLUSTER_SETSLOT'
+  CLUSTER_SETSLOT_RSP = 'SV_CLUSTER_SETSLOT_RSP'
 
 
 class KvCmds:
@@ -43,6 +55,8 @@ class KvCmds:
   KEYS_RSP      = 'KV_KEYS_RSP'
   SAVE_REQ      = "KV_SAVE"
   SAVE_RSP      = "KV_SAVE_RSP"
+  SAVE_STATUS_REQ = "KV_SAVE_STATUS"
+  SAVE_STATUS_RSP = "KV_SAVE_STATUS_RSP"
   LOAD_REQ      = "KV_LOAD"
   LOAD_RSP      = "KV_LOAD_RSP"
 
@@ -62,6 +76,8 @@ class CommonArrCmds:
     self.USED_REQ, self.USED_RSP              = self.make(ident, "USED")    
     self.EXIST_REQ, self.EXIST_RSP            = self.make(ident, "EXIST")
     self.CLEAR_REQ, self.CLEAR_RSP            = self.make(ident, "CLEAR")
+    self.RESERVE_REQ, self.RESERVE_RSP        = self.make(ident, "RESERVE")
+    self.SHRINK_REQ, self.SHRINK_RSP          = self.make(ident, "SHRINK")
 
 
   def make(self, ident: str, cmd: str):
@@ -79,8 +95,15 @@ class SortedArrCmds(CommonArrCmds):
   def __init__(self, ident):
     super().__init__(ident)
     self.INTERSECT_REQ, self.INTERSECT_RSP = self.make(ident, "INTERSECT")
+    self.UNION_REQ, self.UNION_RSP = self.make(ident, "UNION")
+    self.DIFF_REQ, self.DIFF_RSP = self.make(ident, "DIFF")
     self.MIN_REQ, self.MIN_RSP = self.make(ident, "MIN")
     self.MAX_REQ, self.MAX_RSP = self.make(ident, "MAX")
+    self.LOWER_BOUND_REQ, self.LOWER_BOUND_RSP = self.make(ident, "LOWER_BOUND")
+    self.UPPER_BOUND_REQ, self.UPPER_BOUND_RSP = self.make(ident, "UPPER_BOUND")
+    self.COUNT_RNG_REQ, self.COUNT_RNG_RSP = self.make(ident, "COUNT_RNG")
+    self.FIND_RNG_REQ, self.FIND_RNG_RSP = self.make(ident, "FIND_RNG")
+    self.CONTAINS_REQ, self.CONTAINS_RSP = self.make(ident, "CONTAINS")
 
 
 
@@ -89,14 +112,41 @@ class OArrCmd(UnsortedArrCmds):
     super().__init__('OARR')
     
 
-class IArrCmd(UnsortedArrCmds):
+class AggregateArrCmds(UnsortedArrCmds):
+  def __init__(self, ident):
+    super().__init__(ident)
+    self.SUM_REQ, self.SUM_RSP = self.make(ident, "SUM")
+    self.AVG_REQ, self.AVG_RSP = self.make(ident, "AVG")
+    self.MIN_REQ, self.MIN_RSP = self.make(ident, "MIN")
+    self.MAX_REQ, self.MAX_RSP = self.make(ident, "MAX")
+
+
+class IArrCmd(AggregateArrCmds):
   def __init__(self):
     super().__init__('IARR')
+    self.COUNT_EQ_REQ, self.COUNT_EQ_RSP = self.make('IARR', "COUNT_EQ")
+    self.HISTOGRAM_REQ, self.HISTOGRAM_RSP = self.make('IARR', "HISTOGRAM")
+    self.SORT_REQ, self.SORT_RSP = self.make('IARR', "SORT")
+    self.UNIQUE_REQ, self.UNIQUE_RSP = self.make('IARR', "UNIQUE")
+    self.TO_SORTED_REQ, self.TO_SORTED_RSP = self.make('IARR', "TO_SORTED")
+
+
+class FArrCmd(AggregateArrCmds):
+  def __init__(self):
+    super().__init__('FARR')
+    self.DOT_REQ, self.DOT_RSP = self.make('FARR', "DOT")
+    self.ADD_REQ, self.ADD_RSP = self.make('FARR', "ADD")
+    self.SUB_REQ, self.SUB_RSP = self.make('FARR', "SUB")
+    self.MUL_REQ, self.MUL_RSP = self.make('FARR', "MUL")
+    self.DIV_REQ, self.DIV_RSP = self.make('FARR', "DIV")
   
 
 class StringArrCmd(UnsortedArrCmds):
   def __init__(self):
     super().__init__('STRARR')
+    self.SORT_REQ, self.SORT_RSP = self.make('STRARR', "SORT")
+    self.UNIQUE_REQ, self.UNIQUE_RSP = self.make('STRARR', "UNIQUE")
+    self.TO_SORTED_REQ, self.TO_SORTED_RSP = self.make('STRARR', "TO_SORTED")
   
 
 class SortedIArrCmd(SortedArrCmds):
@@ -107,6 +157,12 @@ class SortedIArrCmd(SortedArrCmds):
 class SortedStrArrCmd(SortedArrCmds):
   def __init__(self):
     super().__init__('SSTRARR')
+    self.PREFIX_REQ, self.PREFIX_RSP = self.make('SSTRARR', "PREFIX")
+
+
+class SortedFArrCmd(SortedArrCmds):
+  def __init__(self):
+    super().__init__('SFARR')
 
 #endregion
 
@@ -138,4 +194,52 @@ class ObjListCmds(CommonListCmds):
 
 
 
-#endregion
\ No newline at end of file
+#endregion
+
+#region Vectors
+class VecCmds:
+  def __init__(self, ident: str = 'VEC'):
+    self.CREATE_REQ, self.CREATE_RSP          = self.make(ident, "CREATE")
+    self.DELETE_REQ, self.DELETE_RSP          = self.make(ident, "DELETE")
+    self.DELETE_ALL_REQ, self.DELETE_ALL_RSP  = self.make(ident, "DELETE_ALL")
+    self.EXIST_REQ, self.EXIST_RSP            = self.make(ident, "EXIST")
+    self.ADD_REQ, self.ADD_RSP                = self.make(ident, "ADD")
+    self.GET_REQ, self.GET_RSP                = self.make(ident, "GET")
+    self.LEN_REQ, self.LEN_RSP                = self.make(ident, "LEN")
+    self.CLEAR_REQ, self.CLEAR_RSP            = self.make(ident, "CLEAR")
+    self.SEARCH_REQ, self.SEARCH_RSP          = self.make(ident, "SEARCH")
+
+
+  def make(self, ident: str, cmd: str):
+    req = ident+'_'+cmd
+    return (req, req+'_RSP')
+
+#endregion
+
+
+#region Integer Sets
+class IntSetCmds:
+  def __init__(self, ident: str = 'ISET'):
+    self.CREATE_REQ, self.CREATE_RSP          = self.make(ident, "CREATE")
+    self.DELETE_REQ, self.DELETE_RSP          = self.make(ident, "DELETE")
+    self.DELETE_ALL_REQ, self.DELETE_ALL_RSP  = self.make(ident, "DELETE_ALL")
+    self.EXIST_REQ, self.EXIST_RSP            = self.make(ident, "EXIST")
+    self.ADD_REQ, self.ADD_RSP                = self.make(ident, "ADD")
+    self.RMV_REQ, self.RMV_RSP                = self.make(ident, "RMV")
+    self.CONTAINS_REQ, self.CONTAINS_RSP      = self.make(ident, "CONTAINS")
+    self.LEN_REQ, self.LEN_RSP                = self.make(ident, "LEN")
+    self.RANK_REQ, self.RANK_RSP              = self.make(ident, "RANK")
+    self.SELECT_REQ, self.SELECT_RSP          = self.make(ident, "SELECT")
+    self.GET_RNG_REQ, self.GET_RNG_RSP        = self.make(ident, "GET_RNG")
+    self.CLEAR_REQ, self.CLEAR_RSP            = self.make(ident, "CLEAR")
+    self.INTERSECT_REQ, self.INTERSECT_RSP    = self.make(ident, "INTERSECT")
+    self.UNION_REQ, self.UNION_RSP            = self.make(ident, "UNION")
+    self.XOR_REQ, self.XOR_RSP                = self.make(ident, "XOR")
+    self.DIFF_REQ, self.DIFF_RSP              = self.make(ident, "DIFF")
+
+
+  def make(self, ident: str, cmd: str):
+    req = ident+'_'+cmd
+    return (req, req+'_RSP')
+
+#endregion
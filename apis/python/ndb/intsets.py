@@ -0,0 +1,136 @@
+from ndb.commands import (StValues, Fields, IntSetCmds)
+from ndb.client import NdbClient
+from ndb.common import raise_if_empty, raise_if_lt, raise_if_not
+from typing import List
+
+
+class IntSets:
+  """ Sets of unsigned 64-bit integers, stored compressed as roaring bitmaps.
+
+  Values are kept in ascending order, so a value's position is its rank.
+  """
+  def __init__(self, client: NdbClient):
+    self.client = client
+    self.cmds = IntSetCmds()
+
+
+  async def create(self, name: str) -> None:
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.CREATE_REQ, self.cmds.CREATE_RSP, {'name':name})
+
+
+  async def delete(self, name: str) -> None:
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.DELETE_REQ, self.cmds.DELETE_RSP, {'name':name})
+
+
+  async def delete_all(self) -> None:
+    await self.client.sendCmd(self.cmds.DELETE_ALL_REQ, self.cmds.DELETE_ALL_RSP, {})
+
+
+  async def exist(self, name: str) -> bool:
+    raise_if_empty(name)
+    # don't check status: EXIST response has 'st' success if set exists or NotExist otherwise (so not an error)
+    rsp = await self.client.sendCmd(self.cmds.EXIST_REQ, self.cmds.EXIST_RSP, {'name':name}, checkStatus=False)
+    return rsp[self.cmds.EXIST_RSP][Fields.STATUS] == StValues.ST_SUCCESS
+
+
+  async def add(self, name: str, items: List[int] | int) -> int:
+    """ Adds one value or a list of values, returning the number which weren't already present. """
+    raise_if_empty(name)
+
+    if not isinstance(items, list):
+      items = [items]
+
+    rsp = await self.client.sendCmd(self.cmds.ADD_REQ, self.cmds.ADD_RSP, {'name':name, 'items':items})
+    return rsp[self.cmds.ADD_RSP]['added']
+
+
+  async def remove(self, name: str, items: List[int] | int) -> int:
+    """ Removes one value or a list of values, returning the number which were present. """
+    raise_if_empty(name)
+
+    if not isinstance(items, list):
+      items = [items]
+
+    rsp = await self.client.sendCmd(self.cmds.RMV_REQ, self.cmds.RMV_RSP, {'name':name, 'items':items})
+    return rsp[self.cmds.RMV_RSP]['removed']
+
+
+  async def contains(self, name: str, item: int) -> bool:
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.CONTAINS_REQ, self.cmds.CONTAINS_RSP, {'name':name, 'item':item})
+    return rsp[self.cmds.CONTAINS_RSP]['contains']
+
+
+  async def length(self, name: str) -> int:
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.LEN_REQ, self.cmds.LEN_RSP, {'name':name})
+    return rsp[self.cmds.LEN_RSP]['len']
+
+
+  async def rank(self, name: str, item: int) -> int:
+    """ The number of values less than item. """
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.RANK_REQ, self.cmds.RANK_RSP, {'name':name, 'item':item})
+    return rsp[self.cmds.RANK_RSP]['rank']
+
+
+  async def select(self, name: str, pos: int) -> int:
+    """ The value at pos in ascending order, the inverse of rank(). """
+    raise_if_empty(name)
+    raise_if_lt(pos, 0, 'pos < 0')
+    rsp = await self.client.sendCmd(self.cmds.SELECT_REQ, self.cmds.SELECT_RSP, {'name':name, 'pos':pos})
+    return rsp[self.cmds.SELECT_RSP]['item']
+
+
+  async def get_rng(self, name: str, start: int, stop = None) -> List[int]:
+    """ Values at positions [start, stop), or from start to the end. """
+    raise_if_empty(name)
+
+    if stop == None:
+      rng = [start]
+    elif start > stop:
+      raise ValueError('start > stop')
+    else:
+      rng = [start, stop]
+
+    rsp = await self.client.sendCmd(self.cmds.GET_RNG_REQ, self.cmds.GET_RNG_RSP, {'name':name, 'rng':rng})
+    return rsp[self.cmds.GET_RNG_RSP]['items']
+
+
+  async def clear(self, name: str) -> None:
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.CLEAR_REQ, self.cmds.CLEAR_RSP, {'name':name})
+
+
+  async def intersect(self, *srcs: str, dest: str = None) -> List[int] | int:
+    return await self._setOperation(self.cmds.INTERSECT_REQ, self.cmds.INTERSECT_RSP, srcs, dest)
+
+
+  async def union(self, *srcs: str, dest: str = None) -> List[int] | int:
+    return await self._setOperation(self.cmds.UNION_REQ, self.cmds.UNION_RSP, srcs, dest)
+
+
+  async def xor(self, *srcs: str, dest: str = None) -> List[int] | int:
+    return await self._setOperation(self.cmds.XOR_REQ, self.cmds.XOR_RSP, srcs, dest)
+
+
+  async def diff(self, *srcs: str, dest: str = None) -> List[int] | int:
+    return await self._setOperation(self.cmds.DIFF_REQ, self.cmds.DIFF_RSP, srcs, dest)
+
+
+  async def _setOperation(self, cmdReq: str, cmdRsp: str, srcs, dest: str) -> List[int] | int:
+    "Returns the items, or with dest, the number of items stored in dest"
+    raise_if_lt(len(srcs), 2, 'Requires at least two sets')
+    for src in srcs:
+      raise_if_empty(src)
+
+    body = {'srcs':list(srcs)}
+
+    if dest is not None:
+      raise_if_empty(dest)
+      body['dest'] = dest
+
+    rsp = await self.client.sendCmd(cmdReq, cmdRsp, body)
+    return rsp[cmdRsp]['items'] if dest is None else rsp[cmdRsp]['len']
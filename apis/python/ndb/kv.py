@@ -76,9 +76,26 @@ class KV:
     return rsp[self.cmds.CLEAR_SET_RSP]['cnt'] 
 
 
-  async def save(self, name: str) -> None:
+  async def save(self, name: str, bg = False, delta = False, mmap = False) -> None:
     raise_if_empty(name)
-    await self.client.sendCmd(self.cmds.SAVE_REQ, self.cmds.SAVE_RSP, {'name':name}, StValues.ST_SAVE_COMPLETE)
+    
+    body = {'name':name}
+    if delta:
+      body['delta'] = True
+
+    if mmap:
+      body['mmap'] = True
+
+    if bg:
+      body['bg'] = True
+      await self.client.sendCmd(self.cmds.SAVE_REQ, self.cmds.SAVE_RSP, body, StValues.ST_SAVE_STARTED)
+    else:
+      await self.client.sendCmd(self.cmds.SAVE_REQ, self.cmds.SAVE_RSP, body, StValues.ST_SAVE_COMPLETE)
+
+
+  async def save_status(self) -> dict:
+    rsp = await self.client.sendCmd(self.cmds.SAVE_STATUS_REQ, self.cmds.SAVE_STATUS_RSP, {}, checkStatus=False)
+    return rsp[self.cmds.SAVE_STATUS_RSP]
     
 
   async def load(self, name: str) -> int:
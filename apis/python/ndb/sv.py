@@ -16,4 +16,18 @@ class SV:
     info = dict(rsp.get(self.cmds.INFO_RSP))
     info.pop(Fields.STATUS)
     return info
-  
\ No newline at end of file
+
+
+  async def cluster_slots(self) -> dict:
+    rsp = await self.client.sendCmd(self.cmds.CLUSTER_SLOTS_REQ, self.cmds.CLUSTER_SLOTS_RSP, {})
+    slots = dict(rsp.get(self.cmds.CLUSTER_SLOTS_RSP))
+    slots.pop(Fields.STATUS)
+    return slots
+
+
+  async def cluster_migrate(self, slot: int, node: str) -> None:
+    await self.client.sendCmd(self.cmds.CLUSTER_MIGRATE_REQ, self.cmds.CLUSTER_MIGRATE_RSP, {'slot':slot, 'node':node})
+
+
+  async def cluster_setslot(self, slot: int, node: str) -> None:
+    await self.client.sendCmd(self.cmds.CLUSTER_SETSLOT_REQ, self.cmds.CLUSTER_SETSLOT_RSP, {'slot':slot, 'node':node})
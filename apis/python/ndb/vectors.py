@@ -0,0 +1,84 @@
+from ndb.commands import (StValues, Fields, VecCmds)
+from ndb.client import NdbClient
+from ndb.common import raise_if_empty, raise_if_lt, raise_if_not
+from typing import List, Tuple
+
+
+class Vectors:
+  """ Collections of float vectors, searched for the k nearest to a query vector.
+
+  A vector's id is its position in the collection, in the order added.
+  """
+  def __init__(self, client: NdbClient):
+    self.client = client
+    self.cmds = VecCmds()
+
+
+  async def create(self, name: str, dim: int, quant = None) -> None:
+    raise_if_empty(name)
+    raise_if_lt(dim, 1, 'dim < 1')
+    raise_if_not(quant is None or quant in ('none', 'int8'), "quant must be 'none' or 'int8'")
+
+    args = {'name':name, 'dim':dim}
+    if quant is not None:
+      args['quant'] = quant
+
+    await self.client.sendCmd(self.cmds.CREATE_REQ, self.cmds.CREATE_RSP, args)
+
+
+  async def delete(self, name: str) -> None:
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.DELETE_REQ, self.cmds.DELETE_RSP, {'name':name})
+
+
+  async def delete_all(self) -> None:
+    await self.client.sendCmd(self.cmds.DELETE_ALL_REQ, self.cmds.DELETE_ALL_RSP, {})
+
+
+  async def exist(self, name: str) -> bool:
+    raise_if_empty(name)
+    # don't check status: EXIST response has 'st' success if collection exists or NotExist otherwise (so not an error)
+    rsp = await self.client.sendCmd(self.cmds.EXIST_REQ, self.cmds.EXIST_RSP, {'name':name}, checkStatus=False)
+    return rsp[self.cmds.EXIST_RSP][Fields.STATUS] == StValues.ST_SUCCESS
+
+
+  async def add(self, name: str, vectors: List[List[float]] | List[float]) -> int:
+    """ Adds one vector or a list of vectors, returning the id of the first. """
+    raise_if_empty(name)
+    raise_if_not(isinstance(vectors, list) and len(vectors) > 0, 'vectors must be a non-empty list')
+
+    if not isinstance(vectors[0], list):
+      vectors = [vectors]
+
+    rsp = await self.client.sendCmd(self.cmds.ADD_REQ, self.cmds.ADD_RSP, {'name':name, 'vectors':vectors})
+    return rsp[self.cmds.ADD_RSP]['first']
+
+
+  async def get(self, name: str, id: int) -> List[float]:
+    raise_if_empty(name)
+    raise_if_lt(id, 0, 'id < 0')
+    rsp = await self.client.sendCmd(self.cmds.GET_REQ, self.cmds.GET_RSP, {'name':name, 'id':id})
+    return rsp[self.cmds.GET_RSP]['vector']
+
+
+  async def length(self, name: str) -> int:
+    raise_if_empty(name)
+    rsp = await self.client.sendCmd(self.cmds.LEN_REQ, self.cmds.LEN_RSP, {'name':name})
+    return rsp[self.cmds.LEN_RSP]['len']
+
+
+  async def clear(self, name: str) -> None:
+    raise_if_empty(name)
+    await self.client.sendCmd(self.cmds.CLEAR_REQ, self.cmds.CLEAR_RSP, {'name':name})
+
+
+  async def search(self, name: str, vector: List[float], k = 10, metric = 'cosine') -> List[Tuple[int, float]]:
+    """ The k nearest vectors as (id, score), nearest first. For 'l2', the score is the distance. """
+    raise_if_empty(name)
+    raise_if_not(isinstance(vector, list), 'vector must be a list', TypeError)
+    raise_if_lt(k, 1, 'k < 1')
+    raise_if_not(metric in ('dot', 'cosine', 'l2'), "metric must be 'dot', 'cosine' or 'l2'")
+
+    rsp = await self.client.sendCmd(self.cmds.SEARCH_REQ, self.cmds.SEARCH_RSP, {'name':name, 'vector':vector, 'k':k, 'metric':metric})
+    body = rsp[self.cmds.SEARCH_RSP]
+    return list(zip(body['ids'], body['scores']))
@@ -0,0 +1,152 @@
+// Measures int64 aggregates, as IARR_SUM, IARR_MIN, IARR_MAX and IARR_COUNT_EQ, in values per nanosecond.
+//
+//  aggregate_bench [size]
+//
+// Each kernel (avx512, avx2, scalar, as available) is compared with a plain loop, and each result
+// is checked against it. Values are random over the full int64 range, so sums overflow int64.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrAggregate.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+// best of several runs, values per nanosecond
+template<typename R>
+static double measure (const std::size_t size, const std::function<R()>& run, const R& expected, bool& valid)
+{
+  static const int Runs = 5;
+
+  double best = 0;
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    const auto start = Clock::now();
+    const auto result = run();
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    valid = valid && result == expected;
+    best = std::max(best, size / ns);
+  }
+
+  return best;
+}
+
+
+static std::vector<agg::Kernels> availableKernels ()
+{
+  std::vector<agg::Kernels> kernels;
+
+  #if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512f"))
+      kernels.push_back(agg::Kernels{.sum = agg::sumAvx512, .min = agg::extremeAvx512<false>, .max = agg::extremeAvx512<true>, .countEqual = agg::countEqualAvx512, .name = "avx512"});
+    if (__builtin_cpu_supports("avx2"))
+      kernels.push_back(agg::Kernels{.sum = agg::sumAvx2, .min = agg::extremeAvx2<false>, .max = agg::extremeAvx2<true>, .countEqual = agg::countEqualAvx2, .name = "avx2"});
+  #endif
+
+  kernels.push_back(agg::Kernels{.sum = agg::sumScalar, .min = agg::minScalar, .max = agg::maxScalar, .countEqual = agg::countEqualScalar, .name = "scalar"});
+  return kernels;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t size = argc > 1 ? std::stoull(argv[1]) : 10'000'000U;
+
+  std::mt19937_64 rng{1987};
+  std::vector<std::int64_t> values(size);
+  std::generate(values.begin(), values.end(), [&]{ return static_cast<std::int64_t>(rng()); });
+
+  // a few repeated values to count, and ties for min and max
+  std::uniform_int_distribution<std::size_t> pos {0, size - 1};
+  for (int i = 0 ; i < 1000 ; ++i)
+    values[pos(rng)] = 42;
+
+  const auto [itMin, itMax] = std::minmax_element(values.cbegin(), values.cend());
+  values[pos(rng)] = *itMin;
+  values[pos(rng)] = *itMax;
+
+  const agg::Values v {values};
+
+  // plain loops
+  auto plainSum = [&]{ __int128 total = 0; for (const auto value : values) total += value; return total; };
+  auto plainMin = [&]{ const auto it = std::min_element(values.cbegin(), values.cend()); return std::pair{*it, std::distance(values.cbegin(), it)}; };
+  auto plainMax = [&]{ const auto it = std::max_element(values.cbegin(), values.cend()); return std::pair{*it, std::distance(values.cbegin(), it)}; };
+  auto plainCount = [&]{ return static_cast<std::size_t>(std::count(values.cbegin(), values.cend(), 42)); };
+
+  const auto expectedSum = plainSum();
+  const auto expectedMin = plainMin();
+  const auto expectedMax = plainMax();
+  const auto expectedCount = plainCount();
+
+  std::cout << "Selected: " << agg::AggKernels.name << ", values: " << size << " (values/ns)\n\n";
+
+  std::cout << std::left << std::setw(10) << "Kernel"
+                         << std::setw(10) << "sum"
+                         << std::setw(10) << "min"
+                         << std::setw(10) << "max"
+                         << std::setw(10) << "count_eq"
+                         << "\n";
+
+  bool valid = true;
+
+  auto row = [&](const std::string_view name, auto sum, auto min, auto max, auto count)
+  {
+    std::cout << std::left << std::fixed << std::setprecision(2)
+              << std::setw(10) << name
+              << std::setw(10) << measure<__int128>(size, sum, expectedSum, valid)
+              << std::setw(10) << measure<std::pair<std::int64_t, std::ptrdiff_t>>(size, min, expectedMin, valid)
+              << std::setw(10) << measure<std::pair<std::int64_t, std::ptrdiff_t>>(size, max, expectedMax, valid)
+              << std::setw(10) << measure<std::size_t>(size, count, expectedCount, valid)
+              << "\n";
+  };
+
+  row("plain", plainSum, plainMin, plainMax, plainCount);
+
+  for (const auto& kernel : availableKernels())
+  {
+    auto toPair = [](const agg::Position p){ return std::pair<std::int64_t, std::ptrdiff_t>{p.value, p.pos}; };
+
+    row(kernel.name,
+        [&]{ return kernel.sum(v); },
+        [&]{ return toPair(kernel.min(v)); },
+        [&]{ return toPair(kernel.max(v)); },
+        [&]{ return kernel.countEqual(v, 42); });
+  }
+
+  // histogram has one kernel, checked against dividing each offset by the width
+  for (const std::size_t buckets : {7U, 64U, 1000U})
+  {
+    const std::int64_t min = -(1LL << 62), max = (1LL << 62) + 12345;
+
+    const auto start = Clock::now();
+    const auto histogram = agg::histogram(v, min, max, buckets);
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    std::vector<std::size_t> expected(buckets);
+    for (const auto value : values)
+    {
+      if (min <= value && value <= max)
+        ++expected[(static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(min)) / histogram.width];
+    }
+
+    valid = valid && histogram.counts == expected;
+
+    std::cout << (buckets == 7U ? "\n" : "") << "histogram, " << buckets << " buckets: " << std::setprecision(2) << size / ns << " values/ns\n";
+  }
+
+  if (!valid)
+    std::cout << "\nFAIL: a result differs from the plain loop\n";
+
+  return valid ? 0 : 1;
+}
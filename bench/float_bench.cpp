@@ -0,0 +1,134 @@
+// Measures double aggregates, as FARR_SUM, FARR_DOT, FARR_MIN and FARR_MAX, and FARR_MUL, in values per nanosecond.
+//
+//  float_bench [size]
+//
+// Each kernel (avx512, avx2, scalar, as available) is compared with a plain loop, and each result
+// is checked against it. Values are small integers so every sum is exact, whatever the order of adds.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrFloatMath.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+// best of several runs, values per nanosecond
+template<typename R>
+static double measure (const std::size_t size, const std::function<R()>& run, const R& expected, bool& valid)
+{
+  static const int Runs = 5;
+
+  double best = 0;
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    const auto start = Clock::now();
+    const auto result = run();
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    valid = valid && result == expected;
+    best = std::max(best, size / ns);
+  }
+
+  return best;
+}
+
+
+static std::vector<fmath::Kernels> availableKernels ()
+{
+  std::vector<fmath::Kernels> kernels;
+
+  #if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx512f"))
+      kernels.push_back(fmath::Kernels{.sum = fmath::sumAvx512, .dot = fmath::dotAvx512, .min = fmath::extremeAvx512<false>, .max = fmath::extremeAvx512<true>, .name = "avx512"});
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      kernels.push_back(fmath::Kernels{.sum = fmath::sumAvx2, .dot = fmath::dotAvx2, .min = fmath::extremeAvx2<false>, .max = fmath::extremeAvx2<true>, .name = "avx2"});
+  #endif
+
+  kernels.push_back(fmath::Kernels{.sum = fmath::sumScalar, .dot = fmath::dotScalar, .min = fmath::minScalar, .max = fmath::maxScalar, .name = "scalar"});
+  return kernels;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t size = argc > 1 ? std::stoull(argv[1]) : 10'000'000U;
+
+  std::mt19937_64 rng{1987};
+  std::uniform_int_distribution<int> dist {-1000, 1000};
+  std::vector<double> a(size), b(size);
+  std::generate(a.begin(), a.end(), [&]{ return dist(rng); });
+  std::generate(b.begin(), b.end(), [&]{ return dist(rng) % 8; });
+
+  const fmath::Values va {a}, vb {b};
+
+  // plain loops
+  auto plainSum = [&]{ double total = 0; for (const auto value : a) total += value; return total; };
+  auto plainDot = [&]{ double total = 0; for (std::size_t i = 0 ; i < size ; ++i) total += a[i] * b[i]; return total; };
+  auto plainMin = [&]{ const auto it = std::min_element(a.cbegin(), a.cend()); return std::pair{*it, std::distance(a.cbegin(), it)}; };
+  auto plainMax = [&]{ const auto it = std::max_element(a.cbegin(), a.cend()); return std::pair{*it, std::distance(a.cbegin(), it)}; };
+
+  const auto expectedSum = plainSum();
+  const auto expectedDot = plainDot();
+  const auto expectedMin = plainMin();
+  const auto expectedMax = plainMax();
+
+  std::cout << "Selected: " << fmath::FloatKernels.name << ", values: " << size << " (values/ns)\n\n";
+
+  std::cout << std::left << std::setw(10) << "Kernel"
+                         << std::setw(10) << "sum"
+                         << std::setw(10) << "dot"
+                         << std::setw(10) << "min"
+                         << std::setw(10) << "max"
+                         << "\n";
+
+  bool valid = true;
+
+  auto row = [&](const std::string_view name, auto sum, auto dot, auto min, auto max)
+  {
+    std::cout << std::left << std::fixed << std::setprecision(2)
+              << std::setw(10) << name
+              << std::setw(10) << measure<double>(size, sum, expectedSum, valid)
+              << std::setw(10) << measure<double>(size, dot, expectedDot, valid)
+              << std::setw(10) << measure<std::pair<double, std::ptrdiff_t>>(size, min, expectedMin, valid)
+              << std::setw(10) << measure<std::pair<double, std::ptrdiff_t>>(size, max, expectedMax, valid)
+              << "\n";
+  };
+
+  row("plain", plainSum, plainDot, plainMin, plainMax);
+
+  for (const auto& kernel : availableKernels())
+  {
+    auto toPair = [](const fmath::Position p){ return std::pair<double, std::ptrdiff_t>{p.value, p.pos}; };
+
+    row(kernel.name,
+        [&]{ return kernel.sum(va); },
+        [&]{ return kernel.dot(va, vb); },
+        [&]{ return toPair(kernel.min(va)); },
+        [&]{ return toPair(kernel.max(va)); });
+  }
+
+  // elementwise ops are plain loops, vectorized by the compiler. Multiplying by 1 leaves the values unchanged.
+  {
+    const auto start = Clock::now();
+    fmath::apply(fmath::Op::Mul, std::span<double>{a}, 1.0);
+    fmath::apply(fmath::Op::Mul, std::span<double>{a}, fmath::Values{b});
+    const auto ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    std::cout << "\nmul, scalar then array: " << std::setprecision(2) << 2 * size / ns << " values/ns\n";
+  }
+
+  if (!valid)
+    std::cout << "\nFAIL: a result differs from the plain loop\n";
+
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+// Measures sorted int64 intersection, as SIARR_INTERSECT, against std::set_intersection.
+//
+//  intersect_bench [largeSize]
+//
+// For each size ratio, the smaller array has largeSize / ratio values. Density is the fraction of
+// the smaller array's values which are in the larger. Each result is checked against
+// std::set_intersection. Times are the best of several runs, in microseconds.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrSetOps.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+static std::vector<std::int64_t> createLarge (const std::size_t size, std::mt19937_64& rng)
+{
+  // even values, with gaps
+  std::uniform_int_distribution<std::int64_t> gap {1, 4};
+
+  std::vector<std::int64_t> values;
+  values.reserve(size);
+
+  for (std::int64_t value = 0 ; values.size() < size ; )
+  {
+    value += gap(rng) * 2;
+    values.push_back(value);
+  }
+
+  return values;
+}
+
+
+static std::vector<std::int64_t> createSmall (const std::vector<std::int64_t>& large, const std::size_t size, const double density, std::mt19937_64& rng)
+{
+  // values not in large are odd
+  std::uniform_int_distribution<std::size_t> pos {0, large.size() - 1};
+  std::bernoulli_distribution inLarge {density};
+
+  std::vector<std::int64_t> values;
+  values.reserve(size);
+
+  while (values.size() < size)
+    values.push_back(inLarge(rng) ? large[pos(rng)] : large[pos(rng)] + 1);
+
+  std::sort(values.begin(), values.end());
+  values.erase(std::unique(values.begin(), values.end()), values.end());
+  return values;
+}
+
+
+static double measure (const std::function<setops::Result()>& run, const setops::Result& expected, bool& valid)
+{
+  static const int Runs = 5;
+
+  double best = 0;
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    const auto start = Clock::now();
+    const auto result = run();
+    const auto us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    valid = valid && result == expected;
+    best = i == 0 ? us : std::min(best, us);
+  }
+
+  return best;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t largeSize = argc > 1 ? std::stoull(argv[1]) : 1'000'000U;
+
+  std::mt19937_64 rng{1987};
+  const auto large = createLarge(largeSize, rng);
+  const setops::Values b {large};
+
+  std::cout << "Block kernel: " << setops::BlockKernel.name << ", large array: " << largeSize << " values\n\n";
+
+  std::cout << std::left << std::setw(8)  << "Ratio"
+                         << std::setw(9)  << "Density"
+                         << std::setw(10) << "Matches"
+                         << std::setw(12) << "std (us)"
+                         << std::setw(12) << "scalar"
+                         << std::setw(12) << "block"
+                         << std::setw(12) << "gallop"
+                         << std::setw(12) << "selected"
+                         << "Speedup\n";
+
+  bool valid = true;
+
+  for (const std::size_t ratio : {1U, 4U, 16U, 64U, 256U, 1024U})
+  {
+    for (const double density : {0.01, 0.1, 0.5, 1.0})
+    {
+      const auto small = createSmall(large, largeSize / ratio, density, rng);
+      const setops::Values a {small};
+
+      setops::Result expected;
+      std::set_intersection(small.cbegin(), small.cend(), large.cbegin(), large.cend(), std::back_inserter(expected));
+
+      auto run = [&](auto f) { return [&a, &b, f]{ setops::Result result; f(a, b, result); return result; }; };
+
+      const auto stdUs = measure([&]{ setops::Result result; std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result)); return result; }, expected, valid);
+      const auto scalar = measure(run(setops::intersectScalar), expected, valid);
+      const auto block = measure(run(setops::BlockKernel.intersect), expected, valid);
+      const auto gallop = measure(run(setops::intersectGallop<std::int64_t>), expected, valid);
+      const auto selected = measure([&]{ return setops::intersect(a, b); }, expected, valid);
+
+      std::cout << std::left << std::fixed << std::setprecision(0)
+                << std::setw(8)  << ratio
+                << std::setw(9)  << std::setprecision(2) << density
+                << std::setw(10) << expected.size()
+                << std::setprecision(0)
+                << std::setw(12) << stdUs
+                << std::setw(12) << scalar
+                << std::setw(12) << block
+                << std::setw(12) << gallop
+                << std::setw(12) << selected
+                << std::setprecision(1) << stdUs / selected << "x\n";
+    }
+  }
+
+  if (!valid)
+    std::cout << "\nFAIL: a result differs from std::set_intersection\n";
+
+  return valid ? 0 : 1;
+}
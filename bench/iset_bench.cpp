@@ -0,0 +1,212 @@
+// Compares integer sets, ISET, as roaring bitmaps, with sorted int arrays, SIARR, a sorted
+// std::vector<int64_t>: memory per value, batch add, contains, rank and set operations.
+//
+//  iset_bench [values]
+//
+// Two sets of 'values' random values, drawn from a range which sets their density:
+//  - sparse: 1 in 65536 values of the range, so each roaring container is a small array
+//  - medium: 1 in 32, so containers are arrays of about 2048 values
+//  - dense: 1 in 2, so containers are bitmaps
+//
+// SIARR memory is the vector's size, as an array with no spare capacity. Batch add sorts then
+// merges into the set, as ISET_ADD and SIARR_SET_RNG. Set operations use arr::setops, as
+// SIARR_INTERSECT etc, which has no xor so std::set_symmetric_difference is used. Results are
+// materialised: a vector for SIARR, a set for ISET. Times are the best of several runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+#include <core/arr/ArrSetOps.h>
+#include <core/iset/ISetRoaring.h>
+
+
+using namespace nemesis;
+using Clock = std::chrono::steady_clock;
+
+
+static const int Runs = 3;
+static const std::size_t Lookups = 1'000'000U;
+
+
+static std::vector<std::int64_t> createValues (const std::size_t n, const std::uint64_t range, std::mt19937_64& rng)
+{
+  std::uniform_int_distribution<std::int64_t> dist{0, static_cast<std::int64_t>(range - 1)};
+
+  std::vector<std::int64_t> values(n);
+  for (auto& v : values)
+    v = dist(rng);
+
+  return values;
+}
+
+
+static double measure (const std::function<void()>& setup, const std::function<void()>& run)
+{
+  double best = 0;
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    setup();
+
+    const auto start = Clock::now();
+    run();
+    const auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    best = i == 0 ? ms : std::min(best, ms);
+  }
+
+  return best;
+}
+
+
+static void row (const std::string_view name, const double siarr, const double iset, const std::string_view unit)
+{
+  std::cout << std::left << std::fixed << std::setprecision(2)
+            << std::setw(20) << name
+            << std::setw(14) << siarr
+            << std::setw(14) << iset
+            << siarr / iset << "x  (" << unit << ")\n";
+}
+
+
+static std::vector<std::int64_t> toVector (const iset::Roaring& set)
+{
+  std::vector<std::int64_t> values;
+  values.reserve(set.size());
+  set.forEach(0, set.size(), [&values](const std::uint64_t v){ values.push_back(static_cast<std::int64_t>(v)); });
+  return values;
+}
+
+
+// false if any result differs
+static bool run (const std::string_view dataset, const std::size_t n, const std::uint64_t range)
+{
+  std::mt19937_64 rng{1987};
+  bool valid = true;
+
+  const auto valuesA = createValues(n, range, rng);
+  const auto valuesB = createValues(n, range, rng);
+
+  std::cout << "\n" << dataset << "\n" << std::left << std::setw(20) << "" << std::setw(14) << "siarr" << std::setw(14) << "iset" << "siarr/iset\n";
+
+  // batch add into an empty set
+  std::vector<std::int64_t> sortedA, sortedB;
+  iset::Roaring setA, setB;
+  {
+    std::vector<std::int64_t> items;
+
+    const auto siarrMs = measure([&]{ items = valuesA; sortedA.clear(); }, [&]
+    {
+      std::sort(items.begin(), items.end());
+      items.erase(std::unique(items.begin(), items.end()), items.end());
+      sortedA = std::move(items);
+    });
+
+    const auto isetMs = measure([&]{ setA.clear(); }, [&]
+    {
+      setA.add(std::vector<std::uint64_t>(valuesA.cbegin(), valuesA.cend()));
+    });
+
+    sortedB = valuesB;
+    std::sort(sortedB.begin(), sortedB.end());
+    sortedB.erase(std::unique(sortedB.begin(), sortedB.end()), sortedB.end());
+    setB.add(std::vector<std::uint64_t>(valuesB.cbegin(), valuesB.cend()));
+
+    valid = valid && toVector(setA) == sortedA && toVector(setB) == sortedB;
+    row("batch add", siarrMs, isetMs, "ms");
+  }
+
+  row("memory", static_cast<double>(sortedA.size() * sizeof(std::int64_t)) / sortedA.size(), static_cast<double>(setA.memory()) / setA.size(), "bytes per value");
+
+  const auto targets = createValues(Lookups, range, rng);
+
+  // contains
+  {
+    std::size_t siarrFound = 0, isetFound = 0;
+
+    const auto siarrMs = measure([&]{ siarrFound = 0; }, [&]
+    {
+      for (const auto v : targets)
+        siarrFound += std::binary_search(sortedA.cbegin(), sortedA.cend(), v);
+    });
+
+    const auto isetMs = measure([&]{ isetFound = 0; }, [&]
+    {
+      for (const auto v : targets)
+        isetFound += setA.contains(v);
+    });
+
+    valid = valid && siarrFound == isetFound;
+    row("contains", siarrMs, isetMs, "ms per 1M");
+  }
+
+  // rank, as SIARR_LOWER_BOUND
+  {
+    std::size_t siarrSum = 0, isetSum = 0;
+
+    const auto siarrMs = measure([&]{ siarrSum = 0; }, [&]
+    {
+      for (const auto v : targets)
+        siarrSum += std::distance(sortedA.cbegin(), std::lower_bound(sortedA.cbegin(), sortedA.cend(), v));
+    });
+
+    const auto isetMs = measure([&]{ isetSum = 0; }, [&]
+    {
+      for (const auto v : targets)
+        isetSum += setA.rank(v);
+    });
+
+    valid = valid && siarrSum == isetSum;
+    row("rank", siarrMs, isetMs, "ms per 1M");
+  }
+
+  auto setOperation = [&](const std::string_view name, const iset::Operation op, std::function<std::vector<std::int64_t>()> siarr)
+  {
+    std::vector<std::int64_t> siarrResult;
+    iset::Roaring isetResult;
+
+    const auto siarrMs = measure([]{}, [&]{ siarrResult = siarr(); });
+    const auto isetMs = measure([]{}, [&]{ isetResult = iset::Roaring::apply(op, setA, setB); });
+
+    valid = valid && siarrResult == toVector(isetResult);
+    row(name, siarrMs, isetMs, "ms");
+  };
+
+  const std::vector<std::span<const std::int64_t>> sources {sortedA, sortedB};
+
+  setOperation("intersect", iset::Operation::Intersect, [&]{ return arr::setops::apply<std::int64_t>(arr::setops::Operation::Intersect, sources); });
+  setOperation("union", iset::Operation::Union, [&]{ return arr::setops::apply<std::int64_t>(arr::setops::Operation::Union, sources); });
+  setOperation("diff", iset::Operation::Difference, [&]{ return arr::setops::apply<std::int64_t>(arr::setops::Operation::Difference, sources); });
+  setOperation("xor", iset::Operation::Xor, [&]
+  {
+    std::vector<std::int64_t> result;
+    result.reserve(sortedA.size() + sortedB.size());
+    std::set_symmetric_difference(sortedA.cbegin(), sortedA.cend(), sortedB.cbegin(), sortedB.cend(), std::back_inserter(result));
+    return result;
+  });
+
+  return valid;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nValues = argc > 1 ? std::stoull(argv[1]) : 4'000'000U;
+
+  std::cout << "Values: " << nValues << ", lookups: " << Lookups << ", bitmap kernel: " << iset::kernels::BitmapKernel.name << "\n";
+
+  bool valid = run("sparse", nValues, nValues * 65536U);
+  valid = run("medium", nValues, nValues * 32U) && valid;
+  valid = run("dense", nValues, nValues * 2U) && valid;
+
+  if (!valid)
+    std::cout << "\nFAIL: iset results differ\n";
+
+  return valid ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+// Autocomplete on a sorted string array, as SSTRARR_PREFIX: the Vector layout, a sorted
+// std::vector<std::string>, compared with the FrontCoded layout, FrontCodedStrings.
+//
+//  prefix_bench [strings] [n]
+//
+// Two sets of strings:
+//  - keys: "user:" then a 9 digit id, so neighbours share most of their bytes
+//  - words: 6 to 24 lowercase letters, neighbours sharing about log26(strings) letters
+//
+// Memory of the Vector layout is the vector's capacity plus each string's heap allocation beyond
+// the SSO limit, from malloc_usable_size() plus the allocator's 8 byte header. A query is the lower
+// bounds of a prefix and its successor then the first 'n' strings, for prefixes of 2 to 6 bytes of
+// a random string. Latencies are per query, the mean and 99th percentile.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrFrontCoded.h>
+#include <core/arr/ArrSearch.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+static const std::size_t Queries = 100'000U;
+
+
+static std::vector<std::string> createKeys (const std::size_t n, std::mt19937_64& rng)
+{
+  std::uniform_int_distribution<std::uint64_t> id{0, 999'999'999ULL};
+
+  std::vector<std::string> strings(n);
+  for (auto& s : strings)
+  {
+    auto digits = std::to_string(id(rng));
+    s = "user:" + std::string(9 - digits.size(), '0') + digits;
+  }
+
+  return strings;
+}
+
+
+static std::vector<std::string> createWords (const std::size_t n, std::mt19937_64& rng)
+{
+  std::uniform_int_distribution<std::size_t> length{6, 24};
+  std::uniform_int_distribution<int> letter{'a', 'z'};
+
+  std::vector<std::string> strings(n);
+  for (auto& s : strings)
+  {
+    for (auto i = length(rng) ; i > 0 ; --i)
+      s.push_back(static_cast<char>(letter(rng)));
+  }
+
+  return strings;
+}
+
+
+static std::size_t vectorMemory (const std::vector<std::string>& strings)
+{
+  std::size_t bytes = strings.capacity() * sizeof(std::string);
+
+  for (const auto& s : strings)
+  {
+    if (s.capacity() > 15)
+      bytes += malloc_usable_size(const_cast<char *>(s.data())) + 8;
+  }
+
+  return bytes;
+}
+
+
+// as ArrayExecutor::prefix(), false if there is no successor
+static bool successor (std::string& prefix)
+{
+  while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF)
+    prefix.pop_back();
+
+  if (prefix.empty())
+    return false;
+
+  prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+  return true;
+}
+
+
+// runs the queries with find(prefix, results), returning the mean and 99th percentile in microseconds
+template<typename Find>
+static std::pair<double, double> measure (const std::vector<std::string>& prefixes, Find&& find, std::size_t& total)
+{
+  std::vector<double> latencies;
+  latencies.reserve(prefixes.size());
+
+  std::vector<std::string> results;
+
+  for (const auto& prefix : prefixes)
+  {
+    const auto start = Clock::now();
+    results.clear();
+    find(prefix, results);
+    latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+    total += results.size();
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  double sum = 0;
+  for (const auto us : latencies)
+    sum += us;
+
+  return {sum / latencies.size(), latencies[latencies.size() * 99 / 100]};
+}
+
+
+// false if any result differs
+static bool run (const std::string_view dataset, std::vector<std::string> strings, const std::size_t n)
+{
+  std::mt19937_64 rng{1987};
+
+  std::sort(strings.begin(), strings.end());
+
+  std::vector<std::string> prefixes(Queries);
+  for (auto& prefix : prefixes)
+  {
+    const auto& s = strings[rng() % strings.size()];
+    prefix = s.substr(0, std::min<std::size_t>(s.size(), 2 + rng() % 5));
+  }
+
+  const auto buildStart = Clock::now();
+  FrontCodedStrings coded;
+  coded.append(std::vector<std::string>{strings});
+  const auto buildMs = std::chrono::duration<double, std::milli>(Clock::now() - buildStart).count();
+
+  std::size_t vectorTotal = 0, codedTotal = 0;
+
+  const auto [vectorMean, vectorP99] = measure(prefixes, [&strings, n](const std::string& prefix, std::vector<std::string>& results)
+  {
+    const auto first = search::lowerBound<std::string>(strings, prefix);
+    auto next = prefix;
+    const auto last = successor(next) ? search::lowerBound<std::string>(strings, next) : strings.size();
+
+    results.assign(std::next(strings.cbegin(), first), std::next(strings.cbegin(), first + std::min(n, last - first)));
+  }, vectorTotal);
+
+  const auto [codedMean, codedP99] = measure(prefixes, [&coded, n](const std::string& prefix, std::vector<std::string>& results)
+  {
+    const auto first = coded.lowerBound(prefix);
+    auto next = prefix;
+    const auto last = successor(next) ? coded.lowerBound(next) : coded.size();
+
+    coded.forEach(first, first + std::min(n, last - first), [&results](const std::string& s){ results.push_back(s); });
+  }, codedTotal);
+
+  std::cout << "\n" << dataset << " (front coding built in " << std::fixed << std::setprecision(0) << buildMs << " ms)\n"
+            << std::left << std::setw(24) << "" << std::setw(14) << "vector" << std::setw(14) << "frontcoded" << "vector/frontcoded\n"
+            << std::setprecision(1)
+            << std::setw(24) << "memory (MiB)" << std::setw(14) << vectorMemory(strings) / (1024.0 * 1024.0)
+            << std::setw(14) << coded.memory() / (1024.0 * 1024.0) << std::setprecision(2) << double(vectorMemory(strings)) / coded.memory() << "x\n"
+            << std::setw(24) << "query mean (us)" << std::setw(14) << vectorMean << std::setw(14) << codedMean << vectorMean / codedMean << "x\n"
+            << std::setw(24) << "query p99 (us)" << std::setw(14) << vectorP99 << std::setw(14) << codedP99 << vectorP99 / codedP99 << "x\n";
+
+  return vectorTotal == codedTotal;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nStrings = argc > 1 ? std::stoull(argv[1]) : 10'000'000U;
+  const std::size_t n = argc > 2 ? std::stoull(argv[2]) : 10U;
+
+  std::cout << "Strings: " << nStrings << ", queries: " << Queries << ", results per query: " << n << "\n";
+
+  std::mt19937_64 rng{42};
+
+  bool valid = run("keys", createKeys(nStrings, rng), n);
+  valid = run("words", createWords(nStrings, rng), n) && valid;
+
+  if (!valid)
+    std::cout << "\nFAIL: frontcoded results differ\n";
+
+  return valid ? 0 : 1;
+}
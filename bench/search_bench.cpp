@@ -0,0 +1,103 @@
+// Measures sorted int64 lookups, as SIARR_LOWER_BOUND, in millions of lookups per second.
+//
+//  search_bench [lookups]
+//
+// Compares std::lower_bound with search::lowerBound() (branch-free) on a contiguous array, as the
+// Vector layout, and SortedBlocks::lowerBound(), the Blocked layout. Lookups are random values
+// within the array's range. Each result is checked against std::lower_bound.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrBlocks.h>
+#include <core/arr/ArrSearch.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+// best of several runs, millions of lookups per second
+static double measure (const std::vector<std::int64_t>& lookups, const std::function<std::size_t(std::int64_t)>& find, const std::vector<std::size_t>& expected, bool& valid)
+{
+  static const int Runs = 3;
+
+  double best = 0;
+  std::vector<std::size_t> results(lookups.size());
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    const auto start = Clock::now();
+
+    for (std::size_t l = 0 ; l < lookups.size() ; ++l)
+      results[l] = find(lookups[l]);
+
+    const auto s = std::chrono::duration<double>(Clock::now() - start).count();
+
+    valid = valid && results == expected;
+    best = std::max(best, lookups.size() / s / 1'000'000);
+  }
+
+  return best;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nLookups = argc > 1 ? std::stoull(argv[1]) : 1'000'000U;
+
+  std::mt19937_64 rng{1987};
+  std::uniform_int_distribution<std::int64_t> dist{0, 1LL << 40};
+
+  std::cout << "Lookups: " << nLookups << " (M lookups/s)\n\n";
+
+  std::cout << std::left << std::setw(12) << "Size"
+                         << std::setw(18) << "std::lower_bound"
+                         << std::setw(14) << "branch-free"
+                         << std::setw(10) << "Speedup"
+                         << std::setw(10) << "Blocked"
+                         << "\n";
+
+  bool valid = true;
+
+  for (const std::size_t size : {1'000U, 10'000U, 100'000U, 1'000'000U, 10'000'000U})
+  {
+    std::vector<std::int64_t> values(size);
+    std::generate(values.begin(), values.end(), [&]{ return dist(rng); });
+    std::sort(values.begin(), values.end());
+
+    SortedBlocks<std::int64_t> blocks;
+    blocks.append(std::vector<std::int64_t>{values});
+
+    std::vector<std::int64_t> lookups(nLookups);
+    std::generate(lookups.begin(), lookups.end(), [&]{ return dist(rng); });
+
+    std::vector<std::size_t> expected;
+    expected.reserve(nLookups);
+    for (const auto lookup : lookups)
+      expected.push_back(std::distance(values.cbegin(), std::lower_bound(values.cbegin(), values.cend(), lookup)));
+
+    const auto stdLookups = measure(lookups, [&](const std::int64_t v){ return std::distance(values.cbegin(), std::lower_bound(values.cbegin(), values.cend(), v)); }, expected, valid);
+    const auto branchFree = measure(lookups, [&](const std::int64_t v){ return search::lowerBound<std::int64_t>(values, v); }, expected, valid);
+    const auto blocked = measure(lookups, [&](const std::int64_t v){ return blocks.lowerBound(v); }, expected, valid);
+
+    std::cout << std::left << std::fixed << std::setprecision(1)
+              << std::setw(12) << size
+              << std::setw(18) << stdLookups
+              << std::setw(14) << branchFree
+              << std::setw(10) << branchFree / stdLookups
+              << std::setw(10) << blocked
+              << "\n";
+  }
+
+  if (!valid)
+    std::cout << "\nFAIL: a result differs from std::lower_bound\n";
+
+  return valid ? 0 : 1;
+}
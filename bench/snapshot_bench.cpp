@@ -0,0 +1,156 @@
+// Measures snapshot save and load time, and size on disk, for each compression codec.
+//
+//  snapshot_bench [nKeys] [dir]
+//
+// Values are JSON-like text, similar in size and repetition to typical KV values. Load reads
+// files concurrently, as KV_LOAD does. The dir is removed when done.
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <core/Snapshot.h>
+
+
+namespace fs = std::filesystem;
+using namespace nemesis;
+using namespace nemesis::snapshot;
+using Clock = std::chrono::steady_clock;
+
+
+struct Result
+{
+  double saveMs;
+  double loadMs;
+  std::size_t bytes;
+  std::size_t nFiles;
+};
+
+
+static std::vector<std::pair<std::string, std::string>> createKeys (const std::size_t nKeys)
+{
+  static const char * Cities[] = {"London", "Paris", "New York", "Tokyo", "Berlin", "Madrid", "Rome", "Sydney"};
+
+  std::vector<std::pair<std::string, std::string>> keys;
+  keys.reserve(nKeys);
+
+  for (std::size_t i = 0 ; i < nKeys ; ++i)
+  {
+    std::string value = R"({"id":)" + std::to_string(i) +
+                        R"(,"username":"user)" + std::to_string(i * 7919U) +
+                        R"(","city":")" + Cities[i % 8] +
+                        R"(","active":)" + (i % 3 ? "true" : "false") +
+                        R"(,"scores":[)" + std::to_string(i % 100) + "," + std::to_string((i * 31U) % 1000) + "]}";
+
+    keys.emplace_back("user:" + std::to_string(i), std::move(value));
+  }
+
+  return keys;
+}
+
+
+static Result run (const Codec codec, const std::vector<std::pair<std::string, std::string>>& keys, const fs::path& dir)
+{
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+
+  Result result{};
+
+  auto start = Clock::now();
+  {
+    SnapshotWriter writer{dir, codec};
+
+    for (const auto& [key, value] : keys)
+    {
+      writer.putString(key);
+      writer.putBlob(std::span<const std::uint8_t>{reinterpret_cast<const std::uint8_t *>(value.data()), value.size()});
+      writer.endRecord();
+    }
+
+    writer.close();
+  }
+  result.saveMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+
+  std::vector<fs::path> files;
+  for (const auto& file : fs::directory_iterator{dir})
+  {
+    files.emplace_back(file.path());
+    result.bytes += file.file_size();
+  }
+
+  result.nFiles = files.size();
+
+
+  start = Clock::now();
+  {
+    std::atomic_size_t nextFile{0}, nRecords{0};
+    ThreadPool pool {std::min(files.size(), ThreadPool::defaultSize())};
+
+    for (std::size_t i = 0 ; i < pool.size() ; ++i)
+    {
+      pool.submit([&]
+      {
+        for (auto f = nextFile++ ; f < files.size() ; f = nextFile++)
+        {
+          SnapshotReader reader{files[f]};
+
+          while (reader.nextBlock())
+          {
+            for (std::uint32_t r = 0 ; r < reader.blockRecords() ; ++r, ++nRecords)
+            {
+              reader.getString();
+              reader.getBlob();
+            }
+          }
+        }
+      });
+    }
+    // pool destructor waits
+  }
+  result.loadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  fs::remove_all(dir);
+  return result;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nKeys = argc > 1 ? std::stoull(argv[1]) : 2'000'000U;
+  const fs::path dir = argc > 2 ? fs::path{argv[2]} : fs::temp_directory_path() / "ndb_snapshot_bench";
+
+  std::cout << "Creating " << nKeys << " keys\n";
+  const auto keys = createKeys(nKeys);
+
+  std::size_t rawBytes = 0;
+  for (const auto& [key, value] : keys)
+    rawBytes += key.size() + value.size();
+
+  std::cout << "Raw data: " << rawBytes / (1024U * 1024U) << " MiB\n\n";
+  std::cout << std::left << std::setw(8) << "codec" << std::right << std::setw(12) << "save (ms)" << std::setw(12) << "load (ms)"
+            << std::setw(12) << "size (MiB)" << std::setw(8) << "ratio" << std::setw(8) << "files" << '\n';
+
+  for (const auto codec : {Codec::None, Codec::Zlib, Codec::Lz4})
+  {
+    if (!isAvailable(codec))
+    {
+      std::cout << std::left << std::setw(8) << toString(codec) << " unavailable\n";
+      continue;
+    }
+
+    const auto result = run(codec, keys, dir);
+
+    std::cout << std::left << std::setw(8) << toString(codec) << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << result.saveMs
+              << std::setw(12) << result.loadMs
+              << std::setw(12) << static_cast<double>(result.bytes) / (1024.0 * 1024.0)
+              << std::setw(8) << static_cast<double>(rawBytes) / static_cast<double>(result.bytes)
+              << std::setw(8) << result.nFiles << '\n';
+  }
+
+  return 0;
+}
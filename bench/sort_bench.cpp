@@ -0,0 +1,138 @@
+// Compares sorts used by IARR_SORT, STRARR_SORT and TO_SORTED with std::sort.
+//
+//  sort_bench [values]
+//
+// Integers, as sortItems() sorts an IArray: std::sort, radixSort() alone, then sortItems(),
+// which sorts chunks with radixSort() on a pool and merges them. Values are random across the
+// int64_t range or in a narrow range, where radixSort() skips the bytes which don't differ.
+//
+// Strings, as STRARR_SORT: std::sort of std::string, then StringArena::sort(), which sorts
+// the arena's entries with sortItems(). The strings have a common prefix longer than the
+// arena's inline key, so comparisons read the arena. Times are the best of several runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrSort.h>
+#include <core/arr/ArrStrings.h>
+
+
+using namespace nemesis;
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+static const int Runs = 3;
+
+
+static double measure (const std::function<void()>& setup, const std::function<void()>& run)
+{
+  double best = 0;
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    setup();
+
+    const auto start = Clock::now();
+    run();
+    const auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    best = i == 0 ? ms : std::min(best, ms);
+  }
+
+  return best;
+}
+
+
+static void row (const std::string_view name, const double ms, const double baseline)
+{
+  std::cout << std::left << std::fixed << std::setprecision(2)
+            << std::setw(20) << name
+            << std::setw(12) << ms
+            << baseline / ms << "x\n";
+}
+
+
+// false if any result differs from std::sort
+static bool sortIntegers (const std::string_view dataset, const std::size_t n, const std::int64_t min, const std::int64_t max)
+{
+  std::mt19937_64 rng{1987};
+  std::uniform_int_distribution<std::int64_t> dist{min, max};
+
+  std::vector<std::int64_t> values(n);
+  for (auto& v : values)
+    v = dist(rng);
+
+  std::cout << "\n" << dataset << "\n" << std::left << std::setw(20) << "" << std::setw(12) << "ms" << "vs std::sort\n";
+
+  std::vector<std::int64_t> expected, items;
+
+  const auto stdMs = measure([&]{ expected = values; }, [&]{ std::sort(expected.begin(), expected.end()); });
+  row("std::sort", stdMs, stdMs);
+
+  const auto radixMs = measure([&]{ items = values; }, [&]{ radixSort(items); });
+  bool valid = items == expected;
+  row("radixSort", radixMs, stdMs);
+
+  const auto sortItemsMs = measure([&]{ items = values; }, [&]{ sortItems(items); });
+  valid = valid && items == expected;
+  row("sortItems", sortItemsMs, stdMs);
+
+  return valid;
+}
+
+
+static bool sortStrings (const std::size_t n)
+{
+  std::mt19937_64 rng{1987};
+
+  std::vector<std::string> values(n);
+  for (auto& v : values)
+    v = "user:session:" + std::to_string(rng());
+
+  std::cout << "\nstrings\n" << std::left << std::setw(20) << "" << std::setw(12) << "ms" << "vs std::sort\n";
+
+  std::vector<std::string> expected;
+  StringArena arena {n};
+
+  const auto stdMs = measure([&]{ expected = values; }, [&]{ std::sort(expected.begin(), expected.end()); });
+  row("std::sort", stdMs, stdMs);
+
+  const auto arenaMs = measure([&]
+  {
+    for (std::size_t i = 0 ; i < n ; ++i)
+      arena.set(i, values[i]);
+  },
+  [&]{ arena.sort(n, false); });
+
+  bool valid = true;
+  for (std::size_t i = 0 ; i < n && valid ; ++i)
+    valid = arena.get(i) == expected[i];
+
+  row("StringArena::sort", arenaMs, stdMs);
+  return valid;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nValues = argc > 1 ? std::stoull(argv[1]) : 10'000'000U;
+
+  std::cout << "Values: " << nValues << ", threads: " << ThreadPool::defaultSize() << "\n";
+
+  bool valid = sortIntegers("random", nValues, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max());
+  valid = sortIntegers("range [-1M, 1M]", nValues, -1'000'000, 1'000'000) && valid;
+  valid = sortStrings(nValues / 10) && valid;
+
+  if (!valid)
+    std::cout << "\nFAIL: sorted results differ\n";
+
+  return valid ? 0 : 1;
+}
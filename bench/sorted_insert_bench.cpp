@@ -0,0 +1,269 @@
+// Measures sorted array inserts and range reads, for the Vector and Blocked layouts, then
+// batch inserts into the Vector layout.
+//
+//  sorted_insert_bench [inserts]
+//
+// Each array is filled to a size, then 'inserts' random values are inserted one at a time,
+// as SIARR_SET. The vector layout is measured with the same lower bound and rotate as
+// Array::set(). Range reads get 1000 values from random positions, as SIARR_GET_RNG.
+//
+// Batch inserts, as SIARR_SET_RNG, compare the previous sort then rotate loop with sortItems()
+// then mergeInto(), and mergeInto() alone for pre-sorted items. A copy of the items into the
+// spare capacity is the lower bound. Times are the best of several runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrBlocks.h>
+#include <core/arr/ArrSort.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+static const std::size_t RangeSize = 1000U;
+static const int Runs = 3;
+
+
+static std::vector<std::int64_t> createValues (const std::size_t size, std::mt19937_64& rng)
+{
+  std::uniform_int_distribution<std::int64_t> dist;
+
+  std::vector<std::int64_t> values(size);
+  std::generate(values.begin(), values.end(), [&]{ return dist(rng); });
+  return values;
+}
+
+
+static double measure (const std::function<void()>& setup, const std::function<void()>& run, const int runs = Runs)
+{
+  double best = 0;
+
+  for (int i = 0 ; i < runs ; ++i)
+  {
+    setup();
+
+    const auto start = Clock::now();
+    run();
+    const auto us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+    best = i == 0 ? us : std::min(best, us);
+  }
+
+  return best;
+}
+
+
+// SIARR_SET_RNG before mergeInto()
+static void rotateMerge (std::vector<std::int64_t>& array, std::size_t& used, std::vector<std::int64_t>& items)
+{
+  std::sort(std::begin(items), std::end(items));
+
+  auto itLast = std::next(array.begin(), used);
+  auto itItem = items.begin();
+  const auto itItemsEnd = items.end();
+  auto itLowerBound = std::lower_bound(array.begin(), itLast, *itItem);
+
+  while (itLowerBound != itLast && itItem != itItemsEnd)
+  {
+    auto appended = 0;
+    for (auto i = used; *itItem <= *itLowerBound && itItem != items.end(); ++itItem)
+    {
+      array[i++] = *itItem;
+      ++appended;
+    }
+
+    used += appended;
+    std::rotate(itLowerBound, itLast, std::next(itLast, appended));
+
+    if (itItem != itItemsEnd)
+    {
+      std::advance(itLast, appended);
+      std::advance(itLowerBound, appended);
+      itLowerBound = std::lower_bound(itLowerBound, itLast, *itItem);
+    }
+  }
+
+  std::copy(itItem, itItemsEnd, std::next(std::begin(array), used));
+  used += std::distance(itItem, itItemsEnd);
+}
+
+
+static bool measureBatches (std::mt19937_64& rng)
+{
+  std::cout << "\nBatch inserts (ms)\n\n";
+
+  std::cout << std::left << std::setw(10) << "Size"
+                         << std::setw(10) << "Batch"
+                         << std::setw(12) << "Rotate"
+                         << std::setw(12) << "Sort+merge"
+                         << std::setw(12) << "Merge"
+                         << std::setw(12) << "Copy"
+                         << std::setw(12) << "std::sort"
+                         << std::setw(12) << "sortItems"
+                         << "\n";
+
+  bool valid = true;
+
+  for (const auto& [size, batch] : std::initializer_list<std::pair<std::size_t, std::size_t>>{{100'000U, 10'000U}, {1'000'000U, 10'000U}, {1'000'000U, 100'000U}})
+  {
+    auto initial = createValues(size, rng);
+    std::sort(initial.begin(), initial.end());
+
+    const auto unsorted = createValues(batch, rng);
+    auto sorted = unsorted;
+    std::sort(sorted.begin(), sorted.end());
+
+    std::vector<std::int64_t> array, items, expected;
+    std::size_t used = 0;
+
+    auto reset = [&](const std::vector<std::int64_t>& batchItems)
+    {
+      array.assign(size + batch, 0);
+      std::copy(initial.cbegin(), initial.cend(), array.begin());
+      used = size;
+      items = batchItems;
+    };
+
+    // the rotate loop is slow enough that one run is sufficient
+    const auto rotate = measure([&]{ reset(unsorted); }, [&]{ rotateMerge(array, used, items); }, 1);
+    expected = array;
+
+    const auto sortMerge = measure([&]{ reset(unsorted); }, [&]{ sortItems(items); mergeInto(array, used, items); });
+    valid = valid && array == expected;
+
+    const auto merge = measure([&]{ reset(sorted); }, [&]{ mergeInto(array, used, items); });
+    valid = valid && array == expected;
+
+    const auto copy = measure([&]{ reset(sorted); }, [&]{ std::copy(items.cbegin(), items.cend(), std::next(array.begin(), used)); });
+    const auto stdSort = measure([&]{ items = unsorted; }, [&]{ std::sort(items.begin(), items.end()); });
+    const auto parallelSort = measure([&]{ items = unsorted; }, [&]{ sortItems(items); });
+    valid = valid && items == sorted;
+
+    std::cout << std::left << std::fixed << std::setprecision(2)
+              << std::setw(10) << size
+              << std::setw(10) << batch
+              << std::setw(12) << rotate / 1000
+              << std::setw(12) << sortMerge / 1000
+              << std::setw(12) << merge / 1000
+              << std::setw(12) << copy / 1000
+              << std::setw(12) << stdSort / 1000
+              << std::setw(12) << parallelSort / 1000
+              << "\n";
+  }
+
+  return valid;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nInserts = argc > 1 ? std::stoull(argv[1]) : 10'000U;
+
+  std::mt19937_64 rng{1987};
+  
+  std::cout << "Inserts: " << nInserts << ", leaf capacity: " << SortedBlocks<std::int64_t>::LeafCapacity << "\n\n";
+
+  std::cout << std::left << std::setw(10) << "Size"
+                         << std::setw(18) << "Vector insert"
+                         << std::setw(18) << "Blocked insert"
+                         << std::setw(10) << "Speedup"
+                         << std::setw(18) << "Vector range"
+                         << std::setw(18) << "Blocked range"
+                         << "\n";
+  std::cout << std::setw(10) << "" << std::setw(18) << "(ns/insert)" << std::setw(18) << "(ns/insert)"
+            << std::setw(10) << "" << std::setw(18) << "(ns/range)" << std::setw(18) << "(ns/range)" << "\n";
+
+  bool valid = true;
+
+  for (const std::size_t size : {1'000U, 10'000U, 100'000U, 1'000'000U, 4'000'000U})
+  {
+    auto initial = createValues(size, rng);
+    std::sort(initial.begin(), initial.end());
+
+    const auto inserts = createValues(nInserts, rng);
+
+    std::vector<std::int64_t> vector;
+    SortedBlocks<std::int64_t> blocks;
+
+    const auto vectorInsert = measure([&]
+    {
+      // capacity for all inserts, as Array
+      vector.assign(size + nInserts, 0);
+      std::copy(initial.cbegin(), initial.cend(), vector.begin());
+    },
+    [&]
+    {
+      auto used = size;
+
+      for (const auto value : inserts)
+      {
+        vector[used] = value;
+
+        const auto itLast = std::next(vector.begin(), used);
+        std::rotate(std::lower_bound(vector.begin(), itLast, value), itLast, std::next(itLast, 1));
+        ++used;
+      }
+    });
+
+    const auto blockedInsert = measure([&]
+    {
+      blocks.clear();
+      blocks.append(std::vector<std::int64_t>{initial});
+    },
+    [&]
+    {
+      for (const auto value : inserts)
+        blocks.insert(value);
+    });
+
+
+    // same contents, check then read ranges
+    std::vector<std::int64_t> read;
+    read.reserve(size + nInserts);
+    blocks.forEach(0, blocks.size(), [&read](const auto v){ read.push_back(v); });
+    valid = valid && read == vector;
+
+    std::uniform_int_distribution<std::size_t> startDist {0, size + nInserts - RangeSize};
+    std::vector<std::size_t> starts(1000);
+    std::generate(starts.begin(), starts.end(), [&]{ return startDist(rng); });
+
+    std::int64_t sum = 0;
+
+    const auto vectorRange = measure([]{}, [&]
+    {
+      for (const auto start : starts)
+        std::for_each(std::next(vector.cbegin(), start), std::next(vector.cbegin(), start + RangeSize), [&sum](const auto v){ sum += v; });
+    });
+
+    const auto blockedRange = measure([]{}, [&]
+    {
+      for (const auto start : starts)
+        blocks.forEach(start, start + RangeSize, [&sum](const auto v){ sum += v; });
+    });
+
+    std::cout << std::left << std::fixed << std::setprecision(0)
+              << std::setw(10) << size
+              << std::setw(18) << vectorInsert * 1000 / nInserts
+              << std::setw(18) << blockedInsert * 1000 / nInserts
+              << std::setprecision(1) << std::setw(10) << vectorInsert / blockedInsert
+              << std::setprecision(0)
+              << std::setw(18) << vectorRange * 1000 / starts.size()
+              << std::setw(18) << blockedRange * 1000 / starts.size()
+              << (sum == 0 ? " " : "") << "\n";
+  }
+
+  valid = measureBatches(rng) && valid;
+
+  if (!valid)
+    std::cout << "\nFAIL: the layouts or merges differ\n";
+
+  return valid ? 0 : 1;
+}
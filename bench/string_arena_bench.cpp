@@ -0,0 +1,246 @@
+// Compares string arrays' Vector layout, std::vector<std::string>, with the Arena layout, StringArena:
+// memory, sorted inserts, batch inserts, lower bound and intersect.
+//
+//  string_arena_bench [strings] [inserts]
+//
+// Two sets of strings, each 6 to 40 lowercase letters:
+//  - random: keys (the first 8 bytes) almost always differ, the best case for the arena
+//  - shared prefix: all begin "customer:", so keys are equal and every comparison reads the arena
+//
+// Vector memory is the vector's capacity plus the heap allocation of each string beyond the SSO
+// limit, as reported by malloc_usable_size() plus the allocator's 8 byte header. Inserts are one
+// at a time, as SSTRARR_SET, into an array of 'inserts' strings. A batch insert sorts then
+// merges, the arena sorting its entries rather than the strings. Intersect is of two arrays
+// which share half of their strings, as SSTRARR_INTERSECT, including converting the result to
+// strings. Times are the best of several runs.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <core/arr/ArrSetOps.h>
+#include <core/arr/ArrStrings.h>
+
+
+using namespace nemesis::arr;
+using Clock = std::chrono::steady_clock;
+
+
+static const int Runs = 3;
+static const std::size_t Lookups = 200'000U;
+
+
+static std::vector<std::string> createStrings (const std::size_t n, const std::string& prefix, std::mt19937_64& rng)
+{
+  std::uniform_int_distribution<std::size_t> length{6, 40};
+  std::uniform_int_distribution<int> letter{'a', 'z'};
+
+  std::vector<std::string> strings(n);
+
+  for (auto& s : strings)
+  {
+    s = prefix;
+    for (auto i = length(rng) ; i > 0 ; --i)
+      s.push_back(static_cast<char>(letter(rng)));
+  }
+
+  return strings;
+}
+
+
+static std::size_t vectorMemory (const std::vector<std::string>& strings)
+{
+  std::size_t bytes = strings.capacity() * sizeof(std::string);
+
+  for (const auto& s : strings)
+  {
+    if (s.capacity() > 15)
+      bytes += malloc_usable_size(const_cast<char *>(s.data())) + 8;
+  }
+
+  return bytes;
+}
+
+
+static double measure (const std::function<void()>& setup, const std::function<void()>& run)
+{
+  double best = 0;
+
+  for (int i = 0 ; i < Runs ; ++i)
+  {
+    setup();
+
+    const auto start = Clock::now();
+    run();
+    const auto ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    best = i == 0 ? ms : std::min(best, ms);
+  }
+
+  return best;
+}
+
+
+static void row (const std::string_view name, const double vector, const double arena, const std::string_view unit)
+{
+  std::cout << std::left << std::fixed << std::setprecision(1)
+            << std::setw(28) << name
+            << std::setw(14) << vector
+            << std::setw(14) << arena
+            << std::setprecision(2) << vector / arena << "x  (" << unit << ")\n";
+}
+
+
+// false if any result differs
+static bool run (const std::string_view dataset, const std::string& prefix, const std::size_t nStrings, const std::size_t nInserts)
+{
+  std::mt19937_64 rng{1987};
+  bool valid = true;
+
+  auto strings = createStrings(nStrings, prefix, rng);
+
+  std::cout << "\n" << dataset << "\n" << std::left << std::setw(28) << "" << std::setw(14) << "vector" << std::setw(14) << "arena" << "vector/arena\n";
+
+  // memory, as unsorted arrays
+  {
+    StringArena arena{strings.size()};
+    for (std::size_t i = 0 ; i < strings.size() ; ++i)
+      arena.set(i, strings[i]);
+
+    row("memory", vectorMemory(strings) / (1024.0 * 1024.0), arena.memory() / (1024.0 * 1024.0), "MiB");
+  }
+
+  // sorted inserts, one at a time
+  {
+    const auto items = std::vector<std::string>(strings.begin(), std::next(strings.begin(), nInserts));
+    std::vector<std::string> vector;
+    StringArena arena;
+
+    const auto vectorMs = measure([&]{ vector.assign(nInserts, std::string{}); }, [&]
+    {
+      for (std::size_t used = 0 ; used < items.size() ; ++used)
+      {
+        vector[used] = items[used];
+        const auto itLast = std::next(vector.begin(), used);
+        std::rotate(std::lower_bound(vector.begin(), itLast, items[used]), itLast, std::next(itLast));
+      }
+    });
+
+    const auto arenaMs = measure([&]{ arena = StringArena{nInserts}; }, [&]
+    {
+      for (std::size_t used = 0 ; used < items.size() ; ++used)
+        arena.insert(arena.lowerBound(used, items[used]), used, items[used]);
+    });
+
+    for (std::size_t i = 0 ; i < nInserts ; ++i)
+      valid = valid && vector[i] == arena.get(i);
+
+    row("sorted inserts", vectorMs, arenaMs, "ms");
+  }
+
+  // batch insert: sort then merge into an empty array, as SSTRARR_SET_RNG
+  std::vector<std::string> sorted;
+  StringArena arena;
+  {
+    std::vector<std::string> items;
+
+    const auto vectorMs = measure([&]{ items = strings; sorted.assign(strings.size(), std::string{}); }, [&]
+    {
+      std::sort(items.begin(), items.end());
+      std::move(items.begin(), items.end(), sorted.begin());
+    });
+
+    // the arena sorts its entries, the strings are unsorted
+    const auto arenaMs = measure([&]{ items = strings; arena = StringArena{strings.size()}; }, [&]
+    {
+      arena.merge(0, items);
+    });
+
+    row("batch insert", vectorMs, arenaMs, "ms");
+  }
+
+  // lower bound
+  {
+    const auto targets = createStrings(Lookups, prefix, rng);
+    std::size_t vectorSum = 0, arenaSum = 0;
+
+    const auto vectorMs = measure([&]{ vectorSum = 0; }, [&]
+    {
+      for (const auto& s : targets)
+        vectorSum += std::distance(sorted.begin(), std::lower_bound(sorted.begin(), sorted.end(), s));
+    });
+
+    const auto arenaMs = measure([&]{ arenaSum = 0; }, [&]
+    {
+      for (const auto& s : targets)
+        arenaSum += arena.lowerBound(strings.size(), s);
+    });
+
+    valid = valid && vectorSum == arenaSum;
+    row("lower bound", vectorMs, arenaMs, "ms");
+  }
+
+  // intersect with an array sharing half of the strings
+  {
+    auto others = createStrings(strings.size() / 2, prefix, rng);
+    others.insert(others.end(), std::next(strings.begin(), strings.size() / 2), strings.end());
+    std::sort(others.begin(), others.end());
+
+    StringArena otherArena{others.size()};
+    otherArena.merge(0, others);
+
+    std::vector<std::string> vectorResult, arenaResult;
+
+    const auto vectorMs = measure([]{}, [&]
+    {
+      vectorResult = setops::apply<std::string>(setops::Operation::Intersect, {std::span<const std::string>{sorted}, std::span<const std::string>{others}});
+    });
+
+    const auto arenaMs = measure([]{}, [&]
+    {
+      std::vector<StringRef> a, b;
+      a.reserve(sorted.size());
+      b.reserve(others.size());
+
+      for (std::size_t i = 0 ; i < sorted.size() ; ++i)
+        a.push_back(arena.ref(i));
+
+      for (std::size_t i = 0 ; i < others.size() ; ++i)
+        b.push_back(otherArena.ref(i));
+
+      const auto result = setops::apply<StringRef>(setops::Operation::Intersect, {std::span<const StringRef>{a}, std::span<const StringRef>{b}});
+
+      arenaResult.clear();
+      for (const auto& s : result)
+        arenaResult.push_back(s.str());
+    });
+
+    valid = valid && vectorResult == arenaResult;
+    row("intersect", vectorMs, arenaMs, "ms");
+  }
+
+  return valid;
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nStrings = argc > 1 ? std::stoull(argv[1]) : 1'000'000U;
+  const std::size_t nInserts = argc > 2 ? std::stoull(argv[2]) : 50'000U;
+
+  std::cout << "Strings: " << nStrings << ", inserts: " << nInserts << ", lookups: " << Lookups << "\n";
+
+  bool valid = run("random", "", nStrings, std::min(nInserts, nStrings));
+  valid = run("shared prefix", "customer:", nStrings, std::min(nInserts, nStrings)) && valid;
+
+  if (!valid)
+    std::cout << "\nFAIL: arena results differ\n";
+
+  return valid ? 0 : 1;
+}
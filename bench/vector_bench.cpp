@@ -0,0 +1,191 @@
+// Measures VEC_SEARCH: queries per second of brute force top-k search, float32 and int8, and the
+// recall of int8 compared with float32.
+//
+//  vector_bench [vectors] [dimensions] [queries]
+//
+// Float32 results are checked against a plain loop in double, with a full sort. The kernels add in a
+// different order, so near ties can swap: the check is recall, which should be (almost) 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include <core/ThreadPool.h>
+#include <core/vec/VecCollection.h>
+
+
+using namespace nemesis;
+using namespace nemesis::vec;
+using Clock = std::chrono::steady_clock;
+
+
+static const std::size_t K = 10U;
+
+
+// the ids of the k best by cosine, in double
+static std::vector<std::uint64_t> plainSearch (const std::vector<float>& values, const std::size_t dimensions, const std::span<const float> query)
+{
+  const auto n = values.size() / dimensions;
+
+  auto norm = [](const std::span<const float> v)
+  {
+    double total = 0;
+    for (const auto value : v)
+      total += double{value} * value;
+    return std::sqrt(total);
+  };
+
+  std::vector<std::pair<double, std::uint64_t>> scores;
+  scores.reserve(n);
+
+  for (std::size_t id = 0 ; id < n ; ++id)
+  {
+    const auto vector = std::span{values}.subspan(id * dimensions, dimensions);
+
+    double dot = 0;
+    for (std::size_t i = 0 ; i < dimensions ; ++i)
+      dot += double{query[i]} * vector[i];
+
+    scores.emplace_back(-dot / (norm(query) * norm(vector)), id);
+  }
+
+  std::partial_sort(scores.begin(), std::next(scores.begin(), K), scores.end());
+
+  std::vector<std::uint64_t> ids;
+  for (std::size_t i = 0 ; i < K ; ++i)
+    ids.push_back(scores[i].second);
+
+  return ids;
+}
+
+
+// fraction of 'expected' in 'matches'
+static double recall (const std::vector<Match>& matches, const std::vector<std::uint64_t>& expected)
+{
+  const auto found = std::count_if(expected.cbegin(), expected.cend(), [&matches](const std::uint64_t id)
+  {
+    return std::any_of(matches.cbegin(), matches.cend(), [id](const Match& m){ return m.id == id; });
+  });
+
+  return static_cast<double>(found) / expected.size();
+}
+
+
+// as VecHandler::search(), split by blocks across the pool then merged
+static std::vector<Match> poolSearch (ThreadPool& pool, const Snapshot& snapshot, const std::span<const float> query)
+{
+  const auto nBlocks = snapshot.blocks.size();
+  const auto nTasks = std::min(nBlocks, pool.size());
+
+  std::vector<std::vector<Match>> partials(nTasks);
+  std::vector<std::future<void>> done;
+
+  for (std::size_t task = 0, start = 0 ; task < nTasks ; ++task)
+  {
+    const auto stop = start + nBlocks / nTasks + (task < nBlocks % nTasks ? 1 : 0);
+    done.push_back(pool.submit([&, task, start, stop]{ partials[task] = search(snapshot, start, stop, query, Metric::Cosine, K); }));
+    start = stop;
+  }
+
+  for (auto& f : done)
+    f.get();
+
+  return merge(partials, K);
+}
+
+
+int main (int argc, char ** argv)
+{
+  const std::size_t nVectors = argc > 1 ? std::stoull(argv[1]) : 100'000U;
+  const std::size_t dimensions = argc > 2 ? std::stoull(argv[2]) : 128U;
+  const std::size_t nQueries = argc > 3 ? std::stoull(argv[3]) : 100U;
+
+  // clustered data, which is closer to embeddings than uniform noise, so int8 recall is meaningful
+  std::mt19937_64 rng{1987};
+  std::normal_distribution<float> noise{0.0f, 0.3f};
+  std::vector<float> centres(64 * dimensions);
+  std::generate(centres.begin(), centres.end(), [&]{ return noise(rng) / 0.3f; });
+
+  auto makeVector = [&](std::vector<float>& out)
+  {
+    const auto centre = rng() % 64;
+    for (std::size_t i = 0 ; i < dimensions ; ++i)
+      out.push_back(centres[centre * dimensions + i] + noise(rng));
+  };
+
+  std::vector<float> values, queries;
+  values.reserve(nVectors * dimensions);
+
+  for (std::size_t i = 0 ; i < nVectors ; ++i)
+    makeVector(values);
+
+  for (std::size_t i = 0 ; i < nQueries ; ++i)
+    makeVector(queries);
+
+  Collection floats{dimensions, Quantization::None}, codes{dimensions, Quantization::Int8};
+
+  for (std::size_t id = 0 ; id < nVectors ; ++id)
+  {
+    floats.add(std::span{values}.subspan(id * dimensions, dimensions));
+    codes.add(std::span{values}.subspan(id * dimensions, dimensions));
+  }
+
+  std::vector<std::vector<std::uint64_t>> expected;
+  for (std::size_t q = 0 ; q < nQueries ; ++q)
+    expected.push_back(plainSearch(values, dimensions, std::span{queries}.subspan(q * dimensions, dimensions)));
+
+
+  std::cout << "Kernels: " << dist::DistKernels.name << ", vectors: " << nVectors << ", dimensions: " << dimensions
+            << ", queries: " << nQueries << ", k: " << K << "\n\n";
+
+  std::cout << std::left << std::setw(24) << "Search" << std::setw(12) << "QPS" << std::setw(12) << "recall@10" << "\n";
+
+  bool valid = true;
+
+  auto row = [&](const std::string_view name, const std::function<std::vector<Match>(std::span<const float>)>& run, const bool check)
+  {
+    double totalRecall = 0;
+
+    const auto start = Clock::now();
+
+    for (std::size_t q = 0 ; q < nQueries ; ++q)
+      totalRecall += recall(run(std::span{queries}.subspan(q * dimensions, dimensions)), expected[q]);
+
+    const auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const auto meanRecall = totalRecall / nQueries;
+
+    valid = valid && (!check || meanRecall >= 0.99);
+
+    std::cout << std::left << std::fixed << std::setprecision(3)
+              << std::setw(24) << name
+              << std::setw(12) << std::setprecision(1) << nQueries / seconds
+              << std::setw(12) << std::setprecision(3) << meanRecall << "\n";
+  };
+
+  const auto floatSnapshot = floats.snapshot();
+  const auto codeSnapshot = codes.snapshot();
+
+  row("float32", [&](auto query){ return search(floatSnapshot, 0, floatSnapshot.blocks.size(), query, Metric::Cosine, K); }, true);
+  row("int8", [&](auto query){ return search(codeSnapshot, 0, codeSnapshot.blocks.size(), query, Metric::Cosine, K); }, false);
+
+  {
+    ThreadPool pool;
+    const auto name = "float32, " + std::to_string(pool.size()) + " threads";
+    row(name, [&](auto query){ return poolSearch(pool, floatSnapshot, query); }, true);
+  }
+
+  std::cout << "\nMemory: float32 " << nVectors * dimensions * sizeof(float) / (1024 * 1024) << " MiB, int8 "
+            << nVectors * (dimensions + sizeof(float)) / (1024 * 1024) << " MiB\n";
+
+  if (!valid)
+    std::cout << "\nFAIL: float32 recall is below 0.99\n";
+
+  return valid ? 0 : 1;
+}
@@ -1,20 +1,40 @@
 #ifndef _NDB_CACHEMAP_
 #define _NDB_CACHEMAP_
 
+#include <memory>
 #include <ankerl/unordered_dense.h>
+#include <jsoncons_ext/cbor/cbor.hpp>
 #include <core/NemesisCommon.h>
+#include <core/MmapSnapshot.h>
 
 
 namespace nemesis { 
 
 
+/*
+Keys can also be in a memory mapped snapshot (attach()), loaded in the background by
+prefetch() or when first accessed. A mapped key is moved to the map when it's read, overwritten
+or removed, after which the mapped entry is ignored ("consumed"). When all are consumed, the
+snapshot is unmapped.
+*/
 class CacheMap
 {
   using Map = ankerl::unordered_dense::segmented_map<cachedkey, cachedvalue>;
   using CacheMapIterator = Map::iterator;
   using CacheMapConstIterator = Map::const_iterator;
+  using KeySet = ankerl::unordered_dense::set<cachedkey>;
 
 public:
+
+  // Keys changed since tracking started or the previous takeChanges(), used for delta saves
+  struct Changes
+  {
+    KeySet changed;   // set or added, and still exist
+    KeySet removed;
+    bool cleared{false};  // all keys removed, so a delta isn't possible
+
+    std::size_t size() const noexcept { return changed.size() + removed.size(); }
+  };
   
   CacheMap& operator=(CacheMap&&) = default; // required by Map::erase()
   CacheMap(CacheMap&&) = default;
@@ -30,14 +50,31 @@ public:
 
   void set (cachedkey key, cachedvalue value)
   {
+    if (m_tracking)
+      changed(key);
+
+    if (m_mapped)
+      consume(key);
+
     m_map.insert_or_assign(std::move(key), std::move(value));
   }
 
 
-  std::optional<std::reference_wrapper<const cachedvalue>> get (const cachedkey& key) const
+  // Not const: a mapped value is decoded and moved to the map
+  std::optional<std::reference_wrapper<const cachedvalue>> get (const cachedkey& key)
   {
     if (const auto it = m_map.find(key) ; it != m_map.cend())
       return {it->second};
+    else if (const auto slot = mappedSlot(key); slot)
+    {
+      const auto record = m_mapped->record(*slot);
+      auto value = jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{record.value.data(), record.value.size()});
+
+      // not a change, so not tracked
+      const auto [inserted, _] = m_map.insert_or_assign(key, std::move(value));
+      consume(*slot);
+      return {inserted->second};
+    }
 
     return {};
   };
@@ -45,24 +82,40 @@ public:
 
   void add (cachedkey key, cachedvalue value)
   {
-    m_map.try_emplace(std::move(key), std::move(value));
+    if (m_mapped && mappedSlot(key))
+      return;
+    else if (!m_tracking)
+      m_map.try_emplace(std::move(key), std::move(value));
+    else if (const auto [it, inserted] = m_map.try_emplace(key, std::move(value)); inserted)
+      changed(std::move(key));
   }
 
 
   void remove (const cachedkey& key)
   {
-    m_map.erase(key);
+    const bool erased = m_map.erase(key);
+    const bool consumed = m_mapped && consume(key);
+
+    if ((erased || consumed) && m_tracking)
+    {
+      m_changes.changed.erase(key);
+      m_changes.removed.insert(key);
+    }
   };
 
   
   std::tuple<bool, std::size_t> clear()
   {
-    auto size = m_map.size();
+    auto size = count();
     bool valid = true;
 
     try
     {
+      detach();
       m_map.replace(Map::value_container_type{});
+
+      if (m_tracking)
+        m_changes = Changes{.cleared = true};
     }
     catch (...)
     {
@@ -76,13 +129,19 @@ public:
 
   std::size_t count() const
   {
-    return m_map.size();
+    return m_map.size() + m_mappedRemaining;
+  }
+
+
+  void reserve (const std::size_t n)
+  {
+    m_map.reserve(n);
   }
 
   
   bool contains (const cachedkey& key) const
   {
-    return m_map.contains(key);
+    return m_map.contains(key) || (m_mapped && mappedSlot(key));
   };
 
 
@@ -93,17 +152,177 @@ public:
     for(const auto& it : m_map)
       keys.emplace_back(it.first);
 
+    forEachMapped([&keys](const std::string_view key, const std::span<const std::uint8_t>)
+    {
+      keys.emplace_back(key);
+    });
+
     return keys;
   }
 
 
+  // The map must be empty. Keys in the snapshot are visible immediately.
+  void attach (std::unique_ptr<snapshot::MmapSnapshot> mapped)
+  {
+    m_mapped = std::move(mapped);
+    m_consumed.assign(m_mapped->nSlots(), false);
+    m_mappedRemaining = m_mapped->nKeys();
+    m_prefetchSlot = 0;
+    m_map.reserve(m_mappedRemaining);
+
+    if (m_mappedRemaining == 0)
+      detach();
+  }
+
+
+  bool isMapped () const noexcept
+  {
+    return m_mapped != nullptr;
+  }
+
+
+  // Decodes up to 'n' mapped keys into the map. Returns true if mapped keys remain.
+  // A record which fails its checksum is dropped.
+  bool prefetch (const std::size_t n)
+  {
+    static const std::size_t ReadAhead = 4096U;
+
+    if (!m_mapped)
+      return false;
+
+    for (std::size_t decoded = 0 ; decoded < n && m_mapped && m_prefetchSlot < m_consumed.size() ; ++m_prefetchSlot)
+    {
+      if (m_prefetchSlot % ReadAhead == 0)
+        m_mapped->willNeed(m_prefetchSlot, m_prefetchSlot + ReadAhead);
+
+      if (const auto slot = m_prefetchSlot; m_mapped->isUsed(slot) && !m_consumed[slot])
+      {
+        try
+        {
+          const auto record = m_mapped->record(slot);
+          m_map.try_emplace(cachedkey{record.key}, jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{record.value.data(), record.value.size()}));
+        }
+        catch (const std::exception& ex)
+        {
+          PLOGE << "Mapped snapshot: " << ex.what();
+        }
+
+        consume(slot);  // can detach
+        ++decoded;
+      }
+    }
+
+    return m_mapped != nullptr;
+  }
+
+
+  // Calls f(key, CBOR value) for each mapped key which is not in the map
+  template<typename F>
+  void forEachMapped (F&& f) const
+  {
+    if (!m_mapped)
+      return;
+
+    for (std::size_t slot = 0 ; slot < m_consumed.size() ; ++slot)
+    {
+      if (m_mapped->isUsed(slot) && !m_consumed[slot])
+      {
+        const auto record = m_mapped->record(slot);
+        f(record.key, record.value);
+      }
+    }
+  }
+
+
   const Map& map () const
   {
     return m_map;
   }
 
+
+  // Tracking has a cost for each write, so it's only enabled when delta saves are used
+  void startTracking ()
+  {
+    m_tracking = true;
+    m_changes = Changes{};
+  }
+
+
+  bool isTracking () const noexcept
+  {
+    return m_tracking;
+  }
+
+
+  const Changes& changes () const noexcept
+  {
+    return m_changes;
+  }
+
+
+  // Returns changes since the previous call and starts a new set
+  Changes takeChanges ()
+  {
+    return std::exchange(m_changes, Changes{});
+  }
+
+
+private:
+
+  void changed (cachedkey key)
+  {
+    m_changes.removed.erase(key);
+    m_changes.changed.insert(std::move(key));
+  }
+
+
+  std::optional<std::size_t> mappedSlot (const std::string_view key) const
+  {
+    if (const auto slot = m_mapped->find(key); slot && !m_consumed[*slot])
+      return slot;
+
+    return std::nullopt;
+  }
+
+
+  // Returns true if the key was mapped and not already consumed
+  bool consume (const std::string_view key)
+  {
+    if (const auto slot = mappedSlot(key); slot)
+    {
+      consume(*slot);
+      return true;
+    }
+    return false;
+  }
+
+
+  void consume (const std::size_t slot)
+  {
+    m_consumed[slot] = true;
+
+    if (--m_mappedRemaining == 0)
+      detach();
+  }
+
+
+  void detach ()
+  {
+    m_mapped.reset();
+    m_consumed = std::vector<bool>{};
+    m_mappedRemaining = 0;
+    m_prefetchSlot = 0;
+  }
+
+
 private:
   Map m_map;
+  Changes m_changes;
+  bool m_tracking{false};
+  std::unique_ptr<snapshot::MmapSnapshot> m_mapped;
+  std::vector<bool> m_consumed;   // by slot
+  std::size_t m_mappedRemaining{0};
+  std::size_t m_prefetchSlot{0};
 };
 
 } // ns nemesis
@@ -0,0 +1,690 @@
+#ifndef NDB_CORE_CLUSTER_H
+#define NDB_CORE_CLUSTER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <jsoncons_ext/cbor/cbor.hpp>
+#include <core/NemesisCommon.h>
+#include <core/NemesisConfig.h>
+#include <core/Replication.h>
+#include <core/kv/KvCommands.h>
+
+
+/*
+Cluster mode: the keyspace is split into 16384 hash slots, each owned by one node. A key's
+slot is the CRC16 of the key, or of its hash tag: the part between the first '{' and the next
+'}', if not empty. Keys with the same tag are in the same slot. This is the same as Redis
+Cluster, so existing client libraries can compute slots.
+
+Only keys are partitioned. Arrays and lists are local to the node they're created on.
+
+A KV command for keys in slots owned by another node is not executed, its response has:
+
+  Moved:      the keys are owned by "node" (slot is the first key's slot)
+  CrossSlot:  the keys are owned by more than one node
+  Ask:        the slot is migrating to "node" and the keys are no longer here. Send this
+              request to "node", but don't update the slot map
+  TryAgain:   the slot is migrating and only some of the keys have moved
+
+Commands which don't have keys (KV_COUNT, KV_KEYS, KV_CLEAR, KV_SAVE, KV_LOAD) apply to the
+node's own keys.
+
+
+Migration moves a slot to another node. The source connects to the target's bus port then,
+once per event loop iteration, scans part of the map for keys in the slot, sends a batch and
+waits for the target to apply it, then removes the batch. Keys are always in exactly one node
+when a request is handled. The slot is assigned to the target when all keys are moved.
+
+Ownership changes are not written to the config. Other nodes are told with SV_CLUSTER_SETSLOT,
+otherwise they redirect to the previous owner, which redirects to the new owner.
+
+  Bus message:  a replication frame (Replication.h), with 'seq' as the slot and a CBOR KV_SET
+                request as payload (Keys only)
+  Ack:          u64 1, sent by the target when the message is applied
+*/
+
+
+namespace nemesis { namespace cluster {
+
+  namespace kvCmds = nemesis::kv::cmds;
+
+
+  inline constexpr std::uint16_t NoNode = 0xFFFF;
+
+
+  enum class BusMessage : std::uint32_t
+  {
+    Import = 1, // the slot is being migrated to the receiver
+    Keys,       // a batch of keys in the slot
+    SlotDone    // all keys sent, the receiver now owns the slot
+  };
+
+
+  // CRC16-CCITT (XMODEM), as Redis Cluster
+  inline std::uint16_t crc16 (const std::string_view data) noexcept
+  {
+    static const auto Table = []
+    {
+      std::array<std::uint16_t, 256> table{};
+
+      for (std::uint16_t i = 0 ; i < 256U ; ++i)
+      {
+        std::uint16_t crc = static_cast<std::uint16_t>(i << 8U);
+
+        for (int bit = 0 ; bit < 8 ; ++bit)
+          crc = static_cast<std::uint16_t>(crc & 0x8000U ? (crc << 1U) ^ 0x1021U : crc << 1U);
+
+        table[i] = crc;
+      }
+
+      return table;
+    }();
+
+    std::uint16_t crc = 0;
+
+    for (const auto c : data)
+      crc = static_cast<std::uint16_t>((crc << 8U) ^ Table[((crc >> 8U) ^ static_cast<std::uint8_t>(c)) & 0xFFU]);
+
+    return crc;
+  }
+
+
+  inline std::uint16_t keySlot (std::string_view key) noexcept
+  {
+    if (const auto open = key.find('{'); open != std::string_view::npos)
+    {
+      if (const auto close = key.find('}', open + 1U); close != std::string_view::npos && close > open + 1U)
+        key = key.substr(open + 1U, close - open - 1U);
+    }
+
+    return static_cast<std::uint16_t>(crc16(key) % ClusterSlotCount);
+  }
+
+
+  struct Route
+  {
+    RequestStatus status{RequestStatus::Ok};
+    std::uint16_t slot{0};
+    std::string node;
+  };
+
+
+  class Cluster
+  {
+    struct Node
+    {
+      std::string ip;
+      int port;
+      int busPort;
+      std::string address;  // ip:port, as in responses
+    };
+
+
+    // a connection from a node migrating a slot to this node
+    struct BusConnection
+    {
+      explicit BusConnection(const int fd) : fd(fd)
+      {
+      }
+
+      ~BusConnection()
+      {
+        ::shutdown(fd, SHUT_RDWR);  // unblocks recv()
+        receiver = std::jthread{};
+        ::close(fd);
+      }
+
+      int fd;
+      std::atomic_bool dead{false};
+      std::jthread receiver;
+    };
+
+
+    struct Received
+    {
+      std::shared_ptr<BusConnection> connection;
+      BusMessage type;
+      std::uint16_t slot;
+      njson request;
+    };
+
+
+    struct Migration
+    {
+      std::uint16_t slot;
+      std::uint16_t target;
+      int fd{-1};
+      std::size_t cursor{std::numeric_limits<std::size_t>::max()};
+      std::size_t moved{0};
+      chrono::steady_clock::time_point start;
+    };
+
+    static constexpr std::size_t BatchKeys = 1024U;     // per event loop iteration
+    static constexpr std::size_t BatchScan = 65536U;    // map positions checked per iteration
+    static constexpr int BusTimeoutMs = 5000;
+
+  public:
+    using Write = std::function<Response(const std::string&, njson&)>;
+    // See KvHandler::scanKeys()
+    using Scan = std::function<std::size_t(std::size_t cursor, const std::function<bool(std::string_view)>& include, njson& keys, std::size_t maxKeys, std::size_t maxScan)>;
+    using Contains = std::function<bool(const std::string&)>;
+
+
+    Cluster(const ClusterSettings& settings, const std::string& selfIp, const int selfPort, replication::Wake wake) :
+      m_owner(ClusterSlotCount, NoNode),
+      m_importing(ClusterSlotCount, false),
+      m_wake(std::move(wake))
+    {
+      for (const auto& node : settings.nodes)
+      {
+        const auto index = static_cast<std::uint16_t>(m_nodes.size());
+
+        m_nodes.emplace_back(Node{.ip = node.ip, .port = node.port, .busPort = node.busPort, .address = node.ip + ":" + std::to_string(node.port)});
+
+        if (node.ip == selfIp && node.port == selfPort)
+          m_self = index;
+
+        for (const auto& [start, end] : node.slots)
+          std::fill(m_owner.begin() + start, m_owner.begin() + end + 1U, index);
+      }
+    }
+
+    Cluster(const Cluster&) = delete;
+    Cluster& operator=(const Cluster&) = delete;
+
+
+    ~Cluster()
+    {
+      if (m_listenFd >= 0)
+        ::shutdown(m_listenFd, SHUT_RDWR);
+
+      m_acceptThread = std::jthread{};
+
+      if (m_listenFd >= 0)
+        ::close(m_listenFd);
+
+      if (m_migration)
+        ::close(m_migration->fd);
+
+      // destroyed without the lock, each joins its receiver, which may be waiting for the lock
+      std::vector<std::shared_ptr<BusConnection>> connections;
+      {
+        std::scoped_lock lck{m_busMux};
+        m_received.clear();
+        connections.swap(m_connections);
+      }
+    }
+
+
+    bool start ()
+    {
+      const auto& self = m_nodes[m_self];
+
+      m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+      const int one = 1;
+      ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)); // a hot restart binds before this process closes
+
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      addr.sin_port = htons(static_cast<std::uint16_t>(self.busPort));
+
+      if (m_listenFd < 0 || ::bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(m_listenFd, 16) != 0)
+      {
+        PLOGE << "Cluster: failed to listen on bus port " << self.busPort << ": " << std::strerror(errno);
+        return false;
+      }
+
+      m_acceptThread = std::jthread{[this](std::stop_token stop){ accept(stop); }};
+
+      PLOGI << "Cluster: " << m_nodes.size() << " nodes, " << std::ranges::count(m_owner, m_self) << " slots owned, bus port " << self.busPort;
+      return true;
+    }
+
+
+    // Checks the request's keys are owned by this node
+    Route route (const std::string& command, const njson& body, const Contains& contains) const
+    {
+      const bool isObject = command == kvCmds::SetReq || command == kvCmds::AddReq || command == kvCmds::ClearSetReq;
+      const bool isArray = command == kvCmds::GetReq || command == kvCmds::RmvReq || command == kvCmds::ContainsReq;
+
+      if ((!isObject && !isArray) || !body.contains("keys"))
+        return Route{};
+
+      std::uint16_t foreignOwner = NoNode;
+      std::uint16_t foreignSlot = 0;
+      bool multipleOwners = false, local = false;
+      std::size_t migratingPresent = 0, migratingAbsent = 0;
+
+      auto check = [&](const std::string& key)
+      {
+        const auto slot = keySlot(key);
+
+        if (const auto owner = m_owner[slot]; owner == m_self)
+        {
+          if (m_migration && m_migration->slot == slot)
+            ++(contains(key) ? migratingPresent : migratingAbsent);
+          else
+            local = true;
+        }
+        else if (m_importing[slot])
+          local = true;
+        else if (foreignOwner == NoNode)
+        {
+          foreignOwner = owner;
+          foreignSlot = slot;
+        }
+        else if (owner != foreignOwner)
+          multipleOwners = true;
+      };
+
+      // invalid types are left to the command's validation
+      if (const auto& keys = body.at("keys"); isObject && keys.is_object())
+      {
+        for (const auto& member : keys.object_range())
+          check(member.key());
+      }
+      else if (isArray && keys.is_array())
+      {
+        for (const auto& key : keys.array_range())
+        {
+          if (key.is_string())
+            check(key.as_string());
+        }
+      }
+
+      const bool migrating = migratingPresent || migratingAbsent;
+
+      if (foreignOwner != NoNode)
+      {
+        if (multipleOwners || local || migrating)
+          return Route{.status = RequestStatus::CrossSlot};
+        else
+          return Route{.status = RequestStatus::Moved, .slot = foreignSlot, .node = m_nodes[foreignOwner].address};
+      }
+      else if (migratingAbsent)
+      {
+        if (migratingPresent)
+          return Route{.status = RequestStatus::TryAgain};
+        else if (local)
+          return Route{.status = RequestStatus::CrossSlot};
+        else
+          return Route{.status = RequestStatus::Ask, .slot = m_migration->slot, .node = m_nodes[m_migration->target].address};
+      }
+      else
+        return Route{};
+    }
+
+
+    njson slots () const
+    {
+      njson slots = njson::make_array();
+
+      for (std::size_t start = 0 ; start < ClusterSlotCount ; )
+      {
+        auto end = start;
+
+        while (end + 1U < ClusterSlotCount && m_owner[end + 1U] == m_owner[start])
+          ++end;
+
+        slots.push_back(njson{jsoncons::json_object_arg, {{"start", start}, {"end", end}, {"node", m_nodes[m_owner[start]].address}}});
+        start = end + 1U;
+      }
+
+      njson body;
+      body["st"] = toUnderlying(RequestStatus::Ok);
+      body["self"] = m_nodes[m_self].address;
+      body["slots"] = std::move(slots);
+
+      if (m_migration)
+      {
+        body["migrating"] = njson{jsoncons::json_object_arg, {{"slot", m_migration->slot},
+                                                              {"node", m_nodes[m_migration->target].address},
+                                                              {"moved", m_migration->moved}}};
+      }
+
+      body["importing"] = njson::make_array();
+      for (std::size_t slot = 0 ; slot < ClusterSlotCount ; ++slot)
+      {
+        if (m_importing[slot])
+          body["importing"].push_back(slot);
+      }
+
+      return body;
+    }
+
+
+    // Assigns a slot, i.e. to tell this node of a completed migration between other nodes
+    RequestStatus setSlot (const std::size_t slot, const std::string_view address)
+    {
+      if (slot >= ClusterSlotCount)
+        return RequestStatus::Bounds;
+      else if (const auto node = find(address); !node)
+        return RequestStatus::NotExist;
+      else if (m_importing[slot] || (m_migration && m_migration->slot == slot))
+        return RequestStatus::TryAgain;
+      else
+      {
+        m_owner[slot] = *node;
+        return RequestStatus::Ok;
+      }
+    }
+
+
+    // Starts migrating a slot this node owns. Completes in the background, see poll().
+    RequestStatus migrate (const std::size_t slot, const std::string_view address)
+    {
+      if (slot >= ClusterSlotCount)
+        return RequestStatus::Bounds;
+      else if (m_migration)
+        return RequestStatus::TryAgain; // one at a time
+      else if (m_owner[slot] != m_self)
+        return RequestStatus::Moved;
+      else if (const auto node = find(address); !node || *node == m_self)
+        return RequestStatus::NotExist;
+      else if (const int fd = connect(m_nodes[*node]); fd < 0)
+      {
+        PLOGE << "Cluster: could not connect to " << m_nodes[*node].address << " bus port " << m_nodes[*node].busPort;
+        return RequestStatus::Unknown;
+      }
+      else
+      {
+        m_migration = Migration{.slot = static_cast<std::uint16_t>(slot), .target = *node, .fd = fd, .start = chrono::steady_clock::now()};
+
+        // the target must accept requests for the slot before any are redirected to it
+        if (!exchange(BusMessage::Import))
+        {
+          abortMigration();
+          return RequestStatus::Unknown;
+        }
+
+        PLOGI << "Cluster: migrating slot " << slot << " to " << m_nodes[*node].address;
+        m_wake();
+        return RequestStatus::Ok;
+      }
+    }
+
+
+    // Applies messages received from other nodes, then migrates a batch of keys. Returns
+    // true if a migration is in progress, so the loop should be woken.
+    bool poll (const Write& write, const Scan& scan)
+    {
+      applyReceived(write);
+
+      if (!m_migration)
+        return false;
+
+      njson keys = njson::object();
+      const auto slot = m_migration->slot;
+      m_migration->cursor = scan(m_migration->cursor, [slot](const std::string_view key){ return keySlot(key) == slot; }, keys, BatchKeys, BatchScan);
+
+      if (!keys.empty())
+      {
+        njson request;
+        request[kvCmds::SetReq]["keys"] = keys;
+
+        std::vector<std::uint8_t> payload;
+        jsoncons::cbor::encode_cbor(request, payload);
+
+        if (!exchange(BusMessage::Keys, payload))
+        {
+          abortMigration();
+          return false;
+        }
+
+        // the target has the keys
+        njson rmv;
+        rmv[kvCmds::RmvReq]["keys"] = njson::make_array();
+
+        for (const auto& member : keys.object_range())
+          rmv[kvCmds::RmvReq]["keys"].push_back(member.key());
+
+        write(kvCmds::RmvReq, rmv);
+        m_migration->moved += keys.size();
+      }
+
+      if (m_migration->cursor == 0)
+      {
+        if (!exchange(BusMessage::SlotDone))
+        {
+          abortMigration();
+          return false;
+        }
+
+        PLOGI << "Cluster: migrated slot " << m_migration->slot << " to " << m_nodes[m_migration->target].address << ", "
+              << m_migration->moved << " keys in " << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - m_migration->start).count() << "ms";
+
+        m_owner[m_migration->slot] = m_migration->target;
+        ::close(m_migration->fd);
+        m_migration.reset();
+        return false;
+      }
+
+      return true;
+    }
+
+
+  private:
+
+    std::optional<std::uint16_t> find (const std::string_view address) const
+    {
+      for (std::uint16_t i = 0 ; i < m_nodes.size() ; ++i)
+      {
+        if (m_nodes[i].address == address)
+          return i;
+      }
+
+      return std::nullopt;
+    }
+
+
+    static int connect (const Node& node)
+    {
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(static_cast<std::uint16_t>(node.busPort));
+
+      if (::inet_pton(AF_INET, node.ip.c_str(), &addr.sin_addr) != 1)
+        return -1;
+
+      const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+      if (fd < 0)
+        return -1;
+
+      // non-blocking connect, so an unreachable node doesn't block the event loop for long
+      const int flags = ::fcntl(fd, F_GETFL, 0);
+      ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+      bool connected = ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+
+      if (!connected && errno == EINPROGRESS)
+      {
+        pollfd pfd {.fd = fd, .events = POLLOUT, .revents = 0};
+        int error = 0;
+        socklen_t len = sizeof(error);
+
+        connected = ::poll(&pfd, 1, 2000) == 1 && ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+      }
+
+      if (!connected)
+      {
+        ::close(fd);
+        return -1;
+      }
+
+      ::fcntl(fd, F_SETFL, flags);
+
+      const timeval timeout {.tv_sec = BusTimeoutMs / 1000, .tv_usec = 0};
+      ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      replication::setSocketOptions(fd);
+      return fd;
+    }
+
+
+    // Sends a message to the migration target and waits for it to be applied
+    bool exchange (const BusMessage type, const std::span<const std::uint8_t> payload = {})
+    {
+      std::vector<std::uint8_t> frame;
+      replication::appendFrame(frame, type, m_migration->slot, payload);
+
+      std::uint64_t ack = 0;
+
+      if (!replication::sendAll(m_migration->fd, frame.data(), frame.size()) ||
+          !replication::recvAll(m_migration->fd, reinterpret_cast<std::uint8_t *>(&ack), sizeof(ack)) ||
+          ack != 1U)
+      {
+        PLOGE << "Cluster: migration of slot " << m_migration->slot << " to " << m_nodes[m_migration->target].address << " failed";
+        return false;
+      }
+
+      return true;
+    }
+
+
+    // Keys already moved remain on the target, the migration can be started again
+    void abortMigration ()
+    {
+      ::close(m_migration->fd);
+      m_migration.reset();
+    }
+
+
+    void accept (std::stop_token stop)
+    {
+      while (!stop.stop_requested())
+      {
+        if (const int fd = ::accept(m_listenFd, nullptr, nullptr); fd < 0)
+        {
+          if (errno != EINTR && errno != ECONNABORTED)
+            break;
+        }
+        else
+        {
+          replication::setSocketOptions(fd);
+
+          auto connection = std::make_shared<BusConnection>(fd);
+
+          // started with the lock held, so the receiver finds the connection in m_connections
+          std::scoped_lock lck{m_busMux};
+          std::erase_if(m_connections, [](const auto& c){ return c->dead.load(); });
+          connection->receiver = std::jthread{[this, c = connection.get()](std::stop_token stop){ receive(*c, stop); }};
+          m_connections.emplace_back(std::move(connection));
+        }
+      }
+    }
+
+
+    // A bus connection's receiver thread
+    void receive (BusConnection& connection, std::stop_token stop)
+    {
+      std::vector<std::uint8_t> payload;
+
+      while (!stop.stop_requested())
+      {
+        replication::FrameHeader header;
+
+        if (!replication::recvAll(connection.fd, reinterpret_cast<std::uint8_t *>(&header), sizeof(header)))
+          break;
+
+        payload.resize(header.size);
+
+        if (!replication::recvAll(connection.fd, payload.data(), payload.size()) ||
+            snapshot::crc32c(payload.data(), payload.size()) != header.crc ||
+            header.seq >= ClusterSlotCount)
+          break;
+
+        Received received {.type = static_cast<BusMessage>(header.type), .slot = static_cast<std::uint16_t>(header.seq)};
+
+        if (!payload.empty())
+          received.request = jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{payload.data(), payload.size()});
+
+        {
+          std::scoped_lock lck{m_busMux};
+
+          for (const auto& c : m_connections)
+          {
+            if (c.get() == &connection)
+              received.connection = c;
+          }
+
+          m_received.emplace_back(std::move(received));
+        }
+
+        m_wake();
+      }
+
+      connection.dead = true;
+    }
+
+
+    void applyReceived (const Write& write)
+    {
+      std::deque<Received> received;
+      {
+        std::scoped_lock lck{m_busMux};
+        received.swap(m_received);
+      }
+
+      for (auto& message : received)
+      {
+        switch (message.type)
+        {
+          case BusMessage::Import:
+            PLOGI << "Cluster: importing slot " << message.slot;
+            m_importing[message.slot] = true;
+          break;
+
+          case BusMessage::Keys:
+            m_importing[message.slot] = true;
+            write(kvCmds::SetReq, message.request);
+          break;
+
+          case BusMessage::SlotDone:
+            PLOGI << "Cluster: imported slot " << message.slot;
+            m_importing[message.slot] = false;
+            m_owner[message.slot] = m_self;
+          break;
+        }
+
+        if (const std::uint64_t ack = 1; message.connection)
+          replication::sendAll(message.connection->fd, reinterpret_cast<const std::uint8_t *>(&ack), sizeof(ack));
+      }
+    }
+
+
+  private:
+    std::vector<Node> m_nodes;
+    std::uint16_t m_self{0};
+    std::vector<std::uint16_t> m_owner;  // node by slot
+    std::vector<bool> m_importing;       // by slot
+    std::optional<Migration> m_migration;
+    replication::Wake m_wake;
+    int m_listenFd{-1};
+    std::mutex m_busMux;
+    std::vector<std::shared_ptr<BusConnection>> m_connections;
+    std::deque<Received> m_received;
+    std::jthread m_acceptThread;
+  };
+
+}
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef NDB_CORE_COMPRESSION_H
+#define NDB_CORE_COMPRESSION_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <zlib.h>
+
+#ifdef NDB_LZ4
+  #include <lz4.h>
+#endif
+
+
+/*
+Block compression for snapshot files. The codec is recorded in the file header, so files
+written with any codec (or none) can be loaded regardless of the server's config.
+
+  zlib: always available, already linked. Smaller output, slower
+  lz4:  only when the build finds liblz4 (NDB_LZ4 defined). Compresses/decompresses several
+        times faster than zlib, with a lower ratio
+*/
+
+
+namespace nemesis { namespace snapshot {
+
+
+  enum class Codec : std::uint16_t
+  {
+    None = 0,
+    Zlib = 1,
+    Lz4 = 2
+  };
+
+
+  inline constexpr int ZlibLevel = Z_BEST_SPEED; // saves are bound by time more than disk space
+
+
+  inline bool isAvailable (const Codec codec) noexcept
+  {
+    switch (codec)
+    {
+      case Codec::None:
+      case Codec::Zlib:
+        return true;
+
+      case Codec::Lz4:
+        #ifdef NDB_LZ4
+          return true;
+        #else
+          return false;
+        #endif
+
+      default:
+        return false;
+    }
+  }
+
+
+  inline std::optional<Codec> toCodec (const std::string_view name) noexcept
+  {
+    if (name == "none")
+      return Codec::None;
+    else if (name == "zlib")
+      return Codec::Zlib;
+    else if (name == "lz4")
+      return Codec::Lz4;
+    else
+      return std::nullopt;
+  }
+
+
+  inline std::string_view toString (const Codec codec) noexcept
+  {
+    switch (codec)
+    {
+      case Codec::Zlib: return "zlib";
+      case Codec::Lz4:  return "lz4";
+      default:          return "none";
+    }
+  }
+
+
+  // Replaces the content of 'out'. Throws on failure.
+  inline void compress (const Codec codec, const std::span<const std::uint8_t> in, std::vector<std::uint8_t>& out)
+  {
+    switch (codec)
+    {
+      case Codec::Zlib:
+      {
+        uLongf size = ::compressBound(static_cast<uLong>(in.size()));
+        out.resize(size);
+
+        if (::compress2(out.data(), &size, in.data(), static_cast<uLong>(in.size()), ZlibLevel) != Z_OK)
+          throw std::runtime_error{"zlib compress failed"};
+
+        out.resize(size);
+      }
+      break;
+
+      #ifdef NDB_LZ4
+      case Codec::Lz4:
+      {
+        out.resize(static_cast<std::size_t>(::LZ4_compressBound(static_cast<int>(in.size()))));
+
+        const int size = ::LZ4_compress_default(reinterpret_cast<const char *>(in.data()), reinterpret_cast<char *>(out.data()),
+                                                static_cast<int>(in.size()), static_cast<int>(out.size()));
+        if (size <= 0)
+          throw std::runtime_error{"lz4 compress failed"};
+
+        out.resize(static_cast<std::size_t>(size));
+      }
+      break;
+      #endif
+
+      case Codec::None:
+        out.assign(in.begin(), in.end());
+      break;
+
+      default:
+        throw std::runtime_error{"Compression codec unavailable"};
+    }
+  }
+
+
+  // 'rawSize' is the uncompressed size, which is stored with the block. Replaces the content of 'out'. Throws on failure.
+  inline void decompress (const Codec codec, const std::span<const std::uint8_t> in, const std::size_t rawSize, std::vector<std::uint8_t>& out)
+  {
+    out.resize(rawSize);
+
+    switch (codec)
+    {
+      case Codec::Zlib:
+      {
+        uLongf size = static_cast<uLongf>(rawSize);
+
+        if (::uncompress(out.data(), &size, in.data(), static_cast<uLong>(in.size())) != Z_OK || size != rawSize)
+          throw std::runtime_error{"zlib decompress failed"};
+      }
+      break;
+
+      #ifdef NDB_LZ4
+      case Codec::Lz4:
+      {
+        const int size = ::LZ4_decompress_safe( reinterpret_cast<const char *>(in.data()), reinterpret_cast<char *>(out.data()),
+                                                static_cast<int>(in.size()), static_cast<int>(rawSize));
+        if (size < 0 || static_cast<std::size_t>(size) != rawSize)
+          throw std::runtime_error{"lz4 decompress failed"};
+      }
+      break;
+      #endif
+
+      case Codec::None:
+        if (in.size() != rawSize)
+          throw std::runtime_error{"Block size mismatch"};
+
+        out.assign(in.begin(), in.end());
+      break;
+
+      default:
+        throw std::runtime_error{"Compression codec unavailable"};
+    }
+  }
+
+}
+}
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef NDB_CORE_FORKTASK_H
+#define NDB_CORE_FORKTASK_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace nemesis {
+
+
+/*
+Runs a function in a child process created with fork().
+
+The child has a copy-on-write copy of the parent's memory at the time of the fork, so
+it sees a point-in-time snapshot of the data whilst the parent continues serving clients.
+The cost to the parent is:
+
+  - fork() itself, which copies the page tables (forkDuration)
+  - a minor page fault each time the parent writes to a page that is still shared
+    with the child (minorFaults)
+
+Both are recorded. Faults are measured for the calling thread only (the event loop)
+from the fork until the child is reaped.
+
+Progress is reported through a MAP_SHARED anonymous mapping, which parent and child
+both see. The child must not log: plog's mutex may have been held by another thread
+at the time of the fork. Instead, a task returns false on failure, and an exception
+which escapes it is recorded in Progress, for the parent to log with error().
+*/
+class ForkTask
+{
+public:
+
+  enum class State
+  {
+    None,     // never started
+    Running,
+    Complete,
+    Error
+  };
+
+
+  struct Progress
+  {
+    std::atomic_uint64_t done{0};
+    std::atomic_uint64_t total{0};
+    std::array<char, 256> error{}; // null terminated, read by the parent after the child exits
+
+    void setError (const std::string_view msg) noexcept
+    {
+      const auto size = std::min(msg.size(), error.size() - 1);
+      std::copy_n(msg.data(), size, error.data());
+      error[size] = '\0';
+    }
+  };
+
+  static_assert(std::atomic_uint64_t::is_always_lock_free); // required in shared memory
+
+
+  using Task = std::function<bool(Progress&)>;
+  using Clock = std::chrono::steady_clock;
+
+
+  ForkTask()
+  {
+    if (void * p = ::mmap(nullptr, sizeof(Progress), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0); p != MAP_FAILED)
+      m_progress = new (p) Progress{};
+  }
+
+  ForkTask(const ForkTask&) = delete;
+  ForkTask& operator=(const ForkTask&) = delete;
+
+
+  ~ForkTask()
+  {
+    // a running child is not waited for, it finishes its task independently
+
+    if (m_progress)
+      ::munmap(m_progress, sizeof(Progress));
+  }
+
+
+  // Returns false if a task is running or fork() fails
+  bool start (Task task, const std::uint64_t total)
+  {
+    if (!m_progress || poll() == State::Running)
+      return false;
+
+    m_progress->done = 0;
+    m_progress->total = total;
+    m_progress->error[0] = '\0';
+
+    const auto faults = minorFaults();
+    const auto forkStart = Clock::now();
+
+    if (const pid_t pid = ::fork(); pid < 0)
+      return false;
+    else if (pid == 0)
+    {
+      // child
+      bool success = false;
+
+      try
+      {
+        success = task(*m_progress);
+      }
+      catch (const std::exception& ex)
+      {
+        m_progress->setError(ex.what());
+        success = false;
+      }
+      catch (...)
+      {
+        success = false;
+      }
+
+      ::_exit(success ? 0 : 1); // no atexit handlers or static destructors
+    }
+    else
+    {
+      m_forkDuration = Clock::now() - forkStart;
+      m_start = forkStart;
+      m_end = {};
+      m_faultsAtStart = faults;
+      m_faults = 0;
+      m_pid = pid;
+      m_state = State::Running;
+      return true;
+    }
+  }
+
+
+  // Reaps the child if it has exited
+  State poll ()
+  {
+    if (m_state == State::Running)
+    {
+      int wstatus = 0;
+
+      if (const pid_t pid = ::waitpid(m_pid, &wstatus, WNOHANG); pid == m_pid)
+      {
+        m_state = WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == 0 ? State::Complete : State::Error;
+        m_end = Clock::now();
+        m_faults = minorFaults() - m_faultsAtStart;
+        m_pid = 0;
+      }
+      else if (pid < 0)
+      {
+        m_state = State::Error; // child lost
+        m_end = Clock::now();
+        m_pid = 0;
+      }
+    }
+
+    return m_state;
+  }
+
+
+  State state() const noexcept { return m_state; }
+
+  std::uint64_t done() const noexcept { return m_progress ? m_progress->done.load() : 0U; }
+
+  std::uint64_t total() const noexcept { return m_progress ? m_progress->total.load() : 0U; }
+
+  // the exception which ended the task, if any. Valid once the child has been reaped.
+  std::string_view error() const noexcept
+  {
+    return m_progress && m_state != State::Running ? std::string_view{m_progress->error.data()} : std::string_view{};
+  }
+
+  Clock::duration forkDuration() const noexcept { return m_forkDuration; }
+
+  // running: time since started
+  Clock::duration duration() const noexcept
+  {
+    return m_state == State::Running ? Clock::now() - m_start : m_end - m_start;
+  }
+
+  // running: faults since started
+  std::uint64_t pageFaults() const noexcept
+  {
+    return m_state == State::Running ? minorFaults() - m_faultsAtStart : m_faults;
+  }
+
+
+private:
+
+  static std::uint64_t minorFaults() noexcept
+  {
+    rusage usage{};
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return static_cast<std::uint64_t>(usage.ru_minflt);
+  }
+
+
+private:
+  Progress * m_progress{nullptr};
+  State m_state{State::None};
+  pid_t m_pid{0};
+  Clock::time_point m_start{};
+  Clock::time_point m_end{};
+  Clock::duration m_forkDuration{};
+  std::uint64_t m_faultsAtStart{0};
+  std::uint64_t m_faults{0};
+};
+
+}
+
+#endif
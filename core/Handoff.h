@@ -0,0 +1,567 @@
+#ifndef NDB_CORE_HANDOFF_H
+#define NDB_CORE_HANDOFF_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <core/NemesisCommon.h>
+#include <core/ForkTask.h>
+#include <core/Replication.h>
+
+
+/*
+Hot restart: a new server process takes over from a running one, i.e. to upgrade the binary,
+without a save and startup load.
+
+The running server (Source) listens on an abstract Unix socket named by its query port. The new
+process (Target), started with --handoff:
+
+  1. connects and sends Request
+  2. the source forks and the child writes the data to a directory in /dev/shm (POSIX shared
+     memory): keys in the memory mapped layout, arrays and lists as snapshot files. The source
+     continues serving clients, successful writes are queued
+  3. the source sends Ready then the queued writes, then writes as they happen
+  4. the target maps the keys (values are decoded on access or in the background), loads arrays
+     and lists, applies writes, then listens on the query port with SO_REUSEPORT (the uWS default)
+     and sends Listening. Its event loop isn't running, so new connections wait in the backlog
+  5. the source closes its listen socket and clients, sends remaining writes then Done, and exits
+  6. the target applies the remaining writes and starts its event loop
+
+Clients are unavailable from step 5 to 6, which doesn't depend on the size of the data. They
+must reconnect.
+
+  Message: a replication frame (Replication.h), 'seq' is the write's sequence number
+*/
+
+
+namespace nemesis { namespace handoff {
+
+
+  enum class Message : std::uint32_t
+  {
+    Request = 1,
+    Ready,      // shm directory written
+    Write,      // payload is a CBOR request
+    Listening,  // target is listening on the query port
+    Done        // source has stopped
+  };
+
+
+  inline std::string socketName (const int port)
+  {
+    // abstract namespace: leading null byte, no file, removed when closed
+    return std::string{'\0'} + "nemesisdb-handoff-" + std::to_string(port);
+  }
+
+
+  inline fs::path shmDir (const int port)
+  {
+    return fs::path{"/dev/shm"} / ("nemesisdb-handoff-" + std::to_string(port));
+  }
+
+
+  inline sockaddr_un socketAddress (const int port, socklen_t& len)
+  {
+    const auto name = socketName(port);
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::copy(name.cbegin(), name.cend(), addr.sun_path);
+    len = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + name.size());
+    return addr;
+  }
+
+
+  inline bool sendMessage (const int fd, const Message type, const std::uint64_t seq = 0)
+  {
+    std::vector<std::uint8_t> frame;
+    replication::appendFrame(frame, type, seq);
+    return replication::sendAll(fd, frame.data(), frame.size());
+  }
+
+
+  inline std::optional<replication::FrameHeader> receiveHeader (const int fd)
+  {
+    replication::FrameHeader header;
+
+    if (!replication::recvAll(fd, reinterpret_cast<std::uint8_t *>(&header), sizeof(header)))
+      return std::nullopt;
+
+    return header;
+  }
+
+
+
+  // The running server. All functions are called on the event loop thread.
+  class Source
+  {
+    enum class State
+    {
+      Idle,
+      Snapshot,   // child writing the shm directory
+      Streaming,  // waiting for the target to listen
+      Done
+    };
+
+    // writes queued for a slow target
+    static const std::size_t MaxQueuedBytes = 256U * 1024U * 1024U;
+
+  public:
+    using Save = std::function<bool(const fs::path&, ForkTask::Progress&)>;
+
+    enum class Action
+    {
+      None,
+      StopServing   // close listen sockets and clients, then call finish()
+    };
+
+
+    Source(const int port, replication::Wake wake) : m_port(port), m_wake(std::move(wake))
+    {
+    }
+
+    Source(const Source&) = delete;
+    Source& operator=(const Source&) = delete;
+
+
+    ~Source()
+    {
+      m_watchThread = std::jthread{};
+
+      if (m_listenFd >= 0)
+        ::close(m_listenFd);
+
+      if (m_state != State::Done)
+        abort();
+
+      if (const int fd = m_accepted.exchange(-1); fd >= 0)
+        ::close(fd);
+    }
+
+
+    bool start ()
+    {
+      socklen_t len = 0;
+      const auto addr = socketAddress(m_port, len);
+
+      m_listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+      if (m_listenFd < 0 || ::bind(m_listenFd, reinterpret_cast<const sockaddr *>(&addr), len) != 0 || ::listen(m_listenFd, 1) != 0)
+      {
+        PLOGE << "Handoff: failed to listen: " << std::strerror(errno);
+        return false;
+      }
+
+      m_watchThread = std::jthread{[this](std::stop_token stop){ watch(stop); }};
+      return true;
+    }
+
+
+    bool isActive () const noexcept
+    {
+      return m_state != State::Idle;
+    }
+
+
+    // A successful write request, sent to the target
+    void append (const replication::Record& record)
+    {
+      if (m_state == State::Snapshot || m_state == State::Streaming)
+        replication::appendFrame(m_buffer, Message::Write, ++m_seq, record);
+    }
+
+
+    Action poll (const Save& save)
+    {
+      switch (m_state)
+      {
+        case State::Idle:
+          if (const int fd = m_accepted.exchange(-1); fd >= 0)
+            startSnapshot(fd, save);
+        break;
+
+        case State::Snapshot:
+          if (const auto state = m_snapshot.poll(); state == ForkTask::State::Complete)
+          {
+            PLOGI << "Handoff: data written to " << shmDir(m_port) << " in " << chrono::duration_cast<chrono::milliseconds>(m_snapshot.duration()).count() << "ms";
+
+            if (!sendMessage(m_fd, Message::Ready))
+              abort();
+            else
+              m_state = State::Streaming;
+          }
+          else if (state == ForkTask::State::Error)
+          {
+            PLOGE << "Handoff: failed to write data" << (m_snapshot.error().empty() ? "" : ": ") << m_snapshot.error();
+            abort();
+          }
+          else if (m_buffer.size() > MaxQueuedBytes)
+            abort();
+        break;
+
+        case State::Streaming:
+          if (!flush(false) || m_buffer.size() > MaxQueuedBytes)
+            abort();
+          else if (isListening())
+            return Action::StopServing;
+        break;
+
+        case State::Done:
+        break;
+      }
+
+      return Action::None;
+    }
+
+
+    // Sends remaining writes and Done. The target owns the port, so this process should exit.
+    bool finish ()
+    {
+      replication::appendFrame(m_buffer, Message::Done, m_seq);
+
+      const bool sent = flush(true);
+
+      m_active = false;
+      m_watchFd = -1;
+      ::close(m_fd);
+      m_fd = -1;
+      m_state = State::Done;
+
+      if (sent)
+        PLOGI << "Handoff: complete, " << m_seq << " writes sent";
+      else
+        PLOGE << "Handoff: failed to send the final writes";
+
+      return sent;
+    }
+
+
+  private:
+
+    // Accepts the target. During a handoff, wakes the event loop periodically to poll the
+    // snapshot, and immediately when the target sends Listening.
+    void watch (std::stop_token stop)
+    {
+      static const int IdleMs = 100, ActiveMs = 10;
+
+      while (!stop.stop_requested())
+      {
+        const bool active = m_active.load(std::memory_order_acquire);
+
+        std::array<pollfd, 2> fds {pollfd{.fd = m_listenFd, .events = POLLIN, .revents = 0},
+                                   pollfd{.fd = m_watchFd.load(), .events = POLLIN, .revents = 0}};
+
+        const int n = ::poll(fds.data(), fds[1].fd >= 0 ? 2 : 1, active ? ActiveMs : IdleMs);
+
+        if (fds[0].revents & POLLIN)
+          accept();
+
+        if (active || n > 0)
+          m_wake();
+      }
+    }
+
+
+    void accept ()
+    {
+      // reads and writes are on the event loop thread, so must not block for long
+      const timeval timeout {.tv_sec = 1, .tv_usec = 0};
+
+      if (const int fd = ::accept(m_listenFd, nullptr, nullptr); fd < 0)
+        return;
+      else if (!isSameUser(fd))
+        ::close(fd);  // abstract sockets have no file permissions
+      else
+      {
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        if (int expected = -1; !m_accepted.compare_exchange_strong(expected, fd))
+          ::close(fd);  // one at a time
+      }
+    }
+
+
+    static bool isSameUser (const int fd)
+    {
+      ucred cred{};
+      socklen_t len = sizeof(cred);
+      return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0 && cred.uid == ::geteuid();
+    }
+
+
+    void startSnapshot (const int fd, const Save& save)
+    {
+      // Request is sent immediately after connecting
+      if (const auto header = receiveHeader(fd); !header || header->type != static_cast<std::uint32_t>(Message::Request))
+      {
+        ::close(fd);
+        return;
+      }
+
+      m_fd = fd;
+      m_state = State::Snapshot;
+
+      const auto dir = shmDir(m_port);
+
+      try
+      {
+        fs::remove_all(dir);
+      }
+      catch (const std::exception& ex)
+      {
+        PLOGE << "Handoff: " << ex.what();
+        abort();
+        return;
+      }
+
+      if (!m_snapshot.start([save, dir](ForkTask::Progress& progress){ return save(dir, progress); }, 0))
+      {
+        PLOGE << "Handoff: failed to start";
+        abort();
+      }
+      else
+      {
+        PLOGI << "Handoff: started, fork: " << chrono::duration_cast<chrono::microseconds>(m_snapshot.forkDuration()).count() << "us";
+        m_seq = 0;
+        m_buffer.clear();
+        m_sent = 0;
+        m_watchFd = m_fd;
+        m_active.store(true, std::memory_order_release);
+      }
+    }
+
+
+    // Sends queued writes. Unless 'wait', returns when the socket is full.
+    bool flush (const bool wait)
+    {
+      while (m_sent < m_buffer.size())
+      {
+        if (const auto n = ::send(m_fd, m_buffer.data() + m_sent, m_buffer.size() - m_sent, MSG_NOSIGNAL | (wait ? 0 : MSG_DONTWAIT)); n > 0)
+          m_sent += static_cast<std::size_t>(n);
+        else if (n < 0 && errno == EINTR)
+          continue;
+        else if (n < 0 && !wait && (errno == EAGAIN || errno == EWOULDBLOCK))
+          return true;
+        else
+          return false;
+      }
+
+      m_buffer.clear();
+      m_sent = 0;
+      return true;
+    }
+
+
+    bool isListening ()
+    {
+      pollfd pfd {.fd = m_fd, .events = POLLIN, .revents = 0};
+
+      if (::poll(&pfd, 1, 0) != 1)
+        return false;
+      else if (const auto header = receiveHeader(m_fd); header && header->type == static_cast<std::uint32_t>(Message::Listening))
+        return true;
+      else
+      {
+        abort();  // closed or unexpected, target failed
+        return false;
+      }
+    }
+
+
+    // The target has failed or gone, this server continues
+    void abort ()
+    {
+      if (m_state != State::Idle)
+        PLOGW << "Handoff: abandoned";
+
+      m_active = false;
+      m_watchFd = -1;
+
+      if (m_fd >= 0)
+        ::close(m_fd);
+
+      m_fd = -1;
+      m_state = State::Idle;
+      m_buffer.clear();
+      m_sent = 0;
+
+      std::error_code ec;
+      fs::remove_all(shmDir(m_port), ec);
+    }
+
+
+  private:
+    int m_port;
+    replication::Wake m_wake;
+    int m_listenFd{-1};
+    int m_fd{-1};
+    std::atomic_int m_accepted{-1};
+    std::atomic_int m_watchFd{-1};
+    std::atomic_bool m_active{false};
+    State m_state{State::Idle};
+    ForkTask m_snapshot;
+    std::uint64_t m_seq{0};
+    std::vector<std::uint8_t> m_buffer;
+    std::size_t m_sent{0};
+    std::jthread m_watchThread;
+  };
+
+
+
+  // The new process, called on its event loop thread before the loop runs
+  class Target
+  {
+  public:
+    using Load = std::function<bool(const fs::path&)>;
+    using Apply = std::function<void(njson&)>;
+
+
+    explicit Target(const int port) : m_port(port)
+    {
+    }
+
+    Target(const Target&) = delete;
+    Target& operator=(const Target&) = delete;
+
+
+    ~Target()
+    {
+      if (m_fd >= 0)
+        ::close(m_fd);
+
+      std::error_code ec;
+      fs::remove_all(shmDir(m_port), ec);
+    }
+
+
+    // Connects, waits for the source's data then loads it, and applies writes received so far
+    bool receive (const Load& load, const Apply& apply)
+    {
+      socklen_t len = 0;
+      const auto addr = socketAddress(m_port, len);
+
+      m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+      if (m_fd < 0 || ::connect(m_fd, reinterpret_cast<const sockaddr *>(&addr), len) != 0)
+      {
+        PLOGF << "Handoff: no server running on port " << m_port;
+        return false;
+      }
+
+      PLOGI << "Handoff: connected, waiting for data";
+
+      const auto start = NemesisClock::now();
+
+      if (!sendMessage(m_fd, Message::Request))
+        return false;
+      else if (const auto header = receiveHeader(m_fd); !header || header->type != static_cast<std::uint32_t>(Message::Ready))
+      {
+        PLOGF << "Handoff: the running server failed to write its data";
+        return false;
+      }
+
+      try
+      {
+        if (!load(shmDir(m_port)))
+          return false;
+
+        // keys are mapped, the file is released when they're all decoded
+        fs::remove_all(shmDir(m_port));
+      }
+      catch (const std::exception& ex)
+      {
+        PLOGF << "Handoff: " << ex.what();
+        return false;
+      }
+
+      PLOGI << "Handoff: data loaded in " << chrono::duration_cast<chrono::milliseconds>(NemesisClock::now() - start).count() << "ms";
+
+      return applyWrites(apply, false);
+    }
+
+
+    // Tells the source this process is listening, then applies writes until it stops
+    bool takeOver (const Apply& apply)
+    {
+      const auto start = NemesisClock::now();
+
+      if (!sendMessage(m_fd, Message::Listening) || !applyWrites(apply, true))
+        return false;
+
+      PLOGI << "Handoff: took over after " << chrono::duration_cast<chrono::microseconds>(NemesisClock::now() - start).count() << "us, " << m_applied << " writes applied";
+
+      ::close(m_fd);
+      m_fd = -1;
+      return true;
+    }
+
+
+  private:
+
+    // Applies writes until Done if 'untilDone', otherwise until none are waiting
+    bool applyWrites (const Apply& apply, const bool untilDone)
+    {
+      std::vector<std::uint8_t> payload;
+
+      while (true)
+      {
+        if (!untilDone)
+        {
+          pollfd pfd {.fd = m_fd, .events = POLLIN, .revents = 0};
+
+          if (::poll(&pfd, 1, 0) != 1)
+            return true;
+        }
+
+        const auto header = receiveHeader(m_fd);
+
+        if (!header)
+        {
+          PLOGF << "Handoff: connection to the running server lost";
+          return false;
+        }
+        else if (header->type == static_cast<std::uint32_t>(Message::Done))
+          return true;
+        else if (header->type != static_cast<std::uint32_t>(Message::Write))
+          return false;
+
+        payload.resize(header->size);
+
+        if (!replication::recvAll(m_fd, payload.data(), payload.size()) || snapshot::crc32c(payload.data(), payload.size()) != header->crc)
+        {
+          PLOGF << "Handoff: invalid write received";
+          return false;
+        }
+
+        auto request = jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{payload.data(), payload.size()});
+        apply(request);
+        ++m_applied;
+      }
+    }
+
+
+  private:
+    int m_port;
+    int m_fd{-1};
+    std::size_t m_applied{0};
+  };
+
+}
+}
+
+#endif
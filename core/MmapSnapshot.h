@@ -0,0 +1,397 @@
+#ifndef NDB_CORE_MMAPSNAPSHOT_H
+#define NDB_CORE_MMAPSNAPSHOT_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <core/Snapshot.h>
+
+
+/*
+Snapshot layout which is used in place with mmap(), so the server can accept requests
+before values are decoded.
+
+  Header (4096 bytes, only the first 64 used)
+  Values: Record*
+  Index:  Slot[nSlots], 8 byte aligned
+
+  Header: magic[8] ("NDBMMAP\0"), version (u16), flags (u16), reserved (u32),
+          nKeys (u64), nSlots (u64), valuesOffset (u64), indexOffset (u64), indexCrc (u32), reserved (u32, u64)
+
+  Record: keyLen (u32) | valueLen (u32) | crc (u32, CRC32C of key and value) | key bytes | value as CBOR
+  Slot:   hash (u64) | record offset (u64), offset 0 is an empty slot
+
+The index is an open addressing hash table with linear probing, nSlots is a power of 2 and
+at least twice nKeys. The hash is FNV-1a so it doesn't depend on the hash map implementation.
+
+The index checksum is verified when opened. A record's checksum is verified when it is read,
+so a corrupt value is only detected when accessed.
+*/
+
+
+namespace nemesis { namespace snapshot {
+
+
+  inline constexpr std::array<char, 8> MmapMagic {'N','D','B','M','M','A','P','\0'};
+  inline const std::uint16_t MMAP_FORMAT_VERSION = 1;
+
+
+  struct MmapHeader
+  {
+    std::array<char, 8> magic{MmapMagic};
+    std::uint16_t version{MMAP_FORMAT_VERSION};
+    std::uint16_t flags{0};
+    std::uint32_t reserved{0};
+    std::uint64_t nKeys{0};
+    std::uint64_t nSlots{0};
+    std::uint64_t valuesOffset{0};
+    std::uint64_t indexOffset{0};
+    std::uint32_t indexCrc{0};
+    std::uint32_t reserved2{0};
+    std::uint64_t reserved3{0};
+  };
+
+  struct MmapSlot
+  {
+    std::uint64_t hash{0};
+    std::uint64_t offset{0};
+  };
+
+  static_assert(sizeof(MmapHeader) == 64U && sizeof(MmapSlot) == 16U);
+
+  inline constexpr std::size_t MmapHeaderRegion = 4096U;
+  inline constexpr std::size_t MmapRecordHeader = 12U;
+
+
+  inline std::uint64_t fnv1a (const std::string_view s) noexcept
+  {
+    std::uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (const char c : s)
+    {
+      hash ^= static_cast<std::uint8_t>(c);
+      hash *= 0x100000001B3ULL;
+    }
+
+    return hash;
+  }
+
+
+  // Records are written as they're added, the index is written by close(). nKeys is required
+  // to size the index, the number of records added must not exceed it.
+  class MmapWriter
+  {
+  public:
+    MmapWriter(const std::filesystem::path& path, const std::size_t nKeys) :
+      m_stream(path, std::ios_base::binary | std::ios_base::trunc | std::ios_base::out),
+      m_nKeys(nKeys)
+    {
+      if (!m_stream.is_open())
+        throw std::runtime_error{"Could not open snapshot file"};
+
+      std::size_t nSlots = 16U;
+      while (nSlots < nKeys * 2U)
+        nSlots *= 2U;
+
+      m_slots.resize(nSlots);
+      m_buffer.reserve(SnapshotWriter::BlockSize + 64U * 1024U);
+      m_buffer.resize(MmapHeaderRegion); // written again by close()
+      m_offset = MmapHeaderRegion;
+    }
+
+
+    void add (const std::string_view key, const std::span<const std::uint8_t> value)
+    {
+      if (m_nRecords == m_nKeys)
+        throw std::runtime_error{"Snapshot index full"};
+
+      const std::uint32_t keyLen = static_cast<std::uint32_t>(key.size());
+      const std::uint32_t valueLen = static_cast<std::uint32_t>(value.size());
+      std::uint32_t crc = crc32c(reinterpret_cast<const std::uint8_t *>(key.data()), key.size());
+      crc = crc32c(value.data(), value.size(), crc);
+
+      insertSlot(fnv1a(key), m_offset);
+
+      put(&keyLen, sizeof(keyLen));
+      put(&valueLen, sizeof(valueLen));
+      put(&crc, sizeof(crc));
+      put(key.data(), key.size());
+      put(value.data(), value.size());
+
+      m_offset += MmapRecordHeader + key.size() + value.size();
+      ++m_nRecords;
+
+      if (m_buffer.size() >= SnapshotWriter::BlockSize)
+        flush();
+    }
+
+
+    void close ()
+    {
+      // align the index
+      if (const auto pad = (8U - (m_offset % 8U)) % 8U; pad)
+      {
+        const std::uint64_t zero = 0;
+        put(&zero, pad);
+        m_offset += pad;
+      }
+
+      MmapHeader header;
+      header.nKeys = m_nRecords;
+      header.nSlots = m_slots.size();
+      header.valuesOffset = MmapHeaderRegion;
+      header.indexOffset = m_offset;
+      header.indexCrc = crc32c(reinterpret_cast<const std::uint8_t *>(m_slots.data()), m_slots.size() * sizeof(MmapSlot));
+
+      put(m_slots.data(), m_slots.size() * sizeof(MmapSlot));
+      flush();
+
+      // header, the region was reserved by the constructor
+      m_stream.seekp(0);
+      write(&header, sizeof(header));
+
+      m_stream.close();
+
+      if (m_stream.fail())
+        throw std::runtime_error{"Snapshot write failed"};
+    }
+
+
+    std::size_t nRecords() const noexcept { return m_nRecords; }
+
+
+  private:
+
+    void insertSlot (const std::uint64_t hash, const std::uint64_t offset)
+    {
+      const std::size_t mask = m_slots.size() - 1U;
+
+      for (std::size_t i = hash & mask ; ; i = (i + 1U) & mask)
+      {
+        if (m_slots[i].offset == 0)
+        {
+          m_slots[i] = MmapSlot{.hash = hash, .offset = offset};
+          return;
+        }
+      }
+    }
+
+
+    void put (const void * data, const std::size_t size)
+    {
+      const auto * bytes = static_cast<const std::uint8_t *>(data);
+      m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+    }
+
+
+    void flush ()
+    {
+      write(m_buffer.data(), m_buffer.size());
+      m_buffer.clear();
+    }
+
+
+    void write (const void * data, const std::size_t size)
+    {
+      if (!m_stream.write(static_cast<const char *>(data), size))
+        throw std::runtime_error{"Snapshot write failed"};
+    }
+
+
+  private:
+    std::ofstream m_stream;
+    std::vector<MmapSlot> m_slots;
+    std::vector<std::uint8_t> m_buffer;
+    std::size_t m_nKeys;
+    std::size_t m_nRecords{0};
+    std::uint64_t m_offset{0};
+  };
+
+
+
+  // A read-only mapping of a file written by MmapWriter. Pages are read by the kernel
+  // when first accessed.
+  class MmapSnapshot
+  {
+  public:
+    struct Record
+    {
+      std::string_view key;
+      std::span<const std::uint8_t> value;
+    };
+
+
+    MmapSnapshot(const std::filesystem::path& path)
+    {
+      const int fd = ::open(path.c_str(), O_RDONLY);
+
+      if (fd < 0)
+        throw std::runtime_error{"Could not open snapshot file"};
+
+      struct stat st{};
+
+      if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < MmapHeaderRegion)
+      {
+        ::close(fd);
+        throw std::runtime_error{"Snapshot file truncated"};
+      }
+
+      m_size = static_cast<std::size_t>(st.st_size);
+      void * p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd); // the mapping keeps the file open
+
+      if (p == MAP_FAILED)
+        throw std::runtime_error{"Could not map snapshot file"};
+
+      m_data = static_cast<const std::uint8_t *>(p);
+
+      try
+      {
+        validate();
+      }
+      catch (...)
+      {
+        ::munmap(const_cast<std::uint8_t *>(m_data), m_size);
+        throw;
+      }
+
+      // values are accessed randomly by lookups, the index is read now
+      ::madvise(const_cast<std::uint8_t *>(m_data), m_size, MADV_RANDOM);
+    }
+
+    MmapSnapshot(const MmapSnapshot&) = delete;
+    MmapSnapshot& operator=(const MmapSnapshot&) = delete;
+
+
+    ~MmapSnapshot()
+    {
+      ::munmap(const_cast<std::uint8_t *>(m_data), m_size);
+    }
+
+
+    static bool isMmapFile (const std::filesystem::path& path)
+    {
+      std::array<char, 8> magic{};
+      std::ifstream stream{path, std::ios_base::binary | std::ios_base::in};
+      return stream.read(magic.data(), magic.size()) && magic == MmapMagic;
+    }
+
+
+    std::size_t nKeys() const noexcept { return m_header.nKeys; }
+    std::size_t nSlots() const noexcept { return m_header.nSlots; }
+
+
+    bool isUsed (const std::size_t slot) const noexcept
+    {
+      return m_slots[slot].offset != 0;
+    }
+
+
+    std::optional<std::size_t> find (const std::string_view key) const
+    {
+      const auto hash = fnv1a(key);
+      const std::size_t mask = m_header.nSlots - 1U;
+
+      for (std::size_t i = hash & mask ; m_slots[i].offset != 0 ; i = (i + 1U) & mask)
+      {
+        if (m_slots[i].hash == hash && record(i).key == key)
+          return i;
+      }
+
+      return std::nullopt;
+    }
+
+
+    // Throws if the record's checksum is invalid
+    Record record (const std::size_t slot) const
+    {
+      const auto offset = m_slots[slot].offset;
+
+      if (offset + MmapRecordHeader > m_header.indexOffset)
+        throw std::runtime_error{"Snapshot record out of bounds"};
+
+      std::uint32_t keyLen, valueLen, crc;
+      std::memcpy(&keyLen, m_data + offset, 4U);
+      std::memcpy(&valueLen, m_data + offset + 4U, 4U);
+      std::memcpy(&crc, m_data + offset + 8U, 4U);
+
+      const auto * key = m_data + offset + MmapRecordHeader;
+
+      if (offset + MmapRecordHeader + keyLen + valueLen > m_header.indexOffset)
+        throw std::runtime_error{"Snapshot record out of bounds"};
+      else if (crc32c(key, keyLen + valueLen) != crc)
+        throw std::runtime_error{"Snapshot record checksum mismatch"};
+
+      return Record { .key = std::string_view{reinterpret_cast<const char *>(key), keyLen},
+                      .value = std::span<const std::uint8_t>{key + keyLen, valueLen}};
+    }
+
+
+    // Tell the kernel a range of slots will be read soon, used when prefetching
+    void willNeed (const std::size_t firstSlot, const std::size_t lastSlot) const
+    {
+      std::uint64_t min = UINT64_MAX, max = 0;
+
+      for (auto i = firstSlot ; i < lastSlot && i < m_header.nSlots ; ++i)
+      {
+        if (m_slots[i].offset)
+        {
+          min = std::min(min, m_slots[i].offset);
+          max = std::max(max, m_slots[i].offset);
+        }
+      }
+
+      if (min < max)
+      {
+        const auto page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+        const auto start = min & ~(page - 1U);
+        ::madvise(const_cast<std::uint8_t *>(m_data) + start, std::min<std::uint64_t>(max + page, m_header.indexOffset) - start, MADV_WILLNEED);
+      }
+    }
+
+
+  private:
+
+    void validate ()
+    {
+      std::memcpy(&m_header, m_data, sizeof(m_header));
+
+      if (m_header.magic != MmapMagic)
+        throw std::runtime_error{"Not a snapshot file"};
+      else if (m_header.version != MMAP_FORMAT_VERSION)
+        throw std::runtime_error{"Unsupported snapshot version"};
+      else if ( m_header.nSlots == 0 || (m_header.nSlots & (m_header.nSlots - 1U)) != 0 ||
+                m_header.indexOffset % 8U != 0 ||
+                m_header.indexOffset + m_header.nSlots * sizeof(MmapSlot) != m_size)
+        throw std::runtime_error{"Snapshot file invalid"};
+
+      m_slots = reinterpret_cast<const MmapSlot *>(m_data + m_header.indexOffset);
+
+      if (crc32c(reinterpret_cast<const std::uint8_t *>(m_slots), m_header.nSlots * sizeof(MmapSlot)) != m_header.indexCrc)
+        throw std::runtime_error{"Snapshot index checksum mismatch"};
+    }
+
+
+  private:
+    const std::uint8_t * m_data{nullptr};
+    const MmapSlot * m_slots{nullptr};
+    std::size_t m_size{0};
+    MmapHeader m_header;
+  };
+
+}
+}
+
+#endif
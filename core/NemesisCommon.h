@@ -68,11 +68,19 @@ namespace nemesis {
     SaveComplete          = 120,
     SaveDirWriteFail,
     SaveError,
+    SaveStarted           = 125,
+    SaveInProgress,
     Loading               = 140,
     LoadComplete,
     LoadError,
     Duplicate             = 160,
     Bounds                = 161,
+    ReadOnly              = 170,
+    Moved                 = 171,
+    Ask                   = 172,
+    CrossSlot             = 173,
+    TryAgain              = 174,
+    WalWriteFail          = 180,
     Unknown               = 1000
   };
 
@@ -91,6 +99,7 @@ namespace nemesis {
   const JsonType JsonBool = JsonType::bool_value;
   const JsonType JsonInt = JsonType::int64_value;
   const JsonType JsonUInt = JsonType::uint64_value;
+  const JsonType JsonDouble = JsonType::double_value;
   const JsonType JsonObject = JsonType::object_value;
   const JsonType JsonArray = JsonType::array_value;
 
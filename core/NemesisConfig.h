@@ -1,12 +1,14 @@
 #ifndef NDB_CORE_NEMESISCONFIG_H
 #define NDB_CORE_NEMESISCONFIG_H
 
+#include <algorithm>
 #include <string_view>
 #include <mutex>
 #include <fstream>
 #include <filesystem>
 #include <boost/program_options.hpp>
 #include <core/NemesisCommon.h>
+#include <core/Compression.h>
 
 
 namespace nemesis { 
@@ -29,6 +31,51 @@ namespace nemesis {
     std::size_t maxRspSize{};
   };
 
+  enum class WalFsync
+  {
+    Always,   // fdatasync() after each group commit, before responses are sent
+    EverySec, // fdatasync() once per second by a background thread
+    No        // left to the OS
+  };
+
+  struct WalSettings
+  {
+    bool enabled{false};
+    WalFsync fsync{WalFsync::EverySec};
+    std::size_t compactSize{256U * 1024U * 1024U};  // bytes logged since the last compaction
+  };
+
+  enum class ReplicationRole
+  {
+    None,
+    Primary,  // listens on port for replicas
+    Replica   // connects to primaryIp:primaryPort, read-only for clients
+  };
+
+  struct ReplicationSettings
+  {
+    ReplicationRole role{ReplicationRole::None};
+    int port{0};
+    std::string primaryIp;
+    int primaryPort{0};
+  };
+
+  inline constexpr std::size_t ClusterSlotCount = 16384U;
+
+  struct ClusterNode
+  {
+    std::string ip;
+    int port{0};      // query interface
+    int busPort{0};   // slot migration
+    std::vector<std::pair<std::size_t, std::size_t>> slots;  // inclusive ranges
+  };
+
+  struct ClusterSettings
+  {
+    bool enabled{false};
+    std::vector<ClusterNode> nodes;
+  };
+
   struct Settings
   {
   private:
@@ -49,6 +96,64 @@ namespace nemesis {
       persistEnabled = cfg.at("persist").at("enabled") == true;
       persistPath = cfg.at("persist").at("path").as_string();
 
+      // optional, so existing config files remain valid
+      if (const auto& persist = cfg.at("persist"); persist.contains("compression"))
+        persistCompression = snapshot::toCodec(persist.at("compression").as_string()).value_or(snapshot::Codec::None);
+
+      if (const auto& persist = cfg.at("persist"); persist.contains("wal"))
+      {
+        const auto& walCfg = persist.at("wal");
+        wal.enabled = persistEnabled && walCfg.at("enabled") == true;
+
+        if (walCfg.contains("fsync"))
+        {
+          if (const auto& fsync = walCfg.at("fsync").as_string(); fsync == "always")
+            wal.fsync = WalFsync::Always;
+          else if (fsync == "no")
+            wal.fsync = WalFsync::No;
+          else
+            wal.fsync = WalFsync::EverySec;
+        }
+
+        if (walCfg.contains("compactSize"))
+          wal.compactSize = walCfg.at("compactSize").as<std::size_t>() * 1024U * 1024U;
+      }
+
+      if (cfg.contains("replication"))
+      {
+        const auto& replicationCfg = cfg.at("replication");
+
+        if (const auto& role = replicationCfg.at("role").as_string(); role == "primary")
+        {
+          replication.role = ReplicationRole::Primary;
+          replication.port = replicationCfg.at("port").as<int>();
+        }
+        else if (role == "replica")
+        {
+          const auto primary = replicationCfg.at("primary").as_string();
+          const auto colon = primary.rfind(':');
+
+          replication.role = ReplicationRole::Replica;
+          replication.primaryIp = primary.substr(0, colon);
+          replication.primaryPort = std::stoi(primary.substr(colon + 1));
+        }
+      }
+
+      if (cfg.contains("cluster") && cfg.at("cluster").at("enabled") == true)
+      {
+        cluster.enabled = true;
+
+        for (const auto& nodeCfg : cfg.at("cluster").at("nodes").array_range())
+        {
+          ClusterNode node {.ip = nodeCfg.at("ip").as_string(), .port = nodeCfg.at("port").as<int>(), .busPort = nodeCfg.at("busPort").as<int>()};
+
+          for (const auto& range : nodeCfg.at("slots").array_range())
+            node.slots.emplace_back(range[0].as<std::size_t>(), range[1].as<std::size_t>());
+
+          cluster.nodes.emplace_back(std::move(node));
+        }
+      }
+
       arrays.maxCapacity = cfg.at("arrays").at("maxCapacity").as<std::size_t>();
       arrays.maxRspSize = cfg.at("arrays").at("maxResponseSize").as<std::size_t>();
 
@@ -83,6 +188,13 @@ namespace nemesis {
       settings = Settings{};
     }
 
+    // take over the data and port of a server running with the same config
+    static void initHandoff(const njson& cfg)
+    {
+      settings = Settings{cfg};
+      settings.handoff = true;
+    }
+
     static const Settings& get()
     {
       return settings;
@@ -99,13 +211,18 @@ namespace nemesis {
     InterfaceSettings interface;
     ArraySettings arrays;
     ListSettings lists;
+    WalSettings wal;
+    ReplicationSettings replication;
+    ClusterSettings cluster;
     std::string startupLoadName;
     fs::path startupLoadPath;
     std::size_t maxPayload;
     std::size_t preferredCore;
     bool loadOnStartup;
+    bool handoff{false};
     bool persistEnabled;
     fs::path persistPath;
+    snapshot::Codec persistCompression{snapshot::Codec::None};
 
   
   private:
@@ -125,11 +242,117 @@ namespace nemesis {
   };
 
 
+  bool validateWal (const njson& walCfg)
+  {
+    return  isValid([&walCfg]{ return walCfg.is_object() && walCfg.contains("enabled") && walCfg.at("enabled").is_bool(); }, "persist::wal::enabled must be a bool") &&
+            isValid([&walCfg]{ return !walCfg.contains("fsync") || (walCfg.at("fsync").is_string() && (walCfg.at("fsync") == "always" || walCfg.at("fsync") == "everysec" || walCfg.at("fsync") == "no")); }, "persist::wal::fsync must be \"always\", \"everysec\" or \"no\"") &&
+            isValid([&walCfg]{ return !walCfg.contains("compactSize") || (walCfg.at("compactSize").is_uint64() && walCfg.at("compactSize") > 0U); }, "persist::wal::compactSize must be an unsigned integer above 0");
+  }
+
+
   bool validatePersist (const njson& saveCfg)
   {
     return  isValid([&saveCfg]{ return saveCfg.contains("path") && saveCfg.at("path").is_string(); }, "persist::path must be a string") &&
             isValid([&saveCfg]{ return saveCfg.contains("enabled") && saveCfg.at("enabled").is_bool(); }, "persist::enabled must be a bool") && 
-            isValid([&saveCfg]{ return !saveCfg.at("enabled").as_bool() || (saveCfg.at("enabled").as_bool() && !saveCfg.at("path").as_string().empty()); }, "persist enabled but path is empty");
+            isValid([&saveCfg]{ return !saveCfg.at("enabled").as_bool() || (saveCfg.at("enabled").as_bool() && !saveCfg.at("path").as_string().empty()); }, "persist enabled but path is empty") &&
+            isValid([&saveCfg]{ return !saveCfg.contains("compression") || (saveCfg.at("compression").is_string() && snapshot::toCodec(saveCfg.at("compression").as_string())); }, "persist::compression must be \"none\", \"zlib\" or \"lz4\"") &&
+            isValid([&saveCfg]{ return !saveCfg.contains("compression") || snapshot::isAvailable(*snapshot::toCodec(saveCfg.at("compression").as_string())); }, "persist::compression \"lz4\" is not available in this build") &&
+            (!saveCfg.contains("wal") || validateWal(saveCfg.at("wal")));
+  }
+
+
+  bool validateReplication (const njson& replicationCfg, const njson& persistCfg)
+  {
+    auto isPrimaryAddress = [](const njson& primary)
+    {
+      if (!primary.is_string())
+        return false;
+
+      const auto address = primary.as_string();
+      const auto colon = address.rfind(':');
+      return colon != std::string::npos && colon > 0U && colon + 1U < address.size() &&
+             address.find_first_not_of("0123456789", colon + 1U) == std::string::npos;
+    };
+
+    auto isWalEnabled = [&persistCfg]
+    {
+      return persistCfg.at("enabled") == true && persistCfg.contains("wal") && persistCfg.at("wal").at("enabled") == true;
+    };
+
+    return  isValid([&replicationCfg]{ return replicationCfg.is_object() && replicationCfg.contains("role") && replicationCfg.at("role").is_string(); }, "replication::role must be a string") &&
+            isValid([&replicationCfg]{ return replicationCfg.at("role") == "none" || replicationCfg.at("role") == "primary" || replicationCfg.at("role") == "replica"; }, "replication::role must be \"none\", \"primary\" or \"replica\"") &&
+            isValid([&replicationCfg]{ return replicationCfg.at("role") != "primary" || (replicationCfg.contains("port") && replicationCfg.at("port").is_uint64() && replicationCfg.at("port") <= 65535U); }, "replication::port must be a port number for a primary") &&
+            isValid([&]{ return replicationCfg.at("role") != "replica" || (replicationCfg.contains("primary") && isPrimaryAddress(replicationCfg.at("primary"))); }, "replication::primary must be \"ip:port\" for a replica") &&
+            isValid([&]{ return replicationCfg.at("role") != "replica" || !isWalEnabled(); }, "replication: a replica cannot have persist::wal enabled, its data comes from the primary");
+  }
+
+
+  bool validateCluster (const njson& clusterCfg, const njson& cfg)
+  {
+    auto isPort = [](const njson& node, const char * name)
+    {
+      return node.contains(name) && node.at(name).is_uint64() && node.at(name) <= 65535U;
+    };
+
+    auto isNode = [&isPort](const njson& node)
+    {
+      return  node.is_object() && node.contains("ip") && node.at("ip").is_string() && isPort(node, "port") && isPort(node, "busPort") &&
+              node.contains("slots") && node.at("slots").is_array();
+    };
+
+    // each slot is assigned to exactly one node
+    auto isSlotsAssigned = [&clusterCfg]
+    {
+      std::vector<bool> assigned(ClusterSlotCount, false);
+
+      for (const auto& node : clusterCfg.at("nodes").array_range())
+      {
+        for (const auto& range : node.at("slots").array_range())
+        {
+          if (!range.is_array() || range.size() != 2U || !range[0].is_uint64() || !range[1].is_uint64())
+            return false;
+
+          const auto start = range[0].as<std::size_t>(), end = range[1].as<std::size_t>();
+
+          if (start > end || end >= ClusterSlotCount)
+            return false;
+
+          for (auto slot = start ; slot <= end ; ++slot)
+          {
+            if (assigned[slot])
+              return false;
+
+            assigned[slot] = true;
+          }
+        }
+      }
+
+      return std::ranges::all_of(assigned, [](const bool a){ return a; });
+    };
+
+    auto isSelfNode = [&]
+    {
+      return std::ranges::any_of(clusterCfg.at("nodes").array_range(), [&cfg](const njson& node)
+      {
+        return node.at("ip") == cfg.at("ip") && node.at("port") == cfg.at("port");
+      });
+    };
+
+    auto isReplica = [&cfg]
+    {
+      return cfg.contains("replication") && cfg.at("replication").at("role") == "replica";
+    };
+
+    if (!isValid([&clusterCfg]{ return clusterCfg.is_object() && clusterCfg.contains("enabled") && clusterCfg.at("enabled").is_bool(); }, "cluster::enabled must be a bool"))
+      return false;
+    else if (clusterCfg.at("enabled") == false)
+      return true;
+    else
+      return  isValid([&clusterCfg]{ return clusterCfg.contains("nodes") && clusterCfg.at("nodes").is_array() && !clusterCfg.at("nodes").empty(); }, "cluster::nodes must be a non-empty array") &&
+              isValid([&]{ return std::ranges::all_of(clusterCfg.at("nodes").array_range(), isNode); }, "cluster::nodes must each have ip, port, busPort and slots") &&
+              isValid(isSlotsAssigned, "cluster: each slot, 0 to " + std::to_string(ClusterSlotCount-1) + ", must be assigned to one node as [start,end] ranges") &&
+              isValid(isSelfNode, "cluster::nodes must include this server's ip and port") &&
+              isValid([&]{ return !isReplica(); }, "cluster: a replica cannot be a cluster node");
   }
 
 
@@ -169,7 +392,9 @@ namespace nemesis {
       if (valid &&
           validatePersist(cfg.at("persist")) &&
           validateArrays(cfg.at("arrays")) && 
-          validateLists(cfg.at("lists")))
+          validateLists(cfg.at("lists")) &&
+          (!cfg.contains("replication") || validateReplication(cfg.at("replication"), cfg.at("persist"))) &&
+          (!cfg.contains("cluster") || validateCluster(cfg.at("cluster"), cfg)))
       {
         return {true, cfg};
       }
@@ -200,11 +425,14 @@ namespace nemesis {
     load.add_options()("loadPath",  po::value<std::string>(&cmdLoadPath), "Path to where to find loadName. If not set, will use persist::path from config");
     load.add_options()("loadName",  po::value<std::string>(&loadName), "Name of the save point to load");
     
+    po::options_description handoff("Hot restart");
+    handoff.add_options()("handoff", "Take over the data and port from a server running with this config");
     
     po::options_description all;
     all.add(common);
     all.add(configFile);
     all.add(load);
+    all.add(handoff);
     
     po::variables_map vm;
     bool parsedArgs = false;
@@ -243,7 +471,13 @@ namespace nemesis {
           }
           else if (const auto& [valid, cfg] = parse(cfgPath); valid)
           {
-            if (vm.count("loadPath") || vm.count("loadName"))
+            if (vm.count("handoff") && (vm.count("loadPath") || vm.count("loadName")))
+            {
+              PLOGF << "Cannot load with --handoff";
+            }
+            else if (vm.count("handoff"))
+              Settings::initHandoff(cfg);
+            else if (vm.count("loadPath") || vm.count("loadName"))
             {            
               const fs::path loadPath = vm.count("loadPath") ? cmdLoadPath : cfg["persist"]["path"].as_string();
 
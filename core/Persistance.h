@@ -1,15 +1,19 @@
 #ifndef NDB_CORE_PERSISTANCE_H
 #define NDB_CORE_PERSISTANCE_H
 
+#include <algorithm>
 #include <fstream>
+#include <functional>
 #include <string>
+#include <vector>
 #include <core/NemesisCommon.h>
+#include <core/Compression.h>
 
 
 namespace nemesis { 
 
 
-  inline const std::int16_t METADATA_VERSION = 2;
+  inline const std::int16_t METADATA_VERSION = 3; // 3: data files use the binary snapshot format (core/Snapshot.h)
 
 
   enum class SaveDataType
@@ -45,11 +49,24 @@ namespace nemesis {
   };
 
 
+  // Saves and loads data other than keys (arrays and lists), so KV_SAVE and KV_LOAD
+  // include all data. Each writes to its own directory in the save's root.
+  struct Persister
+  {
+    fs::path dir;
+    std::function<bool(const fs::path&, const snapshot::Codec)> save;  // can run in a forked child
+    std::function<std::size_t(const fs::path&)> load;                  // returns the number loaded, throws on error
+  };
+
+
   struct PreLoadInfo
   {
     DataLoadPaths paths;    
     std::string err;
     SaveDataType dataType;
+    std::size_t nKeys{0}; // from metadata, 0 if the save did not record it
+    std::vector<fs::path> chain;  // save roots to load in order: a full save then any delta saves
+    bool deltas{false};  // saved with the delta option, so changes are tracked after loading
     bool valid;
   };
 
@@ -70,9 +87,10 @@ namespace nemesis {
   }
 
 
-  void completeSaveMetaData(std::ofstream& stream, njson& metadata, const KvSaveStatus status)
+  void completeSaveMetaData(std::ofstream& stream, njson& metadata, const KvSaveStatus status, const std::size_t nKeys)
   {
     metadata["status"] = toUnderlying(status);
+    metadata["keys"] = nKeys; // used to reserve the map when loading
     metadata["complete"] = chrono::time_point_cast<KvSaveMetaDataUnit>(KvSaveClock::now()).time_since_epoch().count();
 
     stream.seekp(0);
@@ -107,6 +125,35 @@ namespace nemesis {
   }
 
  
+  // A delta save's metadata has "prev", the save it is relative to. Follow these back
+  // to the full save, returning the roots oldest first.
+  std::tuple<bool, std::vector<fs::path>> getLoadChain (const fs::path& loadRoot, const fs::path& latestRoot, const njson& latestMd)
+  {
+    std::vector<fs::path> chain {latestRoot};
+    njson md = latestMd;
+
+    while (md.contains("prev"))
+    {
+      const fs::path prevRoot = loadRoot / md.at("prev").as_string();
+      const fs::path mdFile = prevRoot / "md" / "md.json";
+
+      if (!fs::exists(mdFile))
+        return {false, {}};
+
+      std::ifstream mdStream {mdFile};
+      md = njson::parse(mdStream);
+
+      if (!md.contains("status") || md["status"] != toUnderlying(KvSaveStatus::Complete))
+        return {false, {}};
+
+      chain.push_back(prevRoot);
+    }
+
+    std::reverse(chain.begin(), chain.end());
+    return {true, chain};
+  }
+
+ 
   PreLoadInfo validatePreLoad (const std::string& loadName, const fs::path& persistPath)
   {
     PreLoadInfo info {.valid = false};
@@ -133,9 +180,14 @@ namespace nemesis {
         info.err = "Metadata file invalid";
       else if (mdJson["status"] != toUnderlying(KvSaveStatus::Complete))
         info.err = "Cannot load: save is incomplete";
+      else if (auto [chainValid, chain] = getLoadChain(persistPath / loadName, root, mdJson); !chainValid)
+        info.err = "Cannot load: a save in the delta chain is missing or incomplete";
       else
       {
         info.dataType = static_cast<SaveDataType>(mdJson.at("saveDataType").as<unsigned int>());
+        info.nKeys = mdJson.contains("keys") ? mdJson.at("keys").as<std::size_t>() : 0U;
+        info.deltas = mdJson.contains("delta");
+        info.chain = std::move(chain);
         info.paths = getLoadPaths(persistPath / loadName);
         info.valid = info.paths.valid;
       }
@@ -0,0 +1,772 @@
+#ifndef NDB_CORE_REPLICATION_H
+#define NDB_CORE_REPLICATION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <jsoncons_ext/cbor/cbor.hpp>
+#include <core/NemesisCommon.h>
+#include <core/ForkTask.h>
+#include <core/Snapshot.h>
+
+
+/*
+Asynchronous replication from a primary to read-only replicas over TCP.
+
+The primary ships the same records as the WAL: successful write requests, encoded as CBOR.
+Each is given a sequence number. When a replica connects:
+
+  1. the primary forks (as for a background save) and the child writes the server's state to
+     the socket as requests (Snapshot frames), then a SnapshotEnd frame with the sequence
+     number at the time of the fork
+  2. meanwhile, records appended after the fork are queued for the replica
+  3. when the child completes, a sender thread sends the queue then new records as they
+     are committed, or a Heartbeat with the latest sequence number when idle
+
+The replica clears its data when it connects, then applies frames in order on its event
+loop thread. It acknowledges the sequence number it has applied, so both sides can report
+lag. If the connection is lost, the replica reconnects and receives a new snapshot.
+
+  Frame:  type (u32) | size (u32) | seq (u64) | crc (u32, CRC32C of payload) | reserved (u32) | payload
+  Ack:    seq (u64), replica to primary
+*/
+
+
+namespace nemesis { namespace replication {
+
+
+  enum class FrameType : std::uint32_t
+  {
+    Snapshot = 1,   // a request which recreates data
+    SnapshotEnd,    // seq is the sequence number the snapshot is at
+    Mutation,       // a write request
+    Heartbeat       // seq is the primary's latest sequence number
+  };
+
+
+  struct FrameHeader
+  {
+    std::uint32_t type{0};
+    std::uint32_t size{0};
+    std::uint64_t seq{0};
+    std::uint32_t crc{0};
+    std::uint32_t reserved{0};
+  };
+
+  static_assert(sizeof(FrameHeader) == 24U);
+
+
+  using Record = std::vector<std::uint8_t>;
+  using Emit = std::function<void(const njson&)>;
+  using Dump = std::function<void(const Emit&)>;
+  using Apply = std::function<void(njson&)>;
+  using Wake = std::function<void()>;   // wakes the event loop, callable from any thread
+
+  using Clock = chrono::steady_clock;
+
+
+  // 'Type' is FrameType, or the cluster bus's message type, which share the frame layout
+  template<typename Type>
+  void appendFrame (std::vector<std::uint8_t>& buffer, const Type type, const std::uint64_t seq, const std::span<const std::uint8_t> payload = {})
+  {
+    FrameHeader header;
+    header.type = static_cast<std::uint32_t>(type);
+    header.size = static_cast<std::uint32_t>(payload.size());
+    header.seq = seq;
+    header.crc = snapshot::crc32c(payload.data(), payload.size());
+
+    const auto * headerBytes = reinterpret_cast<const std::uint8_t *>(&header);
+    buffer.insert(buffer.end(), headerBytes, headerBytes + sizeof(header));
+    buffer.insert(buffer.end(), payload.begin(), payload.end());
+  }
+
+
+  inline bool sendAll (const int fd, const std::uint8_t * data, std::size_t size)
+  {
+    while (size)
+    {
+      if (const auto n = ::send(fd, data, size, MSG_NOSIGNAL); n < 0)
+      {
+        if (errno != EINTR)
+          return false;
+      }
+      else
+      {
+        data += n;
+        size -= static_cast<std::size_t>(n);
+      }
+    }
+    return true;
+  }
+
+
+  inline bool recvAll (const int fd, std::uint8_t * data, std::size_t size)
+  {
+    while (size)
+    {
+      if (const auto n = ::recv(fd, data, size, 0); n == 0)
+        return false;
+      else if (n < 0)
+      {
+        if (errno != EINTR)
+          return false;
+      }
+      else
+      {
+        data += n;
+        size -= static_cast<std::size_t>(n);
+      }
+    }
+    return true;
+  }
+
+
+  // A send that blocks this long means the peer is stuck, so the connection is dropped
+  inline void setSocketOptions (const int fd)
+  {
+    const int one = 1;
+    const timeval timeout {.tv_sec = 5, .tv_usec = 0};
+
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  }
+
+
+
+  // Runs on the primary. Except for the accept and sender threads, all functions are called
+  // on the event loop thread.
+  class Primary
+  {
+    // a replica connection
+    struct Connection
+    {
+      Connection(const int fd, std::string address) : fd(fd), address(std::move(address))
+      {
+      }
+
+      ~Connection()
+      {
+        sender = std::jthread{}; // join before closing
+        ::close(fd);
+      }
+
+      int fd;
+      std::string address;
+      ForkTask snapshot;
+      bool streaming{false};
+      std::mutex mux;
+      std::condition_variable_any cv;
+      std::deque<std::vector<std::uint8_t>> queue;
+      std::size_t queuedBytes{0};
+      std::atomic_uint64_t acked{0};
+      std::atomic_bool dead{false};
+      std::vector<std::uint8_t> ackBuffer;
+      std::jthread sender;  // last, so stops first
+    };
+
+    // a replica too slow to keep up is dropped, it reconnects and resyncs
+    static constexpr std::size_t MaxQueuedBytes = 256U * 1024U * 1024U;
+
+  public:
+
+    Primary(const int port, Wake wake) : m_port(port), m_wake(std::move(wake))
+    {
+    }
+
+    Primary(const Primary&) = delete;
+    Primary& operator=(const Primary&) = delete;
+
+
+    ~Primary()
+    {
+      if (m_listenFd >= 0)
+        ::shutdown(m_listenFd, SHUT_RDWR); // unblocks accept()
+
+      m_acceptThread = std::jthread{};
+      m_connections.clear();
+
+      for (const auto& [fd, address] : m_accepted)
+        ::close(fd);
+
+      if (m_listenFd >= 0)
+        ::close(m_listenFd);
+    }
+
+
+    bool start ()
+    {
+      m_listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+      const int one = 1;
+      ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)); // a hot restart binds before this process closes
+
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_addr.s_addr = htonl(INADDR_ANY);
+      addr.sin_port = htons(static_cast<std::uint16_t>(m_port));
+
+      if (m_listenFd < 0 || ::bind(m_listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(m_listenFd, 16) != 0)
+      {
+        PLOGE << "Replication: failed to listen on port " << m_port << ": " << std::strerror(errno);
+        return false;
+      }
+
+      m_acceptThread = std::jthread{[this](std::stop_token stop){ accept(stop); }};
+
+      PLOGI << "Replication: primary, listening on port " << m_port;
+      return true;
+    }
+
+
+    // A successful write request, sent to replicas by commit()
+    void append (const Record& record)
+    {
+      appendFrame(m_buffer, FrameType::Mutation, ++m_seq, record);
+    }
+
+
+    // Queues records appended since the previous commit for each replica
+    void commit ()
+    {
+      if (m_buffer.empty())
+        return;
+
+      for (auto& connection : m_connections)
+      {
+        if (connection->dead)
+          continue;
+
+        {
+          std::scoped_lock lck{connection->mux};
+
+          if (connection->queuedBytes + m_buffer.size() > MaxQueuedBytes)
+          {
+            PLOGW << "Replication: " << connection->address << " is too slow, dropping";
+            connection->dead = true;
+          }
+          else
+          {
+            connection->queue.push_back(m_buffer);
+            connection->queuedBytes += m_buffer.size();
+          }
+        }
+
+        connection->cv.notify_one();
+      }
+
+      m_buffer.clear();
+      m_committedSeq.store(m_seq, std::memory_order_release);
+    }
+
+
+    // Starts snapshots for new replicas, starts streaming when a snapshot completes, and
+    // removes lost replicas. Call after commit().
+    void poll (const Dump& dump)
+    {
+      std::vector<std::pair<int, std::string>> accepted;
+      {
+        std::scoped_lock lck{m_acceptedMux};
+        accepted.swap(m_accepted);
+      }
+
+      for (auto& [fd, address] : accepted)
+        startSnapshot(std::make_unique<Connection>(fd, std::move(address)), dump);
+
+
+      for (auto& connection : m_connections)
+      {
+        if (connection->streaming || connection->dead)
+          continue;
+        else if (const auto state = connection->snapshot.poll(); state == ForkTask::State::Complete)
+        {
+          PLOGI << "Replication: snapshot sent to " << connection->address << " in " << chrono::duration_cast<chrono::milliseconds>(connection->snapshot.duration()).count() << "ms";
+
+          connection->streaming = true;
+          connection->sender = std::jthread{[this, c = connection.get()](std::stop_token stop){ send(*c, stop); }};
+        }
+        else if (state == ForkTask::State::Error)
+        {
+          PLOGE << "Replication: snapshot to " << connection->address << " failed" << (connection->snapshot.error().empty() ? "" : ": ") << connection->snapshot.error();
+          connection->dead = true;
+        }
+      }
+
+      std::erase_if(m_connections, [](const auto& connection)
+      {
+        if (connection->dead)
+          PLOGI << "Replication: " << connection->address << " disconnected";
+
+        return connection->dead.load();
+      });
+    }
+
+
+    // Replicas must resync, i.e. after KV_LOAD, which loads files the replicas may not have
+    void resync ()
+    {
+      for (auto& connection : m_connections)
+        connection->dead = true;
+    }
+
+
+    njson info () const
+    {
+      njson info;
+      info["role"] = "primary";
+      info["seq"] = m_seq;
+      info["replicas"] = njson::make_array();
+
+      for (const auto& connection : m_connections)
+      {
+        const auto acked = connection->acked.load();
+
+        njson replica;
+        replica["address"] = connection->address;
+        replica["syncing"] = !connection->streaming;
+        replica["acked"] = acked;
+        replica["lag"] = m_seq > acked ? m_seq - acked : 0U;
+        info["replicas"].push_back(std::move(replica));
+      }
+
+      return info;
+    }
+
+
+  private:
+
+    void accept (std::stop_token stop)
+    {
+      while (!stop.stop_requested())
+      {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+
+        if (const int fd = ::accept(m_listenFd, reinterpret_cast<sockaddr *>(&addr), &len); fd < 0)
+        {
+          if (errno != EINTR && errno != ECONNABORTED)
+            break; // listen socket shutdown
+        }
+        else
+        {
+          setSocketOptions(fd);
+
+          char ip[INET_ADDRSTRLEN]{};
+          ::inet_ntop(AF_INET, &addr.sin_addr, ip, sizeof(ip));
+
+          {
+            std::scoped_lock lck{m_acceptedMux};
+            m_accepted.emplace_back(fd, std::string{ip} + ":" + std::to_string(ntohs(addr.sin_port)));
+          }
+
+          m_wake();
+        }
+      }
+    }
+
+
+    void startSnapshot (std::unique_ptr<Connection> connection, const Dump& dump)
+    {
+      // commit() has been called, so all appended records are in the state dumped
+      const auto fd = connection->fd;
+      const auto seq = m_seq;
+
+      auto write = [fd, seq, &dump](ForkTask::Progress& progress)
+      {
+        // runs in the child process
+        std::vector<std::uint8_t> buffer, record;
+        bool ok = true;
+
+        dump([&](const njson& request)
+        {
+          if (ok)
+          {
+            record.clear();
+            jsoncons::cbor::encode_cbor(request, record);
+            appendFrame(buffer, FrameType::Snapshot, 0, record);
+
+            if (buffer.size() >= snapshot::SnapshotWriter::BlockSize)
+            {
+              ok = sendAll(fd, buffer.data(), buffer.size());
+              buffer.clear();
+            }
+
+            ++progress.done;
+          }
+        });
+
+        appendFrame(buffer, FrameType::SnapshotEnd, seq);
+        return ok && sendAll(fd, buffer.data(), buffer.size());
+      };
+
+      if (!connection->snapshot.start(write, 0))
+      {
+        PLOGE << "Replication: failed to start snapshot for " << connection->address;
+        return;
+      }
+
+      PLOGI << "Replication: " << connection->address << " connected, sending snapshot at seq " << seq;
+      m_connections.emplace_back(std::move(connection));
+    }
+
+
+    // The connection's sender thread
+    void send (Connection& connection, std::stop_token stop)
+    {
+      std::deque<std::vector<std::uint8_t>> frames;
+
+      while (!stop.stop_requested() && !connection.dead)
+      {
+        {
+          std::unique_lock lck{connection.mux};
+          connection.cv.wait_for(lck, stop, chrono::seconds{1}, [&connection]{ return !connection.queue.empty() || connection.dead; });
+
+          frames.swap(connection.queue);
+          connection.queuedBytes = 0;
+        }
+
+        if (frames.empty())
+        {
+          frames.emplace_back();
+          appendFrame(frames.back(), FrameType::Heartbeat, m_committedSeq.load(std::memory_order_acquire));
+        }
+
+        for (const auto& frame : frames)
+        {
+          if (!sendAll(connection.fd, frame.data(), frame.size()))
+          {
+            connection.dead = true;
+            break;
+          }
+        }
+
+        frames.clear();
+        readAcks(connection);
+      }
+
+      m_wake(); // so poll() removes it
+    }
+
+
+    void readAcks (Connection& connection)
+    {
+      std::uint8_t bytes[256];
+
+      while (true)
+      {
+        if (const auto n = ::recv(connection.fd, bytes, sizeof(bytes), MSG_DONTWAIT); n > 0)
+          connection.ackBuffer.insert(connection.ackBuffer.end(), bytes, bytes + n);
+        else
+        {
+          if (n == 0)
+            connection.dead = true; // closed by the replica
+          break;
+        }
+      }
+
+      if (const auto complete = connection.ackBuffer.size() / 8U; complete)
+      {
+        std::uint64_t seq;
+        std::memcpy(&seq, connection.ackBuffer.data() + (complete - 1U) * 8U, 8U);
+        connection.acked = seq;
+        connection.ackBuffer.erase(connection.ackBuffer.begin(), connection.ackBuffer.begin() + complete * 8U);
+      }
+    }
+
+
+  private:
+    int m_port;
+    Wake m_wake;
+    int m_listenFd{-1};
+    std::uint64_t m_seq{0};
+    std::atomic_uint64_t m_committedSeq{0};
+    std::vector<std::uint8_t> m_buffer;
+    std::vector<std::unique_ptr<Connection>> m_connections;
+    std::mutex m_acceptedMux;
+    std::vector<std::pair<int, std::string>> m_accepted;
+    std::jthread m_acceptThread;
+  };
+
+
+
+  // Runs on a replica. The receiver thread connects to the primary and decodes frames,
+  // which are applied by poll() on the event loop thread.
+  class Replica
+  {
+    struct Item
+    {
+      FrameType type;
+      std::uint64_t seq;
+      njson request;
+      bool reset{false};  // connected, so existing data is cleared
+    };
+
+    static constexpr std::size_t MaxQueued = 64U * 1024U;
+
+  public:
+
+    Replica(std::string primaryIp, const int primaryPort, Wake wake) :
+      m_primaryIp(std::move(primaryIp)),
+      m_primaryPort(primaryPort),
+      m_wake(std::move(wake))
+    {
+    }
+
+    Replica(const Replica&) = delete;
+    Replica& operator=(const Replica&) = delete;
+
+
+    ~Replica()
+    {
+      m_receiver.request_stop();
+      m_queueCv.notify_all();
+
+      if (const int fd = m_fd.load(); fd >= 0)
+        ::shutdown(fd, SHUT_RDWR);  // unblocks recv()
+
+      m_receiver = std::jthread{};
+    }
+
+
+    void start ()
+    {
+      PLOGI << "Replication: replica of " << m_primaryIp << ':' << m_primaryPort;
+      m_receiver = std::jthread{[this](std::stop_token stop){ receive(stop); }};
+    }
+
+
+    // Applies up to 'max' received frames. Returns true if more are queued.
+    bool poll (const Apply& apply, const std::function<void()>& reset, const std::size_t max)
+    {
+      std::deque<Item> items;
+      bool more = false;
+      {
+        std::scoped_lock lck{m_queueMux};
+
+        const auto n = std::min(max, m_queue.size());
+        items.insert(items.end(), std::make_move_iterator(m_queue.begin()), std::make_move_iterator(m_queue.begin() + n));
+        m_queue.erase(m_queue.begin(), m_queue.begin() + n);
+        more = !m_queue.empty();
+      }
+
+      m_queueCv.notify_one();
+
+      for (auto& item : items)
+      {
+        if (item.reset)
+        {
+          reset();
+          m_applied = 0;
+          m_primarySeq = 0;
+          m_synced = false;
+          continue;
+        }
+
+        switch (item.type)
+        {
+          case FrameType::Snapshot:
+            apply(item.request);
+          break;
+
+          case FrameType::SnapshotEnd:
+            m_synced = true;
+            m_applied = item.seq;
+            m_primarySeq = std::max(m_primarySeq, item.seq);
+            PLOGI << "Replication: snapshot applied at seq " << item.seq;
+          break;
+
+          case FrameType::Mutation:
+            apply(item.request);
+            m_applied = item.seq;
+            m_primarySeq = std::max(m_primarySeq, item.seq);
+          break;
+
+          case FrameType::Heartbeat:
+            m_primarySeq = std::max(m_primarySeq, item.seq);
+          break;
+        }
+      }
+
+      if (m_synced && m_applied >= m_primarySeq)
+        m_caughtUp = Clock::now();
+
+      return more;
+    }
+
+
+    njson info () const
+    {
+      const auto applied = m_applied.load();
+
+      njson info;
+      info["role"] = "replica";
+      info["primary"] = m_primaryIp + ":" + std::to_string(m_primaryPort);
+      info["connected"] = m_connected.load();
+      info["synced"] = m_synced;
+      info["seq"] = applied;
+      info["primarySeq"] = m_primarySeq;
+      info["lag"] = m_primarySeq > applied ? m_primarySeq - applied : 0U;
+      info["lagMs"] = m_synced && m_primarySeq > applied ? chrono::duration_cast<chrono::milliseconds>(Clock::now() - m_caughtUp).count() : 0;
+      return info;
+    }
+
+
+  private:
+
+    void receive (std::stop_token stop)
+    {
+      while (!stop.stop_requested())
+      {
+        if (const int fd = connect(); fd < 0)
+        {
+          std::unique_lock lck{m_queueMux};
+          m_queueCv.wait_for(lck, stop, chrono::seconds{1}, []{ return false; });
+        }
+        else
+        {
+          m_fd = fd;
+          m_connected = true;
+          push(Item{.reset = true});
+
+          read(fd, stop);
+
+          m_connected = false;
+          m_fd = -1;
+          ::close(fd);
+
+          PLOGW << "Replication: disconnected from primary";
+        }
+      }
+    }
+
+
+    int connect ()
+    {
+      sockaddr_in addr{};
+      addr.sin_family = AF_INET;
+      addr.sin_port = htons(static_cast<std::uint16_t>(m_primaryPort));
+      ::inet_pton(AF_INET, m_primaryIp.c_str(), &addr.sin_addr);
+
+      const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+      if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0)
+      {
+        setSocketOptions(fd);
+        PLOGI << "Replication: connected to primary";
+        return fd;
+      }
+
+      if (fd >= 0)
+        ::close(fd);
+
+      return -1;
+    }
+
+
+    void read (const int fd, std::stop_token stop)
+    {
+      std::uint64_t ackSent = 0;
+      std::vector<std::uint8_t> payload;
+
+      while (!stop.stop_requested())
+      {
+        pollfd pfd {.fd = fd, .events = POLLIN, .revents = 0};
+
+        if (const int ready = ::poll(&pfd, 1, 100); ready < 0 && errno != EINTR)
+          return;
+        else if (ready > 0)
+        {
+          FrameHeader header;
+
+          if (!recvAll(fd, reinterpret_cast<std::uint8_t *>(&header), sizeof(header)))
+            return;
+
+          payload.resize(header.size);
+
+          if (!recvAll(fd, payload.data(), payload.size()))
+            return;
+          else if (snapshot::crc32c(payload.data(), payload.size()) != header.crc)
+          {
+            PLOGE << "Replication: frame checksum mismatch";
+            return;
+          }
+
+          Item item {.type = static_cast<FrameType>(header.type), .seq = header.seq};
+
+          if (!payload.empty())
+            item.request = jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{payload.data(), payload.size()});
+
+          if (!push(std::move(item), stop))
+            return;
+        }
+
+        if (const auto applied = m_applied.load(); applied != ackSent)
+        {
+          if (!sendAll(fd, reinterpret_cast<const std::uint8_t *>(&applied), sizeof(applied)))
+            return;
+
+          ackSent = applied;
+        }
+      }
+    }
+
+
+    // Blocks whilst the queue is full. Returns false if stopped.
+    bool push (Item item, std::stop_token stop = {})
+    {
+      bool wasEmpty = false;
+      {
+        std::unique_lock lck{m_queueMux};
+
+        if (!m_queueCv.wait(lck, stop, [this]{ return m_queue.size() < MaxQueued; }))
+          return false;
+
+        wasEmpty = m_queue.empty();
+        m_queue.push_back(std::move(item));
+      }
+
+      if (wasEmpty)
+        m_wake();
+
+      return true;
+    }
+
+
+  private:
+    std::string m_primaryIp;
+    int m_primaryPort;
+    Wake m_wake;
+    std::atomic_int m_fd{-1};
+    std::atomic_bool m_connected{false};
+    std::atomic_uint64_t m_applied{0};
+    // event loop thread only
+    std::uint64_t m_primarySeq{0};
+    bool m_synced{false};
+    Clock::time_point m_caughtUp{};
+    // receiver to event loop
+    std::mutex m_queueMux;
+    std::condition_variable_any m_queueCv;
+    std::deque<Item> m_queue;
+    std::jthread m_receiver; // last, so stops first
+  };
+
+}
+}
+
+#endif
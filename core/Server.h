@@ -9,6 +9,10 @@
 #include <iostream>
 #include <uwebsockets/App.h>
 #include <core/Persistance.h>
+#include <core/Wal.h>
+#include <core/Replication.h>
+#include <core/Cluster.h>
+#include <core/Handoff.h>
 #include <core/NemesisConfig.h>
 #include <core/NemesisCommon.h>
 #include <core/kv/KvCommon.h>
@@ -18,6 +22,10 @@
 #include <core/arr/ArrCommands.h>
 #include <core/lst/LstHandler.h>
 #include <core/lst/LstCommands.h>
+#include <core/vec/VecHandler.h>
+#include <core/vec/VecCommands.h>
+#include <core/iset/ISetHandler.h>
+#include <core/iset/ISetCommands.h>
 
 
 
@@ -28,6 +36,8 @@ namespace kvCmds = nemesis::kv::cmds;
 namespace svCmds = nemesis::sv;
 namespace arrCmds = nemesis::arr::cmds;
 namespace lstCmds = nemesis::lst::cmds;
+namespace vecCmds = nemesis::vec::cmds;
+namespace isetCmds = nemesis::iset::cmds;
 
 
 
@@ -44,6 +54,7 @@ public:
   ~Server()
   {
     stop();
+    m_wsThread.reset(); // join before members are destroyed, the loop's final WAL commit uses them
   }
 
 
@@ -80,13 +91,31 @@ public:
     if (!init())
       return false;
 
+    if (Settings::get().handoff)
+    {
+      // the WAL is opened after the running server stops
+      if (!receiveHandoff())
+        return false;
+    }
+    else if (Settings::get().wal.enabled && !openWal())
+      return false;
+
     if (Settings::get().loadOnStartup)
     {
-      if (auto [ok, msg] = startupLoad(); !ok)
+      if (m_wal && m_wal->nReplayed())
+      {
+        PLOGW << "Startup load ignored: the write-ahead log has been replayed";
+      }
+      else if (auto [ok, msg] = startupLoad(); !ok)
       {
         PLOGF << msg;
         return false;
       }
+      else if (m_wal)
+      {
+        // loaded data is not in the log, so write it to a base
+        m_wal->compact(std::bind_front(&Server::dump, std::ref(*this)));
+      }
     }
 
     const auto [ip, port, maxPayload] = Settings::get().interface;
@@ -149,7 +178,27 @@ public:
         m_strArrHandler = std::make_shared<arr::StrArrHandler>();
         m_sortedIntArrHandler = std::make_shared<arr::SortedIntArrHandler>();
         m_sortedStrArrHandler = std::make_shared<arr::SortedStrArrHandler>();
+        m_floatArrHandler = std::make_shared<arr::FloatArrHandler>();
+        m_sortedFloatArrHandler = std::make_shared<arr::SortedFloatArrHandler>();
         m_listHandler = std::make_shared<lst::OLstHandler>();
+        m_vecHandler = std::make_shared<vec::VectorHandler>();
+        m_intSetHandler = std::make_shared<iset::IntSetHandler>();
+
+        // TO_SORTED stores into the sorted array handler of the same type
+        m_intArrHandler->setSortedStore(std::bind_front(&arr::SortedIntArrHandler::store, m_sortedIntArrHandler));
+        m_strArrHandler->setSortedStore(std::bind_front(&arr::SortedStrArrHandler::store, m_sortedStrArrHandler));
+
+        // KV_SAVE and KV_LOAD include arrays, lists, vectors and sets
+        m_kvHandler->addPersister(makePersister("arrays/oarr",    m_objectArrHandler));
+        m_kvHandler->addPersister(makePersister("arrays/iarr",    m_intArrHandler));
+        m_kvHandler->addPersister(makePersister("arrays/strarr",  m_strArrHandler));
+        m_kvHandler->addPersister(makePersister("arrays/siarr",   m_sortedIntArrHandler));
+        m_kvHandler->addPersister(makePersister("arrays/sstrarr", m_sortedStrArrHandler));
+        m_kvHandler->addPersister(makePersister("arrays/farr",    m_floatArrHandler));
+        m_kvHandler->addPersister(makePersister("arrays/sfarr",   m_sortedFloatArrHandler));
+        m_kvHandler->addPersister(makePersister("lists/olst",     m_listHandler));
+        m_kvHandler->addPersister(makePersister("vectors/vec",    m_vecHandler));
+        m_kvHandler->addPersister(makePersister("sets/iset",      m_intSetHandler));
       }
       catch(const std::exception& e)
       {
@@ -161,6 +210,15 @@ public:
     }
     
     
+    template<typename HandlerT>
+    static Persister makePersister (const fs::path& dir, std::shared_ptr<HandlerT> handler)
+    {
+      return Persister {.dir = dir,
+                        .save = [handler](const fs::path& path, const snapshot::Codec codec) { return handler->save(path, codec); },
+                        .load = [handler](const fs::path& path) { return handler->load(path); }};
+    }
+
+
     bool startWsServer (const std::string& ip, const int port, const unsigned int maxPayload, const std::size_t core)
     {
       bool listening{false};
@@ -201,6 +259,9 @@ public:
           {
             ws->getUserData()->connected->store(false);
 
+            std::erase_if(m_pendingSends, [ws](const auto& pending){ return pending.ws == ws; });
+            std::erase_if(m_pendingSearches, [ws](const auto& pending){ return pending.first == ws; });
+
             // when we shutdown, we have to call ws->end() to close each client otherwise uWS loop doesn't return,
             // but when we call ws->end(), this lambda is called, so we need to avoid mutex deadlock with this flag
             if (m_run)
@@ -217,13 +278,50 @@ public:
             listening = us_socket_is_closed(0, socket) == 0U;
           }
 
-          startLatch.count_down();
+          if (!m_target)
+            startLatch.count_down();
         });
+
+        // the running server stops when this process is listening
+        if (m_target)
+        {
+          if (listening && !takeOverHandoff())
+          {
+            listening = false;
+
+            for (auto sock : m_sockets)
+              us_listen_socket_close(0, sock);
+
+            m_sockets.clear();
+          }
+
+          startLatch.count_down();
+        }
         
 
         if (!wsApp.constructorFailed())
         {
+          // WAL group commit, replication and prefetching a mapped snapshot
+          uWS::Loop::get()->addPostHandler(this, [this](uWS::Loop *){ onLoopIteration(); });
+
+          if (m_kvHandler->prefetch(0))
+            uWS::Loop::get()->defer([]{});
+
+          startReplication();
+          startCluster();
+          startHandoff();
+
           wsApp.run();
+
+          if (m_wal)
+            onLoopIteration();
+
+          // replication and cluster threads wake the loop, so stop them before it is destroyed
+          m_primary.reset();
+          m_replica.reset();
+          m_cluster.reset();
+          m_handoff.reset();
+          m_vecHandler->stopSearches();
           
           /* this will be reused later for expiring KV
           bool timerSet = true;
@@ -328,69 +426,418 @@ public:
 
         if (!request.at(command).is_object())
           send(ws, createErrorResponse(command+"_RSP", RequestStatus::CommandSyntax));
+        else if (const auto pos = command.find('_'); pos == std::string::npos)
+          send(ws, createErrorResponse(command+"_RSP", RequestStatus::CommandSyntax));
+        else if (m_replica && Wal::isWrite(command, request.at(command)))
+          send(ws, createErrorResponse(command+"_RSP", RequestStatus::ReadOnly));
+        else if (m_cluster && std::string_view{command}.substr(0, pos) == kvCmds::KvIdent && !isRouted(ws, command, request.at(command)))
+          return;
+        else if (isLogged() && Wal::isWrite(command, request.at(command)))
+        {
+          const Response response = write(command, request);
+          send(ws, response.rsp, Wal::isSuccess(response));
+        }
+        else if (m_vecHandler->isSearch(command))
+          search(ws, request);
         else
         {
-          if (const auto pos = command.find('_'); pos == std::string::npos)
-            send(ws, createErrorResponse(command+"_RSP", RequestStatus::CommandSyntax));
-          else
-          {
-            const auto type = std::string_view(command.substr(0, pos));
+          const Response response = dispatch(command, request);
+          send(ws, response.rsp);
+        }
+      }
+    }
+
+
+    // Writes are logged to the WAL, replicas or a hot restart
+    bool isLogged() const noexcept
+    {
+      return m_wal || m_primary || (m_handoff && m_handoff->isActive());
+    }
+
+
+    // Handles a write command, logging and replicating it if it succeeds
+    Response write(const std::string& command, njson& request)
+    {
+      if (!isLogged())
+        return dispatch(command, request);
+      else if (m_wal && m_wal->hasFailed())
+        return Response{.rsp = createErrorResponse(command+"_RSP", RequestStatus::WalWriteFail)};
+
+      auto record = Wal::encode(request);
+      Response response = dispatch(command, request);
+
+      if (Wal::isSuccess(response))
+      {
+        // with the WAL, replicas and a hot restart only receive the write once it is committed
+        if (m_wal)
+        {
+          m_wal->append(record);
+          m_pendingRecords.push_back(PendingRecord{.record = std::move(record), .resync = command == kvCmds::LoadReq});
+        }
+        else
+          replicate(record, command == kvCmds::LoadReq);
+      }
+
+      return response;
+    }
+
+
+    void replicate(const Wal::Record& record, const bool resync)
+    {
+      // loaded data isn't in the stream, so replicas resync from a snapshot
+      if (m_primary && resync)
+        m_primary->resync();
+      else if (m_primary)
+        m_primary->append(record);
+
+      if (m_handoff)
+        m_handoff->append(record);
+    }
+
+
+    // Handles a request from the WAL, a primary or a hot restart, which was valid when first handled
+    void apply(njson& request)
+    {
+      const std::string command = request.object_range().cbegin()->key();
+      dispatch(command, request);
+    }
+
+
+    // Returns false, having sent a redirect, if the keys are not owned by this node
+    bool isRouted(KvWebSocket * ws, const std::string& command, const njson& body)
+    {
+      const auto route = m_cluster->route(command, body, [this](const std::string& key){ return m_kvHandler->contains(key); });
+
+      if (route.status == RequestStatus::Ok)
+        return true;
+
+      njson rsp;
+      rsp[command+"_RSP"]["st"] = toUnderlying(route.status);
+
+      if (!route.node.empty())
+      {
+        rsp[command+"_RSP"]["slot"] = route.slot;
+        rsp[command+"_RSP"]["node"] = route.node;
+      }
+
+      send(ws, rsp);
+      return false;
+    }
+
+
+    // The command has been checked by the caller: it is the only key and is "<type>_<name>"
+    Response dispatch(const std::string& command, njson& request)
+    {
+      const auto type = std::string_view(command.substr(0, command.find('_')));
             
-            if (type == kvCmds::KvIdent)
-            {
-              const Response response = m_kvHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (type == arrCmds::OArrayIdent)
-            {
-              const Response response = m_objectArrHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (type == arrCmds::IntArrayIdent)
-            {
-              const Response response = m_intArrHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (type == arrCmds::StrArrayIdent)
-            {
-              const Response response = m_strArrHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (type == arrCmds::SortedIntArrayIdent)
-            {
-              const Response response = m_sortedIntArrHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (type == arrCmds::SortedStrArrayIdent)
-            {
-              const Response response = m_sortedStrArrHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (type == lstCmds::ListIdent)
-            {
-              const Response response = m_listHandler->handle(command, request);
-              send(ws, response.rsp);
-            }
-            else if (command == sv::cmds::InfoReq)  // only one SV command at the moment
-            {
-              // the json_object_arg is a tag, followed by initializer_list<pair<string, njson>>
-              static const njson Info = {jsoncons::json_object_arg, {
-                                                                      {"st", toUnderlying(RequestStatus::Ok)},  // for compatibility with APIs and consistency
-                                                                      {"serverVersion",   NEMESIS_VERSION},
-                                                                      {"persistEnabled",  Settings::get().persistEnabled}
-                                                                    }};
-              static const njson Prepared {jsoncons::json_object_arg, {{sv::cmds::InfoRsp, Info}}}; 
-
-              send(ws, Prepared);
-            }
-            else  [[unlikely]]
-            {
-              static const njson Prepared {createErrorResponse(command+"_RSP", RequestStatus::CommandNotExist)};
-              send(ws, Prepared);
-            }
-          }
+      if (type == kvCmds::KvIdent)
+        return m_kvHandler->handle(command, request);
+      else if (type == arrCmds::OArrayIdent)
+        return m_objectArrHandler->handle(command, request);
+      else if (type == arrCmds::IntArrayIdent)
+        return m_intArrHandler->handle(command, request);
+      else if (type == arrCmds::StrArrayIdent)
+        return m_strArrHandler->handle(command, request);
+      else if (type == arrCmds::SortedIntArrayIdent)
+        return m_sortedIntArrHandler->handle(command, request);
+      else if (type == arrCmds::SortedStrArrayIdent)
+        return m_sortedStrArrHandler->handle(command, request);
+      else if (type == arrCmds::FloatArrayIdent)
+        return m_floatArrHandler->handle(command, request);
+      else if (type == arrCmds::SortedFloatArrayIdent)
+        return m_sortedFloatArrHandler->handle(command, request);
+      else if (type == lstCmds::ListIdent)
+        return m_listHandler->handle(command, request);
+      else if (type == vecCmds::VecIdent)
+        return m_vecHandler->handle(command, request);
+      else if (type == isetCmds::ISetIdent)
+        return m_intSetHandler->handle(command, request);
+      else if (command == sv::cmds::ClusterSlotsReq || command == sv::cmds::ClusterMigrateReq || command == sv::cmds::ClusterSetSlotReq)
+        return handleCluster(command, request);
+      else if (command == sv::cmds::InfoReq)
+      {
+        // the json_object_arg is a tag, followed by initializer_list<pair<string, njson>>
+        static const njson Info = {jsoncons::json_object_arg, {
+                                                                {"st", toUnderlying(RequestStatus::Ok)},  // for compatibility with APIs and consistency
+                                                                {"serverVersion",   NEMESIS_VERSION},
+                                                                {"persistEnabled",  Settings::get().persistEnabled},
+                                                                {"walEnabled",      Settings::get().wal.enabled}
+                                                              }};
+        static const njson Prepared {jsoncons::json_object_arg, {{sv::cmds::InfoRsp, Info}}}; 
+
+        if (!m_primary && !m_replica)
+          return Response{.rsp = Prepared};
+        else
+        {
+          Response response {.rsp = Prepared};
+          response.rsp[sv::cmds::InfoRsp]["replication"] = m_primary ? m_primary->info() : m_replica->info();
+          return response;
         }
       }
+      else  [[unlikely]]
+      {
+        return Response{.rsp = createErrorResponse(command+"_RSP", RequestStatus::CommandNotExist)};
+      }
+    }
+
+
+    Response handleCluster(const std::string& command, const njson& request)
+    {
+      const std::string rspName = command + "_RSP";
+
+      if (!m_cluster)
+        return Response{.rsp = createErrorResponse(rspName, RequestStatus::CommandDisabled)};
+      else if (command == sv::cmds::ClusterSlotsReq)
+        return Response{.rsp = njson{jsoncons::json_object_arg, {{rspName, m_cluster->slots()}}}};
+      else
+      {
+        const auto& body = request.at(command);
+
+        if (!body.contains("slot") || !body.contains("node"))
+          return Response{.rsp = createErrorResponse(rspName, RequestStatus::ParamMissing)};
+        else if (!body.at("slot").is_uint64() || !body.at("node").is_string())
+          return Response{.rsp = createErrorResponse(rspName, RequestStatus::ValueTypeInvalid)};
+
+        const auto slot = body.at("slot").as<std::size_t>();
+        const auto node = body.at("node").as_string_view();
+        const auto status = command == sv::cmds::ClusterMigrateReq ? m_cluster->migrate(slot, node) : m_cluster->setSlot(slot, node);
+
+        return Response{.rsp = createErrorResponse(rspName, status)};
+      }
+    }
+
+
+    bool openWal()
+    {
+      PLOGI << "-- WAL --";
+
+      m_wal = std::make_unique<Wal>(Settings::get().wal, Settings::get().persistPath / "wal");
+
+      const bool opened = m_wal->open(std::bind_front(&Server::apply, std::ref(*this)));
+
+      PLOGI << "----------";
+      return opened;
+    }
+
+
+    // Called on the event loop thread, so replication threads can wake the loop
+    void startReplication()
+    {
+      const auto& settings = Settings::get().replication;
+      auto wake = [loop = uWS::Loop::get()]{ loop->defer([]{}); };
+
+      if (settings.role == ReplicationRole::Primary)
+      {
+        m_primary = std::make_unique<replication::Primary>(settings.port, wake);
+
+        if (!m_primary->start())
+          m_primary.reset();
+      }
+      else if (settings.role == ReplicationRole::Replica)
+      {
+        m_replica = std::make_unique<replication::Replica>(settings.primaryIp, settings.primaryPort, wake);
+        m_replica->start();
+      }
+    }
+
+
+    // Called on the event loop thread, as startReplication()
+    void startCluster()
+    {
+      if (const auto& settings = Settings::get(); settings.cluster.enabled)
+      {
+        m_cluster = std::make_unique<cluster::Cluster>(settings.cluster, settings.interface.ip, settings.interface.port, [loop = uWS::Loop::get()]{ loop->defer([]{}); });
+
+        if (!m_cluster->start())
+          m_cluster.reset();
+      }
+    }
+
+
+    // Called on the event loop thread, as startReplication()
+    void startHandoff()
+    {
+      m_handoff = std::make_unique<handoff::Source>(Settings::get().interface.port, [loop = uWS::Loop::get()]{ loop->defer([]{}); });
+
+      if (!m_handoff->start())
+        m_handoff.reset();
+    }
+
+
+    // Loads the running server's data, before this server listens
+    bool receiveHandoff()
+    {
+      PLOGI << "-- Handoff --";
+
+      m_target = std::make_unique<handoff::Target>(Settings::get().interface.port);
+
+      const bool received = m_target->receive(std::bind_front(&kv::KvHandler::loadHandoff, std::ref(*m_kvHandler)),
+                                              std::bind_front(&Server::apply, std::ref(*this)));
+
+      PLOGI << "----------";
+
+      if (!received)
+        m_target.reset();
+
+      return received;
+    }
+
+
+    // Called on the event loop thread when listening. The running server stops.
+    bool takeOverHandoff()
+    {
+      const bool tookOver = m_target->takeOver(std::bind_front(&Server::apply, std::ref(*this)));
+
+      m_target.reset();
+
+      // the running server committed its log before it stopped
+      if (tookOver && Settings::get().wal.enabled)
+      {
+        m_wal = std::make_unique<Wal>(Settings::get().wal, Settings::get().persistPath / "wal");
+        return m_wal->open(std::bind_front(&Server::apply, std::ref(*this)), false);
+      }
+
+      return tookOver;
+    }
+
+
+    // This server's port has been taken by a new process
+    void stopServing()
+    {
+      PLOGI << "Handoff: stopping";
+
+      stop();
+
+      m_handoff->finish();
+
+      ::raise(SIGTERM);
+    }
+
+
+    // A replica's existing data is replaced by the primary's snapshot
+    void clearAll()
+    {
+      const std::array<std::string, 11> Clear { kvCmds::ClearReq,
+                                                arrCmds::OArrCmds::DeleteAllReq.data(),
+                                                arrCmds::IntArrCmds::DeleteAllReq.data(),
+                                                arrCmds::StrArrCmds::DeleteAllReq.data(),
+                                                arrCmds::SortedIntArrCmds::DeleteAllReq.data(),
+                                                arrCmds::SortedStrArrCmds::DeleteAllReq.data(),
+                                                arrCmds::FloatArrCmds::DeleteAllReq.data(),
+                                                arrCmds::SortedFloatArrCmds::DeleteAllReq.data(),
+                                                lstCmds::ListCmds::deleteAll.req.data(),
+                                                vecCmds::VectorCmds::deleteAll.req.data(),
+                                                isetCmds::IntSetCmds::deleteAll.req.data()};
+
+      for (const auto& command : Clear)
+      {
+        njson request {jsoncons::json_object_arg, {{command, njson::object()}}};
+        dispatch(command, request);
+      }
+    }
+
+
+    // Runs after each event loop iteration
+    void onLoopIteration()
+    {
+      // keys per iteration, small enough not to delay requests noticeably
+      static const std::size_t PrefetchBatch = 4096U;
+      // replicated requests per iteration
+      static const std::size_t ReplicaBatch = 4096U;
+
+      // searches completed on the pool, sent before the WAL commit so they're included in its sends
+      std::erase_if(m_pendingSearches, [this](auto& pending)
+      {
+        auto& [ws, search] = pending;
+
+        if (search.wait_for(std::chrono::seconds{0}) != std::future_status::ready)
+          return false;
+
+        send(ws, search.get().rsp);
+        return true;
+      });
+
+      if (m_wal)
+      {
+        // group commit: requests handled in this loop iteration are logged with one write.
+        // If that fails, the writes in it aren't acknowledged as Ok or replicated.
+        const bool committed = m_wal->commit();
+
+        for (const auto& [ws, msg, logged] : m_pendingSends)
+          ws->send(logged && !committed ? walFailResponse(msg) : msg, WsSendOpCode);
+
+        if (committed)
+        {
+          for (const auto& [record, resync] : m_pendingRecords)
+            replicate(record, resync);
+        }
+
+        m_pendingSends.clear();
+        m_pendingRecords.clear();
+
+        if (m_wal->needsCompact() && !(m_handoff && m_handoff->isActive()))
+          m_wal->compact(std::bind_front(&Server::dump, std::ref(*this)));
+        else
+          m_wal->pollCompact();
+      }
+
+      if (m_primary)
+      {
+        m_primary->commit();
+        m_primary->poll(std::bind_front(&Server::dump, std::ref(*this)));
+      }
+      else if (m_replica)
+      {
+        if (m_replica->poll(std::bind_front(&Server::apply, std::ref(*this)), std::bind_front(&Server::clearAll, std::ref(*this)), ReplicaBatch))
+          uWS::Loop::get()->defer([]{});
+      }
+
+      // hot restart, not whilst the WAL is being compacted because the compaction wouldn't complete
+      if (m_handoff && (m_handoff->isActive() || !m_wal || !m_wal->isCompacting()))
+      {
+        auto save = [this](const fs::path& dir, ForkTask::Progress& progress){ return m_kvHandler->saveHandoff(dir, progress); };
+
+        if (m_handoff->poll(save) == handoff::Source::Action::StopServing)
+          stopServing();
+      }
+
+      // slot migration, a batch per iteration
+      if (m_cluster && m_cluster->poll(std::bind_front(&Server::write, std::ref(*this)), std::bind_front(&kv::KvHandler::scanKeys, std::ref(*m_kvHandler))))
+        uWS::Loop::get()->defer([]{});
+
+      // a loaded mmap snapshot is decoded in the background, between requests. defer()
+      // wakes the loop so this continues when there are no requests.
+      if (m_kvHandler->prefetch(PrefetchBatch))
+        uWS::Loop::get()->defer([]{});
+    }
+
+
+    // Emits requests which recreate all data, used by WAL compaction and replication snapshots
+    void dump(const Wal::Emit& emit)
+    {
+      m_kvHandler->dump(emit);
+      m_objectArrHandler->dump(emit);
+      m_intArrHandler->dump(emit);
+      m_strArrHandler->dump(emit);
+      m_sortedIntArrHandler->dump(emit);
+      m_sortedStrArrHandler->dump(emit);
+      m_floatArrHandler->dump(emit);
+      m_sortedFloatArrHandler->dump(emit);
+      m_listHandler->dump(emit);
+      m_vecHandler->dump(emit);
+      m_intSetHandler->dump(emit);
+    }
+
+
+    // A large search runs on the vector handler's pool, its response is sent by onLoopIteration()
+    void search(KvWebSocket * ws, njson& request)
+    {
+      auto wake = [loop = uWS::Loop::get()]{ loop->defer([]{}); };
+
+      if (auto result = m_vecHandler->search(request, wake); std::holds_alternative<Response>(result))
+        send(ws, std::get<Response>(result).rsp);
+      else
+        m_pendingSearches.emplace_back(ws, std::move(std::get<vec::VectorHandler::PendingSearch>(result)));
     }
 
 
@@ -409,7 +856,7 @@ public:
       {
         LoadResult loadResult;
 
-        loadResult = m_kvHandler->internalLoad(loadName, info.paths.data);
+        loadResult = m_kvHandler->internalLoad(loadName, info);
         
         const auto success = loadResult.status == RequestStatus::LoadComplete;
     
@@ -435,13 +882,50 @@ public:
     }
     
 
-    ndb_always_inline void send (KvWebSocket * ws, const njson& msg)
+    // A response held for a WAL commit which failed, replaced by an error with the same name
+    static std::string walFailResponse (const std::string& msg)
+    {
+      try
+      {
+        const auto rsp = njson::parse(msg);
+
+        if (rsp.is_object() && rsp.size() == 1U)
+          return createErrorResponse(rsp.object_range().cbegin()->key(), RequestStatus::WalWriteFail).to_string();
+      }
+      catch (const std::exception&)
+      {
+      }
+
+      return createErrorResponse(RequestStatus::WalWriteFail).to_string();
+    }
+
+
+    // 'logged' if the response acknowledges a write appended to the WAL
+    ndb_always_inline void send (KvWebSocket * ws, const njson& msg, const bool logged = false)
     {
-      ws->send(msg.to_string(), WsSendOpCode);
+      if (m_wal)
+        m_pendingSends.push_back(PendingSend{.ws = ws, .msg = msg.to_string(), .logged = logged}); // sent after the WAL commit
+      else
+        ws->send(msg.to_string(), WsSendOpCode);
     }
 
 
   private:
+    // a response held until the WAL commit
+    struct PendingSend
+    {
+      KvWebSocket * ws;
+      std::string msg;
+      bool logged;
+    };
+
+    // a write logged in the WAL, replicated once it is committed
+    struct PendingRecord
+    {
+      Wal::Record record;
+      bool resync;
+    };
+
     struct TimerData
     {
       // TODO use when KV expiry is implemented
@@ -459,7 +943,20 @@ public:
     std::shared_ptr<arr::StrArrHandler> m_strArrHandler;
     std::shared_ptr<arr::SortedIntArrHandler> m_sortedIntArrHandler;
     std::shared_ptr<arr::SortedStrArrHandler> m_sortedStrArrHandler;
+    std::shared_ptr<arr::FloatArrHandler> m_floatArrHandler;
+    std::shared_ptr<arr::SortedFloatArrHandler> m_sortedFloatArrHandler;
     std::shared_ptr<lst::OLstHandler> m_listHandler;
+    std::shared_ptr<vec::VectorHandler> m_vecHandler;
+    std::shared_ptr<iset::IntSetHandler> m_intSetHandler;
+    std::unique_ptr<Wal> m_wal;
+    std::unique_ptr<replication::Primary> m_primary;
+    std::unique_ptr<replication::Replica> m_replica;
+    std::unique_ptr<cluster::Cluster> m_cluster;
+    std::unique_ptr<handoff::Source> m_handoff;
+    std::unique_ptr<handoff::Target> m_target;
+    std::vector<PendingSend> m_pendingSends;
+    std::vector<PendingRecord> m_pendingRecords;
+    std::vector<std::pair<KvWebSocket *, vec::VectorHandler::PendingSearch>> m_pendingSearches;
 };
 
 }
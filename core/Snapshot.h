@@ -0,0 +1,497 @@
+#ifndef NDB_CORE_SNAPSHOT_H
+#define NDB_CORE_SNAPSHOT_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <core/Compression.h>
+#include <core/ThreadPool.h>
+
+#ifdef __SSE4_2__
+  #include <nmmintrin.h>
+#endif
+
+
+/*
+Binary snapshot format, used by KV_SAVE/KV_LOAD.
+
+  File:   FileHeader Block* EndBlock
+  Block:  BlockHeader payload
+
+  FileHeader  (16 bytes): magic[8] ("NDBSNAP\0"), version (u16), flags (u16, the Codec), reserved (u32)
+  BlockHeader (16 bytes): size (u32, payload bytes), nRecords (u32), crc (u32, CRC32C of payload), rawSize (u32, uncompressed payload bytes)
+
+The EndBlock is a BlockHeader with size and nRecords both 0. A file without it is truncated.
+
+A record's layout is decided by the data type being saved, for keys:
+
+  keyLen (u32) | key bytes | valueLen (u32) | value as CBOR
+
+Integers are little endian, the server only targets x86-64.
+
+Records are appended to a block buffer until it reaches BlockSize, then the block is written
+with one write(). A record is never split across blocks. When a file reaches MaxFileSize,
+it is closed and the next file is opened, so several files can be read concurrently.
+
+With a codec, each block's payload is compressed independently. Blocks are compressed on a
+thread pool whilst the next block is filled, then written in order. The checksum is of the
+compressed payload, so corruption is detected before decompressing.
+
+Version 1 files have no compression and rawSize is 0, they are still read.
+*/
+
+
+namespace nemesis { namespace snapshot {
+
+
+  inline const std::uint16_t FORMAT_VERSION = 2;
+  inline constexpr std::array<char, 8> Magic {'N','D','B','S','N','A','P','\0'};
+
+
+  struct FileHeader
+  {
+    std::array<char, 8> magic{Magic};
+    std::uint16_t version{FORMAT_VERSION};
+    std::uint16_t flags{0};
+    std::uint32_t reserved{0};
+  };
+
+  struct BlockHeader
+  {
+    std::uint32_t size{0};
+    std::uint32_t nRecords{0};
+    std::uint32_t crc{0};
+    std::uint32_t rawSize{0};
+  };
+
+  static_assert(sizeof(FileHeader) == 16U && sizeof(BlockHeader) == 16U);
+
+
+  namespace detail
+  {
+    consteval std::array<std::uint32_t, 256> makeCrc32cTable()
+    {
+      std::array<std::uint32_t, 256> table{};
+
+      for (std::uint32_t i = 0; i < 256U; ++i)
+      {
+        std::uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+          crc = (crc & 1U) ? (crc >> 1) ^ 0x82F63B78U : (crc >> 1);
+
+        table[i] = crc;
+      }
+      return table;
+    }
+
+    inline constexpr std::array<std::uint32_t, 256> Crc32cTable = makeCrc32cTable();
+  }
+
+
+  // CRC32C (Castagnoli). Uses the SSE4.2 instruction when available (the build uses -march=native),
+  // the table fallback gives the same result so snapshots are portable between builds.
+  inline std::uint32_t crc32c (const std::uint8_t * data, std::size_t len, std::uint32_t crc = 0)
+  {
+    crc = ~crc;
+
+    #ifdef __SSE4_2__
+      std::uint64_t crc64 = crc;
+
+      for ( ; len >= 8U ; len -= 8U, data += 8U)
+      {
+        std::uint64_t v;
+        std::memcpy(&v, data, 8U);
+        crc64 = _mm_crc32_u64(crc64, v);
+      }
+
+      crc = static_cast<std::uint32_t>(crc64);
+
+      for ( ; len ; --len, ++data)
+        crc = _mm_crc32_u8(crc, *data);
+    #else
+      for ( ; len ; --len, ++data)
+        crc = detail::Crc32cTable[(crc ^ *data) & 0xFFU] ^ (crc >> 8);
+    #endif
+
+    return ~crc;
+  }
+
+
+  // Writes records into blocks, and blocks into files named 0, 1, 2, ... in the directory.
+  class SnapshotWriter
+  {
+  public:
+    static constexpr std::size_t BlockSize = 4U * 1024U * 1024U;
+    static constexpr std::size_t MaxFileSize = 64U * 1024U * 1024U;
+
+
+    SnapshotWriter(const std::filesystem::path& dir, const Codec codec = Codec::None) : m_dir(dir), m_codec(codec)
+    {
+      if (!isAvailable(codec))
+        throw std::runtime_error{"Compression codec unavailable"};
+
+      m_buffer.reserve(BlockSize + 64U * 1024U);
+    }
+
+    ~SnapshotWriter()
+    {
+      // not calling close() here: an unclosed file has no end block, so a failed save is detected when loading.
+      // m_pool's destructor waits for blocks being compressed
+    }
+
+
+    void putU32 (const std::uint32_t v)
+    {
+      putBytes(&v, sizeof(v));
+    }
+
+
+    void putU64 (const std::uint64_t v)
+    {
+      putBytes(&v, sizeof(v));
+    }
+
+
+    void putBytes (const void * data, const std::size_t size)
+    {
+      const auto * bytes = static_cast<const std::uint8_t *>(data);
+      m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+    }
+
+
+    // length prefixed
+    void putString (const std::string_view s)
+    {
+      putU32(static_cast<std::uint32_t>(s.size()));
+      putBytes(s.data(), s.size());
+    }
+
+
+    // length prefixed
+    void putBlob (const std::span<const std::uint8_t> blob)
+    {
+      putU32(static_cast<std::uint32_t>(blob.size()));
+      putBytes(blob.data(), blob.size());
+    }
+
+
+    void endRecord ()
+    {
+      ++m_blockRecords;
+      ++m_nRecords;
+
+      if (m_buffer.size() >= BlockSize)
+        flushBlock();
+    }
+
+
+    // flush the final block and write the end block
+    void close ()
+    {
+      flushBlock();
+
+      while (!m_pending.empty())
+        writePending();
+
+      if (m_stream.is_open())
+        closeFile();
+    }
+
+
+    std::size_t nRecords() const noexcept { return m_nRecords; }
+    std::size_t nFiles() const noexcept { return m_nFiles; }
+
+
+  private:
+
+    struct StoredBlock
+    {
+      BlockHeader header;
+      std::vector<std::uint8_t> payload;
+    };
+
+
+    void flushBlock ()
+    {
+      if (m_blockRecords == 0)
+        return;
+
+      if (m_codec == Codec::None)
+      {
+        BlockHeader header;
+        header.size = static_cast<std::uint32_t>(m_buffer.size());
+        header.nRecords = m_blockRecords;
+        header.crc = crc32c(m_buffer.data(), m_buffer.size());
+        header.rawSize = header.size;
+
+        writeBlock(header, m_buffer);
+        m_buffer.clear();
+      }
+      else
+      {
+        if (!m_pool)
+          m_pool = std::make_unique<ThreadPool>();
+
+        // the pool compresses whilst this thread fills the next block
+        m_pending.push_back(m_pool->submit([codec = m_codec, nRecords = m_blockRecords, raw = std::move(m_buffer)]
+        {
+          StoredBlock block;
+          compress(codec, raw, block.payload);
+
+          block.header.size = static_cast<std::uint32_t>(block.payload.size());
+          block.header.nRecords = nRecords;
+          block.header.crc = crc32c(block.payload.data(), block.payload.size());
+          block.header.rawSize = static_cast<std::uint32_t>(raw.size());
+          return block;
+        }));
+
+        m_buffer = std::vector<std::uint8_t>{};
+        m_buffer.reserve(BlockSize + 64U * 1024U);
+
+        // bounds memory: each pending block holds up to BlockSize
+        while (m_pending.size() > m_pool->size() * 2U)
+          writePending();
+      }
+
+      m_blockRecords = 0;
+    }
+
+
+    void writePending ()
+    {
+      const auto block = m_pending.front().get(); // rethrows a compression error
+      m_pending.pop_front();
+      writeBlock(block.header, block.payload);
+    }
+
+
+    void writeBlock (const BlockHeader& header, const std::span<const std::uint8_t> payload)
+    {
+      if (!m_stream.is_open())
+        openFile();
+
+      write(&header, sizeof(header));
+      write(payload.data(), payload.size());
+
+      // uncompressed size, so a compressed save has as many files as an uncompressed one,
+      // and they're decompressed in parallel when loading
+      m_fileSize += sizeof(header) + header.rawSize;
+
+      if (m_fileSize >= MaxFileSize)
+        closeFile();
+    }
+
+
+    void openFile ()
+    {
+      m_stream.open(m_dir / std::to_string(m_nFiles), std::ios_base::binary | std::ios_base::trunc | std::ios_base::out);
+
+      if (!m_stream.is_open())
+        throw std::runtime_error{"Could not open snapshot file"};
+
+      FileHeader header;
+      header.flags = static_cast<std::uint16_t>(m_codec);
+      write(&header, sizeof(header));
+      m_fileSize = sizeof(header);
+    }
+
+
+    void closeFile ()
+    {
+      const BlockHeader end;
+      write(&end, sizeof(end));
+
+      m_stream.close();
+      ++m_nFiles;
+      m_fileSize = 0;
+    }
+
+
+    void write (const void * data, const std::size_t size)
+    {
+      if (!m_stream.write(static_cast<const char *>(data), size))
+        throw std::runtime_error{"Snapshot write failed"};
+    }
+
+
+  private:
+    std::filesystem::path m_dir;
+    std::ofstream m_stream;
+    std::vector<std::uint8_t> m_buffer;
+    Codec m_codec;
+    std::deque<std::future<StoredBlock>> m_pending;  // compressing, in file order
+    std::unique_ptr<ThreadPool> m_pool;               // last, so destroyed first
+    std::uint32_t m_blockRecords{0};
+    std::size_t m_nRecords{0};
+    std::size_t m_nFiles{0};
+    std::size_t m_fileSize{0};
+  };
+
+
+  // The files SnapshotWriter wrote to 'dir', in the order written. Directory order is unspecified,
+  // and the records of one array or list can continue from one file into the next.
+  inline std::vector<std::filesystem::path> dataFiles (const std::filesystem::path& dir)
+  {
+    std::vector<std::pair<std::uint64_t, std::filesystem::path>> files;
+
+    for (const auto& entry : std::filesystem::directory_iterator{dir})
+    {
+      const auto name = entry.path().filename().string();
+      std::uint64_t index = 0;
+
+      if (const auto [end, err] = std::from_chars(name.data(), name.data() + name.size(), index); err != std::errc{} || end != name.data() + name.size())
+        throw std::runtime_error{"Unexpected snapshot file: " + name};
+
+      files.emplace_back(index, entry.path());
+    }
+
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::filesystem::path> paths;
+    paths.reserve(files.size());
+
+    for (auto& [index, path] : files)
+      paths.emplace_back(std::move(path));
+
+    return paths;
+  }
+
+
+  // Reads a snapshot file one block at a time. Each block's checksum is verified before
+  // records are read. All errors throw.
+  class SnapshotReader
+  {
+  public:
+    SnapshotReader(const std::filesystem::path& path) : m_stream(path, std::ios_base::binary | std::ios_base::in)
+    {
+      FileHeader header;
+
+      if (!m_stream.read(reinterpret_cast<char *>(&header), sizeof(header)) || header.magic != Magic)
+        throw std::runtime_error{"Not a snapshot file"};
+      else if (header.version == 0 || header.version > FORMAT_VERSION)
+        throw std::runtime_error{"Unsupported snapshot version"};
+
+      m_codec = header.version == 1 ? Codec::None : static_cast<Codec>(header.flags);
+
+      if (!isAvailable(m_codec))
+        throw std::runtime_error{"Snapshot compressed with a codec unavailable in this build"};
+    }
+
+
+    static bool isSnapshotFile (const std::filesystem::path& path)
+    {
+      std::array<char, 8> magic{};
+      std::ifstream stream{path, std::ios_base::binary | std::ios_base::in};
+      return stream.read(magic.data(), magic.size()) && magic == Magic;
+    }
+
+
+    // Returns false when the end block is reached.
+    bool nextBlock ()
+    {
+      BlockHeader header;
+
+      if (!m_stream.read(reinterpret_cast<char *>(&header), sizeof(header)))
+        throw std::runtime_error{"Snapshot file truncated"};
+      else if (header.size == 0 && header.nRecords == 0)
+        return false;
+
+      // uncompressed blocks are read directly into m_buffer
+      auto& payload = m_codec == Codec::None ? m_buffer : m_compressed;
+      payload.resize(header.size);
+
+      if (!m_stream.read(reinterpret_cast<char *>(payload.data()), header.size))
+        throw std::runtime_error{"Snapshot file truncated"};
+      else if (crc32c(payload.data(), payload.size()) != header.crc)
+        throw std::runtime_error{"Snapshot block checksum mismatch"};
+      else if (m_codec != Codec::None)
+        decompress(m_codec, m_compressed, header.rawSize, m_buffer);
+
+      m_blockRecords = header.nRecords;
+      m_pos = 0;
+      return true;
+    }
+
+
+    std::uint32_t blockRecords() const noexcept
+    {
+      return m_blockRecords;
+    }
+
+
+    std::uint32_t getU32 ()
+    {
+      std::uint32_t v;
+      std::memcpy(&v, take(sizeof(v)), sizeof(v));
+      return v;
+    }
+
+
+    std::uint64_t getU64 ()
+    {
+      std::uint64_t v;
+      std::memcpy(&v, take(sizeof(v)), sizeof(v));
+      return v;
+    }
+
+
+    // length prefixed. The view is valid until the next call to nextBlock()
+    std::string_view getString ()
+    {
+      const auto size = getU32();
+      return std::string_view{reinterpret_cast<const char *>(take(size)), size};
+    }
+
+
+    // length prefixed. The span is valid until the next call to nextBlock()
+    std::span<const std::uint8_t> getBlob ()
+    {
+      const auto size = getU32();
+      return std::span<const std::uint8_t>{take(size), size};
+    }
+
+
+    std::span<const std::uint8_t> getBytes (const std::size_t size)
+    {
+      return std::span<const std::uint8_t>{take(size), size};
+    }
+
+
+  private:
+
+    const std::uint8_t * take (const std::size_t size)
+    {
+      if (m_pos + size > m_buffer.size())
+        throw std::runtime_error{"Snapshot record exceeds block"};
+
+      const auto * p = m_buffer.data() + m_pos;
+      m_pos += size;
+      return p;
+    }
+
+
+  private:
+    std::ifstream m_stream;
+    std::vector<std::uint8_t> m_buffer;
+    std::vector<std::uint8_t> m_compressed;
+    Codec m_codec{Codec::None};
+    std::size_t m_pos{0};
+    std::uint32_t m_blockRecords{0};
+  };
+
+}
+}
+
+#endif
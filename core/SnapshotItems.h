@@ -0,0 +1,102 @@
+#ifndef NDB_CORE_SNAPSHOTITEMS_H
+#define NDB_CORE_SNAPSHOTITEMS_H
+
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <vector>
+#include <jsoncons_ext/cbor/cbor.hpp>
+#include <core/NemesisCommon.h>
+#include <core/Snapshot.h>
+
+
+/*
+Encoding of array and list items in snapshot records, specialised by item type:
+
+  std::int64_t  a raw block of n * 8 bytes
+  double        a raw block of n * 8 bytes
+  std::string   length prefixed, as SnapshotWriter::putString()
+  njson         length prefixed CBOR
+
+The number of items is written by the caller.
+*/
+
+
+namespace nemesis { namespace snapshot {
+
+
+  // 'buffer' is reused between calls to avoid allocating for each CBOR item
+  template<typename T>
+  void putItem (SnapshotWriter& writer, const T& item, std::vector<std::uint8_t>& buffer)
+  {
+    if constexpr (std::is_same_v<T, std::int64_t>)
+      writer.putU64(static_cast<std::uint64_t>(item));
+    else if constexpr (std::is_same_v<T, double>)
+      writer.putU64(std::bit_cast<std::uint64_t>(item));
+    else if constexpr (std::is_same_v<T, std::string>)
+      writer.putString(item);
+    else
+    {
+      buffer.clear();
+      jsoncons::cbor::encode_cbor(item, buffer);
+      writer.putBlob(buffer);
+    }
+  }
+
+
+  template<typename T>
+  void putItems (SnapshotWriter& writer, const std::span<const T> items, std::vector<std::uint8_t>& buffer)
+  {
+    if constexpr (std::is_same_v<T, std::int64_t> || std::is_same_v<T, double>)
+      writer.putBytes(items.data(), items.size_bytes());
+    else
+    {
+      for (const auto& item : items)
+        putItem(writer, item, buffer);
+    }
+  }
+
+
+  template<typename T>
+  T getItem (SnapshotReader& reader)
+  {
+    if constexpr (std::is_same_v<T, std::int64_t>)
+      return static_cast<std::int64_t>(reader.getU64());
+    else if constexpr (std::is_same_v<T, double>)
+      return std::bit_cast<double>(reader.getU64());
+    else if constexpr (std::is_same_v<T, std::string>)
+      return std::string{reader.getString()};
+    else
+    {
+      const auto blob = reader.getBlob();
+      return jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{blob.data(), blob.size()});
+    }
+  }
+
+
+  // Replaces the content of 'items'
+  template<typename T>
+  void getItems (SnapshotReader& reader, const std::size_t n, std::vector<T>& items)
+  {
+    if constexpr (std::is_same_v<T, std::int64_t> || std::is_same_v<T, double>)
+    {
+      const auto bytes = reader.getBytes(n * sizeof(T));
+      items.resize(n);
+      std::memcpy(items.data(), bytes.data(), bytes.size());
+    }
+    else
+    {
+      items.clear();
+      items.reserve(n);
+
+      for (std::size_t i = 0 ; i < n ; ++i)
+        items.emplace_back(getItem<T>(reader));
+    }
+  }
+
+}
+}
+
+#endif
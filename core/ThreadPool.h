@@ -0,0 +1,203 @@
+#ifndef NDB_CORE_THREADPOOL_H
+#define NDB_CORE_THREADPOOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace nemesis {
+
+
+/*
+Fixed number of threads which run submitted tasks in FIFO order.
+
+A pool is created where it's needed (i.e. for the duration of a load) rather than
+shared by the process. This is important with fork(): only the calling thread exists
+in the child, so a pool created before the fork is unusable in the child.
+*/
+class ThreadPool
+{
+public:
+
+  static std::size_t defaultSize() noexcept
+  {
+    return std::max<std::size_t>(1U, std::thread::hardware_concurrency());
+  }
+
+
+  ThreadPool(const std::size_t nThreads = defaultSize())
+  {
+    m_threads.reserve(nThreads);
+
+    for (std::size_t i = 0 ; i < nThreads ; ++i)
+      m_threads.emplace_back([this]{ run(); });
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+  ~ThreadPool()
+  {
+    {
+      std::scoped_lock lck{m_mux};
+      m_stop = true;
+    }
+
+    m_cv.notify_all();
+    m_threads.clear(); // joins, tasks already queued are completed first
+  }
+
+
+  template<typename F>
+  auto submit (F&& f) -> std::future<std::invoke_result_t<F>>
+  {
+    using R = std::invoke_result_t<F>;
+
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    auto future = task->get_future();
+
+    {
+      std::scoped_lock lck{m_mux};
+      m_tasks.emplace([task]{ (*task)(); });
+    }
+
+    m_cv.notify_one();
+    return future;
+  }
+
+
+  std::size_t size() const noexcept
+  {
+    return m_threads.size();
+  }
+
+
+private:
+
+  void run ()
+  {
+    while (true)
+    {
+      std::function<void()> task;
+
+      {
+        std::unique_lock lck{m_mux};
+        m_cv.wait(lck, [this]{ return m_stop || !m_tasks.empty(); });
+
+        if (m_tasks.empty())
+          return; // stopping and nothing left to do
+
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+      }
+
+      task();
+    }
+  }
+
+
+private:
+  std::mutex m_mux;
+  std::condition_variable m_cv;
+  std::queue<std::function<void()>> m_tasks;
+  bool m_stop{false};
+  std::vector<std::jthread> m_threads;  // last member: threads must stop before the above are destroyed
+};
+
+
+
+/*
+Multiple producer, single consumer queue with a capacity, so producers
+can't get too far ahead of the consumer.
+
+Each producer calls producerDone() when finished. pop() returns false when all
+producers are done and the queue is empty. close() releases producers blocked
+in push() if the consumer stops early.
+*/
+template<typename T>
+class BoundedQueue
+{
+public:
+  BoundedQueue(const std::size_t capacity, const std::size_t nProducers) : m_capacity(capacity), m_nProducers(nProducers)
+  {
+  }
+
+
+  // Returns false if the queue was closed, in which case the item is discarded.
+  bool push (T&& item)
+  {
+    {
+      std::unique_lock lck{m_mux};
+      m_notFull.wait(lck, [this]{ return m_closed || m_queue.size() < m_capacity; });
+
+      if (m_closed)
+        return false;
+
+      m_queue.push(std::move(item));
+    }
+
+    m_notEmpty.notify_one();
+    return true;
+  }
+
+
+  bool pop (T& item)
+  {
+    {
+      std::unique_lock lck{m_mux};
+      m_notEmpty.wait(lck, [this]{ return !m_queue.empty() || m_nProducers == 0; });
+
+      if (m_queue.empty())
+        return false;
+
+      item = std::move(m_queue.front());
+      m_queue.pop();
+    }
+
+    m_notFull.notify_one();
+    return true;
+  }
+
+
+  void producerDone ()
+  {
+    {
+      std::scoped_lock lck{m_mux};
+      --m_nProducers;
+    }
+    m_notEmpty.notify_all();
+  }
+
+
+  void close ()
+  {
+    {
+      std::scoped_lock lck{m_mux};
+      m_closed = true;
+    }
+    m_notFull.notify_all();
+  }
+
+
+private:
+  std::mutex m_mux;
+  std::condition_variable m_notFull;
+  std::condition_variable m_notEmpty;
+  std::queue<T> m_queue;
+  std::size_t m_capacity;
+  std::size_t m_nProducers;
+  bool m_closed{false};
+};
+
+}
+
+#endif
@@ -0,0 +1,700 @@
+#ifndef NDB_CORE_WAL_H
+#define NDB_CORE_WAL_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <jsoncons_ext/cbor/cbor.hpp>
+#include <core/NemesisCommon.h>
+#include <core/NemesisConfig.h>
+#include <core/ForkTask.h>
+#include <core/Snapshot.h>
+#include <core/ThreadPool.h>
+
+
+/*
+Write-ahead log of mutating requests.
+
+  <persist::path>/wal/<seq>.log    segments, appended to in order
+  <persist::path>/wal/<seq>.base   state at the end of segment <seq>, written by compaction
+
+  File:    header Record*
+  Header   (16 bytes): magic[8] ("NDBWAL\0\0"), version (u16), flags (u16), reserved (u32)
+  Record:  size (u32) | crc (u32, CRC32C of payload) | payload (the request as CBOR)
+
+A request is appended if it is a write command (isWrite()) and it succeeded. Records are
+buffered and written by commit(), which the server calls once per event loop iteration, so
+all writes from an iteration share one write() and, with fsync "always", one fdatasync().
+Responses are sent after commit().
+
+If a commit's write or sync fails, the segment is truncated to the end of the previous commit,
+so it never holds a torn record before later ones, and the WAL has failed: commit() then
+fails if any record was appended and the server refuses writes, because the data in memory
+includes changes which weren't logged. Compaction stops for the same reason.
+
+Startup replays the newest base then the segments after it. A torn record at the end of
+the last segment (crash during write) is truncated. Compaction rotates to a new segment,
+then a forked child writes the server's state as requests to a new base. When the child
+completes, segments covered by the base are deleted.
+*/
+
+
+namespace nemesis {
+
+
+class Wal
+{
+public:
+  using Record = std::vector<std::uint8_t>;
+  using Emit = std::function<void(const njson&)>;
+  using Dump = std::function<void(const Emit&)>;
+  using Apply = std::function<void(njson&)>;
+
+
+  static constexpr std::uint16_t FORMAT_VERSION = 1;
+  static constexpr std::array<char, 8> Magic {'N','D','B','W','A','L','\0','\0'};
+  static constexpr std::size_t MaxSegmentSize = 64U * 1024U * 1024U;
+
+
+  struct Header
+  {
+    std::array<char, 8> magic{Magic};
+    std::uint16_t version{FORMAT_VERSION};
+    std::uint16_t flags{0};
+    std::uint32_t reserved{0};
+  };
+
+  static_assert(sizeof(Header) == 16U);
+
+
+  Wal(const WalSettings& settings, const fs::path& dir) : m_settings(settings), m_dir(dir)
+  {
+  }
+
+  Wal(const Wal&) = delete;
+  Wal& operator=(const Wal&) = delete;
+
+
+  ~Wal()
+  {
+    m_syncThread = std::jthread{}; // stop and join before closing the fd
+
+    if (m_fd >= 0)
+    {
+      ::fdatasync(m_fd);
+      ::close(m_fd);
+    }
+  }
+
+
+  // Command names, after the type ident, which change data
+  static bool isWrite (const std::string_view command)
+  {
+    static const std::set<std::string_view, std::less<>> Writes = {"SET", "SET_RNG", "ADD", "RMV", "CLEAR", "CLEAR_SET", "LOAD",
+                                                                   "CREATE", "DELETE", "DELETE_ALL", "SWAP", "SPLICE", "SUB", "MUL", "DIV",
+                                                                   "RESERVE", "SHRINK", "SORT", "UNIQUE", "TO_SORTED"};
+
+    const auto pos = command.find('_');
+    return pos != std::string_view::npos && Writes.contains(command.substr(pos+1));
+  }
+
+
+  // As above, and array and set operations which store their result with "dest"
+  static bool isWrite (const std::string_view command, const njson& body)
+  {
+    static const std::set<std::string_view, std::less<>> Stores = {"INTERSECT", "UNION", "XOR", "DIFF"};
+
+    if (isWrite(command))
+      return true;
+
+    const auto pos = command.find('_');
+    return pos != std::string_view::npos && Stores.contains(command.substr(pos+1)) && body.contains("dest");
+  }
+
+
+  static bool isSuccess (const Response& response)
+  {
+    if (!response.rsp.is_object() || response.rsp.empty())
+      return false;
+
+    const auto& body = response.rsp.object_range().cbegin()->value();
+    return  body.contains("st") &&
+            (body.at("st") == toUnderlying(RequestStatus::Ok) || body.at("st") == toUnderlying(RequestStatus::LoadComplete));
+  }
+
+
+  // Encoded before the request is handled: handlers may move from the request
+  static Record encode (const njson& request)
+  {
+    Record record;
+    jsoncons::cbor::encode_cbor(request, record);
+    return record;
+  }
+
+
+
+  // Replays the newest base and the segments after it, then opens a new segment.
+  // Returns false if the log is invalid, which should prevent startup.
+  // Without 'replay' the data must already match the log, i.e. after a handoff.
+  bool open (const Apply& apply, const bool replay = true)
+  {
+    try
+    {
+      if (!fs::exists(m_dir))
+        fs::create_directories(m_dir);
+
+      const auto [base, segments] = findFiles();
+
+      m_nextSeq = base ? *base + 1 : 1U;
+
+      if (!segments.empty())
+        m_nextSeq = std::max(m_nextSeq, segments.back() + 1);
+
+      const auto start = NemesisClock::now();
+      ThreadPool pool;
+
+      if (base && replay)
+        m_nReplayed += replayFile(pool, basePath(*base), apply, false);
+
+      for (std::size_t i = 0 ; i < segments.size() ; ++i)
+      {
+        if (replay)
+          m_nReplayed += replayFile(pool, segmentPath(segments[i]), apply, i == segments.size()-1);
+
+        m_logSize += fs::file_size(segmentPath(segments[i]));
+      }
+
+      if (replay)
+        PLOGI << "WAL replayed " << m_nReplayed << " requests in " << chrono::duration_cast<chrono::milliseconds>(NemesisClock::now() - start).count() << "ms";
+
+      openSegment();
+
+      if (m_settings.fsync == WalFsync::EverySec)
+        m_syncThread = std::jthread{[this](std::stop_token stop){ syncEverySecond(stop); }};
+
+      return true;
+    }
+    catch (const std::exception& ex)
+    {
+      PLOGF << "WAL: " << ex.what();
+      return false;
+    }
+  }
+
+
+  std::size_t nReplayed() const noexcept
+  {
+    return m_nReplayed;
+  }
+
+
+  void append (const Record& record)
+  {
+    frame(m_buffer, record);
+  }
+
+
+  // Writes buffered records with one write(). Returns false on a write or sync error, or if records
+  // were buffered after the WAL failed.
+  bool commit ()
+  {
+    if (m_buffer.empty())
+      return true;
+    else if (m_failed)
+    {
+      m_buffer.clear();
+      return false;
+    }
+
+    bool ok = writeAll(m_fd, m_buffer.data(), m_buffer.size());
+
+    if (ok && m_settings.fsync == WalFsync::Always)
+      ok = ::fdatasync(m_fd) == 0;
+    else if (ok && m_settings.fsync == WalFsync::EverySec)
+      m_dirty.store(true, std::memory_order_release);
+
+    if (!ok)
+    {
+      PLOGE << "WAL write failed: " << std::strerror(errno) << ". Writes are refused.";
+
+      // remove a partial write, the segment is O_APPEND so the next write would follow it
+      if (::ftruncate(m_fd, m_segmentSize) != 0)
+        PLOGE << "WAL truncate failed: " << std::strerror(errno);
+
+      m_failed = true;
+      m_buffer.clear();
+      return false;
+    }
+
+    m_segmentSize += m_buffer.size();
+    m_logSize += m_buffer.size();
+    m_buffer.clear();
+
+    if (m_segmentSize >= MaxSegmentSize)
+      rotate();
+
+    return true;
+  }
+
+
+  // A commit failed, see commit()
+  bool hasFailed () const noexcept
+  {
+    return m_failed;
+  }
+
+
+  bool isCompacting () const noexcept
+  {
+    return m_compact.state() == ForkTask::State::Running;
+  }
+
+
+  bool needsCompact () const noexcept
+  {
+    return !m_failed && m_logSize >= m_settings.compactSize && m_compact.state() != ForkTask::State::Running;
+  }
+
+
+  // Rotates the segment then writes a base in a child process. Call commit() first.
+  bool compact (const Dump& dump)
+  {
+    if (m_failed || m_compact.poll() == ForkTask::State::Running || !rotate())
+      return false;
+
+    const auto baseSeq = m_nextSeq - 2; // the segment before the one just opened
+    const auto tmpPath = basePath(baseSeq).concat(".tmp");
+
+    auto write = [dump, tmpPath](ForkTask::Progress& progress)
+    {
+      // runs in the child process
+      const int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+      if (fd < 0)
+        return false;
+
+      std::vector<std::uint8_t> buffer;
+      bool ok = writeHeader(fd);
+
+      dump([&](const njson& request)
+      {
+        if (ok)
+        {
+          frame(buffer, encode(request));
+
+          if (buffer.size() >= snapshot::SnapshotWriter::BlockSize)
+          {
+            ok = writeAll(fd, buffer.data(), buffer.size());
+            buffer.clear();
+          }
+
+          ++progress.done;
+        }
+      });
+
+      ok = ok && writeAll(fd, buffer.data(), buffer.size()) && ::fsync(fd) == 0;
+      ::close(fd);
+      return ok;
+    };
+
+    if (!m_compact.start(write, 0))
+    {
+      PLOGE << "WAL compaction failed to start";
+      return false;
+    }
+    else
+    {
+      PLOGI << "WAL compaction started, fork: " << chrono::duration_cast<chrono::microseconds>(m_compact.forkDuration()).count() << "us";
+      m_compactSeq = baseSeq;
+      m_logSize = m_segmentSize;
+      return true;
+    }
+  }
+
+
+  // When compaction completes, install the base and remove segments it replaces
+  void pollCompact ()
+  {
+    if (m_compact.state() != ForkTask::State::Running || m_compact.poll() == ForkTask::State::Running)
+      return;
+
+    const auto tmpPath = basePath(m_compactSeq).concat(".tmp");
+
+    try
+    {
+      if (m_compact.state() == ForkTask::State::Error)
+      {
+        PLOGE << "WAL compaction failed" << (m_compact.error().empty() ? "" : ": ") << m_compact.error();
+        fs::remove(tmpPath);
+      }
+      else
+      {
+        fs::rename(tmpPath, basePath(m_compactSeq));
+        syncDir();
+
+        // the new base replaces older bases and segments up to and including m_compactSeq
+        removeBefore(m_compactSeq);
+
+        PLOGI << "WAL compaction complete: " << m_compact.done() << " requests in " << chrono::duration_cast<chrono::milliseconds>(m_compact.duration()).count() << "ms";
+      }
+    }
+    catch (const std::exception& ex)
+    {
+      PLOGE << "WAL compaction: " << ex.what();
+    }
+  }
+
+
+private:
+
+  static void frame (std::vector<std::uint8_t>& buffer, const Record& record)
+  {
+    const std::uint32_t size = static_cast<std::uint32_t>(record.size());
+    const std::uint32_t crc = snapshot::crc32c(record.data(), record.size());
+
+    const auto * sizeBytes = reinterpret_cast<const std::uint8_t *>(&size);
+    const auto * crcBytes = reinterpret_cast<const std::uint8_t *>(&crc);
+
+    buffer.insert(buffer.end(), sizeBytes, sizeBytes + sizeof(size));
+    buffer.insert(buffer.end(), crcBytes, crcBytes + sizeof(crc));
+    buffer.insert(buffer.end(), record.cbegin(), record.cend());
+  }
+
+
+  static bool writeAll (const int fd, const std::uint8_t * data, std::size_t size)
+  {
+    while (size)
+    {
+      if (const auto n = ::write(fd, data, size); n < 0)
+      {
+        if (errno != EINTR)
+          return false;
+      }
+      else
+      {
+        data += n;
+        size -= static_cast<std::size_t>(n);
+      }
+    }
+    return true;
+  }
+
+
+  static bool writeHeader (const int fd)
+  {
+    const Header header;
+    return writeAll(fd, reinterpret_cast<const std::uint8_t *>(&header), sizeof(header));
+  }
+
+
+  fs::path segmentPath (const std::uint64_t seq) const
+  {
+    return m_dir / (std::to_string(seq) + ".log");
+  }
+
+
+  fs::path basePath (const std::uint64_t seq) const
+  {
+    return m_dir / (std::to_string(seq) + ".base");
+  }
+
+
+  // The newest base, and segments after it in order. Removes files left by an interrupted compaction.
+  std::tuple<std::optional<std::uint64_t>, std::vector<std::uint64_t>> findFiles ()
+  {
+    std::optional<std::uint64_t> base;
+    std::vector<std::uint64_t> segments;
+
+    for (const auto& entry : fs::directory_iterator{m_dir})
+    {
+      const auto& path = entry.path();
+
+      if (path.extension() == ".tmp")
+        fs::remove(path);
+      else if (path.extension() == ".base")
+        base = std::max<std::uint64_t>(base.value_or(0), std::stoull(path.stem()));
+      else if (path.extension() == ".log")
+        segments.push_back(std::stoull(path.stem()));
+    }
+
+    if (base)
+    {
+      removeBefore(*base);
+      std::erase_if(segments, [b = *base](const auto seq){ return seq <= b; });
+    }
+
+    std::sort(segments.begin(), segments.end());
+    return {base, segments};
+  }
+
+
+  // Removes segments with seq <= 'seq' and bases older than 'seq'
+  void removeBefore (const std::uint64_t seq)
+  {
+    for (const auto& entry : fs::directory_iterator{m_dir})
+    {
+      const auto& path = entry.path();
+
+      if ((path.extension() == ".log" && std::stoull(path.stem()) <= seq) ||
+          (path.extension() == ".base" && std::stoull(path.stem()) < seq))
+      {
+        fs::remove(path);
+      }
+    }
+  }
+
+
+  void openSegment ()
+  {
+    const auto path = segmentPath(m_nextSeq);
+
+    if (const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644); fd < 0)
+      throw std::runtime_error{"Could not open WAL segment"};
+    else if (!writeHeader(fd))
+    {
+      ::close(fd);
+      throw std::runtime_error{"Could not write WAL segment"};
+    }
+    else
+    {
+      std::scoped_lock lck{m_fdMux};
+
+      if (m_fd >= 0)
+      {
+        ::fdatasync(m_fd);
+        ::close(m_fd);
+      }
+
+      m_fd = fd;
+      m_segmentSize = sizeof(Header);
+      ++m_nextSeq;
+    }
+
+    syncDir();
+  }
+
+
+  bool rotate ()
+  {
+    try
+    {
+      openSegment();
+      return true;
+    }
+    catch (const std::exception& ex)
+    {
+      PLOGE << "WAL: " << ex.what(); // continue with the current segment
+      return false;
+    }
+  }
+
+
+  void syncDir ()
+  {
+    if (const int fd = ::open(m_dir.c_str(), O_RDONLY | O_DIRECTORY); fd >= 0)
+    {
+      ::fsync(fd);
+      ::close(fd);
+    }
+  }
+
+
+  void syncEverySecond (std::stop_token stop)
+  {
+    std::mutex mux;
+    std::condition_variable_any cv;
+
+    while (!stop.stop_requested())
+    {
+      {
+        std::unique_lock lck{mux};
+        cv.wait_for(lck, stop, chrono::seconds{1}, []{ return false; });
+      }
+
+      if (m_dirty.exchange(false, std::memory_order_acq_rel))
+      {
+        std::scoped_lock lck{m_fdMux};
+        ::fdatasync(m_fd);
+      }
+    }
+  }
+
+
+  // Reads records in chunks and decodes them in parallel, but applies them in order on the calling thread.
+  // A torn record is only allowed at the end of the last segment, where it is truncated.
+  std::size_t replayFile (ThreadPool& pool, const fs::path& path, const Apply& apply, const bool isLastSegment)
+  {
+    static const std::size_t ChunkSize = 8U * 1024U * 1024U;
+    static const std::size_t BatchRecords = 1024U;
+
+    using Batch = std::vector<njson>;
+
+    std::ifstream stream{path, std::ios_base::binary | std::ios_base::in};
+    Header header;
+
+    if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)))
+    {
+      // crashed before the header was written
+      if (isLastSegment)
+        return 0U;
+      else
+        throw std::runtime_error{"WAL file truncated: " + path.string()};
+    }
+    else if (header.magic != Magic || header.version != FORMAT_VERSION)
+      throw std::runtime_error{"Not a WAL file: " + path.string()};
+
+
+    std::deque<std::future<Batch>> pending;
+    std::size_t nRecords = 0;
+
+    auto applyFront = [&]()
+    {
+      auto batch = pending.front().get();
+      pending.pop_front();
+
+      for (auto& request : batch)
+        apply(request);
+
+      nRecords += batch.size();
+    };
+
+
+    std::vector<std::uint8_t> chunk;
+    std::size_t chunkOffset = sizeof(Header);  // file offset of chunk[0]
+    std::size_t pos = 0;
+    bool eof = false;
+    bool torn = false;
+
+    while (!torn && !(eof && pos == chunk.size()))
+    {
+      // keep the unread tail, then fill
+      chunk.erase(chunk.begin(), chunk.begin() + pos);
+      chunkOffset += pos;
+      pos = 0;
+
+      if (!eof)
+      {
+        const auto tail = chunk.size();
+        chunk.resize(tail + ChunkSize);
+        stream.read(reinterpret_cast<char *>(chunk.data() + tail), ChunkSize);
+        chunk.resize(tail + static_cast<std::size_t>(stream.gcount()));
+        eof = stream.eof();
+      }
+
+      // split complete records into batches, each decoded by the pool
+      auto bytes = std::make_shared<std::vector<std::uint8_t>>();
+      std::vector<std::size_t> offsets;
+
+      auto submit = [&]()
+      {
+        if (offsets.empty())
+          return;
+
+        pending.push_back(pool.submit([bytes, offsets = std::move(offsets)]()
+        {
+          Batch batch;
+          batch.reserve(offsets.size()-1);
+
+          for (std::size_t i = 0 ; i+1 < offsets.size() ; ++i)
+            batch.emplace_back(jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{bytes->data() + offsets[i], offsets[i+1] - offsets[i]}));
+
+          return batch;
+        }));
+
+        bytes = std::make_shared<std::vector<std::uint8_t>>();
+        offsets.clear();
+
+        if (pending.size() > pool.size() * 2U)
+          applyFront();
+      };
+
+
+      while (chunk.size() - pos >= 8U)
+      {
+        std::uint32_t size, crc;
+        std::memcpy(&size, chunk.data() + pos, 4U);
+        std::memcpy(&crc, chunk.data() + pos + 4U, 4U);
+
+        if (chunk.size() - pos - 8U < size)
+          break; // incomplete, read more
+        else if (snapshot::crc32c(chunk.data() + pos + 8U, size) != crc)
+        {
+          torn = true;
+          break;
+        }
+        else
+        {
+          if (offsets.empty())
+            offsets.push_back(0U);
+
+          bytes->insert(bytes->end(), chunk.data() + pos + 8U, chunk.data() + pos + 8U + size);
+          offsets.push_back(bytes->size());
+          pos += 8U + size;
+
+          if (offsets.size() > BatchRecords)
+            submit();
+        }
+      }
+
+      submit();
+
+      if (eof && pos != chunk.size())
+        torn = true;  // partial record at the end
+    }
+
+
+    while (!pending.empty())
+      applyFront();
+
+
+    if (torn)
+    {
+      if (!isLastSegment)
+        throw std::runtime_error{"WAL file corrupt: " + path.string()};
+
+      PLOGW << "WAL: truncating torn record at end of " << path;
+
+      stream.close();
+      fs::resize_file(path, chunkOffset + pos);
+    }
+
+    return nRecords;
+  }
+
+
+private:
+  WalSettings m_settings;
+  fs::path m_dir;
+  int m_fd{-1};
+  std::mutex m_fdMux; // fd is replaced by rotation and synced by m_syncThread
+  std::vector<std::uint8_t> m_buffer;
+  std::uint64_t m_nextSeq{1};
+  std::uint64_t m_compactSeq{0};
+  std::size_t m_segmentSize{0};
+  std::size_t m_logSize{0};   // bytes in segments since the last base
+  std::size_t m_nReplayed{0};
+  std::atomic_bool m_dirty{false};
+  bool m_failed{false};
+  ForkTask m_compact;
+  std::jthread m_syncThread;  // last member: stops before the above are destroyed
+};
+
+}
+
+#endif
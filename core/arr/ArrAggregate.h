@@ -0,0 +1,407 @@
+#ifndef NDB_CORE_ARRAGGREGATE_H
+#define NDB_CORE_ARRAGGREGATE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace nemesis { namespace arr { namespace agg {
+
+/*
+Aggregates of int64 values, for unsorted int arrays.
+
+  - sum: exact, as a 128-bit integer. Each value's low and high 32 bits are summed separately, as
+    unsigned, in 64-bit lanes, and the number of negative values is counted, because a negative
+    value is its unsigned value less 2^64. A lane can't overflow before 2^32 values, so long
+    ranges are summed in chunks
+  - min and max: the value and the position of its first occurrence. Each lane keeps its best
+    value and its position, replaced only by a strictly better value, so on a tie the lowest
+    position is kept. The lanes are reduced at the end
+  - countEqual: the number of values equal to a value
+  - histogram: counts per equal-width bucket. Scalar, the bucket is a multiply by the width's
+    reciprocal rather than a division, which is several times slower
+
+The kernels are selected at runtime, from AVX-512, AVX2 and scalar, as in ArrSetOps.h.
+*/
+
+
+using Values = std::span<const std::int64_t>;
+
+
+struct Position
+{
+  std::int64_t value;
+  std::size_t pos;
+};
+
+
+// HISTOGRAM's "buckets" limit, the response is one count per bucket
+static constexpr std::size_t MaxHistogramBuckets = 4096U;
+
+// lanes are summed in chunks of this many values, so a lane never overflows
+static constexpr std::size_t SumChunkSize = std::size_t{1} << 31;
+
+
+inline __int128 sumScalar (const Values values)
+{
+  __int128 total = 0;
+
+  for (const auto value : values)
+    total += value;
+
+  return total;
+}
+
+
+template<bool Max>
+Position extremeScalar (const Values values, Position best)
+{
+  for (std::size_t i = best.pos + 1 ; i < values.size() ; ++i)
+  {
+    if (Max ? best.value < values[i] : values[i] < best.value)
+      best = Position{.value = values[i], .pos = i};
+  }
+
+  return best;
+}
+
+
+inline Position minScalar (const Values values)
+{
+  return extremeScalar<false>(values, Position{.value = values[0], .pos = 0});
+}
+
+
+inline Position maxScalar (const Values values)
+{
+  return extremeScalar<true>(values, Position{.value = values[0], .pos = 0});
+}
+
+
+inline std::size_t countEqualScalar (const Values values, const std::int64_t value)
+{
+  return std::count(values.begin(), values.end(), value);
+}
+
+
+// Reduces per-lane sums: lows and highs are the unsigned low and high 32 bits, negatives the number of negative values
+template<std::size_t Width>
+__int128 reduceSum (const std::uint64_t (&lows)[Width], const std::uint64_t (&highs)[Width], const std::uint64_t (&negatives)[Width])
+{
+  __int128 total = 0;
+
+  for (std::size_t l = 0 ; l < Width ; ++l)
+    total += (static_cast<__int128>(highs[l]) << 32) + lows[l] - (static_cast<__int128>(negatives[l]) << 64);
+
+  return total;
+}
+
+
+// The best of the lanes, the lowest position on a tie
+template<bool Max, std::size_t Width>
+Position reduceExtreme (const std::int64_t (&best)[Width], const std::uint64_t (&positions)[Width])
+{
+  Position result{.value = best[0], .pos = positions[0]};
+
+  for (std::size_t l = 1 ; l < Width ; ++l)
+  {
+    if ((Max ? result.value < best[l] : best[l] < result.value) || (best[l] == result.value && positions[l] < result.pos))
+      result = Position{.value = best[l], .pos = positions[l]};
+  }
+
+  return result;
+}
+
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) inline __int128 sumAvx2 (const Values values)
+{
+  static constexpr std::size_t Width = 4U;
+
+  const __m256i lowMask = _mm256_set1_epi64x(0xFFFFFFFF);
+  __m256i lows = _mm256_setzero_si256(), highs = _mm256_setzero_si256(), negatives = _mm256_setzero_si256();
+
+  std::size_t i = 0;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values.data() + i));
+    lows = _mm256_add_epi64(lows, _mm256_and_si256(v, lowMask));
+    highs = _mm256_add_epi64(highs, _mm256_srli_epi64(v, 32));
+    negatives = _mm256_add_epi64(negatives, _mm256_srli_epi64(v, 63));
+  }
+
+  std::uint64_t l[Width], h[Width], n[Width];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(l), lows);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(h), highs);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(n), negatives);
+
+  return reduceSum(l, h, n) + sumScalar(values.subspan(i));
+}
+
+
+template<bool Max>
+__attribute__((target("avx2"))) inline Position extremeAvx2 (const Values values)
+{
+  static constexpr std::size_t Width = 4U;
+
+  if (values.size() < Width)
+    return extremeScalar<Max>(values, Position{.value = values[0], .pos = 0});
+
+  const __m256i step = _mm256_set1_epi64x(Width);
+  __m256i best = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values.data()));
+  __m256i positions = _mm256_set_epi64x(3, 2, 1, 0);
+  __m256i bestPositions = positions;
+
+  std::size_t i = Width;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values.data() + i));
+    const __m256i better = Max ? _mm256_cmpgt_epi64(v, best) : _mm256_cmpgt_epi64(best, v);
+
+    positions = _mm256_add_epi64(positions, step);
+    best = _mm256_blendv_epi8(best, v, better);
+    bestPositions = _mm256_blendv_epi8(bestPositions, positions, better);
+  }
+
+  std::int64_t b[Width];
+  std::uint64_t p[Width];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(b), best);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), bestPositions);
+
+  // the remaining values follow every lane's position
+  auto result = reduceExtreme<Max>(b, p);
+
+  for ( ; i < values.size() ; ++i)
+  {
+    if (Max ? result.value < values[i] : values[i] < result.value)
+      result = Position{.value = values[i], .pos = i};
+  }
+
+  return result;
+}
+
+
+__attribute__((target("avx2"))) inline std::size_t countEqualAvx2 (const Values values, const std::int64_t value)
+{
+  static constexpr std::size_t Width = 4U;
+
+  const __m256i target = _mm256_set1_epi64x(value);
+  __m256i counts = _mm256_setzero_si256();
+
+  std::size_t i = 0;
+
+  // an equal lane is -1
+  for ( ; i + Width <= values.size() ; i += Width)
+    counts = _mm256_sub_epi64(counts, _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values.data() + i)), target));
+
+  std::uint64_t c[Width];
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(c), counts);
+
+  return c[0] + c[1] + c[2] + c[3] + countEqualScalar(values.subspan(i), value);
+}
+
+
+// GCC 12's avx512fintrin.h has a false -Wmaybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f"))) inline __int128 sumAvx512 (const Values values)
+{
+  static constexpr std::size_t Width = 8U;
+
+  const __m512i lowMask = _mm512_set1_epi64(0xFFFFFFFF);
+  __m512i lows = _mm512_setzero_si512(), highs = _mm512_setzero_si512(), negatives = _mm512_setzero_si512();
+
+  std::size_t i = 0;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __m512i v = _mm512_loadu_si512(values.data() + i);
+    lows = _mm512_add_epi64(lows, _mm512_and_si512(v, lowMask));
+    highs = _mm512_add_epi64(highs, _mm512_srli_epi64(v, 32));
+    negatives = _mm512_add_epi64(negatives, _mm512_srli_epi64(v, 63));
+  }
+
+  std::uint64_t l[Width], h[Width], n[Width];
+  _mm512_storeu_si512(l, lows);
+  _mm512_storeu_si512(h, highs);
+  _mm512_storeu_si512(n, negatives);
+
+  return reduceSum(l, h, n) + sumScalar(values.subspan(i));
+}
+
+
+template<bool Max>
+__attribute__((target("avx512f"))) inline Position extremeAvx512 (const Values values)
+{
+  static constexpr std::size_t Width = 8U;
+
+  if (values.size() < Width)
+    return extremeScalar<Max>(values, Position{.value = values[0], .pos = 0});
+
+  const __m512i step = _mm512_set1_epi64(Width);
+  __m512i best = _mm512_loadu_si512(values.data());
+  __m512i positions = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+  __m512i bestPositions = positions;
+
+  std::size_t i = Width;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __m512i v = _mm512_loadu_si512(values.data() + i);
+    const __mmask8 better = Max ? _mm512_cmpgt_epi64_mask(v, best) : _mm512_cmplt_epi64_mask(v, best);
+
+    positions = _mm512_add_epi64(positions, step);
+    best = _mm512_mask_mov_epi64(best, better, v);
+    bestPositions = _mm512_mask_mov_epi64(bestPositions, better, positions);
+  }
+
+  std::int64_t b[Width];
+  std::uint64_t p[Width];
+  _mm512_storeu_si512(b, best);
+  _mm512_storeu_si512(p, bestPositions);
+
+  auto result = reduceExtreme<Max>(b, p);
+
+  for ( ; i < values.size() ; ++i)
+  {
+    if (Max ? result.value < values[i] : values[i] < result.value)
+      result = Position{.value = values[i], .pos = i};
+  }
+
+  return result;
+}
+
+
+__attribute__((target("avx512f"))) inline std::size_t countEqualAvx512 (const Values values, const std::int64_t value)
+{
+  static constexpr std::size_t Width = 8U;
+
+  const __m512i target = _mm512_set1_epi64(value);
+  const __m512i one = _mm512_set1_epi64(1);
+  __m512i counts = _mm512_setzero_si512();
+
+  std::size_t i = 0;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __mmask8 equal = _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(values.data() + i), target);
+    counts = _mm512_mask_add_epi64(counts, equal, counts, one);
+  }
+
+  std::uint64_t c[Width];
+  _mm512_storeu_si512(c, counts);
+
+  std::size_t total = countEqualScalar(values.subspan(i), value);
+  for (const auto count : c)
+    total += count;
+
+  return total;
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+
+struct Kernels
+{
+  __int128 (*sum)(const Values);
+  Position (*min)(const Values);  // 'values' must not be empty
+  Position (*max)(const Values);  // 'values' must not be empty
+  std::size_t (*countEqual)(const Values, const std::int64_t);
+  std::string_view name;
+};
+
+
+inline Kernels selectKernels ()
+{
+  #if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+      return Kernels{.sum = sumAvx512, .min = extremeAvx512<false>, .max = extremeAvx512<true>, .countEqual = countEqualAvx512, .name = "avx512"};
+    else if (__builtin_cpu_supports("avx2"))
+      return Kernels{.sum = sumAvx2, .min = extremeAvx2<false>, .max = extremeAvx2<true>, .countEqual = countEqualAvx2, .name = "avx2"};
+  #endif
+
+  return Kernels{.sum = sumScalar, .min = minScalar, .max = maxScalar, .countEqual = countEqualScalar, .name = "scalar"};
+}
+
+
+inline const Kernels AggKernels = selectKernels();
+
+
+inline __int128 sum (const Values values)
+{
+  __int128 total = 0;
+
+  for (std::size_t start = 0 ; start < values.size() ; start += SumChunkSize)
+    total += AggKernels.sum(values.subspan(start, std::min(SumChunkSize, values.size() - start)));
+
+  return total;
+}
+
+
+struct Histogram
+{
+  std::vector<std::size_t> counts;
+  std::uint64_t width{0};
+  std::size_t below{0};  // values less than min
+  std::size_t above{0};  // values greater than max
+};
+
+
+// 'buckets' of equal width over [min, max], so bucket i is [min + i*width, min + (i+1)*width), with
+// width = ceil((max - min + 1) / buckets). 'buckets' must be > 0 and max >= min.
+inline Histogram histogram (const Values values, const std::int64_t min, const std::int64_t max, const std::size_t buckets)
+{
+  // in unsigned, max - min can't overflow, and value - min is the offset when value >= min.
+  // ceil((range + 1) / buckets) is range / buckets + 1, which only overflows with one bucket
+  const auto range = static_cast<std::uint64_t>(max) - static_cast<std::uint64_t>(min);
+  const auto width = buckets == 1 ? 0 : range / buckets + 1;
+
+  Histogram result{.width = buckets == 1 ? range + 1 : width};
+
+  // branch-free, values outside [min, max] are often mixed with those within, so a branch is
+  // mispredicted. They are counted in an extra bucket, removed after. The bucket is offset / width, by multiplying with the
+  // reciprocal then correcting: a double has 53 bits, so for a quotient < buckets that is within 1.
+  const double reciprocal = buckets == 1 ? 0.0 : 1.0 / static_cast<double>(width);
+  std::vector<std::size_t> counts(buckets + 1);
+
+  for (const auto value : values)
+  {
+    const auto offset = static_cast<std::uint64_t>(value) - static_cast<std::uint64_t>(min);
+    const std::uint64_t outside = offset > range;
+
+    auto bucket = std::min<std::uint64_t>(static_cast<std::uint64_t>(static_cast<double>(offset) * reciprocal), buckets - 1);
+    bucket -= bucket * width > offset;
+    bucket += (offset - bucket * width >= width) & (bucket + 1 < buckets);
+
+    // a select, the compiler branches for '?:'
+    ++counts[bucket + (buckets - bucket) * outside];
+    result.below += value < min;
+  }
+
+  result.above = counts.back() - result.below;
+  counts.pop_back();
+  result.counts = std::move(counts);
+
+  return result;
+}
+
+}
+}
+}
+
+#endif
@@ -2,10 +2,21 @@
 #define NDB_CORE_ARRARRAY_H
 
 #include <algorithm>
+#include <iterator>
+#include <span>
+#include <string>
+#include <type_traits>
 #include <vector>
+#include <ankerl/unordered_dense.h>
 #include <core/NemesisCommon.h>
 #include <core/arr/ArrCommands.h>
-#include <core/arr/ArrArray.h>
+#include <core/arr/ArrCommon.h>
+#include <core/arr/ArrBlocks.h>
+#include <core/arr/ArrFrontCoded.h>
+#include <core/arr/ArrPages.h>
+#include <core/arr/ArrSearch.h>
+#include <core/arr/ArrSort.h>
+#include <core/arr/ArrStrings.h>
 
 
 namespace nemesis { namespace arr {
@@ -14,26 +25,56 @@ namespace nemesis { namespace arr {
 /*
 A fixed-sized std::vector. Does not perform bounds checks, but
 provides functions for that purpose.
+
+A sorted array can instead have the Blocked layout, storing items in
+SortedBlocks, which is allocated as items are set rather than to the capacity.
+A sorted string array can have the FrontCoded layout, which is as Blocked but
+FrontCodedStrings stores each string as only the bytes it doesn't share with the
+string before it.
+An unsorted array can instead have the Paged layout, storing items in SparsePages,
+which allocates a page when an item in it is first set, so untouched positions
+are the default item (null, 0 or "") without using memory.
+A string array can instead have the Arena layout, storing strings in StringArena,
+which packs their bytes into one buffer with a prefix of each inline, so most
+comparisons don't read the buffer.
+An array only has members for the layouts its type can have, e.g. an int array has no
+StringArena.
+
+A growable array's capacity, size(), increases when a set needs more, doubling
+up to the arrays.maxCapacity setting, so it can be created small. Any array's
+capacity can be changed with reserve() and shrinkToFit().
 */
 template<typename T, bool Sorted>
 class Array
 {
   using Iterator = std::vector<T>::iterator;
 
+  static constexpr bool IsString = std::is_same_v<T, std::string>;
+
+  // in place of the storage of a layout this array type can't have. A type per storage, so
+  // with [[no_unique_address]] they don't need distinct addresses and take no space.
+  template<typename Storage>
+  struct NoStorage {};
+
+  template<bool Has, typename Storage>
+  using StorageIf = std::conditional_t<Has, Storage, NoStorage<Storage>>;
+
 public:
 
   using ValueT = T;
   
 
-  Array(const std::size_t size) : m_size(size), m_used(0)
+  Array(const std::size_t size, const Layout layout = Layout::Vector, const bool growable = false)
+    : m_size(size), m_used(0), m_layout(layout), m_growable(growable)
   {
-    m_array.resize(m_size);
+    resize(m_size);
   }
 
 
-  static bool isRequestedSizeValid(const std::size_t size) noexcept
+  // a growable array can be created empty
+  static bool isRequestedSizeValid(const std::size_t size, const bool growable = false) noexcept
   {
-    return size == std::clamp<std::size_t>(size, 1, Settings::get().arrays.maxCapacity);
+    return size == std::clamp<std::size_t>(size, growable ? 0 : 1, Settings::get().arrays.maxCapacity);
   }
 
 
@@ -43,6 +84,120 @@ public:
   }
 
 
+  bool isBlocked() const noexcept
+  {
+    return m_layout == Layout::Blocked;
+  }
+
+
+  bool isFrontCoded() const noexcept
+  {
+    return m_layout == Layout::FrontCoded;
+  }
+
+
+  bool isPaged() const noexcept
+  {
+    return m_layout == Layout::Paged;
+  }
+
+
+  bool isArena() const noexcept
+  {
+    return m_layout == Layout::Arena;
+  }
+
+
+  Layout layout() const noexcept
+  {
+    return m_layout;
+  }
+
+
+  bool isGrowable() const noexcept
+  {
+    return m_growable;
+  }
+
+
+  /*
+  Returns true if the array can hold 'n' items, which a growable array grows to do: to at
+  least double its size, limited to maxCapacity, so sets have amortized O(1) growth.
+  */
+  bool makeCapacity(const std::size_t n)
+  {
+    if (n <= m_size)
+      return true;
+    else if (!m_growable || n > Settings::get().arrays.maxCapacity)
+      return false;
+    else
+    {
+      resize(std::clamp<std::size_t>(2 * m_size, n, Settings::get().arrays.maxCapacity));
+      return true;
+    }
+  }
+
+
+  // Increases size() to 'n', returning false if 'n' is above maxCapacity. A smaller 'n' has no effect.
+  bool reserve(const std::size_t n)
+  {
+    if (n > Settings::get().arrays.maxCapacity)
+      return false;
+    else if (n > m_size)
+      resize(n);
+
+    return true;
+  }
+
+
+  /*
+  The extent of the items held: used() for sorted arrays and for unsorted arrays, the last item
+  which isn't the default (items set by position are beyond used()).
+  */
+  std::size_t extent() const
+  {
+    std::size_t n = std::min(m_used, m_size);
+
+    if constexpr (!Sorted)
+    {
+      if (isPaged())
+        n = std::max(n, m_pages.lastSet());
+      else if (isArena())
+      {
+        if constexpr (IsString)
+          n = std::max(n, m_strings.lastSet());
+      }
+      else
+      {
+        const auto itLast = std::find_if(m_array.crbegin(), m_array.crend(), [](const T& item){ return item != T{}; });
+        n = std::max<std::size_t>(n, std::distance(itLast, m_array.crend()));
+      }
+    }
+
+    return n;
+  }
+
+
+  /*
+  Reduces size() to extent(), releasing memory. An array which isn't growable keeps a size of
+  at least 1, as CREATE requires.
+  */
+  void shrinkToFit()
+  {
+    const auto n = extent();
+
+    resize(std::max<std::size_t>(n, m_growable ? 0 : 1));
+
+    if (m_layout == Layout::Vector)
+      m_array.shrink_to_fit();
+    else if (m_layout == Layout::Arena)
+    {
+      if constexpr (IsString)
+        m_strings.shrinkToFit();
+    }
+  }
+
+
   bool isFull() const noexcept
   {
     return m_used >= m_size;
@@ -63,12 +218,49 @@ public:
 
   void set(const std::size_t pos, const T& item) requires (!Sorted)
   {
-    m_array[pos] = item;
+    if (isPaged())
+      m_pages.set(pos, item);
+    else if (isArena())
+    {
+      if constexpr (IsString)
+        m_strings.set(pos, item);
+    }
+    else
+      m_array[pos] = item;
   }
 
 
   void set(const T& item)
   {
+    if constexpr (IsString)
+    {
+      if (isArena())
+      {
+        if constexpr (Sorted)
+          m_strings.insert(m_strings.lowerBound(m_used, item), m_used, item);
+        else
+          m_strings.set(m_used, item);
+
+        ++m_used;
+        return;
+      }
+    }
+
+    if constexpr (Sorted)
+    {
+      if (hasLeaves())
+      {
+        withLeaves([&item](auto& leaves){ leaves.insert(item); });
+        ++m_used;
+        return;
+      }
+    }
+    else if (isPaged())
+    {
+      m_pages.set(m_used++, item);
+      return;
+    }
+
     m_array[m_used] = item;
 
     if constexpr (Sorted)
@@ -85,69 +277,68 @@ public:
 
   void setRange(std::size_t pos, const std::vector<T>& items) requires (!Sorted)
   { 
-    std::copy(std::cbegin(items), std::cend(items), std::next(std::begin(m_array), pos));
+    if (isPaged() || isArena())
+      setEach(pos, items);
+    else
+      std::copy(std::cbegin(items), std::cend(items), std::next(std::begin(m_array), pos));
+
     m_used += items.size();
   }
 
   
   void setRange(std::vector<T>& items) requires (!Sorted)
   {
-    std::copy(std::cbegin(items), std::cend(items), std::next(std::begin(m_array), m_used));
+    if (isPaged() || isArena())
+      setEach(m_used, items);
+    else
+      std::copy(std::cbegin(items), std::cend(items), std::next(std::begin(m_array), m_used));
+
     m_used += items.size();
   }
 
 
-  void setRange(std::vector<T>& items) requires (Sorted)
-  {    
-    // TODO add flag in request to signal items are already sorted
-    std::sort(std::begin(items), std::end(items));
-
-    if (m_used == 0)
-    {
-      std::copy(std::cbegin(items), std::cend(items), std::begin(m_array));
-      m_used += items.size();
-    }
-    else
+  // 'isSorted' if the client has sorted the items. That is checked, O(n), rather than trusted.
+  void setRange(std::vector<T>& items, const bool isSorted = false) requires (Sorted)
+  {
+    if constexpr (IsString)
     {
-      auto itLast = std::next(m_array.begin(), m_used);      
-      auto itItem = items.begin();
-      const auto itItemsEnd = items.end();
-      auto itLowerBound = std::lower_bound(m_array.begin(), itLast, *itItem);
-
-      while (itLowerBound != itLast && itItem != itItemsEnd)
+      // sorts the entries rather than the strings
+      if (isArena())
       {
-        // append whilst item <= lower bound
-        auto appended = 0;
-        for (auto i = m_used; *itItem <= *itLowerBound && itItem != items.end(); ++itItem)
-        {
-          m_array[i++] = *itItem;
-          ++appended;
-        }
-        
-        m_used += appended;
-
-        // left rotate [lowerbound, last) to after appended
-        std::rotate(itLowerBound, itLast, std::next(itLast, appended));
-        
-        if (itItem != itItemsEnd)
-        {
-          // find lower bound of item
-          std::advance(itLast, appended);
-          std::advance(itLowerBound, appended);
-          itLowerBound = std::lower_bound(itLowerBound, itLast, *itItem);
-        }
+        m_strings.merge(m_used, items);
+        m_used += items.size();
+        return;
       }
-      
-      // 1. all items > array max item OR
-      // 2. remaining items > array max
-      std::copy(itItem, itItemsEnd, std::next(std::begin(m_array), m_used));
-      m_used += std::distance(itItem, itItemsEnd);
     }
+
+    if (!isSorted || !std::is_sorted(std::cbegin(items), std::cend(items)))
+      sortItems(items);
+
+    if (hasLeaves())
+      withLeaves([&items](auto& leaves){ leaves.insert(std::span<const T>{items}); });
+    else
+      mergeInto(m_array, m_used, items);
+
+    m_used += items.size();
   }
 
 
   T get(const std::size_t pos) const
   {
+    if constexpr (IsString)
+    {
+      if (isArena())
+        return m_strings.get(pos);
+    }
+
+    if constexpr (Sorted)
+    {
+      if (hasLeaves())
+        return pos < m_used ? withLeaves([pos](const auto& leaves) -> T { return leaves.at(pos); }) : T{};
+    }
+    else if (isPaged())
+      return m_pages.get(pos);
+
     return m_array[pos];
   }
 
@@ -160,7 +351,37 @@ public:
 
   njson getRange(const std::size_t start, std::size_t stop) const
   {
-    stop = std::min<std::size_t>(std::min<std::size_t>(stop, m_used), Settings::get().arrays.maxRspSize);
+    // maxRspSize limits the number of items, and start may be beyond used()
+    stop = std::max(start, std::min({stop, m_used, start + Settings::get().arrays.maxRspSize}));
+
+    if (isPaged() || isArena())
+    {
+      njson rsp{njson::make_array(stop - start)};
+
+      for (auto pos = start ; pos < stop ; ++pos)
+        rsp[pos - start] = get(pos);
+
+      return rsp;
+    }
+
+    if constexpr (Sorted)
+    {
+      if (hasLeaves())
+      {
+        njson rsp{njson::make_array(stop > start ? stop - start : 0)};
+
+        std::size_t i = 0;
+        withLeaves([&](const auto& leaves)
+        {
+          leaves.forEach(start, stop, [&rsp, &i](const auto& item)
+          {
+            rsp[i++] = item;
+          });
+        });
+
+        return rsp;
+      }
+    }
 
     const auto itStart = std::next(m_array.cbegin(), start);
     const auto itEnd = std::next(m_array.cbegin(), stop);
@@ -182,20 +403,145 @@ public:
 
   void swap(const std::size_t posA, const std::size_t posB) requires (!Sorted)
   {
-    std::iter_swap( std::next(m_array.begin(), posA),
+    if (isPaged())
+    {
+      const T a = m_pages.get(posA);
+      m_pages.set(posA, m_pages.get(posB));
+      m_pages.set(posB, a);
+    }
+    else if (isArena())
+    {
+      if constexpr (IsString)
+        m_strings.swap(posA, posB);
+    }
+    else
+      std::iter_swap( std::next(m_array.begin(), posA),
                     std::next(m_array.begin(), posB));
   }
 
 
+  // Sorts [0, used()), in parallel when large, see sortItems(). Items beyond used() don't move.
+  void sort(const bool descending) requires (!Sorted)
+  {
+    if constexpr (IsString)
+    {
+      if (isArena())
+      {
+        m_strings.sort(m_used, descending);
+        return;
+      }
+    }
+
+    std::vector<T> copy;
+    std::span<T> items;
+
+    if (isPaged())
+    {
+      range(0, m_used, copy);
+      items = copy;
+    }
+    else
+      items = std::span<T>{m_array}.first(m_used);
+
+    sortItems(items);
+
+    if (descending)
+      std::reverse(items.begin(), items.end());
+
+    if (isPaged())
+      setEach(0, copy);
+  }
+
+
+  /*
+  Removes repeated items from [0, used()), keeping the first of each in their order. The items
+  removed are then cleared, as clear(), so items beyond used() move down. Returns used().
+
+  Sorted items, such as after sort(), only compare neighbours, otherwise the items seen are hashed.
+  */
+  std::size_t unique() requires (!Sorted)
+  {
+    using Key = std::conditional_t<IsString, std::string_view, T>;
+
+    std::vector<T> copy;
+    const auto items = range(0, m_used, copy);
+
+    std::vector<T> kept;
+    kept.reserve(items.size());
+
+    if (std::is_sorted(items.begin(), items.end()) || std::is_sorted(items.rbegin(), items.rend()))
+      std::unique_copy(items.begin(), items.end(), std::back_inserter(kept));
+    else
+    {
+      ankerl::unordered_dense::set<Key> seen;
+      seen.reserve(items.size());
+
+      for (const auto& item : items)
+      {
+        if (seen.emplace(item).second)
+          kept.push_back(item);
+      }
+    }
+
+    if (const auto n = kept.size() ; n != items.size())
+    {
+      if (isPaged() || isArena())
+        setEach(0, kept);
+      else
+        std::move(kept.begin(), kept.end(), m_array.begin());
+
+      clear(n, m_used);
+    }
+
+    return m_used;
+  }
+
+
   void clear(const std::size_t start)
   {
     clear(start, m_size);
     m_used = 0;
+
+    if constexpr (Sorted)
+      withLeaves([](auto& leaves){ leaves.clear(); });
   }
 
 
   void clear(const std::size_t start, const std::size_t stop)
   {
+    if (isArena())
+    {
+      // as below, only moving entries
+      if (const auto pivot = std::min<std::size_t>(m_used, stop); start == 0 && pivot == m_size)
+        m_used = 0;
+      else if (start < pivot)
+      {
+        if constexpr (IsString)
+          m_strings.rotate(start, pivot, m_size);
+
+        m_used -= pivot - start;
+      }
+      return;
+    }
+
+    if constexpr (Sorted)
+    {
+      if (hasLeaves())
+      {
+        m_used = withLeaves([start, stop](auto& leaves)
+        {
+          leaves.erase(start, stop);
+          return leaves.size();
+        });
+        return;
+      }
+    }
+    else if (isPaged())
+    {
+      clearPages(start, std::min<std::size_t>(m_used, stop));
+      return;
+    }
+
     PLOGD << "Array::clear(): " << start << " to " << std::min<std::size_t>(m_used, stop);
 
     const auto itStart = std::next(m_array.begin(), start);
@@ -229,18 +575,222 @@ public:
   }
 
 
+  // all items, including those beyond used(). Not for the Blocked, FrontCoded, Paged or Arena layouts.
+  std::span<const T> storage() const noexcept
+  {
+    return m_array;
+  }
+
+
+  // all items, to modify in place, which doesn't change used()
+  std::span<T> storage() noexcept requires (!Sorted)
+  {
+    return m_array;
+  }
+
+
+  // Up to 'n' contiguous items from 'pos': all 'n' unless Paged, where a page boundary ends them
+  std::span<const T> contiguous(const std::size_t pos, const std::size_t n) const requires (!Sorted)
+  {
+    return isPaged() ? m_pages.contiguous(pos, n) : std::span<const T>{m_array}.subspan(pos, n);
+  }
+
+
+  // As above, to modify in place. A Paged array allocates the page.
+  std::span<T> contiguous(const std::size_t pos, const std::size_t n) requires (!Sorted)
+  {
+    return isPaged() ? m_pages.contiguous(pos, n) : std::span<T>{m_array}.subspan(pos, n);
+  }
+
+
+  // Calls f(pos, item) for each item from 'start' which isn't the default. Paged only visits allocated pages.
+  template<typename F>
+  void forEachSet(const std::size_t start, F&& f) const requires (!Sorted)
+  {
+    if (isPaged())
+      m_pages.forEachSet(start, f);
+    else if (isArena())
+    {
+      if constexpr (IsString)
+      {
+        for (auto pos = start ; pos < m_size ; ++pos)
+        {
+          if (!m_strings.isEmpty(pos))
+            f(pos, m_strings.get(pos));
+        }
+      }
+    }
+    else
+    {
+      for (auto pos = start ; pos < m_size ; ++pos)
+      {
+        if (m_array[pos] != T{})
+          f(pos, m_array[pos]);
+      }
+    }
+  }
+
+
+  // true if Paged and no page in [start, stop) is allocated, so all are the default
+  bool isUntouched(const std::size_t start, const std::size_t stop) const noexcept requires (!Sorted)
+  {
+    return isPaged() && m_pages.isUntouched(start, stop);
+  }
+
+
+  // 'n' items from 'start'. Blocked, FrontCoded, Paged and Arena items are not contiguous, so are copied to 'copy'.
+  std::span<const T> range(const std::size_t start, const std::size_t n, std::vector<T>& copy) const
+  {
+    if constexpr (IsString)
+    {
+      if (isArena())
+      {
+        copy.clear();
+        copy.reserve(n);
+
+        for (auto pos = start ; pos < start + n ; ++pos)
+          copy.push_back(m_strings.get(pos));
+
+        return copy;
+      }
+    }
+
+    if constexpr (Sorted)
+    {
+      if (hasLeaves())
+      {
+        copy.clear();
+        copy.reserve(n);
+        withLeaves([&](const auto& leaves){ leaves.forEach(start, start + n, [&copy](const auto& item){ copy.push_back(item); }); });
+        return copy;
+      }
+    }
+    else if (isPaged())
+    {
+      copy.clear();
+      copy.reserve(n);
+
+      for (auto pos = start ; pos < start + n ; )
+      {
+        const auto items = m_pages.contiguous(pos, start + n - pos);
+        copy.insert(copy.end(), items.begin(), items.end());
+        pos += items.size();
+      }
+
+      return copy;
+    }
+
+    return std::span<const T>{m_array}.subspan(start, n);
+  }
+
+
+  // Calls f(ref) with a StringRef of each item in [0, used()). Arena layout only.
+  template<typename F>
+  void forEachRef(F&& f) const requires (IsString)
+  {
+    for (std::size_t pos = 0 ; pos < m_used ; ++pos)
+      f(m_strings.ref(pos));
+  }
+
+
+  // Used when loading a save: moves items into the array from 'pos' and sets used(). Items
+  // are in the order saved, so sorted arrays remain sorted.
+  void restore(const std::size_t pos, std::vector<T>&& items, const std::size_t used)
+  {
+    // either may be sorted (Arena) or unsorted, neither has m_array
+    if (isPaged() || isArena())
+    {
+      setEach(pos, items);
+      m_used = used;
+      return;
+    }
+
+    if constexpr (Sorted)
+    {
+      if (hasLeaves())
+      {
+        m_used = withLeaves([&items](auto& leaves)
+        {
+          // saved in order, so each chunk follows the last
+          if (leaves.empty() || items.empty() || !(items.front() < leaves.back()))
+            leaves.append(std::move(items));
+          else
+          {
+            std::sort(std::begin(items), std::end(items));
+            leaves.insert(std::span<const T>{items});
+          }
+
+          return leaves.size();
+        });
+        return;
+      }
+    }
+
+    std::move(std::begin(items), std::end(items), std::next(std::begin(m_array), pos));
+    m_used = used;
+  }
+
+
+  // position of the first item not less than 'item', which is the number of items less than it
+  std::size_t lowerBound(const T& item) const requires (Sorted)
+  {
+    if constexpr (IsString)
+    {
+      if (isArena())
+        return m_strings.lowerBound(m_used, item);
+    }
+
+    if (hasLeaves())
+      return withLeaves([&item](const auto& leaves){ return leaves.lowerBound(item); });
+    else
+      return search::lowerBound<T>(std::span{m_array.data(), m_used}, item);
+  }
+
+
+  // position of the first item greater than 'item'
+  std::size_t upperBound(const T& item) const requires (Sorted)
+  {
+    if constexpr (IsString)
+    {
+      if (isArena())
+        return m_strings.upperBound(m_used, item);
+    }
+
+    if (hasLeaves())
+      return withLeaves([&item](const auto& leaves){ return leaves.upperBound(item); });
+    else
+      return search::upperBound<T>(std::span{m_array.data(), m_used}, item);
+  }
+
+
+  bool contains(const T& item) const requires (Sorted)
+  {
+    const auto pos = lowerBound(item);
+    return pos < m_used && get(pos) == item;
+  }
+
+
   std::vector<T> min(const std::size_t n) const requires (Sorted)
   {
     const auto nValues = std::min<std::size_t>(n, m_used);
-    const auto itEnd = std::next(m_array.cbegin(), nValues);
     
     std::vector<T> result;
     result.reserve(nValues);
 
-    std::for_each(m_array.cbegin(), itEnd, [&result](const auto& value)
+    if (hasLeaves())
+      withLeaves([&](const auto& leaves){ leaves.forEach(0, nValues, [&result](const auto& value){ result.emplace_back(value); }); });
+    else if (isArena())
     {
-      result.emplace_back(value);
-    });
+      for (std::size_t pos = 0 ; pos < nValues ; ++pos)
+        result.emplace_back(get(pos));
+    }
+    else
+    {
+      std::for_each(m_array.cbegin(), std::next(m_array.cbegin(), nValues), [&result](const auto& value)
+      {
+        result.emplace_back(value);
+      });
+    }
 
     return result;
   }
@@ -249,43 +799,164 @@ public:
   std::vector<T> max(const std::size_t n) const requires (Sorted)
   {
     const auto nValues = std::min<std::size_t>(n, m_used);
-    const auto itEnd = std::next(m_array.crbegin(), nValues);
     
     std::vector<T> result;
     result.reserve(nValues);
 
-    std::for_each(m_array.crbegin(), itEnd, [&result](const auto& value)
+    if (hasLeaves())
+      withLeaves([&](const auto& leaves){ leaves.forEachReverse(nValues, [&result](const auto& value){ result.emplace_back(value); }); });
+    else if (isArena())
     {
-      result.emplace_back(value);
-    });
+      for (std::size_t pos = m_used ; pos > m_used - nValues ; --pos)
+        result.emplace_back(get(pos - 1));
+    }
+    else
+    {
+      // m_array holds size() items, the last used at m_used-1
+      const auto itLast = std::next(m_array.crbegin(), m_array.size() - m_used);
+      std::for_each(itLast, std::next(itLast, nValues), [&result](const auto& value)
+      {
+        result.emplace_back(value);
+      });
+    }
 
     return result;
   }
 
+private:
+
+  // Blocked and FrontCoded layouts have leaves, holding the items in sorted order
+  bool hasLeaves() const noexcept
+  {
+    return m_layout == Layout::Blocked || m_layout == Layout::FrontCoded;
+  }
+
+
+  // Calls f(leaves) with the SortedBlocks or FrontCodedStrings, which have the same interface
+  template<typename F>
+  decltype(auto) withLeaves(F&& f) requires (Sorted)
+  {
+    if constexpr (IsString)
+    {
+      if (isFrontCoded())
+        return f(m_coded);
+    }
+
+    return f(m_blocks);
+  }
+
 
-  std::vector<T>::const_iterator cbegin() const noexcept requires (Sorted)
+  template<typename F>
+  decltype(auto) withLeaves(F&& f) const requires (Sorted)
   {
-    return m_array.cbegin();
+    if constexpr (IsString)
+    {
+      if (isFrontCoded())
+        return f(m_coded);
+    }
+
+    return f(m_blocks);
   }
 
 
-  std::vector<T>::const_iterator cend() const noexcept requires (Sorted)
+  // Blocked items are allocated as they're set, so only the Vector layout allocates to the size
+  void resize(const std::size_t size)
   {
-    return std::next(m_array.cbegin(), m_used);
+    m_size = size;
+
+    if (m_layout == Layout::Vector)
+      m_array.resize(m_size);
+    else if (m_layout == Layout::Paged)
+    {
+      if constexpr (!Sorted)
+        m_pages.resize(m_size);
+    }
+    else if (m_layout == Layout::Arena)
+    {
+      if constexpr (IsString)
+        m_strings.resize(m_size);
+    }
   }
 
+
+  // for layouts which aren't a std::vector<T>, Paged or Arena
+  void setEach(const std::size_t pos, const std::vector<T>& items)
+  {
+    for (std::size_t i = 0 ; i < items.size() ; ++i)
+    {
+      if constexpr (IsString)
+      {
+        if (isArena())
+        {
+          m_strings.set(pos + i, items[i]);
+          continue;
+        }
+      }
+
+      if constexpr (!Sorted)
+        m_pages.set(pos + i, items[i]);
+    }
+  }
+
+
+  /*
+  As clear() for the Vector layout, [start, pivot) rotated to the end, but only moving items which
+  aren't the default, so the cost is in proportion to items set rather than size().
+  */
+  void clearPages(const std::size_t start, const std::size_t pivot) requires (!Sorted)
+  {
+    if (start == 0 && pivot == m_size)
+    {
+      m_used = 0; // clearing entire array
+      return;
+    }
+    else if (pivot <= start)
+      return;
+
+    const auto n = pivot - start;
+
+    std::vector<std::pair<std::size_t, T>> removed, moved;
+    m_pages.forEachSet(start, [&](const std::size_t pos, const T& item)
+    {
+      if (pos < pivot)
+        removed.emplace_back(m_size - n + (pos - start), item);
+      else
+        moved.emplace_back(pos - n, item);
+    });
+
+    m_pages.reset(start, m_size);
+
+    for (const auto& [pos, item] : moved)
+      m_pages.set(pos, item);
+
+    for (const auto& [pos, item] : removed)
+      m_pages.set(pos, item);
+
+    m_used -= n;
+  }
+
+
 private:
   std::vector<T> m_array;
   std::size_t m_size;
   std::size_t m_used;
+  Layout m_layout;
+  bool m_growable;
+  // each is empty unless this array type can have the layout
+  [[no_unique_address]] StorageIf<Sorted, SortedBlocks<T>> m_blocks;                 // Blocked
+  [[no_unique_address]] StorageIf<Sorted && IsString, FrontCodedStrings> m_coded;     // FrontCoded
+  [[no_unique_address]] StorageIf<!Sorted, SparsePages<T>> m_pages;                   // Paged
+  [[no_unique_address]] StorageIf<IsString, StringArena> m_strings;                   // Arena
 };
 
 
 using OArray = Array<njson, false>;
 using IArray = Array<std::int64_t, false>;
 using SArray = Array<std::string, false>;
+using FArray = Array<double, false>;
 
 using SortedIArray = Array<std::int64_t, true>;
+using SortedFArray = Array<double, true>;
 
 }
 }
@@ -0,0 +1,361 @@
+#ifndef NDB_CORE_ARRBLOCKS_H
+#define NDB_CORE_ARRBLOCKS_H
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+#include <core/arr/ArrSearch.h>
+
+
+namespace nemesis { namespace arr {
+
+
+/*
+The sizes of leaves in a 1-based Fenwick tree, m_tree[i] is the total size of leaves (i - lowbit(i), i],
+so the total size before a leaf, and the leaf containing a position, are both O(log leaves).
+*/
+class LeafSizes
+{
+public:
+
+  // from sizeOf(leaf) of each leaf
+  template<typename Leaves, typename SizeOf>
+  void rebuild(const Leaves& leaves, SizeOf&& sizeOf)
+  {
+    m_tree.assign(leaves.size() + 1, 0);
+
+    for (std::size_t i = 1 ; i < m_tree.size() ; ++i)
+    {
+      m_tree[i] += sizeOf(leaves[i-1]);
+
+      if (const auto parent = i + (i & (~i + 1)) ; parent < m_tree.size())
+        m_tree[parent] += m_tree[i];
+    }
+  }
+
+
+  // one item added to 'leaf'
+  void increment(const std::size_t leaf)
+  {
+    for (auto i = leaf + 1 ; i < m_tree.size() ; i += i & (~i + 1))
+      ++m_tree[i];
+  }
+
+
+  // total size of the leaves before 'leaf'
+  std::size_t prefix(const std::size_t leaf) const
+  {
+    std::size_t total = 0;
+
+    for (auto i = leaf ; i ; i -= i & (~i + 1))
+      total += m_tree[i];
+
+    return total;
+  }
+
+
+  // the leaf and the offset within it of 'pos', which must be less than the total size
+  std::pair<std::size_t, std::size_t> locate(std::size_t pos) const
+  {
+    // largest number of leaves whose total size is <= pos, that is the 0-based leaf containing pos
+    std::size_t leaf = 0;
+
+    for (std::size_t step = m_tree.size() > 1 ? std::bit_floor(m_tree.size() - 1) : 0 ; step ; step >>= 1)
+    {
+      if (leaf + step < m_tree.size() && m_tree[leaf + step] <= pos)
+      {
+        leaf += step;
+        pos -= m_tree[leaf];
+      }
+    }
+
+    return {leaf, pos};
+  }
+
+
+  void clear()
+  {
+    m_tree.clear();
+  }
+
+
+private:
+  std::vector<std::size_t> m_tree;
+};
+
+
+/*
+Sorted values in leaves of fixed capacity, the blocked layout of a sorted array.
+
+Inserting into one sorted std::vector moves every value after the insert position, O(n).
+Here the leaf is found by a binary search of each leaf's last value, then only the values
+after the position in that leaf move, so O(log n + LeafCapacity). A full leaf is split in two.
+
+Positions (get, get range, clear) are found with LeafSizes, a Fenwick tree of the leaf sizes, O(log n),
+as are a value's bounds, from the leaf's position and the value's position in the leaf.
+The tree is updated on each insert, and rebuilt when leaves are split or removed, which is
+O(leaves) but for a split only happens once per LeafCapacity / 2 inserts into a leaf.
+*/
+template<typename T>
+class SortedBlocks
+{
+public:
+  // about 4KB of values per leaf
+  static constexpr std::size_t LeafCapacity = std::max<std::size_t>(64U, 4096U / sizeof(T));
+  // append() leaves room, otherwise the first insert into each leaf splits it
+  static constexpr std::size_t FillCapacity = LeafCapacity * 3 / 4;
+
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+
+  bool empty() const noexcept
+  {
+    return m_size == 0;
+  }
+
+
+  std::size_t leaves() const noexcept
+  {
+    return m_leaves.size();
+  }
+
+
+  // the largest value, must not be empty()
+  const T& back() const
+  {
+    return m_lasts.back();
+  }
+
+
+  const T& at(const std::size_t pos) const
+  {
+    const auto [leaf, offset] = m_sizes.locate(pos);
+    return m_leaves[leaf][offset];
+  }
+
+
+  // position of the first value not less than 'value'
+  std::size_t lowerBound(const T& value) const
+  {
+    return bound<false>(value);
+  }
+
+
+  // position of the first value greater than 'value'
+  std::size_t upperBound(const T& value) const
+  {
+    return bound<true>(value);
+  }
+
+
+  void insert(const T& value)
+  {
+    if (m_leaves.empty())
+    {
+      m_leaves.emplace_back().push_back(value);
+      m_lasts.push_back(value);
+      m_size = 1;
+      rebuildTree();
+      return;
+    }
+
+    // first leaf which can contain value, or the last leaf if value is the largest
+    const auto leaf = std::min<std::size_t>(std::distance(m_lasts.cbegin(), std::lower_bound(m_lasts.cbegin(), m_lasts.cend(), value)),
+                                            m_leaves.size() - 1);
+
+    auto& values = m_leaves[leaf];
+    values.insert(std::lower_bound(values.begin(), values.end(), value), value);
+    m_lasts[leaf] = values.back();
+    ++m_size;
+
+    if (values.size() > LeafCapacity)
+      split(leaf);
+    else
+    {
+      m_sizes.increment(leaf);
+    }
+  }
+
+
+  // 'values' must be sorted. Few values are inserted individually, otherwise
+  // all values are merged, O(n + values.size())
+  void insert(const std::span<const T> values)
+  {
+    if (values.size() * LeafCapacity < m_size)
+    {
+      for (const auto& value : values)
+        insert(value);
+    }
+    else
+    {
+      std::vector<T> current;
+      current.reserve(m_size);
+
+      for (auto& leaf : m_leaves)
+        std::move(leaf.begin(), leaf.end(), std::back_inserter(current));
+
+      std::vector<T> merged;
+      merged.reserve(current.size() + values.size());
+      std::merge(std::make_move_iterator(current.begin()), std::make_move_iterator(current.end()),
+                 values.begin(), values.end(),
+                 std::back_inserter(merged));
+
+      clear();
+      append(std::move(merged));
+    }
+  }
+
+
+  // 'values' must be sorted and not less than back(), filling the last leaf then new leaves, to FillCapacity
+  void append(std::vector<T>&& values)
+  {
+    for (auto it = values.begin() ; it != values.end() ; )
+    {
+      if (m_leaves.empty() || m_leaves.back().size() >= FillCapacity)
+      {
+        m_leaves.emplace_back().reserve(LeafCapacity);
+        m_lasts.emplace_back();
+      }
+
+      auto& leaf = m_leaves.back();
+      const auto n = std::min<std::size_t>(FillCapacity - leaf.size(), std::distance(it, values.end()));
+
+      leaf.insert(leaf.end(), std::make_move_iterator(it), std::make_move_iterator(std::next(it, n)));
+      m_lasts.back() = leaf.back();
+      std::advance(it, n);
+    }
+
+    m_size += values.size();
+    rebuildTree();
+  }
+
+
+  // removes positions [start, stop)
+  void erase(const std::size_t start, const std::size_t stop)
+  {
+    if (start >= std::min(stop, m_size))
+      return;
+
+    auto [leaf, offset] = m_sizes.locate(start);
+
+    for (std::size_t n = std::min(stop, m_size) - start ; n ; ++leaf, offset = 0)
+    {
+      auto& values = m_leaves[leaf];
+      const auto count = std::min(n, values.size() - offset);
+      const auto itStart = std::next(values.begin(), offset);
+
+      values.erase(itStart, std::next(itStart, count));
+      m_size -= count;
+      n -= count;
+    }
+
+    std::erase_if(m_leaves, [](const auto& values){ return values.empty(); });
+
+    m_lasts.clear();
+    for (const auto& values : m_leaves)
+      m_lasts.push_back(values.back());
+
+    rebuildTree();
+  }
+
+
+  void clear()
+  {
+    m_leaves.clear();
+    m_lasts.clear();
+    m_sizes.clear();
+    m_size = 0;
+  }
+
+
+  // calls f(value) for positions [start, stop)
+  template<typename F>
+  void forEach(const std::size_t start, const std::size_t stop, F&& f) const
+  {
+    if (start >= std::min(stop, m_size))
+      return;
+
+    auto [leaf, offset] = m_sizes.locate(start);
+
+    for (std::size_t n = std::min(stop, m_size) - start ; n ; ++leaf, offset = 0)
+    {
+      const auto& values = m_leaves[leaf];
+      const auto count = std::min(n, values.size() - offset);
+
+      for (auto it = std::next(values.cbegin(), offset), itEnd = std::next(it, count) ; it != itEnd ; ++it)
+        f(*it);
+
+      n -= count;
+    }
+  }
+
+
+  // calls f(value) for the last n values, largest first
+  template<typename F>
+  void forEachReverse(std::size_t n, F&& f) const
+  {
+    for (auto leaf = m_leaves.crbegin() ; n && leaf != m_leaves.crend() ; ++leaf)
+    {
+      for (auto it = leaf->crbegin() ; n && it != leaf->crend() ; ++it, --n)
+        f(*it);
+    }
+  }
+
+
+private:
+
+  template<bool Upper>
+  std::size_t bound(const T& value) const
+  {
+    // the first leaf with a last value which bounds 'value', then within it
+    const auto leaf = search::bound<T, Upper>(m_lasts, value);
+
+    if (leaf == m_leaves.size())
+      return m_size;
+    else
+      return m_sizes.prefix(leaf) + search::bound<T, Upper>(m_leaves[leaf], value);
+  }
+
+
+  void split(const std::size_t leaf)
+  {
+    auto& values = m_leaves[leaf];
+    const auto itMid = std::next(values.begin(), values.size() / 2);
+
+    std::vector<T> upper;
+    upper.reserve(LeafCapacity);
+    upper.insert(upper.end(), std::make_move_iterator(itMid), std::make_move_iterator(values.end()));
+    values.erase(itMid, values.end());
+
+    m_lasts[leaf] = values.back();
+    m_lasts.insert(std::next(m_lasts.begin(), leaf + 1), upper.back());
+    m_leaves.insert(std::next(m_leaves.begin(), leaf + 1), std::move(upper));
+
+    rebuildTree();
+  }
+
+
+  void rebuildTree()
+  {
+    m_sizes.rebuild(m_leaves, [](const auto& values){ return values.size(); });
+  }
+
+
+private:
+  std::vector<std::vector<T>> m_leaves;
+  std::vector<T> m_lasts;             // each leaf's last value
+  LeafSizes m_sizes;
+  std::size_t m_size{0};
+};
+
+}
+}
+
+#endif
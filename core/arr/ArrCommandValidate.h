@@ -1,10 +1,15 @@
 #ifndef NDB_CORE_ARRCMDVALIDATE_H
 #define NDB_CORE_ARRCMDVALIDATE_H
 
+#include <limits>
+#include <string>
 #include <tuple>
+#include <type_traits>
 #include <string_view>
 #include <core/NemesisCommon.h>
 #include <core/arr/ArrCommands.h>
+#include <core/arr/ArrAggregate.h>
+#include <core/arr/ArrFloatMath.h>
 #include <core/arr/ArrCommon.h>
 
 
@@ -15,8 +20,28 @@ namespace nemesis { namespace arr {
   template<typename Cmds>
   RequestStatus validateCreate (const njson& request)
   {
+    // sorted arrays can be "vector" or "blocked", unsorted "vector" or "paged", string arrays "arena"
+    // and sorted string arrays "frontcoded"
+    auto checkLayout = [](const njson& body) -> RequestStatus
+    {
+      if (!body.contains("layout"))
+        return RequestStatus::Ok;
+      else if (const auto layout = toLayout(body.at("layout").as_string_view()); !layout)
+        return RequestStatus::ValueTypeInvalid;
+      else if (*layout == (Cmds::IsSorted ? Layout::Paged : Layout::Blocked))
+        return RequestStatus::ValueTypeInvalid;
+      else if (*layout == Layout::Arena && !std::is_same_v<typename Cmds::ItemT, std::string>)
+        return RequestStatus::ValueTypeInvalid;
+      else if (*layout == Layout::FrontCoded && !(Cmds::IsSorted && std::is_same_v<typename Cmds::ItemT, std::string>))
+        return RequestStatus::ValueTypeInvalid;
+      else
+        return RequestStatus::Ok;
+    };
+
     return isValid(Cmds::CreateRsp, request.at(Cmds::CreateReq), { {Param::required("name", JsonString)},
-                                                                   {Param::required("len", JsonUInt)}});
+                                                                   {Param::required("len", JsonUInt)},
+                                                                   {Param::optional("layout", JsonString)},
+                                                                   {Param::optional("growable", JsonBool)}}, checkLayout);
   }
 
 
@@ -60,7 +85,7 @@ namespace nemesis { namespace arr {
 
     // if container can be sorted, then request cannot set a position (since it may change after sorting)
     if constexpr (Cmds::IsSorted)
-      params = {{Param::required("name", JsonString)}, {Param::required("items", JsonArray)}};
+      params = {{Param::required("name", JsonString)}, {Param::required("items", JsonArray)}, {Param::optional("sorted", JsonBool)}};
     else
       params = {{Param::required("name", JsonString)}, {Param::required("items", JsonArray)}, {Param::optional("pos", JsonUInt)}};
 
@@ -129,6 +154,45 @@ namespace nemesis { namespace arr {
   }
 
 
+  template<typename Cmds>
+  RequestStatus validateReserve (const njson& req)
+  {
+    return isValid(Cmds::ReserveRsp, req.at(Cmds::ReserveReq.data()), { {Param::required("name", JsonString)},
+                                                                        {Param::required("len",  JsonUInt)}});
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateShrink (const njson& req)
+  {
+    return isValid(Cmds::ShrinkRsp, req.at(Cmds::ShrinkReq.data()), { {Param::required("name", JsonString)}});
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateSort (const njson& req)
+  {
+    return isValid(Cmds::SortRsp, req.at(Cmds::SortReq.data()), { {Param::required("name", JsonString)},
+                                                                  {Param::optional("desc", JsonBool)}});
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateUnique (const njson& req)
+  {
+    return isValid(Cmds::UniqueRsp, req.at(Cmds::UniqueReq.data()), { {Param::required("name", JsonString)}});
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateToSorted (const njson& req)
+  {
+    return isValid(Cmds::ToSortedRsp, req.at(Cmds::ToSortedReq.data()), { {Param::required("name",   JsonString)},
+                                                                          {Param::required("dest",   JsonString)},
+                                                                          {Param::optional("unique", JsonBool)}});
+  }
+
+
   template<typename Cmds>
   RequestStatus validateExist (const njson& req)
   {
@@ -168,13 +232,194 @@ namespace nemesis { namespace arr {
 
 
   template<typename Cmds>
-  RequestStatus validateIntersect (const njson& req)
+  RequestStatus validateSetOperation (const njson& req, const std::string_view reqName, const std::string_view rspName)
+  {
+    // sources are "srcA" and "srcB", or "srcs" with at least two names
+    auto checkSources = [](const njson& body) -> RequestStatus
+    {
+      if (!body.contains("srcs"))
+        return body.contains("srcA") && body.contains("srcB") ? RequestStatus::Ok : RequestStatus::ParamMissing;
+      else if (body.at("srcs").size() < 2U)
+        return RequestStatus::CommandSyntax;
+      else
+      {
+        const auto srcs = body.at("srcs").array_range();
+        return std::all_of(srcs.cbegin(), srcs.cend(), [](const njson& src){ return src.is_string(); }) ? RequestStatus::Ok : RequestStatus::ValueTypeInvalid;
+      }
+    };
+
+    return isValid(rspName, req.at(reqName), {{Param::optional("srcA", JsonString)},
+                                              {Param::optional("srcB", JsonString)},
+                                              {Param::optional("srcs", JsonArray)},
+                                              {Param::optional("dest", JsonString)}}, checkSources);
+  }
+
+
+  // LOWER_BOUND and UPPER_BOUND: "item"
+  template<typename Cmds>
+  RequestStatus validateBound (const njson& req, const std::string_view reqName, const std::string_view rspName)
   {
-    const auto reqName = Cmds::IntersectReq.data();
-    const auto rspName = Cmds::IntersectRsp.data();
+    auto checkItem = [](const njson& body) -> RequestStatus
+    {
+      if (!body.contains("item"))
+        return RequestStatus::ParamMissing;
+      else
+        return Cmds::isTypeValid(body.at("item").type()) ? RequestStatus::Ok : RequestStatus::ValueTypeInvalid;
+    };
+
+    return isValid(rspName, req.at(reqName), {{Param::required("name", JsonString)}}, checkItem);
+  }
+
+
+  // COUNT_RNG and FIND_RNG: "min" and "max", inclusive
+  template<typename Cmds>
+  RequestStatus validateValueRange (const njson& req, const std::string_view reqName, const std::string_view rspName)
+  {
+    auto checkRange = [](const njson& body) -> RequestStatus
+    {
+      if (!(body.contains("min") && body.contains("max")))
+        return RequestStatus::ParamMissing;
+      else
+        return Cmds::isTypeValid(body.at("min").type()) && Cmds::isTypeValid(body.at("max").type()) ? RequestStatus::Ok : RequestStatus::ValueTypeInvalid;
+    };
+
+    return isValid(rspName, req.at(reqName), {{Param::required("name", JsonString)}}, checkRange);
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateContains (const njson& req)
+  {
+    auto checkItems = [](const njson& body) -> RequestStatus
+    {
+      for (const auto& item : body.at("items").array_range())
+        if (!Cmds::isTypeValid(item.type()))
+          return RequestStatus::ValueTypeInvalid;
+
+      return RequestStatus::Ok;
+    };
+
+    return isValid(Cmds::ContainsRsp, req.at(Cmds::ContainsReq), {{Param::required("name",  JsonString)},
+                                                                  {Param::required("items", JsonArray)}}, checkItems);
+  }
+
+
+  // PREFIX: "prefix" and optional "n", the maximum number of items returned
+  template<typename Cmds>
+  RequestStatus validatePrefix (const njson& req)
+  {
+    return isValid(Cmds::PrefixRsp, req.at(Cmds::PrefixReq), {{Param::required("name",   JsonString)},
+                                                              {Param::required("prefix", JsonString)},
+                                                              {Param::optional("n",      JsonUInt)}});
+  }
+
+
+  // an aggregate's optional "rng": [start] or [start, stop], which can't be empty
+  inline RequestStatus checkAggregateRange (const njson& body)
+  {
+    if (!body.contains("rng"))
+      return RequestStatus::Ok;
+    else if (const auto nDims = body.at("rng").size(); !(nDims == 1 || nDims == 2))
+      return RequestStatus::ValueSize;
+    else
+    {
+      const auto rng = body.at("rng").array_range();
+
+      if (!std::all_of(rng.cbegin(), rng.cend(), [](const njson& pos){ return pos.is_uint64(); }))
+        return RequestStatus::ValueTypeInvalid;
+      else if (nDims == 2 && rng.cbegin()->as<std::size_t>() >= rng.crbegin()->as<std::size_t>())
+        return RequestStatus::CommandSyntax;
+      else
+        return RequestStatus::Ok;
+    }
+  }
+
+
+  // SUM, AVG, MIN and MAX of unsorted int and float arrays
+  template<typename Cmds>
+  RequestStatus validateAggregate (const njson& req, const std::string_view reqName, const std::string_view rspName)
+  {
+    return isValid(rspName, req.at(reqName), {{Param::required("name", JsonString)},
+                                              {Param::optional("rng",  JsonArray)}}, checkAggregateRange);
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateCountEqual (const njson& req)
+  {
+    auto checkItem = [](const njson& body) -> RequestStatus
+    {
+      if (!body.contains("item"))
+        return RequestStatus::ParamMissing;
+      else if (!Cmds::isTypeValid(body.at("item").type()))
+        return RequestStatus::ValueTypeInvalid;
+      else
+        return checkAggregateRange(body);
+    };
+
+    return isValid(Cmds::CountEqRsp, req.at(Cmds::CountEqReq), {{Param::required("name", JsonString)},
+                                                                {Param::optional("rng",  JsonArray)}}, checkItem);
+  }
+
+
+  // "min" and "max" inclusive, and "buckets", [1, agg::MaxHistogramBuckets]
+  template<typename Cmds>
+  RequestStatus validateHistogram (const njson& req)
+  {
+    auto isInt64 = [](const njson& value)
+    {
+      return !value.is_uint64() || value.as<std::uint64_t>() <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+    };
+
+    auto checkBuckets = [isInt64](const njson& body) -> RequestStatus
+    {
+      if (!(body.contains("min") && body.contains("max")))
+        return RequestStatus::ParamMissing;
+      else if (!(Cmds::isTypeValid(body.at("min").type()) && Cmds::isTypeValid(body.at("max").type())))
+        return RequestStatus::ValueTypeInvalid;
+      else if (!(isInt64(body.at("min")) && isInt64(body.at("max")))) // as<int64_t> would wrap
+        return RequestStatus::ValueTypeInvalid;
+      else if (body.at("max").as<std::int64_t>() < body.at("min").as<std::int64_t>())
+        return RequestStatus::CommandSyntax;
+      else if (const auto buckets = body.at("buckets").as<std::size_t>(); buckets == 0 || buckets > agg::MaxHistogramBuckets)
+        return RequestStatus::ValueSize;
+      else
+        return checkAggregateRange(body);
+    };
+
+    return isValid(Cmds::HistogramRsp, req.at(Cmds::HistogramReq), {{Param::required("name",    JsonString)},
+                                                                    {Param::required("buckets", JsonUInt)},
+                                                                    {Param::optional("rng",     JsonArray)}}, checkBuckets);
+  }
+
+
+  // DOT: "srcA" and "srcB", and an optional "rng"
+  template<typename Cmds>
+  RequestStatus validateDot (const njson& req)
+  {
+    return isValid(Cmds::DotRsp, req.at(Cmds::DotReq), {{Param::required("srcA", JsonString)},
+                                                        {Param::required("srcB", JsonString)},
+                                                        {Param::optional("rng",  JsonArray)}}, checkAggregateRange);
+  }
+
+
+  // ADD, SUB, MUL and DIV: either a number in "value" or an array in "src", and an optional "rng"
+  template<typename Cmds>
+  RequestStatus validateElementwise (const njson& req, const std::string_view reqName, const std::string_view rspName)
+  {
+    auto checkOperand = [](const njson& body) -> RequestStatus
+    {
+      if (body.contains("value") == body.contains("src"))
+        return body.contains("value") ? RequestStatus::CommandSyntax : RequestStatus::ParamMissing;
+      else if (body.contains("value") && !Cmds::isTypeValid(body.at("value").type()))
+        return RequestStatus::ValueTypeInvalid;
+      else
+        return checkAggregateRange(body);
+    };
 
-    return isArrayCmdValid<Cmds>(rspName, req.at(reqName), {{Param::required("srcA", JsonString)},
-                                                            {Param::required("srcB", JsonString)} });
+    return isValid(rspName, req.at(reqName), {{Param::required("name", JsonString)},
+                                              {Param::optional("src",  JsonString)},
+                                              {Param::optional("rng",  JsonArray)}}, checkOperand);
   }
 
 
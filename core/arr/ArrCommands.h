@@ -26,8 +26,30 @@ namespace nemesis { namespace arr { namespace cmds {
   static constexpr FixedString Swap       = "SWAP";
   static constexpr FixedString Clear      = "CLEAR";
   static constexpr FixedString Intersect  = "INTERSECT";
+  static constexpr FixedString Union      = "UNION";
+  static constexpr FixedString Diff       = "DIFF";
   static constexpr FixedString Min        = "MIN";
   static constexpr FixedString Max        = "MAX";
+  static constexpr FixedString LowerBound = "LOWER_BOUND";
+  static constexpr FixedString UpperBound = "UPPER_BOUND";
+  static constexpr FixedString CountRng   = "COUNT_RNG";
+  static constexpr FixedString FindRng    = "FIND_RNG";
+  static constexpr FixedString Contains   = "CONTAINS";
+  static constexpr FixedString Sum        = "SUM";
+  static constexpr FixedString Avg        = "AVG";
+  static constexpr FixedString CountEq    = "COUNT_EQ";
+  static constexpr FixedString Histogram  = "HISTOGRAM";
+  static constexpr FixedString Dot        = "DOT";
+  static constexpr FixedString Add        = "ADD";
+  static constexpr FixedString Sub        = "SUB";
+  static constexpr FixedString Mul        = "MUL";
+  static constexpr FixedString Div        = "DIV";
+  static constexpr FixedString Reserve    = "RESERVE";
+  static constexpr FixedString Shrink     = "SHRINK";
+  static constexpr FixedString Prefix     = "PREFIX";
+  static constexpr FixedString Sort       = "SORT";
+  static constexpr FixedString Unique     = "UNIQUE";
+  static constexpr FixedString ToSorted   = "TO_SORTED";
   
 
   template<FixedString Ident, FixedString Cmd>
@@ -57,6 +79,12 @@ namespace nemesis { namespace arr { namespace cmds {
 
   static constexpr FixedString SortedStrArrayIdent   = "SSTRARR"; // Sorted STRing ARRay
   static constexpr FixedString SortedStrArrayIdent_  = "SSTRARR_";
+
+  static constexpr FixedString FloatArrayIdent   = "FARR";
+  static constexpr FixedString FloatArrayIdent_  = "FARR_";
+
+  static constexpr FixedString SortedFloatArrayIdent   = "SFARR";
+  static constexpr FixedString SortedFloatArrayIdent_  = "SFARR_";
   
 
   template <FixedString Ident>
@@ -84,6 +112,10 @@ namespace nemesis { namespace arr { namespace cmds {
     static constexpr auto GetRsp        = makeRsp<Ident,Get>();
     static constexpr auto GetRngReq     = makeReq<Ident,GetRng>();
     static constexpr auto GetRngRsp     = makeRsp<Ident,GetRng>();
+    static constexpr auto ReserveReq    = makeReq<Ident,Reserve>();
+    static constexpr auto ReserveRsp    = makeRsp<Ident,Reserve>();
+    static constexpr auto ShrinkReq     = makeReq<Ident,Shrink>();
+    static constexpr auto ShrinkRsp     = makeRsp<Ident,Shrink>();
     
     // not enabled in sorted containers
     static constexpr auto SwapReq       = makeReq<Ident,Swap>();
@@ -92,10 +124,58 @@ namespace nemesis { namespace arr { namespace cmds {
     // only enabled in sorted containers
     static constexpr auto IntersectReq = makeReq<Ident,Intersect>();    
     static constexpr auto IntersectRsp = makeRsp<Ident,Intersect>();
+    static constexpr auto UnionReq = makeReq<Ident,Union>();
+    static constexpr auto UnionRsp = makeRsp<Ident,Union>();
+    static constexpr auto DiffReq = makeReq<Ident,Diff>();
+    static constexpr auto DiffRsp = makeRsp<Ident,Diff>();
     static constexpr auto MinReq = makeReq<Ident,Min>();
     static constexpr auto MinRsp = makeRsp<Ident,Min>();
     static constexpr auto MaxReq = makeReq<Ident,Max>();
     static constexpr auto MaxRsp = makeRsp<Ident,Max>();
+    static constexpr auto LowerBoundReq = makeReq<Ident,LowerBound>();
+    static constexpr auto LowerBoundRsp = makeRsp<Ident,LowerBound>();
+    static constexpr auto UpperBoundReq = makeReq<Ident,UpperBound>();
+    static constexpr auto UpperBoundRsp = makeRsp<Ident,UpperBound>();
+    static constexpr auto CountRngReq = makeReq<Ident,CountRng>();
+    static constexpr auto CountRngRsp = makeRsp<Ident,CountRng>();
+    static constexpr auto FindRngReq = makeReq<Ident,FindRng>();
+    static constexpr auto FindRngRsp = makeRsp<Ident,FindRng>();
+    static constexpr auto ContainsReq = makeReq<Ident,Contains>();
+    static constexpr auto ContainsRsp = makeRsp<Ident,Contains>();
+
+    // only enabled in sorted string arrays
+    static constexpr auto PrefixReq = makeReq<Ident,Prefix>();
+    static constexpr auto PrefixRsp = makeRsp<Ident,Prefix>();
+
+    // only enabled in unsorted int and float arrays, which also use MIN and MAX. COUNT_EQ and HISTOGRAM are int only
+    static constexpr auto SumReq = makeReq<Ident,Sum>();
+    static constexpr auto SumRsp = makeRsp<Ident,Sum>();
+    static constexpr auto AvgReq = makeReq<Ident,Avg>();
+    static constexpr auto AvgRsp = makeRsp<Ident,Avg>();
+    static constexpr auto CountEqReq = makeReq<Ident,CountEq>();
+    static constexpr auto CountEqRsp = makeRsp<Ident,CountEq>();
+    static constexpr auto HistogramReq = makeReq<Ident,Histogram>();
+    static constexpr auto HistogramRsp = makeRsp<Ident,Histogram>();
+
+    // only enabled in unsorted float arrays
+    static constexpr auto DotReq = makeReq<Ident,Dot>();
+    static constexpr auto DotRsp = makeRsp<Ident,Dot>();
+    static constexpr auto AddReq = makeReq<Ident,Add>();
+    static constexpr auto AddRsp = makeRsp<Ident,Add>();
+    static constexpr auto SubReq = makeReq<Ident,Sub>();
+    static constexpr auto SubRsp = makeRsp<Ident,Sub>();
+    static constexpr auto MulReq = makeReq<Ident,Mul>();
+    static constexpr auto MulRsp = makeRsp<Ident,Mul>();
+    static constexpr auto DivReq = makeReq<Ident,Div>();
+    static constexpr auto DivRsp = makeRsp<Ident,Div>();
+
+    // only enabled in unsorted int and string arrays
+    static constexpr auto SortReq = makeReq<Ident,Sort>();
+    static constexpr auto SortRsp = makeRsp<Ident,Sort>();
+    static constexpr auto UniqueReq = makeReq<Ident,Unique>();
+    static constexpr auto UniqueRsp = makeRsp<Ident,Unique>();
+    static constexpr auto ToSortedReq = makeReq<Ident,ToSorted>();
+    static constexpr auto ToSortedRsp = makeRsp<Ident,ToSorted>();
   };
 
   
@@ -107,6 +187,9 @@ namespace nemesis { namespace arr { namespace cmds {
     static constexpr JsonType ItemJsonT = JT;
     static constexpr bool IsSorted = false;
     static constexpr bool CanIntersect = false;
+    static constexpr bool CanAggregate = false;
+    static constexpr bool CanMath = false;
+    static constexpr bool CanSort = false;
   };
 
 
@@ -128,6 +211,11 @@ namespace nemesis { namespace arr { namespace cmds {
   // Integer Array (signed)
   struct IntArrCmds : public UnsortedArray<std::int64_t, JsonInt, IntArrayIdent_>
   {  
+    // SUM, AVG, MIN, MAX, COUNT_EQ and HISTOGRAM
+    static constexpr bool CanAggregate = true;
+    // SORT, UNIQUE and TO_SORTED
+    static constexpr bool CanSort = true;
+
     static constexpr bool isTypeValid (const JsonType t)
     {
       // jsoncons (and possibly JSON specs) stores an an integer 
@@ -142,6 +230,9 @@ namespace nemesis { namespace arr { namespace cmds {
   // String Array
   struct StrArrCmds : public UnsortedArray<std::string, JsonString, StrArrayIdent_>
   {   
+    // SORT, UNIQUE and TO_SORTED
+    static constexpr bool CanSort = true;
+
     static constexpr bool isTypeValid (const JsonType t)
     {
       return t == ItemJsonT;
@@ -149,6 +240,22 @@ namespace nemesis { namespace arr { namespace cmds {
   };
 
 
+  // Float Array (double)
+  struct FloatArrCmds : public UnsortedArray<double, JsonDouble, FloatArrayIdent_>
+  {
+    // SUM, AVG, MIN and MAX
+    static constexpr bool CanAggregate = true;
+    // DOT, ADD, SUB, MUL and DIV
+    static constexpr bool CanMath = true;
+
+    static constexpr bool isTypeValid (const JsonType t)
+    {
+      // an integer in JSON, such as 1 rather than 1.0, is parsed as an integer
+      return t == ItemJsonT || t == JsonUInt || t == JsonInt;
+    }
+  };
+
+
   // The IsSorted and CanIntersect are both probably not required,
   // because intersection requires a sorted container, so can probably
   // remove CanIntersect. There may be a container that's sorted but
@@ -162,6 +269,9 @@ namespace nemesis { namespace arr { namespace cmds {
     static constexpr JsonType ItemJsonT = JT;
     static constexpr bool IsSorted = true;
     static constexpr bool CanIntersect = true;
+    static constexpr bool CanAggregate = false;
+    static constexpr bool CanMath = false;
+    static constexpr bool CanSort = false;
   };
 
 
@@ -183,6 +293,16 @@ namespace nemesis { namespace arr { namespace cmds {
       return t == ItemJsonT;
     }
   };
+
+
+  // Sorted Float Array
+  struct SortedFloatArrCmds : public SortedArray<double, JsonDouble, SortedFloatArrayIdent_>
+  {   
+    static constexpr bool isTypeValid (const JsonType t)
+    {
+      return t == ItemJsonT || t == JsonUInt || t == JsonInt;
+    }
+  };
 }
 }
 }
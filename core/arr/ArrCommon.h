@@ -1,6 +1,8 @@
 #ifndef NDB_CORE_ARRCOMMON_H
 #define NDB_CORE_ARRCOMMON_H
 
+#include <optional>
+#include <string_view>
 #include <core/NemesisCommon.h>
 
 
@@ -22,11 +24,61 @@ namespace nemesis {  namespace arr {
     Clear,
     Swap,
     Intersect,
+    Union,
+    Diff,
     Min,
-    Max
+    Max,
+    LowerBound,
+    UpperBound,
+    CountRng,
+    FindRng,
+    Contains,
+    Sum,
+    Avg,
+    CountEq,
+    Histogram,
+    Dot,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Reserve,
+    Shrink,
+    Prefix,
+    Sort,
+    Unique,
+    ToSorted
   };
 
 
+  // How an array stores its items, set with CREATE's "layout"
+  enum class Layout : std::uint8_t
+  {
+    Vector,     // contiguous, an insert moves all items after it
+    Blocked,    // sorted only: SortedBlocks, an insert moves items within one leaf
+    Paged,      // unsorted only: SparsePages, a page allocated when first set
+    Arena,      // strings only: StringArena, packed bytes with an inline prefix per string
+    FrontCoded  // sorted strings only: FrontCodedStrings, as Blocked with each string's shared prefix omitted
+  };
+
+
+  inline std::optional<Layout> toLayout (const std::string_view name)
+  {
+    if (name == "vector")
+      return Layout::Vector;
+    else if (name == "blocked")
+      return Layout::Blocked;
+    else if (name == "paged")
+      return Layout::Paged;
+    else if (name == "arena")
+      return Layout::Arena;
+    else if (name == "frontcoded")
+      return Layout::FrontCoded;
+    else
+      return std::nullopt;
+  }
+
+
   template <class ArrayCmds>
   RequestStatus isArrayCmdValid ( const std::string_view queryRspName, 
                                             const njson& req,
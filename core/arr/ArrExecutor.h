@@ -1,11 +1,20 @@
 #ifndef NDB_CORE_ARREXECUTOR_H
 #define NDB_CORE_ARREXECUTOR_H
 
+#include <algorithm>
 #include <functional>
+#include <limits>
+#include <optional>
+#include <span>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 #include <core/NemesisCommon.h>
 #include <core/arr/ArrCommands.h>
 #include <core/arr/ArrArray.h>
+#include <core/arr/ArrSetOps.h>
+#include <core/arr/ArrAggregate.h>
+#include <core/arr/ArrFloatMath.h>
 
 
 namespace nemesis { namespace arr {
@@ -31,9 +40,10 @@ public:
 
     try
     {
+      // makeCapacity() grows a growable array, otherwise it's a bounds check
       if constexpr (Cmds::IsSorted)
       {
-        if (array.isFull())
+        if (!array.makeCapacity(array.used() + 1))
           rspBody["st"] = toUnderlying(RequestStatus::Bounds);
         else
           array.set(reqBody.at("item").as<ArrayValueT>());
@@ -44,14 +54,14 @@ public:
         {
           const std::size_t pos = reqBody.at("pos").as<std::size_t>();
       
-          if (!array.isInBounds(pos))
+          if (!array.makeCapacity(pos + 1))
             rspBody["st"] = toUnderlying(RequestStatus::Bounds);
           else
             array.set(pos, reqBody.at("item").as<ArrayValueT>());
         }
         else
         {
-          if (array.isFull())
+          if (!array.makeCapacity(array.used() + 1))
             rspBody["st"] = toUnderlying(RequestStatus::Bounds);
           else
             array.set(reqBody.at("item").as<ArrayValueT>());
@@ -83,10 +93,10 @@ public:
 
       if constexpr (Cmds::IsSorted)
       {
-        if (!array.hasCapacity(items.size()))
+        if (!array.makeCapacity(array.used() + items.size()))
           response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Bounds);
         else
-          array.setRange(items);
+          array.setRange(items, reqBody.contains("sorted") && reqBody.at("sorted").as_bool());
       }
       else
       {
@@ -94,14 +104,14 @@ public:
         {
           const std::size_t pos = reqBody.at("pos").as<std::size_t>();
 
-          if (!array.isSetInBounds(pos, items.size()))
+          if (!array.makeCapacity(pos + items.size()) || !array.isSetInBounds(pos, items.size()))
             response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Bounds);
           else
             array.setRange(pos, items);
         }
         else
         {
-          if (array.isFull())
+          if (!array.makeCapacity(array.used() + items.size()))
             response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Bounds);
           else
             array.setRange(items);
@@ -167,6 +177,34 @@ public:
   }
 
 
+  // RESERVE: "len" is the minimum capacity. Responds with the capacity.
+  static Response reserve (Array& array, const njson& reqBody)
+  {
+    static const constexpr auto RspName = Cmds::ReserveRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(array.reserve(reqBody.at("len").as<std::size_t>()) ? RequestStatus::Ok : RequestStatus::Bounds);
+    response.rsp[RspName]["len"] = array.size();
+    return response;
+  }
+
+
+  // SHRINK: reduces the capacity to the items held. Responds with the capacity.
+  static Response shrink (Array& array, const njson& reqBody)
+  {
+    static const constexpr auto RspName = Cmds::ShrinkRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+
+    array.shrinkToFit();
+
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+    response.rsp[RspName]["len"] = array.size();
+    return response;
+  }
+
+
   static Response used (const Array& array, const njson& reqBody)
   {
     static const njson Prepared = njson{jsoncons::json_object_arg, {{Cmds::UsedRsp.data(), njson::object()}}};
@@ -205,26 +243,232 @@ public:
   }
 
 
-  static Response intersect (const Array& a, const Array& b) requires (Cmds::IsSorted)
+  // Positions [first, last) of the items in [min, max]
+  static std::pair<std::size_t, std::size_t> valueRange (const Array& array, const njson& reqBody) requires (Cmds::IsSorted)
   {
-    static const constexpr auto RspName = Cmds::IntersectRsp.data();
-    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+    const auto min = reqBody.at("min").as<ArrayValueT>();
+    const auto max = reqBody.at("max").as<ArrayValueT>();
 
-    Response response{.rsp = Prepared};
-    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+    if (max < min)
+      return {0, 0};
+    else
+      return {array.lowerBound(min), array.upperBound(max)};
+  }
 
-    try
+
+  // The result of 'op' on 'arrays', in order
+  static std::vector<typename Cmds::ItemT> applySetOperation (const setops::Operation op, const std::vector<const Array *>& arrays) requires (Cmds::IsSorted)
+  {
+    if constexpr (std::is_same_v<ArrayValueT, std::string>)
     {
-      std::vector<typename Cmds::ItemT> result;
-      std::set_intersection(a.cbegin(), a.cend(),
-                            b.cbegin(), b.cend(),
-                            std::back_inserter(result));
+      if (std::any_of(arrays.cbegin(), arrays.cend(), [](const Array * array){ return array->isArena(); }))
+        return applyStringSetOperation(op, arrays);
+    }
+
+    setops::Sources<typename Cmds::ItemT> sources;
+    sources.reserve(arrays.size());
+
+    std::vector<std::vector<typename Cmds::ItemT>> copies (arrays.size()); // for blocked arrays
+
+    for (std::size_t i = 0 ; i < arrays.size() ; ++i)
+      sources.emplace_back(arrays[i]->range(0, arrays[i]->used(), copies[i]));
+
+    return setops::apply(op, std::move(sources));
+  }
+
+
+  // As above, with arrays as StringRefs, which compare by key and are not copied until the result
+  static std::vector<std::string> applyStringSetOperation (const setops::Operation op, const std::vector<const Array *>& arrays) requires (Cmds::IsSorted)
+  {
+    std::vector<std::vector<StringRef>> refs (arrays.size());
+    std::vector<std::vector<std::string>> copies (arrays.size()); // for other layouts
+
+    setops::Sources<StringRef> sources;
+    sources.reserve(arrays.size());
+
+    for (std::size_t i = 0 ; i < arrays.size() ; ++i)
+    {
+      refs[i].reserve(arrays[i]->used());
+
+      if (arrays[i]->isArena())
+        arrays[i]->forEachRef([&ref = refs[i]](const StringRef& s){ ref.push_back(s); });
+      else
+      {
+        for (const auto& s : arrays[i]->range(0, arrays[i]->used(), copies[i]))
+          refs[i].push_back(StringRef::of(s));
+      }
+
+      sources.emplace_back(refs[i]);
+    }
+
+    const auto result = setops::apply(op, std::move(sources));
+
+    std::vector<std::string> strings;
+    strings.reserve(result.size());
 
+    for (const auto& s : result)
+      strings.push_back(s.str());
+
+    return strings;
+  }
+
+
+  static Response setOperation (const char * rspName, const setops::Operation op, const std::vector<const Array *>& arrays) requires (Cmds::IsSorted)
+  {
+    Response response;
+    response.rsp = njson{jsoncons::json_object_arg, {{rspName, njson::object()}}};
+    response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      auto result = applySetOperation(op, arrays);
       
       njson items (jsoncons::json_array_arg,  std::make_move_iterator(result.begin()),
                                               std::make_move_iterator(result.end()));
       
-      response.rsp[RspName]["items"] = std::move(items);
+      response.rsp[rspName]["items"] = std::move(items);
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  // LOWER_BOUND or UPPER_BOUND
+  static Response bound (const char * rspName, const Array& array, const njson& reqBody, const bool upper) requires (Cmds::IsSorted)
+  {
+    Response response;
+    response.rsp = njson{jsoncons::json_object_arg, {{rspName, njson::object()}}};
+    response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      const auto item = reqBody.at("item").as<ArrayValueT>();
+      response.rsp[rspName]["pos"] = upper ? array.upperBound(item) : array.lowerBound(item);
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  static Response countRange (const Array& array, const njson& reqBody) requires (Cmds::IsSorted)
+  {
+    static const constexpr auto RspName = Cmds::CountRngRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+    
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      const auto [first, last] = valueRange(array, reqBody);
+      response.rsp[RspName]["count"] = last - first;
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  static Response findRange (const Array& array, const njson& reqBody) requires (Cmds::IsSorted)
+  {
+    static const constexpr auto RspName = Cmds::FindRngRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+    
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      const auto [first, last] = valueRange(array, reqBody);
+      response.rsp[RspName]["items"] = array.getRange(first, last);
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  static Response contains (const Array& array, const njson& reqBody) requires (Cmds::IsSorted)
+  {
+    static const constexpr auto RspName = Cmds::ContainsRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+    
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      const auto& items = reqBody.at("items");
+
+      njson contains = njson::make_array();
+      contains.reserve(items.size());
+
+      for (const auto& item : items.array_range())
+        contains.push_back(array.contains(item.as<ArrayValueT>()));
+
+      response.rsp[RspName]["contains"] = std::move(contains);
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  /*
+  Items beginning with "prefix": from its lower bound to the lower bound of its successor, the
+  smallest string greater than every string with the prefix. "count" is the number of items
+  with the prefix, "items" the first "n" of them.
+  */
+  static Response prefix (const Array& array, const njson& reqBody) requires (Cmds::IsSorted && std::is_same_v<ArrayValueT, std::string>)
+  {
+    static const constexpr auto RspName = Cmds::PrefixRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      auto prefix = reqBody.at("prefix").as_string();
+      const auto first = array.lowerBound(prefix);
+
+      // the successor: remove trailing 0xFF bytes then increment the last, none if nothing remains
+      while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xFF)
+        prefix.pop_back();
+
+      std::size_t last = array.used();
+      if (!prefix.empty())
+      {
+        prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+        last = array.lowerBound(prefix);
+      }
+
+      const auto n = reqBody.contains("n") ? reqBody.at("n").as<std::size_t>() : last - first;
+
+      response.rsp[RspName]["items"] = array.getRange(first, first + std::min(n, last - first));
+      response.rsp[RspName]["count"] = last - first;
     }
     catch(const std::exception& e)
     {
@@ -264,6 +508,69 @@ public:
   }
 
 
+  // SORT: sorts [0, used()) in place, ascending unless "desc"
+  static Response sort (Array& array, const njson& reqBody) requires (Cmds::CanSort)
+  {
+    static const constexpr auto RspName = Cmds::SortRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      array.sort(reqBody.contains("desc") && reqBody.at("desc").as_bool());
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  // UNIQUE: removes repeated items from [0, used()), keeping the first of each. Responds with used().
+  static Response unique (Array& array, const njson& reqBody) requires (Cmds::CanSort)
+  {
+    static const constexpr auto RspName = Cmds::UniqueRsp.data();
+    static const njson Prepared = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+
+    Response response{.rsp = Prepared};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      response.rsp[RspName]["used"] = array.unique();
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  // Items in [0, used()) sorted ascending, and with 'unique', without repeats. For TO_SORTED.
+  static std::vector<ArrayValueT> sorted (const Array& array, const bool unique) requires (Cmds::CanSort)
+  {
+    std::vector<ArrayValueT> items;
+
+    if (const auto values = array.range(0, array.used(), items) ; values.data() != items.data())
+      items.assign(values.begin(), values.end());
+
+    sortItems(items);
+
+    if (unique)
+      items.erase(std::unique(items.begin(), items.end()), items.end());
+
+    return items;
+  }
+
+
   static Response min (Array& array, const njson& reqBody)
   {
     static const constexpr auto RspName = Cmds::MinRsp.data();
@@ -316,6 +623,363 @@ public:
 
     return response;
   }
+
+
+  /*
+  [start, stop) of an aggregate's "rng", with stop limited to size(). Without a stop, the range ends at
+  size(), or extent() for a growable array, whose capacity grows beyond the items set. Empty if start is
+  out of bounds, or at or beyond extent() when that ends the range.
+  */
+  static std::pair<std::size_t, std::size_t> aggregateRange (const Array& array, const njson& reqBody) requires (Cmds::CanAggregate)
+  {
+    const auto [start, stop, hasStop, hasRng] = rangeFromRequest(reqBody, "rng");
+
+    if (!array.isInBounds(start))
+      return {0, 0};
+    else if (hasStop)
+      return {start, std::min(stop, array.size())};
+    else if (array.isGrowable())
+      return {start, std::max(start, array.extent())};
+    else
+      return {start, array.size()};
+  }
+
+
+  // Calls f(values, pos) for each contiguous run of [start, stop), 'pos' the position of the first.
+  // One run unless the array is paged, when the kernels run per page and results are combined.
+  // A non-const paged array allocates each page, see the overload below.
+  template<typename A, typename F>
+  static void forEachRun (A& array, std::size_t start, const std::size_t stop, F&& f)
+  {
+    while (start < stop)
+    {
+      const auto values = array.contiguous(start, stop - start);
+      f(values, start);
+      start += values.size();
+    }
+  }
+
+
+  // As above, but consecutive untouched pages, which are all zero, are passed to zeros(pos, n)
+  // rather than read or allocated.
+  template<typename A, typename F, typename Z>
+  static void forEachRun (A& array, std::size_t start, const std::size_t stop, F&& f, Z&& zeros)
+  {
+    auto zerosStart = start;
+
+    while (start < stop)
+    {
+      const auto n = std::as_const(array).contiguous(start, stop - start).size();
+
+      if (!array.isUntouched(start, start + n))
+      {
+        if (zerosStart < start)
+          zeros(zerosStart, start - zerosStart);
+
+        f(array.contiguous(start, n), start);
+        zerosStart = start + n;
+      }
+
+      start += n;
+    }
+
+    if (zerosStart < stop)
+      zeros(zerosStart, stop - zerosStart);
+  }
+
+
+  // Aggregates the values in "rng": 'set' sets the response body from [start, stop)
+  template<typename Set>
+  static Response aggregate (const char * rspName, const Array& array, const njson& reqBody, Set&& set) requires (Cmds::CanAggregate)
+  {
+    Response response;
+    response.rsp = njson{jsoncons::json_object_arg, {{rspName, njson::object()}}};
+    response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      if (const auto [start, stop] = aggregateRange(array, reqBody); start == stop)
+        response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Bounds);
+      else
+        set(start, stop, response.rsp[rspName]);
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  // An int sum is exact, but JSON integers are 64-bit, so a sum beyond int64 is a double
+  static Response sum (const Array& array, const njson& reqBody) requires (Cmds::CanAggregate)
+  {
+    return aggregate(Cmds::SumRsp.data(), array, reqBody, [&array](const std::size_t start, const std::size_t stop, njson& rspBody)
+    {
+      if constexpr (std::is_same_v<ArrayValueT, double>)
+        rspBody["sum"] = sumOf(array, start, stop);
+      else
+      {
+        const auto total = sumOf(array, start, stop);
+
+        if (total >= std::numeric_limits<std::int64_t>::min() && total <= std::numeric_limits<std::int64_t>::max())
+          rspBody["sum"] = static_cast<std::int64_t>(total);
+        else
+          rspBody["sum"] = static_cast<double>(total);
+      }
+    });
+  }
+
+
+  static Response avg (const Array& array, const njson& reqBody) requires (Cmds::CanAggregate)
+  {
+    return aggregate(Cmds::AvgRsp.data(), array, reqBody, [&array](const std::size_t start, const std::size_t stop, njson& rspBody)
+    {
+      rspBody["avg"] = static_cast<double>(sumOf(array, start, stop)) / (stop - start);
+    });
+  }
+
+
+  // double for FARR, otherwise exact (agg::sum())
+  static auto sumOf (const Array& array, const std::size_t start, const std::size_t stop) requires (Cmds::CanAggregate)
+  {
+    if constexpr (std::is_same_v<ArrayValueT, double>)
+    {
+      double total = 0;
+      forEachRun(array, start, stop, [&total](const auto values, std::size_t){ total += fmath::FloatKernels.sum(values); }, [](std::size_t, std::size_t){});
+      return total;
+    }
+    else
+    {
+      decltype(agg::sum(std::span<const ArrayValueT>{})) total = 0;
+      forEachRun(array, start, stop, [&total](const auto values, std::size_t){ total += agg::sum(values); }, [](std::size_t, std::size_t){});
+      return total;
+    }
+  }
+
+
+  // MIN or MAX: the value and the position of its first occurrence
+  static Response extreme (const char * rspName, const Array& array, const njson& reqBody, const bool max) requires (Cmds::CanAggregate)
+  {
+    return aggregate(rspName, array, reqBody, [&array, max](const std::size_t start, const std::size_t stop, njson& rspBody)
+    {
+      using PositionT = std::conditional_t<std::is_same_v<ArrayValueT, double>, fmath::Position, agg::Position>;
+
+      std::optional<PositionT> extreme;
+
+      // a later run replaces only if strictly better, so the first occurrence is kept
+      auto replace = [&extreme, max](const PositionT& result)
+      {
+        if (!extreme || (max ? result.value > extreme->value : result.value < extreme->value))
+          extreme = result;
+      };
+
+      forEachRun(array, start, stop, [&replace, max](const auto values, const std::size_t pos)
+      {
+        PositionT result;
+
+        if constexpr (std::is_same_v<ArrayValueT, double>)
+          result = max ? fmath::FloatKernels.max(values) : fmath::FloatKernels.min(values);
+        else
+          result = max ? agg::AggKernels.max(values) : agg::AggKernels.min(values);
+
+        replace(PositionT{result.value, pos + result.pos});
+      },
+      [&replace](const std::size_t pos, std::size_t){ replace(PositionT{0, pos}); });
+
+      rspBody["item"] = extreme->value;
+      rspBody["pos"] = extreme->pos;
+    });
+  }
+
+
+  static Response countEqual (const Array& array, const njson& reqBody) requires (Cmds::CanAggregate && std::is_integral_v<ArrayValueT>)
+  {
+    return aggregate(Cmds::CountEqRsp.data(), array, reqBody, [&array, &reqBody](const std::size_t start, const std::size_t stop, njson& rspBody)
+    {
+      const auto item = reqBody.at("item").as<std::int64_t>();
+      std::size_t count = 0;
+
+      forEachRun( array, start, stop, [&count, item](const auto values, std::size_t){ count += agg::AggKernels.countEqual(values, item); },
+                  [&count, item](std::size_t, const std::size_t n){ count += item == 0 ? n : 0; });
+
+      rspBody["count"] = count;
+    });
+  }
+
+
+  static Response histogram (const Array& array, const njson& reqBody) requires (Cmds::CanAggregate && std::is_integral_v<ArrayValueT>)
+  {
+    return aggregate(Cmds::HistogramRsp.data(), array, reqBody, [&array, &reqBody](const std::size_t start, const std::size_t stop, njson& rspBody)
+    {
+      const auto min = reqBody.at("min").as<std::int64_t>();
+      const auto max = reqBody.at("max").as<std::int64_t>();
+      const auto buckets = reqBody.at("buckets").as<std::size_t>();
+
+      std::optional<agg::Histogram> result;
+
+      // each run has the same buckets, so the counts add
+      auto add = [&result](agg::Histogram run)
+      {
+        if (!result)
+          result = std::move(run);
+        else
+        {
+          std::transform(result->counts.cbegin(), result->counts.cend(), run.counts.cbegin(), result->counts.begin(), std::plus<>{});
+          result->below += run.below;
+          result->above += run.above;
+        }
+      };
+
+      forEachRun(array, start, stop, [&](const auto values, std::size_t){ add(agg::histogram(values, min, max, buckets)); },
+      [&](std::size_t, const std::size_t n)
+      {
+        // the histogram of one zero, n times
+        const ArrayValueT zero{};
+        auto run = agg::histogram(std::span<const ArrayValueT>{&zero, 1}, min, max, buckets);
+
+        std::transform(run.counts.cbegin(), run.counts.cend(), run.counts.begin(), [n](const auto count){ return count * n; });
+        run.below *= n;
+        run.above *= n;
+        add(std::move(run));
+      });
+
+      rspBody["counts"] = njson{jsoncons::json_array_arg, result->counts.cbegin(), result->counts.cend()};
+      rspBody["width"] = result->width;
+      rspBody["below"] = result->below;
+      rspBody["above"] = result->above;
+    });
+  }
+
+
+  // [start, stop) of "rng" within both arrays, with stop limited to the smaller size. Empty if start is out of bounds of either.
+  static std::pair<std::size_t, std::size_t> mathRange (const Array& a, const Array& b, const njson& reqBody) requires (Cmds::CanMath)
+  {
+    const auto [start, stop, hasStop, hasRng] = rangeFromRequest(reqBody, "rng");
+    const auto size = std::min(a.size(), b.size());
+
+    if (start >= size)
+      return {0, 0};
+    else
+      return {start, std::min(hasStop ? stop : size, size)};
+  }
+
+
+  static Response dot (const Array& a, const Array& b, const njson& reqBody) requires (Cmds::CanMath)
+  {
+    static const constexpr auto RspName = Cmds::DotRsp.data();
+
+    Response response;
+    response.rsp = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+    response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      if (const auto [start, stop] = mathRange(a, b, reqBody); start == stop)
+        response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Bounds);
+      else
+      {
+        double total = 0;
+
+        // runs of 'a', each limited to the run of 'b' at the same position. An untouched page is zero.
+        for (auto pos = start ; pos < stop ; )
+        {
+          const auto y = b.contiguous(pos, stop - pos);
+          const auto x = a.contiguous(pos, y.size());
+
+          if (!a.isUntouched(pos, pos + x.size()) && !b.isUntouched(pos, pos + x.size()))
+            total += fmath::FloatKernels.dot(x, y.first(x.size()));
+
+          pos += x.size();
+        }
+
+        response.rsp[RspName]["dot"] = total;
+      }
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
+
+
+  // ADD, SUB, MUL or DIV each value in "rng" by "value", or by the value at the same position in 'src'.
+  // Division by zero is rejected because JSON can't represent the infinity or NaN.
+  static Response elementwise (const char * rspName, const fmath::Op op, Array& array, const Array * src, const njson& reqBody) requires (Cmds::CanMath)
+  {
+    Response response;
+    response.rsp = njson{jsoncons::json_object_arg, {{rspName, njson::object()}}};
+    response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Ok);
+
+    try
+    {
+      const auto [start, stop] = mathRange(array, src ? *src : array, reqBody);
+
+      if (start == stop)
+        response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Bounds);
+      else if (src)
+      {
+        bool hasZero = false;
+
+        if (op == fmath::Op::Div)
+        {
+          forEachRun( *src, start, stop, [&hasZero](const auto other, std::size_t){ hasZero = hasZero || std::find(other.begin(), other.end(), 0.0) != other.end(); },
+                      [&hasZero](std::size_t, std::size_t){ hasZero = true; });
+        }
+
+        if (hasZero)
+          response.rsp[rspName]["st"] = toUnderlying(RequestStatus::ValueSize);
+        else
+        {
+          // untouched pages are zero: MUL and DIV leave zeros in 'array', ADD and SUB of zeros in 'src'
+          // change nothing, so neither allocates a page
+          const bool scales = op == fmath::Op::Mul || op == fmath::Op::Div;
+
+          for (auto pos = start ; pos < stop ; )
+          {
+            const auto n = std::as_const(array).contiguous(pos, src->contiguous(pos, stop - pos).size()).size();
+
+            if (!(scales ? array.isUntouched(pos, pos + n) : src->isUntouched(pos, pos + n)))
+              fmath::apply(op, array.contiguous(pos, n), src->contiguous(pos, n));
+
+            pos += n;
+          }
+        }
+      }
+      else
+      {
+        const auto value = reqBody.at("value").as<double>();
+
+        if (op == fmath::Op::Div && value == 0.0)
+          response.rsp[rspName]["st"] = toUnderlying(RequestStatus::ValueSize);
+        else
+        {
+          auto apply = [op, value](const auto values, std::size_t){ fmath::apply(op, values, value); };
+
+          // untouched pages are zero, which MUL, DIV and adding zero leave unchanged, so they aren't allocated
+          const bool keepsZero = op == fmath::Op::Mul || op == fmath::Op::Div || value == 0.0;
+
+          forEachRun(array, start, stop, apply, [&array, &apply, keepsZero](const std::size_t pos, const std::size_t n)
+          {
+            if (!keepsZero)
+              forEachRun(array, pos, pos + n, apply);
+          });
+        }
+      }
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Unknown);
+    }
+
+    return response;
+  }
 };
 
 }
@@ -0,0 +1,363 @@
+#ifndef NDB_CORE_ARRFLOATMATH_H
+#define NDB_CORE_ARRFLOATMATH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace nemesis { namespace arr { namespace fmath {
+
+/*
+Math on double values, for float arrays.
+
+  - sum and dot: floating point addition isn't associative, so the compiler won't vectorize
+    these without -ffast-math. The kernels keep 4 vector accumulators, which also hides the
+    latency of each add, then add them. The result can differ from a sequential sum in the
+    last bits, as with any reordering, but is usually closer because each accumulator sums fewer values
+  - min and max: the value and the position of its first occurrence, as agg::min() and agg::max()
+  - apply: an elementwise operation with a scalar or another array. There's no reduction, so
+    plain loops, which the compiler vectorizes
+
+The sum, dot, min and max kernels are selected at runtime, from AVX-512, AVX2 and scalar,
+as in ArrSetOps.h.
+*/
+
+
+using Values = std::span<const double>;
+
+
+struct Position
+{
+  double value;
+  std::size_t pos;
+};
+
+
+enum class Op : std::uint8_t
+{
+  Add,
+  Sub,
+  Mul,
+  Div
+};
+
+
+inline std::optional<Op> toOp (const std::string_view name)
+{
+  if (name == "ADD")
+    return Op::Add;
+  else if (name == "SUB")
+    return Op::Sub;
+  else if (name == "MUL")
+    return Op::Mul;
+  else if (name == "DIV")
+    return Op::Div;
+  else
+    return std::nullopt;
+}
+
+
+inline double sumScalar (const Values values)
+{
+  double total = 0;
+
+  for (const auto value : values)
+    total += value;
+
+  return total;
+}
+
+
+// 'a' and 'b' must be the same size
+inline double dotScalar (const Values a, const Values b)
+{
+  double total = 0;
+
+  for (std::size_t i = 0 ; i < a.size() ; ++i)
+    total += a[i] * b[i];
+
+  return total;
+}
+
+
+template<bool Max>
+Position extremeScalar (const Values values, Position best, const std::size_t from)
+{
+  for (std::size_t i = from ; i < values.size() ; ++i)
+  {
+    if (Max ? best.value < values[i] : values[i] < best.value)
+      best = Position{.value = values[i], .pos = i};
+  }
+
+  return best;
+}
+
+
+inline Position minScalar (const Values values)
+{
+  return extremeScalar<false>(values, Position{.value = values[0], .pos = 0}, 1);
+}
+
+
+inline Position maxScalar (const Values values)
+{
+  return extremeScalar<true>(values, Position{.value = values[0], .pos = 0}, 1);
+}
+
+
+// The best of the lanes, the lowest position on a tie
+template<bool Max, std::size_t Width>
+Position reduceExtreme (const double (&best)[Width], const std::uint64_t (&positions)[Width])
+{
+  Position result{.value = best[0], .pos = positions[0]};
+
+  for (std::size_t l = 1 ; l < Width ; ++l)
+  {
+    if ((Max ? result.value < best[l] : best[l] < result.value) || (best[l] == result.value && positions[l] < result.pos))
+      result = Position{.value = best[l], .pos = positions[l]};
+  }
+
+  return result;
+}
+
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2,fma"))) inline double sumAvx2 (const Values values)
+{
+  static constexpr std::size_t Width = 4U;
+
+  __m256d acc[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= values.size() ; i += 4 * Width)
+  {
+    for (std::size_t a = 0 ; a < 4 ; ++a)
+      acc[a] = _mm256_add_pd(acc[a], _mm256_loadu_pd(values.data() + i + a * Width));
+  }
+
+  for ( ; i + Width <= values.size() ; i += Width)
+    acc[0] = _mm256_add_pd(acc[0], _mm256_loadu_pd(values.data() + i));
+
+  double lanes[Width];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(acc[0], acc[1]), _mm256_add_pd(acc[2], acc[3])));
+
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumScalar(values.subspan(i));
+}
+
+
+__attribute__((target("avx2,fma"))) inline double dotAvx2 (const Values a, const Values b)
+{
+  static constexpr std::size_t Width = 4U;
+
+  __m256d acc[4] = {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_setzero_pd()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+      acc[n] = _mm256_fmadd_pd(_mm256_loadu_pd(a.data() + i + n * Width), _mm256_loadu_pd(b.data() + i + n * Width), acc[n]);
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+    acc[0] = _mm256_fmadd_pd(_mm256_loadu_pd(a.data() + i), _mm256_loadu_pd(b.data() + i), acc[0]);
+
+  double lanes[Width];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(acc[0], acc[1]), _mm256_add_pd(acc[2], acc[3])));
+
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotScalar(a.subspan(i), b.subspan(i));
+}
+
+
+template<bool Max>
+__attribute__((target("avx2"))) inline Position extremeAvx2 (const Values values)
+{
+  static constexpr std::size_t Width = 4U;
+
+  if (values.size() < Width)
+    return extremeScalar<Max>(values, Position{.value = values[0], .pos = 0}, 1);
+
+  const __m256i step = _mm256_set1_epi64x(Width);
+  __m256d best = _mm256_loadu_pd(values.data());
+  __m256i positions = _mm256_set_epi64x(3, 2, 1, 0);
+  __m256i bestPositions = positions;
+
+  std::size_t i = Width;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __m256d v = _mm256_loadu_pd(values.data() + i);
+    const __m256d better = Max ? _mm256_cmp_pd(v, best, _CMP_GT_OQ) : _mm256_cmp_pd(v, best, _CMP_LT_OQ);
+
+    positions = _mm256_add_epi64(positions, step);
+    best = _mm256_blendv_pd(best, v, better);
+    bestPositions = _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(bestPositions), _mm256_castsi256_pd(positions), better));
+  }
+
+  double b[Width];
+  std::uint64_t p[Width];
+  _mm256_storeu_pd(b, best);
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), bestPositions);
+
+  // the remaining values follow every lane's position
+  return extremeScalar<Max>(values, reduceExtreme<Max>(b, p), i);
+}
+
+
+// GCC 12's avx512fintrin.h has a false -Wmaybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f"))) inline double sumAvx512 (const Values values)
+{
+  static constexpr std::size_t Width = 8U;
+
+  __m512d acc[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= values.size() ; i += 4 * Width)
+  {
+    for (std::size_t a = 0 ; a < 4 ; ++a)
+      acc[a] = _mm512_add_pd(acc[a], _mm512_loadu_pd(values.data() + i + a * Width));
+  }
+
+  for ( ; i + Width <= values.size() ; i += Width)
+    acc[0] = _mm512_add_pd(acc[0], _mm512_loadu_pd(values.data() + i));
+
+  double lanes[Width];
+  _mm512_storeu_pd(lanes, _mm512_add_pd(_mm512_add_pd(acc[0], acc[1]), _mm512_add_pd(acc[2], acc[3])));
+
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + sumScalar(values.subspan(i));
+}
+
+
+__attribute__((target("avx512f"))) inline double dotAvx512 (const Values a, const Values b)
+{
+  static constexpr std::size_t Width = 8U;
+
+  __m512d acc[4] = {_mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd(), _mm512_setzero_pd()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+      acc[n] = _mm512_fmadd_pd(_mm512_loadu_pd(a.data() + i + n * Width), _mm512_loadu_pd(b.data() + i + n * Width), acc[n]);
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+    acc[0] = _mm512_fmadd_pd(_mm512_loadu_pd(a.data() + i), _mm512_loadu_pd(b.data() + i), acc[0]);
+
+  double lanes[Width];
+  _mm512_storeu_pd(lanes, _mm512_add_pd(_mm512_add_pd(acc[0], acc[1]), _mm512_add_pd(acc[2], acc[3])));
+
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + dotScalar(a.subspan(i), b.subspan(i));
+}
+
+
+template<bool Max>
+__attribute__((target("avx512f"))) inline Position extremeAvx512 (const Values values)
+{
+  static constexpr std::size_t Width = 8U;
+
+  if (values.size() < Width)
+    return extremeScalar<Max>(values, Position{.value = values[0], .pos = 0}, 1);
+
+  const __m512i step = _mm512_set1_epi64(Width);
+  __m512d best = _mm512_loadu_pd(values.data());
+  __m512i positions = _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+  __m512i bestPositions = positions;
+
+  std::size_t i = Width;
+
+  for ( ; i + Width <= values.size() ; i += Width)
+  {
+    const __m512d v = _mm512_loadu_pd(values.data() + i);
+    const __mmask8 better = Max ? _mm512_cmp_pd_mask(v, best, _CMP_GT_OQ) : _mm512_cmp_pd_mask(v, best, _CMP_LT_OQ);
+
+    positions = _mm512_add_epi64(positions, step);
+    best = _mm512_mask_mov_pd(best, better, v);
+    bestPositions = _mm512_mask_mov_epi64(bestPositions, better, positions);
+  }
+
+  double b[Width];
+  std::uint64_t p[Width];
+  _mm512_storeu_pd(b, best);
+  _mm512_storeu_si512(p, bestPositions);
+
+  return extremeScalar<Max>(values, reduceExtreme<Max>(b, p), i);
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+
+struct Kernels
+{
+  double (*sum)(const Values);
+  double (*dot)(const Values, const Values);  // 'a' and 'b' must be the same size
+  Position (*min)(const Values);              // 'values' must not be empty
+  Position (*max)(const Values);              // 'values' must not be empty
+  std::string_view name;
+};
+
+
+inline Kernels selectKernels ()
+{
+  #if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+      return Kernels{.sum = sumAvx512, .dot = dotAvx512, .min = extremeAvx512<false>, .max = extremeAvx512<true>, .name = "avx512"};
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      return Kernels{.sum = sumAvx2, .dot = dotAvx2, .min = extremeAvx2<false>, .max = extremeAvx2<true>, .name = "avx2"};
+  #endif
+
+  return Kernels{.sum = sumScalar, .dot = dotScalar, .min = minScalar, .max = maxScalar, .name = "scalar"};
+}
+
+
+inline const Kernels FloatKernels = selectKernels();
+
+
+// values[i] = values[i] op scalar
+inline void apply (const Op op, const std::span<double> values, const double scalar)
+{
+  switch (op)
+  {
+    case Op::Add: for (auto& value : values) value += scalar; break;
+    case Op::Sub: for (auto& value : values) value -= scalar; break;
+    case Op::Mul: for (auto& value : values) value *= scalar; break;
+    case Op::Div: for (auto& value : values) value /= scalar; break;
+  }
+}
+
+
+// values[i] = values[i] op other[i], 'other' must be the same size
+inline void apply (const Op op, const std::span<double> values, const Values other)
+{
+  switch (op)
+  {
+    case Op::Add: for (std::size_t i = 0 ; i < values.size() ; ++i) values[i] += other[i]; break;
+    case Op::Sub: for (std::size_t i = 0 ; i < values.size() ; ++i) values[i] -= other[i]; break;
+    case Op::Mul: for (std::size_t i = 0 ; i < values.size() ; ++i) values[i] *= other[i]; break;
+    case Op::Div: for (std::size_t i = 0 ; i < values.size() ; ++i) values[i] /= other[i]; break;
+  }
+}
+
+}
+}
+}
+
+#endif
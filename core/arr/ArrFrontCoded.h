@@ -0,0 +1,444 @@
+#ifndef NDB_CORE_ARRFRONTCODED_H
+#define NDB_CORE_ARRFRONTCODED_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <core/arr/ArrBlocks.h>
+#include <core/arr/ArrSearch.h>
+
+
+namespace nemesis { namespace arr {
+
+
+/*
+The FrontCoded layout of sorted string arrays: as SortedBlocks, but each leaf is compressed.
+
+Neighbouring sorted strings often share a prefix ("user:1001", "user:1002"), so each string
+in a leaf is stored as the length of the prefix it shares with the string before it, then
+only the bytes which differ:
+
+  shared (varint) | suffix size (varint) | suffix
+
+The first string of a leaf shares nothing, so a leaf decodes independently. Reading a string
+decodes from the start of its leaf, at most LeafCapacity strings, into one reused buffer.
+An insert decodes its leaf, inserts, then encodes it again, unless the string is the largest,
+which is only appended.
+
+Each leaf's last string is kept in full, so the leaf bounding a string is found with a binary
+search, without decoding.
+*/
+class FrontCodedStrings
+{
+  struct Leaf
+  {
+    std::vector<char> bytes;
+    std::uint32_t count{0};
+  };
+
+public:
+  // larger leaves than SortedBlocks, the cost of leaf and last string is shared by more strings
+  static constexpr std::size_t LeafCapacity = 128U;
+  static constexpr std::size_t FillCapacity = LeafCapacity * 3 / 4;
+
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+
+  bool empty() const noexcept
+  {
+    return m_size == 0;
+  }
+
+
+  std::size_t leaves() const noexcept
+  {
+    return m_leaves.size();
+  }
+
+
+  // Bytes allocated for leaves and last strings, excluding the allocator's overhead
+  std::size_t memory() const noexcept
+  {
+    std::size_t bytes = m_leaves.capacity() * sizeof(Leaf) + m_lasts.capacity() * sizeof(std::string);
+
+    for (const auto& leaf : m_leaves)
+      bytes += leaf.bytes.capacity();
+
+    for (const auto& last : m_lasts)
+      bytes += last.capacity() > 15 ? last.capacity() + 1 : 0;
+
+    return bytes;
+  }
+
+
+  // the largest string, must not be empty()
+  const std::string& back() const
+  {
+    return m_lasts.back();
+  }
+
+
+  std::string at(const std::size_t pos) const
+  {
+    const auto [leaf, offset] = m_sizes.locate(pos);
+
+    std::string result;
+    decode(m_leaves[leaf], [&result, i = std::size_t{0}, offset](const std::string& s) mutable
+    {
+      if (i++ < offset)
+        return true;
+
+      result = s;
+      return false;
+    });
+
+    return result;
+  }
+
+
+  // position of the first string not less than 'value'
+  std::size_t lowerBound(const std::string& value) const
+  {
+    return bound<false>(value);
+  }
+
+
+  // position of the first string greater than 'value'
+  std::size_t upperBound(const std::string& value) const
+  {
+    return bound<true>(value);
+  }
+
+
+  void insert(const std::string& value)
+  {
+    if (m_leaves.empty())
+    {
+      m_leaves.emplace_back();
+      m_lasts.emplace_back();
+      encode(m_leaves.back(), m_lasts.back(), value);
+      m_lasts.back() = value;
+      m_size = 1;
+      rebuildTree();
+      return;
+    }
+
+    // first leaf which can contain value, or the last leaf if value is the largest
+    const auto leaf = std::min<std::size_t>(std::distance(m_lasts.cbegin(), std::lower_bound(m_lasts.cbegin(), m_lasts.cend(), value)),
+                                            m_leaves.size() - 1);
+
+    if (!(value < m_lasts[leaf]))
+    {
+      encode(m_leaves[leaf], m_lasts[leaf], value);
+      m_lasts[leaf] = value;
+    }
+    else
+    {
+      auto strings = decodeAll(m_leaves[leaf]);
+      strings.insert(std::lower_bound(strings.begin(), strings.end(), value), value);
+      m_leaves[leaf] = encodeAll(strings);
+    }
+
+    ++m_size;
+
+    if (m_leaves[leaf].count > LeafCapacity)
+      split(leaf);
+    else
+      m_sizes.increment(leaf);
+  }
+
+
+  // 'values' must be sorted. Few values are inserted individually, otherwise
+  // all strings are decoded and merged, O(n + values.size())
+  void insert(const std::span<const std::string> values)
+  {
+    if (values.size() * LeafCapacity < m_size)
+    {
+      for (const auto& value : values)
+        insert(value);
+    }
+    else
+    {
+      std::vector<std::string> current;
+      current.reserve(m_size);
+
+      for (const auto& leaf : m_leaves)
+        decode(leaf, [&current](const std::string& s){ current.push_back(s); return true; });
+
+      std::vector<std::string> merged;
+      merged.reserve(current.size() + values.size());
+      std::merge(std::make_move_iterator(current.begin()), std::make_move_iterator(current.end()),
+                 values.begin(), values.end(),
+                 std::back_inserter(merged));
+
+      clear();
+      append(std::move(merged));
+    }
+  }
+
+
+  // 'values' must be sorted and not less than back(), filling the last leaf then new leaves, to FillCapacity
+  void append(std::vector<std::string>&& values)
+  {
+    for (auto& value : values)
+    {
+      if (m_leaves.empty() || m_leaves.back().count >= FillCapacity)
+      {
+        m_leaves.emplace_back();
+        m_lasts.emplace_back();
+      }
+
+      encode(m_leaves.back(), m_lasts.back(), value);
+      m_lasts.back() = std::move(value);
+    }
+
+    m_size += values.size();
+    rebuildTree();
+  }
+
+
+  // removes positions [start, stop)
+  void erase(const std::size_t start, const std::size_t stop)
+  {
+    if (start >= std::min(stop, m_size))
+      return;
+
+    auto [leaf, offset] = m_sizes.locate(start);
+
+    for (std::size_t n = std::min(stop, m_size) - start ; n ; ++leaf, offset = 0)
+    {
+      const auto count = std::min<std::size_t>(n, m_leaves[leaf].count - offset);
+
+      if (count == m_leaves[leaf].count)
+        m_leaves[leaf] = Leaf{};
+      else
+      {
+        auto strings = decodeAll(m_leaves[leaf]);
+        const auto itStart = std::next(strings.begin(), offset);
+
+        strings.erase(itStart, std::next(itStart, count));
+        m_leaves[leaf] = encodeAll(strings);
+        m_lasts[leaf] = strings.back();
+      }
+
+      m_size -= count;
+      n -= count;
+    }
+
+    // remove emptied leaves with their last strings
+    std::size_t kept = 0;
+    for (std::size_t i = 0 ; i < m_leaves.size() ; ++i)
+    {
+      if (!m_leaves[i].count)
+        continue;
+      else if (kept != i)
+      {
+        m_leaves[kept] = std::move(m_leaves[i]);
+        m_lasts[kept] = std::move(m_lasts[i]);
+      }
+
+      ++kept;
+    }
+
+    m_leaves.resize(kept);
+    m_lasts.resize(kept);
+
+    rebuildTree();
+  }
+
+
+  void clear()
+  {
+    m_leaves.clear();
+    m_lasts.clear();
+    m_sizes.clear();
+    m_size = 0;
+  }
+
+
+  // calls f(value) for positions [start, stop)
+  template<typename F>
+  void forEach(const std::size_t start, const std::size_t stop, F&& f) const
+  {
+    if (start >= std::min(stop, m_size))
+      return;
+
+    auto [leaf, offset] = m_sizes.locate(start);
+
+    for (std::size_t n = std::min(stop, m_size) - start ; n ; ++leaf, offset = 0)
+    {
+      const auto count = std::min<std::size_t>(n, m_leaves[leaf].count - offset);
+
+      decode(m_leaves[leaf], [&f, i = std::size_t{0}, offset, count](const std::string& s) mutable
+      {
+        if (i >= offset)
+          f(s);
+
+        return ++i < offset + count;
+      });
+
+      n -= count;
+    }
+  }
+
+
+  // calls f(value) for the last n values, largest first
+  template<typename F>
+  void forEachReverse(std::size_t n, F&& f) const
+  {
+    for (auto leaf = m_leaves.crbegin() ; n && leaf != m_leaves.crend() ; ++leaf)
+    {
+      const auto strings = decodeAll(*leaf);
+
+      for (auto it = strings.crbegin() ; n && it != strings.crend() ; ++it, --n)
+        f(*it);
+    }
+  }
+
+
+private:
+
+  template<bool Upper>
+  std::size_t bound(const std::string& value) const
+  {
+    // the first leaf with a last string which bounds 'value', then within it
+    const auto leaf = search::bound<std::string, Upper>(m_lasts, value);
+
+    if (leaf == m_leaves.size())
+      return m_size;
+
+    std::size_t pos = 0;
+    decode(m_leaves[leaf], [&value, &pos](const std::string& s)
+    {
+      const bool before = Upper ? !(value < s) : s < value;
+      pos += before;
+      return before;
+    });
+
+    return m_sizes.prefix(leaf) + pos;
+  }
+
+
+  // Calls f(s) for each string in the leaf, in order, while f returns true. 's' is reused.
+  template<typename F>
+  static void decode(const Leaf& leaf, F&& f)
+  {
+    std::string s;
+    const char * p = leaf.bytes.data();
+
+    for (std::uint32_t i = 0 ; i < leaf.count ; ++i)
+    {
+      const auto shared = readSize(p);
+      const auto n = readSize(p);
+
+      s.resize(shared);
+      s.append(p, n);
+      p += n;
+
+      if (!f(std::as_const(s)))
+        return;
+    }
+  }
+
+
+  static std::vector<std::string> decodeAll(const Leaf& leaf)
+  {
+    std::vector<std::string> strings;
+    strings.reserve(leaf.count + 1);
+    decode(leaf, [&strings](const std::string& s){ strings.push_back(s); return true; });
+    return strings;
+  }
+
+
+  // Appends 's' to the leaf, 'previous' is the leaf's last string, ignored if the leaf is empty
+  static void encode(Leaf& leaf, const std::string_view previous, const std::string_view s)
+  {
+    std::size_t shared = 0;
+
+    if (leaf.count)
+    {
+      const auto n = std::min(previous.size(), s.size());
+      shared = std::distance(s.cbegin(), std::mismatch(s.cbegin(), std::next(s.cbegin(), n), previous.cbegin()).first);
+    }
+
+    writeSize(leaf.bytes, shared);
+    writeSize(leaf.bytes, s.size() - shared);
+    leaf.bytes.insert(leaf.bytes.end(), std::next(s.cbegin(), shared), s.cend());
+    ++leaf.count;
+  }
+
+
+  static Leaf encodeAll(const std::span<const std::string> strings)
+  {
+    Leaf leaf;
+    for (std::size_t i = 0 ; i < strings.size() ; ++i)
+      encode(leaf, i ? std::string_view{strings[i-1]} : std::string_view{}, strings[i]);
+
+    return leaf;
+  }
+
+
+  static void writeSize(std::vector<char>& bytes, std::size_t n)
+  {
+    for ( ; n >= 0x80 ; n >>= 7)
+      bytes.push_back(static_cast<char>(n | 0x80));
+
+    bytes.push_back(static_cast<char>(n));
+  }
+
+
+  static std::size_t readSize(const char *& p) noexcept
+  {
+    std::size_t n = 0;
+
+    for (unsigned shift = 0 ; ; shift += 7)
+    {
+      const auto byte = static_cast<std::uint8_t>(*p++);
+      n |= static_cast<std::size_t>(byte & 0x7F) << shift;
+
+      if (!(byte & 0x80))
+        return n;
+    }
+  }
+
+
+  void split(const std::size_t leaf)
+  {
+    const auto strings = decodeAll(m_leaves[leaf]);
+    const auto mid = strings.size() / 2;
+
+    m_leaves[leaf] = encodeAll(std::span{strings}.first(mid));
+    m_lasts[leaf] = strings[mid - 1];
+    m_lasts.insert(std::next(m_lasts.begin(), leaf + 1), strings.back());
+    m_leaves.insert(std::next(m_leaves.begin(), leaf + 1), encodeAll(std::span{strings}.subspan(mid)));
+
+    rebuildTree();
+  }
+
+
+  void rebuildTree()
+  {
+    m_sizes.rebuild(m_leaves, [](const Leaf& leaf){ return leaf.count; });
+  }
+
+
+private:
+  std::vector<Leaf> m_leaves;
+  std::vector<std::string> m_lasts;   // each leaf's last string, in full
+  LeafSizes m_sizes;
+  std::size_t m_size{0};
+};
+
+}
+}
+
+#endif
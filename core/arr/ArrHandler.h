@@ -7,6 +7,8 @@
 #include <ankerl/unordered_dense.h>
 #include <core/NemesisCommon.h>
 #include <core/NemesisConfig.h>
+#include <core/Snapshot.h>
+#include <core/SnapshotItems.h>
 #include <core/arr/ArrCommon.h>
 #include <core/arr/ArrCommandValidate.h>
 #include <core/arr/ArrExecutor.h>
@@ -32,6 +34,9 @@ namespace nemesis { namespace arr {
   public:
     ArrHandler() = default;
 
+    // stores sorted items as a sorted array, replacing an array with that name, see store()
+    using SortedStore = std::function<RequestStatus(const std::string&, std::vector<T>&&)>;
+
     using HandlerPmrMap = ankerl::unordered_dense::pmr::map<ArrQueryType, Handler>;
     using QueryTypePmrMap = ankerl::unordered_dense::pmr::map<std::string_view, ArrQueryType>;
 
@@ -56,8 +61,48 @@ namespace nemesis { namespace arr {
       else
       {
         h.emplace(ArrQueryType::Intersect,  Handler{std::bind_front(&ArrHandler<T, Cmds>::intersect,  std::ref(*this))});
+        h.emplace(ArrQueryType::Union,      Handler{std::bind_front(&ArrHandler<T, Cmds>::setUnion,   std::ref(*this))});
+        h.emplace(ArrQueryType::Diff,       Handler{std::bind_front(&ArrHandler<T, Cmds>::difference, std::ref(*this))});
         h.emplace(ArrQueryType::Min,        Handler{std::bind_front(&ArrHandler<T, Cmds>::min,        std::ref(*this))});
         h.emplace(ArrQueryType::Max,        Handler{std::bind_front(&ArrHandler<T, Cmds>::max,        std::ref(*this))});
+        h.emplace(ArrQueryType::LowerBound, Handler{std::bind_front(&ArrHandler<T, Cmds>::lowerBound, std::ref(*this))});
+        h.emplace(ArrQueryType::UpperBound, Handler{std::bind_front(&ArrHandler<T, Cmds>::upperBound, std::ref(*this))});
+        h.emplace(ArrQueryType::CountRng,   Handler{std::bind_front(&ArrHandler<T, Cmds>::countRange, std::ref(*this))});
+        h.emplace(ArrQueryType::FindRng,    Handler{std::bind_front(&ArrHandler<T, Cmds>::findRange,  std::ref(*this))});
+        h.emplace(ArrQueryType::Contains,   Handler{std::bind_front(&ArrHandler<T, Cmds>::contains,   std::ref(*this))});
+
+        if constexpr (std::is_same_v<T, std::string>)
+          h.emplace(ArrQueryType::Prefix,   Handler{std::bind_front(&ArrHandler<T, Cmds>::prefix,     std::ref(*this))});
+      }
+
+      if constexpr (Cmds::CanAggregate)
+      {
+        h.emplace(ArrQueryType::Sum,        Handler{std::bind_front(&ArrHandler<T, Cmds>::sum,         std::ref(*this))});
+        h.emplace(ArrQueryType::Avg,        Handler{std::bind_front(&ArrHandler<T, Cmds>::avg,         std::ref(*this))});
+        h.emplace(ArrQueryType::Min,        Handler{std::bind_front(&ArrHandler<T, Cmds>::minPosition, std::ref(*this))});
+        h.emplace(ArrQueryType::Max,        Handler{std::bind_front(&ArrHandler<T, Cmds>::maxPosition, std::ref(*this))});
+
+        if constexpr (std::is_integral_v<T>)
+        {
+          h.emplace(ArrQueryType::CountEq,    Handler{std::bind_front(&ArrHandler<T, Cmds>::countEqual,  std::ref(*this))});
+          h.emplace(ArrQueryType::Histogram,  Handler{std::bind_front(&ArrHandler<T, Cmds>::histogram,   std::ref(*this))});
+        }
+      }
+
+      if constexpr (Cmds::CanMath)
+      {
+        h.emplace(ArrQueryType::Dot,        Handler{std::bind_front(&ArrHandler<T, Cmds>::dot,      std::ref(*this))});
+        h.emplace(ArrQueryType::Add,        Handler{std::bind_front(&ArrHandler<T, Cmds>::add,      std::ref(*this))});
+        h.emplace(ArrQueryType::Sub,        Handler{std::bind_front(&ArrHandler<T, Cmds>::subtract, std::ref(*this))});
+        h.emplace(ArrQueryType::Mul,        Handler{std::bind_front(&ArrHandler<T, Cmds>::multiply, std::ref(*this))});
+        h.emplace(ArrQueryType::Div,        Handler{std::bind_front(&ArrHandler<T, Cmds>::divide,   std::ref(*this))});
+      }
+
+      if constexpr (Cmds::CanSort)
+      {
+        h.emplace(ArrQueryType::Sort,       Handler{std::bind_front(&ArrHandler<T, Cmds>::sort,     std::ref(*this))});
+        h.emplace(ArrQueryType::Unique,     Handler{std::bind_front(&ArrHandler<T, Cmds>::unique,   std::ref(*this))});
+        h.emplace(ArrQueryType::ToSorted,   Handler{std::bind_front(&ArrHandler<T, Cmds>::toSorted, std::ref(*this))});
       }
       
       return h;
@@ -82,8 +127,30 @@ namespace nemesis { namespace arr {
         {Cmds::ClearReq,        ArrQueryType::Clear},
         {Cmds::SwapReq,         ArrQueryType::Swap},
         {Cmds::IntersectReq,    ArrQueryType::Intersect},
+        {Cmds::UnionReq,        ArrQueryType::Union},
+        {Cmds::DiffReq,         ArrQueryType::Diff},
         {Cmds::MinReq,          ArrQueryType::Min},
         {Cmds::MaxReq,          ArrQueryType::Max},
+        {Cmds::LowerBoundReq,   ArrQueryType::LowerBound},
+        {Cmds::UpperBoundReq,   ArrQueryType::UpperBound},
+        {Cmds::CountRngReq,     ArrQueryType::CountRng},
+        {Cmds::FindRngReq,      ArrQueryType::FindRng},
+        {Cmds::ContainsReq,     ArrQueryType::Contains},
+        {Cmds::PrefixReq,       ArrQueryType::Prefix},
+        {Cmds::SumReq,          ArrQueryType::Sum},
+        {Cmds::AvgReq,          ArrQueryType::Avg},
+        {Cmds::CountEqReq,      ArrQueryType::CountEq},
+        {Cmds::HistogramReq,    ArrQueryType::Histogram},
+        {Cmds::DotReq,          ArrQueryType::Dot},
+        {Cmds::AddReq,          ArrQueryType::Add},
+        {Cmds::SubReq,          ArrQueryType::Sub},
+        {Cmds::MulReq,          ArrQueryType::Mul},
+        {Cmds::DivReq,          ArrQueryType::Div},
+        {Cmds::ReserveReq,      ArrQueryType::Reserve},
+        {Cmds::ShrinkReq,       ArrQueryType::Shrink},
+        {Cmds::SortReq,         ArrQueryType::Sort},
+        {Cmds::UniqueReq,       ArrQueryType::Unique},
+        {Cmds::ToSortedReq,     ArrQueryType::ToSorted},
       }, 1, alloc); 
 
       return map;
@@ -148,7 +215,21 @@ namespace nemesis { namespace arr {
                                   .execute = ArrayExecutor<ArrayT, Cmds>::clear,
                                   .rspName = Cmds::ClearRsp.data()
                                 }
-      }      
+      },
+      { ArrQueryType::Reserve,  ValidateExecute
+                                {
+                                  .validate = validateReserve<Cmds>,
+                                  .execute = ArrayExecutor<ArrayT, Cmds>::reserve,
+                                  .rspName = Cmds::ReserveRsp.data()
+                                }
+      },
+      { ArrQueryType::Shrink,   ValidateExecute
+                                {
+                                  .validate = validateShrink<Cmds>,
+                                  .execute = ArrayExecutor<ArrayT, Cmds>::shrink,
+                                  .rspName = Cmds::ShrinkRsp.data()
+                                }
+      }
     };
 
   public:
@@ -185,6 +266,217 @@ namespace nemesis { namespace arr {
     }
 
 
+    /*
+    Stores sorted 'items' as the array 'name', replacing its items. An existing array keeps its layout,
+    growable flag and capacity, which increases if the items need more. Otherwise the array is created
+    growable, with the Vector layout and a capacity of the items, at least 1. Bounds if there are too many.
+    */
+    RequestStatus store(const std::string& name, std::vector<T>&& items) requires (Cmds::IsSorted)
+    {
+      const auto used = items.size();
+      const auto existing = m_arrays.find(name);
+
+      const auto layout = existing == m_arrays.end() ? Layout::Vector : existing->second.layout();
+      const auto growable = existing == m_arrays.end() || existing->second.isGrowable();
+      const auto size = std::max<std::size_t>({used, 1U, existing == m_arrays.end() ? 0U : existing->second.size()});
+
+      if (!ArrayT::isRequestedSizeValid(size, growable))
+        return RequestStatus::Bounds;
+
+      ArrayT array {size, layout, growable};
+      array.restore(0, std::move(items), used);
+      m_arrays.insert_or_assign(name, std::move(array));
+      return RequestStatus::Ok;
+    }
+
+
+    // TO_SORTED's destination, the sorted array handler of the same item type
+    void setSortedStore(SortedStore store) requires (Cmds::CanSort)
+    {
+      m_sortedStore = std::move(store);
+    }
+
+
+    // Emits requests which recreate the arrays, used by WAL compaction
+    void dump (const std::function<void(const njson&)>& emit) const
+    {
+      static const std::size_t BatchSize = 1024U;
+
+      std::vector<T> copy;
+
+      for (const auto& [name, array] : m_arrays)
+      {
+        njson create;
+        create[Cmds::CreateReq.data()]["name"] = name;
+        create[Cmds::CreateReq.data()]["len"] = array.size();
+
+        if (array.isBlocked())
+          create[Cmds::CreateReq.data()]["layout"] = "blocked";
+        else if (array.isPaged())
+          create[Cmds::CreateReq.data()]["layout"] = "paged";
+        else if (array.isArena())
+          create[Cmds::CreateReq.data()]["layout"] = "arena";
+        else if (array.isFrontCoded())
+          create[Cmds::CreateReq.data()]["layout"] = "frontcoded";
+
+        if (array.isGrowable())
+          create[Cmds::CreateReq.data()]["growable"] = true;
+
+        emit(create);
+
+        for (std::size_t start = 0 ; start < array.used() ; start += BatchSize)
+        {
+          const auto stop = std::min<std::size_t>(start + BatchSize, array.used());
+          const auto items = array.range(start, stop - start, copy);
+
+          njson request;
+          auto& body = request[Cmds::SetRngReq.data()];
+          body["name"] = name;
+          body["items"] = njson::make_array();
+          body["items"].reserve(stop - start);
+
+          for (const auto& item : items)
+            body["items"].push_back(item);
+
+          if constexpr (Cmds::IsSorted)
+            body["sorted"] = true;
+          else
+            body["pos"] = start;
+
+          emit(request);
+        }
+
+        if constexpr (!Cmds::IsSorted)
+        {
+          // SET with a position does not change used(), so items beyond used() are set individually
+          array.forEachSet(array.used(), [&emit, &name](const std::size_t pos, const T& item)
+          {
+            njson request;
+            auto& body = request[Cmds::SetReq.data()];
+            body["name"] = name;
+            body["pos"] = pos;
+            body["item"] = item;
+            emit(request);
+          });
+        }
+      }
+    }
+
+
+    /*
+    Writes all arrays to snapshot files in 'dir'. Can run in a forked child (background save).
+    
+    An array is written in chunks, each a record:
+      name | size (u64) | used (u64) | start (u64) | n (u64) | items[start, start+n)
+
+    Unsorted arrays write all items, including beyond used(), sorted arrays only to used().
+    A Paged array skips chunks with no pages allocated, other than the first which creates
+    the array on load. The size's top bits are set for the Blocked layout, a growable array,
+    the Paged, Arena and FrontCoded layouts, sizes are limited well below them.
+    */
+    static constexpr std::uint64_t BlockedFlag = 1ULL << 63;
+    static constexpr std::uint64_t GrowableFlag = 1ULL << 62;
+    static constexpr std::uint64_t PagedFlag = 1ULL << 61;
+    static constexpr std::uint64_t ArenaFlag = 1ULL << 60;
+    static constexpr std::uint64_t FrontCodedFlag = 1ULL << 59;
+
+    bool save (const fs::path& dir, const snapshot::Codec codec) const
+    {
+      static const std::size_t ChunkSize = 4096U;
+
+      fs::create_directories(dir);
+
+      snapshot::SnapshotWriter writer{dir, codec};
+      std::vector<std::uint8_t> buffer;
+      std::vector<T> copy;
+
+      for (const auto& [name, array] : m_arrays)
+      {
+        const std::size_t nSave = Cmds::IsSorted ? array.used() : array.size();
+        std::size_t start = 0;
+        
+        do
+        {
+          const auto n = std::min<std::size_t>(ChunkSize, nSave - start);
+
+          if constexpr (!Cmds::IsSorted)
+          {
+            if (start != 0 && array.isUntouched(start, start + n))
+            {
+              start += n;
+              continue;
+            }
+          }
+
+          writer.putString(name);
+          writer.putU64(array.size() | (array.isBlocked() ? BlockedFlag : 0) | (array.isGrowable() ? GrowableFlag : 0) | (array.isPaged() ? PagedFlag : 0) | (array.isArena() ? ArenaFlag : 0) | (array.isFrontCoded() ? FrontCodedFlag : 0));
+          writer.putU64(array.used());
+          writer.putU64(start);
+          writer.putU64(n);
+          snapshot::putItems<T>(writer, array.range(start, n, copy), buffer);
+          writer.endRecord();
+
+          start += n;
+
+        } while (start < nSave);
+      }
+
+      writer.close();
+      return true;
+    }
+
+
+    // Loads arrays written by save(), replacing arrays with the same name. Throws on error.
+    std::size_t load (const fs::path& dir)
+    {
+      std::size_t nArrays{0};
+
+      if (!fs::exists(dir))
+        return nArrays;
+
+      std::vector<T> items;
+
+      // in the order written, a container's records can span files
+      for (const auto& file : snapshot::dataFiles(dir))
+      {
+        snapshot::SnapshotReader reader{file};
+
+        while (reader.nextBlock())
+        {
+          for (std::uint32_t i = 0 ; i < reader.blockRecords() ; ++i)
+          {
+            std::string name {reader.getString()};
+            const auto sizeField = reader.getU64();
+            const auto size = sizeField & ~(BlockedFlag | GrowableFlag | PagedFlag | ArenaFlag | FrontCodedFlag);
+            const auto layout = layoutOf(sizeField);
+            const bool growable = sizeField & GrowableFlag;
+            const auto used = reader.getU64();
+            const auto start = reader.getU64();
+            const auto n = reader.getU64();
+            
+            if (used > size || start + n > size)
+              throw std::runtime_error{"Array record invalid"};
+
+            snapshot::getItems<T>(reader, n, items);
+
+            if (start == 0)
+            {
+              m_arrays.insert_or_assign(name, ArrayT{size, layout, growable});
+              ++nArrays;
+            }
+            
+            if (auto it = m_arrays.find(name); it == m_arrays.end() || it->second.size() != size)
+              throw std::runtime_error{"Array record invalid"};
+            else
+              it->second.restore(start, std::move(items), used);
+          }
+        }
+      }
+
+      return nArrays;
+    }
+
+
   private:
 
     Response validateAndExecute(const ValidateExecute& validateExecute, njson& request, const std::string_view reqName)
@@ -214,7 +506,7 @@ namespace nemesis { namespace arr {
         return Response{.rsp = createErrorResponse(RspName, status)};
       else if (const auto& name = reqBody.at("name").as_string(); arrayExist(name))
         return Response{.rsp = createErrorResponse(RspName, RequestStatus::Duplicate)};
-      else if (const std::size_t size = reqBody.at("len").template as<std::size_t>(); !ArrayT::isRequestedSizeValid(size))
+      else if (!ArrayT::isRequestedSizeValid(reqBody.at("len").template as<std::size_t>(), isGrowable(reqBody)))
         return Response{.rsp = createErrorResponse(RspName, RequestStatus::Bounds)};
       else
       {
@@ -225,7 +517,8 @@ namespace nemesis { namespace arr {
         try
         {
           const std::size_t size = reqBody.at("len").template as<std::size_t>();
-          [[maybe_unused]] const auto [it, emplaced] = m_arrays.try_emplace(name, ArrayT{size});
+          const auto layout = reqBody.contains("layout") ? *toLayout(reqBody.at("layout").as_string_view()) : Layout::Vector;
+          [[maybe_unused]] const auto [it, emplaced] = m_arrays.try_emplace(name, ArrayT{size, layout, isGrowable(reqBody)});
           // already checked the array name does not exist, so can ignore try_emplace() return val
         }
         catch(const std::exception& e)
@@ -311,28 +604,68 @@ namespace nemesis { namespace arr {
 
     ndb_always_inline Response intersect(njson& request) requires (Cmds::IsSorted)
     {
-      static constexpr auto RspName = Cmds::IntersectRsp.data();
+      return setOperation(request, setops::Operation::Intersect, Cmds::IntersectReq.data(), Cmds::IntersectRsp.data());
+    }
 
-      if (const auto status = validateIntersect<Cmds>(request) ; status != RequestStatus::Ok)
-        return Response{.rsp = createErrorResponse(RspName, status)};
-      else
+
+    ndb_always_inline Response setUnion(njson& request) requires (Cmds::IsSorted)
+    {
+      return setOperation(request, setops::Operation::Union, Cmds::UnionReq.data(), Cmds::UnionRsp.data());
+    }
+
+
+    ndb_always_inline Response difference(njson& request) requires (Cmds::IsSorted)
+    {
+      return setOperation(request, setops::Operation::Difference, Cmds::DiffReq.data(), Cmds::DiffRsp.data());
+    }
+
+
+    // Returns the result, or with "dest", stores it as a sorted array, replacing an array with that name
+    Response setOperation(njson& request, const setops::Operation op, const char * reqName, const char * rspName) requires (Cmds::IsSorted)
+    {
+      if (const auto status = validateSetOperation<Cmds>(request, reqName, rspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(rspName, status)};
+
+      const auto& body = request.at(reqName);
+
+      std::vector<std::string> names;
+
+      if (body.contains("srcs"))
       {
-        const auto& body = request.at(Cmds::IntersectReq);
-        const auto& srcA = body.at("srcA").as_string();
-        const auto& srcB = body.at("srcB").as_string();
+        for (const auto& src : body.at("srcs").array_range())
+          names.emplace_back(src.as_string());
+      }
+      else if (const auto& srcA = body.at("srcA").as_string(), srcB = body.at("srcB").as_string(); srcA == srcB)
+        return Response{.rsp = createErrorResponse(rspName, RequestStatus::Duplicate)};
+      else
+        names = {srcA, srcB};
 
-        if (srcA == srcB)
-          return Response{.rsp = createErrorResponse(RspName, RequestStatus::Duplicate)};
+      std::vector<const ArrayT *> arrays;
+      arrays.reserve(names.size());
+
+      for (const auto& name : names)
+      {
+        if (const auto [exist, it] = getArray(name, body); !exist)
+          return Response{.rsp = createErrorResponse(rspName, RequestStatus::NotExist)};
         else
-        {
-          const auto [arrAExist, arrA] = getArray(srcA, body);
-          const auto [arrBExist, arrB] = getArray(srcB, body);
+          arrays.push_back(&it->second);
+      }
 
-          if (!(arrAExist && arrBExist))
-            return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
-          else
-            return ArrayExecutor<ArrayT, Cmds>::intersect(arrA->second, arrB->second);
-        }
+      if (!body.contains("dest"))
+        return ArrayExecutor<ArrayT, Cmds>::setOperation(rspName, op, arrays);
+      else
+      {
+        auto result = ArrayExecutor<ArrayT, Cmds>::applySetOperation(op, arrays);
+        const auto used = result.size();
+
+        if (const auto status = store(body.at("dest").as_string(), std::move(result)) ; status != RequestStatus::Ok)
+          return Response{.rsp = createErrorResponse(rspName, status)};
+
+        Response response;
+        response.rsp = njson{jsoncons::json_object_arg, {{rspName, njson::object()}}};
+        response.rsp[rspName]["st"] = toUnderlying(RequestStatus::Ok);
+        response.rsp[rspName]["used"] = used;
+        return response;
       }
     }
 
@@ -354,6 +687,238 @@ namespace nemesis { namespace arr {
     }
 
 
+    ndb_always_inline Response sort(njson& request) requires(Cmds::CanSort)
+    {
+      return queryArray(request, validateSort<Cmds>(request), Cmds::SortReq.data(), Cmds::SortRsp.data(), ArrayExecutor<ArrayT, Cmds>::sort);
+    }
+
+
+    ndb_always_inline Response unique(njson& request) requires(Cmds::CanSort)
+    {
+      return queryArray(request, validateUnique<Cmds>(request), Cmds::UniqueReq.data(), Cmds::UniqueRsp.data(), ArrayExecutor<ArrayT, Cmds>::unique);
+    }
+
+
+    // Copies "name" to the sorted array "dest", sorted, and with "unique", without repeats. The source is unchanged.
+    Response toSorted(njson& request) requires(Cmds::CanSort)
+    {
+      static constexpr auto RspName = Cmds::ToSortedRsp.data();
+
+      if (const auto status = validateToSorted<Cmds>(request) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(Cmds::ToSortedReq);
+
+      if (auto [exist, it] = getArray(body) ; !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else if (!m_sortedStore)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Unknown)};
+      else
+      {
+        auto items = ArrayExecutor<ArrayT, Cmds>::sorted(it->second, body.contains("unique") && body.at("unique").as_bool());
+        const auto used = items.size();
+
+        if (const auto status = m_sortedStore(body.at("dest").as_string(), std::move(items)) ; status != RequestStatus::Ok)
+          return Response{.rsp = createErrorResponse(RspName, status)};
+
+        Response response;
+        response.rsp = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+        response.rsp[RspName]["st"] = toUnderlying(RequestStatus::Ok);
+        response.rsp[RspName]["used"] = used;
+        return response;
+      }
+    }
+
+
+    ndb_always_inline Response lowerBound(njson& request) requires(Cmds::IsSorted)
+    {
+      static constexpr auto ReqName = Cmds::LowerBoundReq.data();
+      static constexpr auto RspName = Cmds::LowerBoundRsp.data();
+
+      return queryArray(request, validateBound<Cmds>(request, ReqName, RspName), ReqName, RspName, [](const ArrayT& array, const njson& body)
+      {
+        return ArrayExecutor<ArrayT, Cmds>::bound(RspName, array, body, false);
+      });
+    }
+
+
+    ndb_always_inline Response upperBound(njson& request) requires(Cmds::IsSorted)
+    {
+      static constexpr auto ReqName = Cmds::UpperBoundReq.data();
+      static constexpr auto RspName = Cmds::UpperBoundRsp.data();
+
+      return queryArray(request, validateBound<Cmds>(request, ReqName, RspName), ReqName, RspName, [](const ArrayT& array, const njson& body)
+      {
+        return ArrayExecutor<ArrayT, Cmds>::bound(RspName, array, body, true);
+      });
+    }
+
+
+    ndb_always_inline Response countRange(njson& request) requires(Cmds::IsSorted)
+    {
+      static constexpr auto ReqName = Cmds::CountRngReq.data();
+      static constexpr auto RspName = Cmds::CountRngRsp.data();
+
+      return queryArray(request, validateValueRange<Cmds>(request, ReqName, RspName), ReqName, RspName, ArrayExecutor<ArrayT, Cmds>::countRange);
+    }
+
+
+    ndb_always_inline Response findRange(njson& request) requires(Cmds::IsSorted)
+    {
+      static constexpr auto ReqName = Cmds::FindRngReq.data();
+      static constexpr auto RspName = Cmds::FindRngRsp.data();
+
+      return queryArray(request, validateValueRange<Cmds>(request, ReqName, RspName), ReqName, RspName, ArrayExecutor<ArrayT, Cmds>::findRange);
+    }
+
+
+    ndb_always_inline Response contains(njson& request) requires(Cmds::IsSorted)
+    {
+      return queryArray(request, validateContains<Cmds>(request), Cmds::ContainsReq.data(), Cmds::ContainsRsp.data(), ArrayExecutor<ArrayT, Cmds>::contains);
+    }
+
+
+    ndb_always_inline Response prefix(njson& request) requires(Cmds::IsSorted && std::is_same_v<T, std::string>)
+    {
+      return queryArray(request, validatePrefix<Cmds>(request), Cmds::PrefixReq.data(), Cmds::PrefixRsp.data(), ArrayExecutor<ArrayT, Cmds>::prefix);
+    }
+
+
+    ndb_always_inline Response sum(njson& request) requires(Cmds::CanAggregate)
+    {
+      static constexpr auto ReqName = Cmds::SumReq.data();
+      static constexpr auto RspName = Cmds::SumRsp.data();
+
+      return queryArray(request, validateAggregate<Cmds>(request, ReqName, RspName), ReqName, RspName, ArrayExecutor<ArrayT, Cmds>::sum);
+    }
+
+
+    ndb_always_inline Response avg(njson& request) requires(Cmds::CanAggregate)
+    {
+      static constexpr auto ReqName = Cmds::AvgReq.data();
+      static constexpr auto RspName = Cmds::AvgRsp.data();
+
+      return queryArray(request, validateAggregate<Cmds>(request, ReqName, RspName), ReqName, RspName, ArrayExecutor<ArrayT, Cmds>::avg);
+    }
+
+
+    ndb_always_inline Response minPosition(njson& request) requires(Cmds::CanAggregate)
+    {
+      static constexpr auto ReqName = Cmds::MinReq.data();
+      static constexpr auto RspName = Cmds::MinRsp.data();
+
+      return queryArray(request, validateAggregate<Cmds>(request, ReqName, RspName), ReqName, RspName, [](const ArrayT& array, const njson& body)
+      {
+        return ArrayExecutor<ArrayT, Cmds>::extreme(RspName, array, body, false);
+      });
+    }
+
+
+    ndb_always_inline Response maxPosition(njson& request) requires(Cmds::CanAggregate)
+    {
+      static constexpr auto ReqName = Cmds::MaxReq.data();
+      static constexpr auto RspName = Cmds::MaxRsp.data();
+
+      return queryArray(request, validateAggregate<Cmds>(request, ReqName, RspName), ReqName, RspName, [](const ArrayT& array, const njson& body)
+      {
+        return ArrayExecutor<ArrayT, Cmds>::extreme(RspName, array, body, true);
+      });
+    }
+
+
+    ndb_always_inline Response countEqual(njson& request) requires(Cmds::CanAggregate && std::is_integral_v<T>)
+    {
+      return queryArray(request, validateCountEqual<Cmds>(request), Cmds::CountEqReq.data(), Cmds::CountEqRsp.data(), ArrayExecutor<ArrayT, Cmds>::countEqual);
+    }
+
+
+    ndb_always_inline Response histogram(njson& request) requires(Cmds::CanAggregate && std::is_integral_v<T>)
+    {
+      return queryArray(request, validateHistogram<Cmds>(request), Cmds::HistogramReq.data(), Cmds::HistogramRsp.data(), ArrayExecutor<ArrayT, Cmds>::histogram);
+    }
+
+
+    ndb_always_inline Response dot(njson& request) requires(Cmds::CanMath)
+    {
+      static constexpr auto RspName = Cmds::DotRsp.data();
+
+      if (const auto status = validateDot<Cmds>(request) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else
+      {
+        const auto& body = request.at(Cmds::DotReq);
+        const auto [existA, itA] = getArray(body.at("srcA").as_string(), body);
+        const auto [existB, itB] = getArray(body.at("srcB").as_string(), body);
+
+        if (!(existA && existB))
+          return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+        else
+          return ArrayExecutor<ArrayT, Cmds>::dot(itA->second, itB->second, body);
+      }
+    }
+
+
+    ndb_always_inline Response add(njson& request) requires(Cmds::CanMath)
+    {
+      return elementwise(request, fmath::Op::Add, Cmds::AddReq.data(), Cmds::AddRsp.data());
+    }
+
+
+    ndb_always_inline Response subtract(njson& request) requires(Cmds::CanMath)
+    {
+      return elementwise(request, fmath::Op::Sub, Cmds::SubReq.data(), Cmds::SubRsp.data());
+    }
+
+
+    ndb_always_inline Response multiply(njson& request) requires(Cmds::CanMath)
+    {
+      return elementwise(request, fmath::Op::Mul, Cmds::MulReq.data(), Cmds::MulRsp.data());
+    }
+
+
+    ndb_always_inline Response divide(njson& request) requires(Cmds::CanMath)
+    {
+      return elementwise(request, fmath::Op::Div, Cmds::DivReq.data(), Cmds::DivRsp.data());
+    }
+
+
+    // Modifies "name" in place, by "value" or by the array "src", which can be "name"
+    Response elementwise(njson& request, const fmath::Op op, const char * reqName, const char * rspName) requires(Cmds::CanMath)
+    {
+      if (const auto status = validateElementwise<Cmds>(request, reqName, rspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(rspName, status)};
+
+      const auto& body = request.at(reqName);
+
+      auto [exist, it] = getArray(body.at("name").as_string(), body);
+      if (!exist)
+        return Response{.rsp = createErrorResponse(rspName, RequestStatus::NotExist)};
+      else if (!body.contains("src"))
+        return ArrayExecutor<ArrayT, Cmds>::elementwise(rspName, op, it->second, nullptr, body);
+      else if (const auto [srcExist, itSrc] = getArray(body.at("src").as_string(), body); !srcExist)
+        return Response{.rsp = createErrorResponse(rspName, RequestStatus::NotExist)};
+      else
+        return ArrayExecutor<ArrayT, Cmds>::elementwise(rspName, op, it->second, &itSrc->second, body);
+    }
+
+
+    // Executes a command on one array, after the request is validated as 'status'
+    template<typename Execute>
+    Response queryArray(njson& request, const RequestStatus status, const char * reqName, const char * rspName, Execute&& execute)
+    {
+      if (status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(rspName, status)};
+      else
+      {
+        const auto& body = request.at(reqName);
+        if (auto [exist, it] = getArray(body.at("name").as_string(), body) ; !exist)
+          return Response{.rsp = createErrorResponse(rspName, RequestStatus::NotExist)};
+        else
+          return execute(it->second, body);
+      }
+    }
+
+
     ndb_always_inline Response min(njson& request) requires(Cmds::IsSorted)
     {
       static constexpr auto RspName = Cmds::MinRsp.data();
@@ -408,9 +973,31 @@ namespace nemesis { namespace arr {
     }
 
 
+    static Layout layoutOf (const std::uint64_t sizeField)
+    {
+      if (sizeField & BlockedFlag)
+        return Layout::Blocked;
+      else if (sizeField & PagedFlag)
+        return Layout::Paged;
+      else if (sizeField & ArenaFlag)
+        return Layout::Arena;
+      else if (sizeField & FrontCodedFlag)
+        return Layout::FrontCoded;
+      else
+        return Layout::Vector;
+    }
+
+
+    static bool isGrowable (const njson& createBody)
+    {
+      return createBody.contains("growable") && createBody.at("growable").as_bool();
+    }
+
+
   private:
     Arrays m_arrays;
     Cmds m_cmds;
+    SortedStore m_sortedStore;
   };
 
   
@@ -420,6 +1007,9 @@ namespace nemesis { namespace arr {
   
   using SortedIntArrHandler = ArrHandler<std::int64_t, SortedIntArrCmds>;
   using SortedStrArrHandler = ArrHandler<std::string, SortedStrArrCmds>;
+
+  using FloatArrHandler = ArrHandler<double, FloatArrCmds>;
+  using SortedFloatArrHandler = ArrHandler<double, SortedFloatArrCmds>;
 }
 }
 
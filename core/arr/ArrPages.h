@@ -0,0 +1,218 @@
+#ifndef NDB_CORE_ARRPAGES_H
+#define NDB_CORE_ARRPAGES_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+
+namespace nemesis { namespace arr {
+
+
+/*
+Values in fixed size pages, the paged layout of an unsorted array.
+
+A page is allocated by the first write of a value which isn't the default (T{}), so an array
+which is mostly unset uses memory in proportion to what has been written rather than its size.
+Positions in unallocated pages read as T{}. A bitmap of allocated pages lets saves and scans
+skip untouched pages without visiting each page pointer.
+*/
+template<typename T>
+class SparsePages
+{
+public:
+  // about 4KB of values per page
+  static constexpr std::size_t PageCapacity = std::max<std::size_t>(64U, 4096U / sizeof(T));
+
+
+  explicit SparsePages (const std::size_t size = 0)
+  {
+    resize(size);
+  }
+
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+
+  // Values beyond a reduced size are discarded, so they read as T{} if the size increases again
+  void resize (const std::size_t size)
+  {
+    if (size < m_size && size % PageCapacity != 0)
+    {
+      if (auto& page = m_pages[size / PageCapacity]; page)
+        std::fill(page.get() + size % PageCapacity, page.get() + PageCapacity, T{});
+    }
+
+    m_size = size;
+    m_pages.resize((size + PageCapacity - 1) / PageCapacity);
+    m_occupied.resize((m_pages.size() + 63) / 64);
+
+    // bits of removed pages
+    if (m_pages.size() % 64 != 0)
+      m_occupied.back() &= (1ULL << (m_pages.size() % 64)) - 1;
+  }
+
+
+  std::size_t occupiedPages () const noexcept
+  {
+    std::size_t n = 0;
+
+    for (const auto word : m_occupied)
+      n += std::popcount(word);
+
+    return n;
+  }
+
+
+  const T& get (const std::size_t pos) const
+  {
+    const auto& page = m_pages[pos / PageCapacity];
+    return page ? page[pos % PageCapacity] : defaultPage()[0];
+  }
+
+
+  // Writing the default to an unallocated page doesn't allocate it
+  void set (const std::size_t pos, const T& value)
+  {
+    if (auto& page = m_pages[pos / PageCapacity]; page)
+      page[pos % PageCapacity] = value;
+    else if (value != T{})
+      allocate(pos / PageCapacity)[pos % PageCapacity] = value;
+  }
+
+
+  // Up to 'n' values from 'pos', stopping at the end of pos's page
+  std::span<const T> contiguous (const std::size_t pos, const std::size_t n) const
+  {
+    const auto offset = pos % PageCapacity;
+    const auto& page = m_pages[pos / PageCapacity];
+    return std::span<const T>{page ? page.get() : defaultPage(), PageCapacity}.subspan(offset, std::min(n, PageCapacity - offset));
+  }
+
+
+  // As above, to modify, so the page is allocated
+  std::span<T> contiguous (const std::size_t pos, const std::size_t n)
+  {
+    const auto offset = pos % PageCapacity;
+    auto& page = m_pages[pos / PageCapacity];
+    return std::span<T>{page ? page.get() : allocate(pos / PageCapacity), PageCapacity}.subspan(offset, std::min(n, PageCapacity - offset));
+  }
+
+
+  // Sets [start, stop) to T{}, releasing pages entirely within it
+  void reset (const std::size_t start, const std::size_t stop)
+  {
+    for (auto pos = start ; pos < stop ; )
+    {
+      const auto offset = pos % PageCapacity;
+      const auto n = std::min(stop - pos, PageCapacity - offset);
+
+      if (auto& page = m_pages[pos / PageCapacity]; page && n == PageCapacity)
+      {
+        page.reset();
+        m_occupied[pos / PageCapacity / 64] &= ~(1ULL << (pos / PageCapacity % 64));
+      }
+      else if (page)
+        std::fill(page.get() + offset, page.get() + offset + n, T{});
+
+      pos += n;
+    }
+  }
+
+
+  // true if [start, stop) has no allocated pages, so is all T{}
+  bool isUntouched (const std::size_t start, const std::size_t stop) const noexcept
+  {
+    for (auto page = start / PageCapacity ; page * PageCapacity < stop ; ++page)
+    {
+      if (isOccupied(page))
+        return false;
+    }
+
+    return true;
+  }
+
+
+  // Calls f(pos, value) for each value from 'start' which isn't T{}, in allocated pages only
+  template<typename F>
+  void forEachSet (const std::size_t start, F&& f) const
+  {
+    for (std::size_t w = 0 ; w < m_occupied.size() ; ++w)
+    {
+      for (auto word = m_occupied[w] ; word ; word &= word - 1)
+      {
+        const auto pageStart = (w * 64 + std::countr_zero(word)) * PageCapacity;
+        const auto& page = m_pages[pageStart / PageCapacity];
+
+        for (auto pos = std::max(start, pageStart) ; pos < std::min(pageStart + PageCapacity, m_size) ; ++pos)
+        {
+          if (page[pos - pageStart] != T{})
+            f(pos, page[pos - pageStart]);
+        }
+      }
+    }
+  }
+
+
+  // The position after the last value which isn't T{}, 0 if there are none
+  std::size_t lastSet () const
+  {
+    for (auto w = m_occupied.size() ; w-- > 0 ; )
+    {
+      for (auto word = m_occupied[w] ; word ; word &= ~(1ULL << (63 - std::countl_zero(word))))
+      {
+        const auto pageStart = (w * 64 + 63 - std::countl_zero(word)) * PageCapacity;
+        const auto& page = m_pages[pageStart / PageCapacity];
+
+        for (auto pos = std::min(pageStart + PageCapacity, m_size) ; pos > pageStart ; --pos)
+        {
+          if (page[pos - 1 - pageStart] != T{})
+            return pos;
+        }
+      }
+    }
+
+    return 0;
+  }
+
+
+private:
+
+  bool isOccupied (const std::size_t page) const noexcept
+  {
+    return m_occupied[page / 64] & (1ULL << (page % 64));
+  }
+
+
+  T * allocate (const std::size_t page)
+  {
+    m_pages[page] = std::make_unique<T[]>(PageCapacity);
+    m_occupied[page / 64] |= 1ULL << (page % 64);
+    return m_pages[page].get();
+  }
+
+
+  // read by unallocated pages
+  static const T * defaultPage ()
+  {
+    static const std::vector<T> Defaults(PageCapacity);
+    return Defaults.data();
+  }
+
+
+private:
+  std::vector<std::unique_ptr<T[]>> m_pages;  // nullptr until written
+  std::vector<std::uint64_t> m_occupied;      // a bit per page, set when allocated
+  std::size_t m_size{0};
+};
+
+}
+}
+
+#endif
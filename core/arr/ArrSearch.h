@@ -0,0 +1,82 @@
+#ifndef NDB_CORE_ARRSEARCH_H
+#define NDB_CORE_ARRSEARCH_H
+
+#include <algorithm>
+#include <span>
+#include <type_traits>
+
+
+namespace nemesis { namespace arr { namespace search {
+
+/*
+Binary searches of sorted values, returning positions as std::lower_bound and std::upper_bound.
+
+For arithmetic types the search is branch-free: each step halves the range with a conditional
+move rather than a branch, so there are no mispredictions, which otherwise occur on about half
+the steps with random lookups. Both halves of the next step are prefetched, which hides some
+of the cache misses in large arrays.
+
+Other types (strings) use std, a comparison costs more than a misprediction.
+*/
+
+
+template<typename T, bool Upper>
+std::size_t bound (const std::span<const T> values, const T& value)
+{
+  if constexpr (std::is_arithmetic_v<T>)
+  {
+    if (values.empty())
+      return 0;
+
+    const T * base = values.data();
+
+    // the result is in [base, base + n]
+    for (std::size_t n = values.size() ; n > 1 ; )
+    {
+      const auto half = n / 2;
+      n -= half;
+
+      __builtin_prefetch(base + n / 2);
+      __builtin_prefetch(base + half + n / 2);
+
+      if constexpr (Upper)
+        base = !(value < base[half]) ? base + half : base;
+      else
+        base = base[half] < value ? base + half : base;
+    }
+
+    if constexpr (Upper)
+      return (base - values.data()) + !(value < *base);
+    else
+      return (base - values.data()) + (*base < value);
+  }
+  else
+  {
+    if constexpr (Upper)
+      return std::distance(values.begin(), std::upper_bound(values.begin(), values.end(), value));
+    else
+      return std::distance(values.begin(), std::lower_bound(values.begin(), values.end(), value));
+  }
+}
+
+
+// position of the first value not less than 'value'
+template<typename T>
+std::size_t lowerBound (const std::span<const T> values, const T& value)
+{
+  return bound<T, false>(values, value);
+}
+
+
+// position of the first value greater than 'value'
+template<typename T>
+std::size_t upperBound (const std::span<const T> values, const T& value)
+{
+  return bound<T, true>(values, value);
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,394 @@
+#ifndef NDB_CORE_ARRSETOPS_H
+#define NDB_CORE_ARRSETOPS_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace nemesis { namespace arr { namespace setops {
+
+/*
+Set operations on sorted int64 arrays. Results match std::set_intersection: a value which is
+duplicated appears the fewer number of times it appears in either array.
+
+Intersection is chosen by the arrays' sizes:
+
+  - very different: galloping. For each value in the smaller array, an exponential then binary
+    search of the larger, from the previous position, so O(m log(n/m)) rather than O(m + n)
+
+  - otherwise: blocks of each array are compared with SIMD, every lane against every lane.
+    If no values are equal, the block with the lower last value can't intersect the rest of
+    the other array, so is skipped. If any are equal, the equal values in the first array's
+    block are the intersection, then the block(s) with the lower last value are skipped.
+    That is only correct if neither block has a duplicate, including the value after each
+    block, otherwise the blocks are merged as the scalar algorithm.
+
+The block kernel is selected at runtime, from AVX-512, AVX2 and scalar. The kernels are
+compiled for their instruction set regardless of -march, so the binary can run on an older CPU.
+
+apply() performs an operation over K arrays of any sorted type:
+
+  - Intersect: smallest array first, so each result is no larger than the next input, and
+    pairs become skewed, which galloping suits. Stops early if a result is empty
+  - Union: merges adjacent pairs until one remains, O(N log K), as std::set_union: a value
+    appears the most times it appears in any array
+  - Difference: the first array without values in the others, as std::set_difference
+*/
+
+
+using Values = std::span<const std::int64_t>;
+using Result = std::vector<std::int64_t>;
+
+// galloping when the larger array is at least this many times the smaller
+static constexpr std::size_t GallopRatio = 32U;
+
+
+// Appends a[i + lane] for each lane set in 'matched'
+inline void appendMatched (const Values a, const std::size_t i, std::uint32_t matched, Result& result)
+{
+  while (matched)
+  {
+    result.push_back(a[i + std::countr_zero(matched)]);
+    matched &= matched - 1;
+  }
+}
+
+
+// Merges as std::set_intersection, from a[i] and b[j] until either reaches its end
+inline void merge (const Values a, const Values b, std::size_t& i, std::size_t& j, const std::size_t aEnd, const std::size_t bEnd, Result& result)
+{
+  while (i < aEnd && j < bEnd)
+  {
+    if (a[i] < b[j])
+      ++i;
+    else if (b[j] < a[i])
+      ++j;
+    else
+    {
+      result.push_back(a[i]);
+      ++i;
+      ++j;
+    }
+  }
+}
+
+
+inline void intersectScalar (const Values a, const Values b, Result& result)
+{
+  std::size_t i = 0, j = 0;
+  merge(a, b, i, j, a.size(), b.size(), result);
+}
+
+
+// 'small' should be much smaller than 'large'
+template<typename T>
+void intersectGallop (const std::span<const T> small, const std::span<const T> large, std::vector<T>& result)
+{
+  std::size_t j = 0;
+
+  for (const auto& value : small)
+  {
+    if (j == large.size())
+      break;
+
+    // find a bound for the first value >= 'value', then binary search within it
+    std::size_t bound = 1;
+    while (j + bound < large.size() && large[j + bound] < value)
+      bound *= 2;
+
+    const auto first = std::next(large.begin(), j + bound / 2);
+    const auto last = std::next(large.begin(), std::min(j + bound + 1, large.size()));
+    j = std::distance(large.begin(), std::lower_bound(first, last, value));
+
+    if (j < large.size() && large[j] == value)
+    {
+      result.push_back(value);
+      ++j;
+    }
+  }
+}
+
+
+#if defined(__x86_64__)
+
+// True if any of the 4 values equals the value after it
+__attribute__((target("avx2"))) inline bool hasDuplicateAvx2 (const std::int64_t * values)
+{
+  const __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values)),
+                                        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + 1)));
+  return !_mm256_testz_si256(eq, eq);
+}
+
+
+// True if any of the 8 values equals the value after it
+__attribute__((target("avx512f"))) inline bool hasDuplicateAvx512 (const std::int64_t * values)
+{
+  return _mm512_cmpeq_epi64_mask(_mm512_loadu_si512(values), _mm512_loadu_si512(values + 1)) != 0;
+}
+
+
+// 4 values per block
+__attribute__((target("avx2"))) inline void intersectAvx2 (const Values a, const Values b, Result& result)
+{
+  static constexpr std::size_t Width = 4U;
+  static constexpr int Rotate = 0b00'11'10'01;
+
+  std::size_t i = 0, j = 0;
+
+  while (i + Width <= a.size() && j + Width <= b.size())
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a.data() + i));
+    __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b.data() + j));
+    __m256i eq = _mm256_cmpeq_epi64(va, vb);
+
+    for (std::size_t r = 1 ; r < Width ; ++r)
+    {
+      vb = _mm256_permute4x64_epi64(vb, Rotate);
+      eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(va, vb));
+    }
+
+    const auto aLast = a[i + Width - 1], bLast = b[j + Width - 1];
+
+    if (!_mm256_testz_si256(eq, eq))
+    {
+      const bool hasNext = i + Width < a.size() && j + Width < b.size();
+
+      if (!hasNext || hasDuplicateAvx2(a.data() + i) || hasDuplicateAvx2(b.data() + j))
+      {
+        merge(a, b, i, j, i + Width, j + Width, result);
+        continue;
+      }
+
+      appendMatched(a, i, static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(eq))), result);
+    }
+
+    i += aLast <= bLast ? Width : 0;
+    j += bLast <= aLast ? Width : 0;
+  }
+
+  merge(a, b, i, j, a.size(), b.size(), result);
+}
+
+
+// 8 values per block. GCC 12's avx512fintrin.h has a false -Wmaybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f"))) inline void intersectAvx512 (const Values a, const Values b, Result& result)
+{
+  static constexpr std::size_t Width = 8U;
+
+  std::size_t i = 0, j = 0;
+
+  while (i + Width <= a.size() && j + Width <= b.size())
+  {
+    const __m512i va = _mm512_loadu_si512(a.data() + i);
+    __m512i vb = _mm512_loadu_si512(b.data() + j);
+    __mmask8 eq = _mm512_cmpeq_epi64_mask(va, vb);
+
+    for (std::size_t r = 1 ; r < Width ; ++r)
+    {
+      vb = _mm512_alignr_epi64(vb, vb, 1);
+      eq |= _mm512_cmpeq_epi64_mask(va, vb);
+    }
+
+    const auto aLast = a[i + Width - 1], bLast = b[j + Width - 1];
+
+    if (eq)
+    {
+      const bool hasNext = i + Width < a.size() && j + Width < b.size();
+
+      if (!hasNext || hasDuplicateAvx512(a.data() + i) || hasDuplicateAvx512(b.data() + j))
+      {
+        merge(a, b, i, j, i + Width, j + Width, result);
+        continue;
+      }
+
+      appendMatched(a, i, eq, result);
+    }
+
+    i += aLast <= bLast ? Width : 0;
+    j += bLast <= aLast ? Width : 0;
+  }
+
+  merge(a, b, i, j, a.size(), b.size(), result);
+}
+#pragma GCC diagnostic pop
+
+#endif
+
+
+struct Kernel
+{
+  void (*intersect)(const Values, const Values, Result&);
+  std::string_view name;
+};
+
+
+inline Kernel selectKernel ()
+{
+  #if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+      return Kernel{.intersect = intersectAvx512, .name = "avx512"};
+    else if (__builtin_cpu_supports("avx2"))
+      return Kernel{.intersect = intersectAvx2, .name = "avx2"};
+  #endif
+
+  return Kernel{.intersect = intersectScalar, .name = "scalar"};
+}
+
+
+inline const Kernel BlockKernel = selectKernel();
+
+
+enum class Operation
+{
+  Intersect,
+  Union,
+  Difference
+};
+
+
+template<typename T>
+using Sources = std::vector<std::span<const T>>;
+
+
+// Intersects int64 with intersect() below, otherwise galloping or std::set_intersection
+template<typename T>
+std::vector<T> intersectPair (std::span<const T> a, std::span<const T> b);
+
+
+// Performs 'op' over 'sources', which must have at least one array
+template<typename T>
+std::vector<T> apply (const Operation op, Sources<T> sources)
+{
+  std::vector<T> result;
+
+  if (op == Operation::Intersect)
+  {
+    std::sort(sources.begin(), sources.end(), [](const auto& a, const auto& b){ return a.size() < b.size(); });
+
+    result.assign(sources.front().begin(), sources.front().end());
+
+    for (std::size_t i = 1 ; i < sources.size() && !result.empty() ; ++i)
+      result = intersectPair<T>(result, sources[i]);
+  }
+  else if (op == Operation::Union)
+  {
+    std::vector<std::vector<T>> merged;
+    merged.reserve((sources.size() + 1) / 2);
+
+    // first pass from the sources, then merging the merged
+    for (std::size_t i = 0 ; i < sources.size() ; i += 2)
+    {
+      auto& out = merged.emplace_back();
+
+      if (i + 1 == sources.size())
+        out.assign(sources[i].begin(), sources[i].end());
+      else
+      {
+        out.reserve(sources[i].size() + sources[i+1].size());
+        std::set_union(sources[i].begin(), sources[i].end(), sources[i+1].begin(), sources[i+1].end(), std::back_inserter(out));
+      }
+    }
+
+    while (merged.size() > 1)
+    {
+      std::vector<std::vector<T>> next;
+      next.reserve((merged.size() + 1) / 2);
+
+      for (std::size_t i = 0 ; i < merged.size() ; i += 2)
+      {
+        if (i + 1 == merged.size())
+          next.emplace_back(std::move(merged[i]));
+        else
+        {
+          auto& out = next.emplace_back();
+          out.reserve(merged[i].size() + merged[i+1].size());
+          std::set_union(std::make_move_iterator(merged[i].begin()), std::make_move_iterator(merged[i].end()),
+                         std::make_move_iterator(merged[i+1].begin()), std::make_move_iterator(merged[i+1].end()),
+                         std::back_inserter(out));
+        }
+      }
+
+      merged = std::move(next);
+    }
+
+    result = std::move(merged.front());
+  }
+  else
+  {
+    result.assign(sources.front().begin(), sources.front().end());
+
+    for (std::size_t i = 1 ; i < sources.size() && !result.empty() ; ++i)
+    {
+      std::vector<T> remaining;
+      remaining.reserve(result.size());
+      std::set_difference(std::make_move_iterator(result.begin()), std::make_move_iterator(result.end()),
+                          sources[i].begin(), sources[i].end(),
+                          std::back_inserter(remaining));
+      result = std::move(remaining);
+    }
+  }
+
+  return result;
+}
+
+
+inline Result intersect (Values a, Values b)
+{
+  if (a.size() > b.size())
+    std::swap(a, b);
+
+  Result result;
+
+  if (a.empty())
+    return result;
+
+  result.reserve(a.size());
+
+  if (b.size() / a.size() >= GallopRatio)
+    intersectGallop<std::int64_t>(a, b, result);
+  else
+    BlockKernel.intersect(a, b, result);
+
+  return result;
+}
+
+
+template<typename T>
+std::vector<T> intersectPair (std::span<const T> a, std::span<const T> b)
+{
+  if constexpr (std::is_same_v<T, std::int64_t>)
+    return intersect(a, b);
+  else
+  {
+    if (a.size() > b.size())
+      std::swap(a, b);
+
+    std::vector<T> result;
+
+    if (!a.empty() && b.size() / a.size() >= GallopRatio)
+      intersectGallop<T>(a, b, result);
+    else
+      std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+
+    return result;
+  }
+}
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef NDB_CORE_ARRSORT_H
+#define NDB_CORE_ARRSORT_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include <core/ThreadPool.h>
+
+
+namespace nemesis { namespace arr {
+
+
+/*
+Sorting and merging for sorted arrays' batch inserts and the SORT, UNIQUE and TO_SORTED commands.
+
+sortItems() sorts large batches in parallel: chunks are sorted on a pool then merged in
+pairs, also on the pool. The pool is created for the call, so it is safe after fork().
+The caller waits, so a write which sorts is ordered with the writes around it.
+
+A chunk of int64_t with the default order is sorted by radixSort() rather than std::sort,
+which is a few times faster for more than a few thousand values, at the cost of a buffer
+the size of the chunk.
+
+mergeInto() merges sorted items into the sorted values before 'used', in the spare
+capacity after them. Merging from the ends, each value is moved at most once, in blocks
+between items, so O(used + items). Values less than all items aren't moved.
+*/
+
+
+// batches smaller than this are sorted on the calling thread
+static constexpr std::size_t ParallelSortMin = 65536U;
+
+// int64_t chunks smaller than this use std::sort rather than radixSort()
+static constexpr std::size_t RadixSortMin = 2048U;
+
+
+// Sorts 'keys' by their lowest 'nDigits' bytes, a byte per pass from the least significant, with
+// 'buffer' of the same size. A pass is skipped when all keys have the same byte there.
+inline void radixSortDigits (std::uint64_t * keys, std::uint64_t * buffer, const std::size_t n, const std::size_t nDigits)
+{
+  std::array<std::array<std::size_t, 256>, sizeof(std::uint64_t)> counts{};
+
+  for (std::size_t i = 0 ; i < n ; ++i)
+  {
+    for (std::size_t d = 0 ; d < nDigits ; ++d)
+      ++counts[d][(keys[i] >> (8 * d)) & 0xFF];
+  }
+
+  std::uint64_t * src = keys;
+  std::uint64_t * dest = buffer;
+
+  for (std::size_t d = 0 ; d < nDigits ; ++d)
+  {
+    const auto shift = 8 * d;
+
+    if (counts[d][(src[0] >> shift) & 0xFF] == n)
+      continue;
+
+    std::array<std::size_t, 256> offsets;
+    std::size_t offset = 0;
+    for (std::size_t b = 0 ; b < 256 ; ++b)
+    {
+      offsets[b] = offset;
+      offset += counts[d][b];
+    }
+
+    for (std::size_t i = 0 ; i < n ; ++i)
+      dest[offsets[(src[i] >> shift) & 0xFF]++] = src[i];
+
+    std::swap(src, dest);
+  }
+
+  if (src != keys)
+    std::copy(src, src + n, keys);
+}
+
+
+/*
+Radix sort for int64_t. Bytes above the highest which differs between values are skipped. The
+values are partitioned by that byte, then each partition is sorted by the bytes below it, which
+for large inputs keeps each partition's passes within the cache rather than scattering across
+all of the values.
+*/
+inline void radixSort (std::span<std::int64_t> items)
+{
+  static constexpr std::uint64_t SignBit = 1ULL << 63;
+  static constexpr std::size_t PartitionMin = 65536U;
+
+  const auto n = items.size();
+
+  if (n < 2)
+    return;
+
+  // flipping the sign bit orders negatives before positives, as unsigned keys. A signed and
+  // unsigned type can alias.
+  auto keys = reinterpret_cast<std::uint64_t *>(items.data());
+
+  std::uint64_t differ = 0;
+  for (std::size_t i = 0 ; i < n ; ++i)
+  {
+    keys[i] ^= SignBit;
+    differ |= keys[i] ^ keys[0];
+  }
+
+  if (differ != 0)
+  {
+    const std::size_t nDigits = (std::bit_width(differ) + 7) / 8;
+    std::vector<std::uint64_t> buffer (n);
+
+    if (n < PartitionMin)
+      radixSortDigits(keys, buffer.data(), n, nDigits);
+    else
+    {
+      const auto shift = 8 * (nDigits - 1);
+
+      std::array<std::size_t, 257> bounds{};
+      for (std::size_t i = 0 ; i < n ; ++i)
+        ++bounds[((keys[i] >> shift) & 0xFF) + 1];
+
+      std::partial_sum(bounds.begin(), bounds.end(), bounds.begin());
+
+      auto offsets = bounds;
+      for (std::size_t i = 0 ; i < n ; ++i)
+        buffer[offsets[(keys[i] >> shift) & 0xFF]++] = keys[i];
+
+      for (std::size_t b = 0 ; b < 256 ; ++b)
+      {
+        if (const auto first = bounds[b], size = bounds[b + 1] - first ; size != 0)
+        {
+          radixSortDigits(buffer.data() + first, keys + first, size, nDigits - 1);
+          std::copy(buffer.data() + first, buffer.data() + first + size, keys + first);
+        }
+      }
+    }
+  }
+
+  for (std::size_t i = 0 ; i < n ; ++i)
+    keys[i] ^= SignBit;
+}
+
+
+template<typename T, typename Compare>
+void sortChunk (std::span<T> items, Compare less)
+{
+  if constexpr (std::is_same_v<T, std::int64_t> && std::is_same_v<Compare, std::less<>>)
+  {
+    if (items.size() >= RadixSortMin)
+    {
+      radixSort(items);
+      return;
+    }
+  }
+
+  std::sort(items.begin(), items.end(), less);
+}
+
+
+template<typename T, typename Compare = std::less<>>
+void sortItems (std::span<T> items, Compare less = {}, const std::size_t nThreads = ThreadPool::defaultSize())
+{
+  static const std::size_t MinChunkSize = 16384U;
+
+  const auto nChunks = std::min<std::size_t>(nThreads, items.size() / MinChunkSize);
+
+  if (items.size() < ParallelSortMin || nChunks < 2)
+  {
+    sortChunk(items, less);
+    return;
+  }
+
+  ThreadPool pool {nChunks};
+  std::vector<std::future<void>> tasks;
+
+  // chunk i is [bounds[i], bounds[i+1])
+  std::vector<std::size_t> bounds;
+  for (std::size_t i = 0 ; i <= nChunks ; ++i)
+    bounds.push_back(items.size() * i / nChunks);
+
+  for (std::size_t i = 0 ; i < nChunks ; ++i)
+  {
+    tasks.emplace_back(pool.submit([items, less, first = bounds[i], last = bounds[i+1]]
+    {
+      sortChunk(items.subspan(first, last - first), less);
+    }));
+  }
+
+  for (auto& task : tasks)
+    task.get();
+
+  // merge adjacent pairs of chunks until one remains
+  for (std::size_t width = 1 ; width < nChunks ; width *= 2)
+  {
+    tasks.clear();
+
+    for (std::size_t i = 0 ; i + width < nChunks ; i += 2 * width)
+    {
+      const auto first = bounds[i], middle = bounds[i + width], last = bounds[std::min(i + 2 * width, nChunks)];
+
+      tasks.emplace_back(pool.submit([items, less, first, middle, last]
+      {
+        std::inplace_merge(std::next(items.begin(), first), std::next(items.begin(), middle), std::next(items.begin(), last), less);
+      }));
+    }
+
+    for (auto& task : tasks)
+      task.get();
+  }
+}
+
+
+template<typename T>
+void sortItems (std::vector<T>& items, const std::size_t nThreads = ThreadPool::defaultSize())
+{
+  sortItems(std::span<T>{items}, std::less<>{}, nThreads);
+}
+
+
+// 'values' and 'items' must be sorted, with values.size() >= used + items.size(). Items are moved from.
+template<typename T>
+void mergeInto (std::vector<T>& values, std::size_t used, std::vector<T>& items)
+{
+  auto out = std::next(values.begin(), used + items.size());
+
+  for (auto item = items.rbegin() ; item != items.rend() ; ++item)
+  {
+    // the values greater than item, galloping back from used because items are usually
+    // spread through values, so the distance between them is short
+    std::size_t step = 1;
+    while (step <= used && *item < values[used - step])
+      step *= 2;
+
+    const auto first = std::next(values.begin(), step <= used ? used - step : 0);
+    const auto last = std::next(values.begin(), used - step / 2);
+    const auto itGreater = std::upper_bound(first, last, *item);
+
+    // move them as a block, then the item before them
+    out = std::move_backward(itGreater, std::next(values.begin(), used), out);
+    *--out = std::move(*item);
+    used = std::distance(values.begin(), itGreater);
+  }
+}
+
+}
+}
+
+#endif
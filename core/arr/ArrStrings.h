@@ -0,0 +1,338 @@
+#ifndef NDB_CORE_ARRSTRINGS_H
+#define NDB_CORE_ARRSTRINGS_H
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <core/arr/ArrSort.h>
+
+
+namespace nemesis { namespace arr {
+
+
+/*
+The Arena layout of string arrays.
+
+A std::string over the SSO limit is a separate allocation, and comparing two means following
+both pointers. StringArena instead has a fixed size entry per string:
+
+  key | offset | size
+
+'key' is the string's first 8 bytes, zero-padded and big-endian, so comparing keys as integers
+orders strings as std::string does. Only when keys are equal, and both strings are longer than
+the key, are the remaining bytes compared. Those are packed into one buffer, the arena, at 'offset',
+so a string of 8 bytes or less has nothing in the arena.
+
+Replacing a string leaves its bytes in the arena until it's compacted, which happens when
+less than half of the arena is referenced by entries.
+*/
+
+
+static constexpr std::size_t StringKeySize = sizeof(std::uint64_t);
+
+
+// The first 8 bytes of 's', zero-padded, big-endian
+inline std::uint64_t stringKey (const std::string_view s) noexcept
+{
+  std::uint64_t key = 0;
+  std::memcpy(&key, s.data(), std::min(s.size(), StringKeySize));
+
+  if constexpr (std::endian::native == std::endian::little)
+    return __builtin_bswap64(key);
+  else
+    return key;
+}
+
+
+// A string compared by its key first, without copying it: the suffix refers to an arena or a std::string
+struct StringRef
+{
+  std::uint64_t key;
+  std::string_view suffix;  // bytes after the key, empty if size <= StringKeySize
+  std::uint32_t size;
+
+
+  static StringRef of (const std::string_view s) noexcept
+  {
+    return StringRef{ .key = stringKey(s),
+                      .suffix = s.size() > StringKeySize ? s.substr(StringKeySize) : std::string_view{},
+                      .size = static_cast<std::uint32_t>(s.size())};
+  }
+
+
+  std::string str() const
+  {
+    std::string s(size, '\0');
+
+    for (std::size_t i = 0 ; i < std::min<std::size_t>(size, StringKeySize) ; ++i)
+      s[i] = static_cast<char>(key >> (56 - 8 * i));
+
+    std::copy(suffix.cbegin(), suffix.cend(), std::next(s.begin(), std::min<std::size_t>(size, StringKeySize)));
+    return s;
+  }
+
+
+  // If keys are equal and either string fits in the key, the shorter is a prefix of the other
+  friend std::strong_ordering operator<=> (const StringRef& a, const StringRef& b) noexcept
+  {
+    if (a.key != b.key)
+      return a.key <=> b.key;
+    else if (a.size <= StringKeySize || b.size <= StringKeySize)
+      return a.size <=> b.size;
+    else
+      return a.suffix.compare(b.suffix) <=> 0;
+  }
+
+
+  friend bool operator== (const StringRef& a, const StringRef& b) noexcept
+  {
+    return a.key == b.key && a.size == b.size && a.suffix == b.suffix;
+  }
+};
+
+
+class StringArena
+{
+  struct Entry
+  {
+    std::uint64_t key{0};
+    std::uint32_t offset{0};
+    std::uint32_t size{0};
+
+    std::size_t suffixSize() const noexcept
+    {
+      return size > StringKeySize ? size - StringKeySize : 0;
+    }
+  };
+
+  static constexpr std::size_t CompactMin = 64U * 1024U;
+
+public:
+
+  explicit StringArena (const std::size_t size = 0) : m_entries(size)
+  {
+  }
+
+
+  std::size_t size () const noexcept
+  {
+    return m_entries.size();
+  }
+
+
+  // Entries beyond 'size' are removed, new entries are empty strings
+  void resize (const std::size_t size)
+  {
+    for (auto i = size ; i < m_entries.size() ; ++i)
+      m_live -= m_entries[i].suffixSize();
+
+    m_entries.resize(size);
+  }
+
+
+  // Bytes allocated for entries and the arena
+  std::size_t memory () const noexcept
+  {
+    return m_entries.capacity() * sizeof(Entry) + m_bytes.capacity();
+  }
+
+
+  StringRef ref (const std::size_t i) const noexcept
+  {
+    const auto& entry = m_entries[i];
+    return StringRef{.key = entry.key, .suffix = {m_bytes.data() + entry.offset, entry.suffixSize()}, .size = entry.size};
+  }
+
+
+  std::string get (const std::size_t i) const
+  {
+    return ref(i).str();
+  }
+
+
+  bool isEmpty (const std::size_t i) const noexcept
+  {
+    return m_entries[i].size == 0;
+  }
+
+
+  // Throws std::length_error if the arena would exceed 4GB
+  void set (const std::size_t i, const std::string_view s)
+  {
+    auto& entry = m_entries[i];
+
+    // empty before appending, which may compact
+    m_live -= entry.suffixSize();
+    entry = Entry{};
+
+    const auto offset = s.size() > StringKeySize ? append(s.substr(StringKeySize)) : 0U;
+    entry = Entry{.key = stringKey(s), .offset = offset, .size = static_cast<std::uint32_t>(s.size())};
+  }
+
+
+  void swap (const std::size_t a, const std::size_t b) noexcept
+  {
+    std::swap(m_entries[a], m_entries[b]);
+  }
+
+
+  // As std::rotate() of the strings, only moving entries
+  void rotate (const std::size_t first, const std::size_t middle, const std::size_t last)
+  {
+    std::rotate(std::next(m_entries.begin(), first), std::next(m_entries.begin(), middle), std::next(m_entries.begin(), last));
+  }
+
+
+  // Sets 's' at 'last' then moves it to 'pos', moving [pos, last) up by one. Entries are
+  // trivially copyable, so that's a memmove rather than rotate's swaps.
+  void insert (const std::size_t pos, const std::size_t last, const std::string_view s)
+  {
+    set(last, s);
+
+    const auto entry = m_entries[last];
+    std::move_backward(std::next(m_entries.begin(), pos), std::next(m_entries.begin(), last), std::next(m_entries.begin(), last + 1));
+    m_entries[pos] = entry;
+  }
+
+
+  // Positions of the first string in [0, n) not less than, or greater than, 's'
+  std::size_t lowerBound (const std::size_t n, const std::string_view s) const
+  {
+    const auto target = StringRef::of(s);
+    const auto it = std::partition_point(m_entries.cbegin(), std::next(m_entries.cbegin(), n), [this, &target](const Entry& entry)
+    {
+      return refOf(entry) < target;
+    });
+    return std::distance(m_entries.cbegin(), it);
+  }
+
+
+  std::size_t upperBound (const std::size_t n, const std::string_view s) const
+  {
+    const auto target = StringRef::of(s);
+    const auto it = std::partition_point(m_entries.cbegin(), std::next(m_entries.cbegin(), n), [this, &target](const Entry& entry)
+    {
+      return !(target < refOf(entry));
+    });
+    return std::distance(m_entries.cbegin(), it);
+  }
+
+
+  /*
+  Merges 'items' into the sorted strings in [0, used). The items are written from 'used', so
+  size() must be at least used + items.size(). They needn't be sorted: their entries are, which
+  is faster than sorting the strings because most comparisons are of keys.
+  */
+  void merge (std::size_t used, const std::vector<std::string>& items)
+  {
+    for (std::size_t i = 0 ; i < items.size() ; ++i)
+      set(used + i, items[i]);
+
+    auto less = [this](const Entry& a, const Entry& b)
+    {
+      return refOf(a) < refOf(b);
+    };
+
+    const auto firstItem = std::next(m_entries.begin(), used);
+    const auto lastItem = std::next(firstItem, items.size());
+
+    if (!std::is_sorted(firstItem, lastItem, less))
+      std::sort(firstItem, lastItem, less);
+
+    std::inplace_merge(m_entries.begin(), firstItem, lastItem, less);
+  }
+
+
+  // Sorts the first 'n' strings, ascending or descending. Only entries move, compared as in merge().
+  void sort (const std::size_t n, const bool descending)
+  {
+    const auto entries = std::span<Entry>{m_entries}.first(n);
+
+    sortItems(entries, [this](const Entry& a, const Entry& b)
+    {
+      return refOf(a) < refOf(b);
+    });
+
+    if (descending)
+      std::reverse(entries.begin(), entries.end());
+  }
+
+
+  // The position after the last string which isn't empty, 0 if there are none
+  std::size_t lastSet () const noexcept
+  {
+    const auto it = std::find_if(m_entries.crbegin(), m_entries.crend(), [](const Entry& entry){ return entry.size != 0; });
+    return std::distance(it, m_entries.crend());
+  }
+
+
+  // Releases unused memory, including bytes of replaced strings
+  void shrinkToFit ()
+  {
+    compact();
+    m_entries.shrink_to_fit();
+    m_bytes.shrink_to_fit();
+  }
+
+
+private:
+
+  StringRef refOf (const Entry& entry) const noexcept
+  {
+    return StringRef{.key = entry.key, .suffix = {m_bytes.data() + entry.offset, entry.suffixSize()}, .size = entry.size};
+  }
+
+
+  std::uint32_t append (const std::string_view bytes)
+  {
+    if (m_bytes.size() >= CompactMin && m_bytes.size() > 2 * m_live)
+      compact();
+
+    if (m_bytes.size() + bytes.size() > std::numeric_limits<std::uint32_t>::max())
+      throw std::length_error{"String arena exceeds 4GB"};
+
+    const auto offset = static_cast<std::uint32_t>(m_bytes.size());
+    m_bytes.insert(m_bytes.end(), bytes.cbegin(), bytes.cend());
+    m_live += bytes.size();
+    return offset;
+  }
+
+
+  // Copies the bytes of each entry to a new arena, in entry order
+  void compact ()
+  {
+    std::vector<char> bytes;
+    bytes.reserve(m_live);
+
+    for (auto& entry : m_entries)
+    {
+      if (const auto n = entry.suffixSize(); n)
+      {
+        const auto offset = static_cast<std::uint32_t>(bytes.size());
+        bytes.insert(bytes.end(), std::next(m_bytes.cbegin(), entry.offset), std::next(m_bytes.cbegin(), entry.offset + n));
+        entry.offset = offset;
+      }
+    }
+
+    m_bytes = std::move(bytes);
+  }
+
+
+private:
+  std::vector<Entry> m_entries;
+  std::vector<char> m_bytes;
+  std::size_t m_live{0}; // bytes in the arena referenced by entries
+};
+
+}
+}
+
+#endif
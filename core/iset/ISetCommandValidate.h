@@ -0,0 +1,100 @@
+#ifndef NDB_CORE_ISETCMDVALIDATE_H
+#define NDB_CORE_ISETCMDVALIDATE_H
+
+#include <algorithm>
+#include <string_view>
+#include <core/NemesisCommon.h>
+#include <core/iset/ISetCommands.h>
+#include <core/iset/ISetCommon.h>
+
+
+namespace nemesis { namespace iset {
+
+  using namespace nemesis::iset::cmds;
+
+
+  // commands with only "name"
+  template<typename Cmds>
+  RequestStatus validateName (const njson& request, const std::string_view reqName, const std::string_view rspName)
+  {
+    return isValid(rspName, request.at(reqName), { {Param::required("name", JsonString)} });
+  }
+
+
+  // ADD and RMV: "items", each an unsigned integer
+  template<typename Cmds>
+  RequestStatus validateItems (const njson& request, const std::string_view reqName, const std::string_view rspName)
+  {
+    auto checkItems = [](const njson& body) -> RequestStatus
+    {
+      const auto items = body.at("items").array_range();
+      return std::all_of(items.cbegin(), items.cend(), [](const njson& item){ return item.is_uint64(); }) ? RequestStatus::Ok : RequestStatus::ValueTypeInvalid;
+    };
+
+    return isValid(rspName, request.at(reqName), { {Param::required("name",  JsonString)},
+                                                   {Param::required("items", JsonArray)}}, checkItems);
+  }
+
+
+  // CONTAINS and RANK
+  template<typename Cmds>
+  RequestStatus validateItem (const njson& request, const std::string_view reqName, const std::string_view rspName)
+  {
+    return isValid(rspName, request.at(reqName), { {Param::required("name", JsonString)},
+                                                   {Param::required("item", JsonUInt)}});
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateSelect (const njson& request)
+  {
+    return isValid(Cmds::select.rsp, request.at(Cmds::select.req), { {Param::required("name", JsonString)},
+                                                                     {Param::required("pos",  JsonUInt)}});
+  }
+
+
+  // "rng": [start] or [start, stop], positions in ascending order
+  template<typename Cmds>
+  RequestStatus validateGetRange (const njson& request)
+  {
+    auto checkRng = [](const njson& body) -> RequestStatus
+    {
+      const auto& rng = body.at("rng");
+
+      if (const auto nDims = rng.size(); !(nDims == 1 || nDims == 2))
+        return RequestStatus::ValueSize;
+      else if (const auto positions = rng.array_range(); !std::all_of(positions.cbegin(), positions.cend(), [](const njson& pos){ return pos.is_uint64(); }))
+        return RequestStatus::ValueTypeInvalid;
+      else if (nDims == 2 && rng[0].as<std::size_t>() > rng[1].as<std::size_t>())
+        return RequestStatus::CommandSyntax;
+      else
+        return RequestStatus::Ok;
+    };
+
+    return isValid(Cmds::getRange.rsp, request.at(Cmds::getRange.req), { {Param::required("name", JsonString)},
+                                                                         {Param::required("rng",  JsonArray)}}, checkRng);
+  }
+
+
+  // INTERSECT, UNION, XOR and DIFF: "srcs" with at least two names, and an optional "dest"
+  template<typename Cmds>
+  RequestStatus validateSetOperation (const njson& request, const std::string_view reqName, const std::string_view rspName)
+  {
+    auto checkSources = [](const njson& body) -> RequestStatus
+    {
+      if (body.at("srcs").size() < 2U)
+        return RequestStatus::CommandSyntax;
+      else
+      {
+        const auto srcs = body.at("srcs").array_range();
+        return std::all_of(srcs.cbegin(), srcs.cend(), [](const njson& src){ return src.is_string(); }) ? RequestStatus::Ok : RequestStatus::ValueTypeInvalid;
+      }
+    };
+
+    return isValid(rspName, request.at(reqName), { {Param::required("srcs", JsonArray)},
+                                                   {Param::optional("dest", JsonString)}}, checkSources);
+  }
+}
+}
+
+#endif
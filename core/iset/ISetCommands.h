@@ -0,0 +1,82 @@
+#ifndef NDB_CORE_ISETCOMMANDS_H
+#define NDB_CORE_ISETCOMMANDS_H
+
+#include <core/NemesisCommon.h>
+
+namespace nemesis { namespace iset { namespace cmds {
+
+  static constexpr FixedString Create     = "CREATE";
+  static constexpr FixedString Delete     = "DELETE";
+  static constexpr FixedString DeleteAll  = "DELETE_ALL";
+  static constexpr FixedString Exist      = "EXIST";
+  static constexpr FixedString Add        = "ADD";
+  static constexpr FixedString Remove     = "RMV";
+  static constexpr FixedString Contains   = "CONTAINS";
+  static constexpr FixedString Len        = "LEN";
+  static constexpr FixedString Rank       = "RANK";
+  static constexpr FixedString Select     = "SELECT";
+  static constexpr FixedString GetRange   = "GET_RNG";
+  static constexpr FixedString Clear      = "CLEAR";
+  static constexpr FixedString Intersect  = "INTERSECT";
+  static constexpr FixedString Union      = "UNION";
+  static constexpr FixedString Xor        = "XOR";
+  static constexpr FixedString Diff       = "DIFF";
+
+
+  static constexpr FixedString ISetIdent  = "ISET";
+  static constexpr FixedString ISetIdent_ = "ISET_";
+  static constexpr FixedString Rsp        = "_RSP";
+
+
+  template<FixedString Ident, FixedString Cmd>
+  static consteval auto makeReq() -> decltype(Ident+Cmd)
+  {
+    return Ident+Cmd;
+  }
+
+  template<FixedString Ident, FixedString Cmd>
+  static consteval auto makeRsp() -> decltype(makeReq<Ident, Cmd>()+Rsp)
+  {
+    return makeReq<Ident, Cmd>()+Rsp;
+  }
+
+
+  template <FixedString Ident>
+  struct SetCmds
+  {
+    template<FixedString Name>
+    struct Cmd
+    {
+      static constexpr auto req = makeReq<Ident, Name>();
+      static constexpr auto rsp = makeRsp<Ident, Name>();
+    };
+
+    static constexpr Cmd<Create> create {};
+    static constexpr Cmd<Delete> del{};
+    static constexpr Cmd<DeleteAll> deleteAll{};
+    static constexpr Cmd<Exist> exist{};
+    static constexpr Cmd<Add> add {};
+    static constexpr Cmd<Remove> remove{};
+    static constexpr Cmd<Contains> contains{};
+    static constexpr Cmd<Len> len{};
+    static constexpr Cmd<Rank> rank{};
+    static constexpr Cmd<Select> select{};
+    static constexpr Cmd<GetRange> getRange{};
+    static constexpr Cmd<Clear> clear{};
+    static constexpr Cmd<Intersect> intersect{};
+    static constexpr Cmd<Union> unite{};
+    static constexpr Cmd<Xor> symmetricDiff{};
+    static constexpr Cmd<Diff> diff{};
+  };
+
+
+  // Unsigned integer sets, as roaring bitmaps
+  struct IntSetCmds : public SetCmds<ISetIdent_>
+  {
+  };
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef NDB_CORE_ISETCOMMON_H
+#define NDB_CORE_ISETCOMMON_H
+
+#include <core/NemesisCommon.h>
+
+
+namespace nemesis {  namespace iset {
+
+  enum class ISetQueryType : std::uint8_t
+  {
+    Create,
+    Delete,
+    DeleteAll,
+    Exist,
+    Add,
+    Remove,
+    Contains,
+    Len,
+    Rank,
+    Select,
+    GetRange,
+    Clear,
+    Intersect,
+    Union,
+    Xor,
+    Diff,
+    MAX
+  };
+}
+}
+
+#endif
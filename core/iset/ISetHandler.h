@@ -0,0 +1,585 @@
+#ifndef NDB_CORE_ISETHANDLERS_H
+#define NDB_CORE_ISETHANDLERS_H
+
+
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <ankerl/unordered_dense.h>
+#include <core/NemesisCommon.h>
+#include <core/NemesisConfig.h>
+#include <core/Snapshot.h>
+#include <core/iset/ISetCommon.h>
+#include <core/iset/ISetCommands.h>
+#include <core/iset/ISetCommandValidate.h>
+#include <core/iset/ISetRoaring.h>
+
+
+
+namespace nemesis { namespace iset {
+
+
+  using namespace nemesis::iset::cmds;
+
+
+  /*
+  Sets of unsigned integers, each a roaring bitmap (see ISetRoaring.h).
+
+  A set is created empty by CREATE. INTERSECT, UNION, XOR and DIFF take two or more sets,
+  returning the result's values or, with "dest", storing the result as a set which is created
+  or replaced, so results can be combined further without leaving the server.
+  */
+  template<typename Cmds>
+  class SetHandler
+  {
+    using Sets = ankerl::unordered_dense::map<std::string, Roaring>;
+    using Iterator = Sets::iterator;
+    using HandlerPmrMap = ankerl::unordered_dense::pmr::map<ISetQueryType, Handler>;
+    using QueryTypePmrMap = ankerl::unordered_dense::pmr::map<std::string_view, ISetQueryType>;
+
+
+  public:
+
+    template<class Alloc>
+    auto createLocalHandlers (Alloc& alloc)
+    {
+      // initialise with 1 bucket and pmr allocator
+      HandlerPmrMap h (
+      {
+        {ISetQueryType::Create,     Handler{std::bind_front(&SetHandler<Cmds>::create,      std::ref(*this))}},
+        {ISetQueryType::Delete,     Handler{std::bind_front(&SetHandler<Cmds>::deleteSet,   std::ref(*this))}},
+        {ISetQueryType::DeleteAll,  Handler{std::bind_front(&SetHandler<Cmds>::deleteAll,   std::ref(*this))}},
+        {ISetQueryType::Exist,      Handler{std::bind_front(&SetHandler<Cmds>::exist,       std::ref(*this))}},
+        {ISetQueryType::Add,        Handler{std::bind_front(&SetHandler<Cmds>::add,         std::ref(*this))}},
+        {ISetQueryType::Remove,     Handler{std::bind_front(&SetHandler<Cmds>::remove,      std::ref(*this))}},
+        {ISetQueryType::Contains,   Handler{std::bind_front(&SetHandler<Cmds>::contains,    std::ref(*this))}},
+        {ISetQueryType::Len,        Handler{std::bind_front(&SetHandler<Cmds>::length,      std::ref(*this))}},
+        {ISetQueryType::Rank,       Handler{std::bind_front(&SetHandler<Cmds>::rank,        std::ref(*this))}},
+        {ISetQueryType::Select,     Handler{std::bind_front(&SetHandler<Cmds>::select,      std::ref(*this))}},
+        {ISetQueryType::GetRange,   Handler{std::bind_front(&SetHandler<Cmds>::getRange,    std::ref(*this))}},
+        {ISetQueryType::Clear,      Handler{std::bind_front(&SetHandler<Cmds>::clear,       std::ref(*this))}},
+        {ISetQueryType::Intersect,  Handler{std::bind_front(&SetHandler<Cmds>::intersect,   std::ref(*this))}},
+        {ISetQueryType::Union,      Handler{std::bind_front(&SetHandler<Cmds>::unite,       std::ref(*this))}},
+        {ISetQueryType::Xor,        Handler{std::bind_front(&SetHandler<Cmds>::symmetricDiff, std::ref(*this))}},
+        {ISetQueryType::Diff,       Handler{std::bind_front(&SetHandler<Cmds>::diff,        std::ref(*this))}},
+      }, 1, alloc);
+
+      return h;
+    }
+
+
+    template<class Alloc>
+    auto createQueryTypeNameMap (Alloc& alloc)
+    {
+      QueryTypePmrMap map (
+      {
+        {Cmds::create.req,        ISetQueryType::Create},
+        {Cmds::del.req,           ISetQueryType::Delete},
+        {Cmds::deleteAll.req,     ISetQueryType::DeleteAll},
+        {Cmds::exist.req,         ISetQueryType::Exist},
+        {Cmds::add.req,           ISetQueryType::Add},
+        {Cmds::remove.req,        ISetQueryType::Remove},
+        {Cmds::contains.req,      ISetQueryType::Contains},
+        {Cmds::len.req,           ISetQueryType::Len},
+        {Cmds::rank.req,          ISetQueryType::Rank},
+        {Cmds::select.req,        ISetQueryType::Select},
+        {Cmds::getRange.req,      ISetQueryType::GetRange},
+        {Cmds::clear.req,         ISetQueryType::Clear},
+        {Cmds::intersect.req,     ISetQueryType::Intersect},
+        {Cmds::unite.req,         ISetQueryType::Union},
+        {Cmds::symmetricDiff.req, ISetQueryType::Xor},
+        {Cmds::diff.req,          ISetQueryType::Diff},
+      }, 1, alloc);
+
+      return map;
+    }
+
+
+  public:
+
+    Response handle(const std::string_view& reqName, njson& request)
+    {
+      static PmrResource<typename HandlerPmrMap::value_type, 1024U> handlerPmrResource; // TODO buffer size
+      static PmrResource<typename HandlerPmrMap::value_type, 1024U> queryTypeNamePmrResource; // TODO buffer size
+      static const QueryTypePmrMap QueryNameToType{createQueryTypeNameMap(queryTypeNamePmrResource.getAlloc())};
+      static const HandlerPmrMap LocalHandlers{createLocalHandlers(handlerPmrResource.getAlloc())};
+
+      if (const auto itType = QueryNameToType.find(reqName) ; itType == QueryNameToType.cend())
+        return Response {.rsp = createErrorResponse(RequestStatus::CommandNotExist)};
+      else if (const auto localHandlerIt = LocalHandlers.find(itType->second) ; localHandlerIt != LocalHandlers.cend())
+      {
+        try
+        {
+          auto& handler = localHandlerIt->second;
+          return handler(request);
+        }
+        catch (const std::exception& ex)
+        {
+          PLOGE << ex.what() ;
+          return Response {.rsp = createErrorResponse(RequestStatus::Unknown)};
+        }
+      }
+      else
+        return Response {.rsp = createErrorResponse(RequestStatus::CommandNotExist)};
+    }
+
+
+    // Emits requests which recreate the sets, used by WAL compaction
+    void dump (const std::function<void(const njson&)>& emit) const
+    {
+      static const std::size_t BatchSize = 1024U;
+
+      for (const auto& [name, set] : m_sets)
+      {
+        njson create;
+        create[Cmds::create.req.data()]["name"] = name;
+        emit(create);
+
+        for (std::size_t start = 0 ; start < set.size() ; start += BatchSize)
+        {
+          njson request;
+          auto& body = request[Cmds::add.req.data()];
+          body["name"] = name;
+          body["items"] = njson::make_array();
+
+          set.forEach(start, start + BatchSize, [&items = body["items"]](const std::uint64_t v){ items.push_back(v); });
+          emit(request);
+        }
+      }
+    }
+
+
+    /*
+    Writes all sets to snapshot files in 'dir'. Can run in a forked child (background save).
+
+    A set is written a container per record:
+      name | key (u64) | n (u64) | n values (u16), or if n > Container::ArrayMax, the bitmap's words
+
+    An empty set has one record with n of 0.
+    */
+    bool save (const fs::path& dir, const snapshot::Codec codec) const
+    {
+      fs::create_directories(dir);
+
+      snapshot::SnapshotWriter writer{dir, codec};
+
+      for (const auto& [name, set] : m_sets)
+      {
+        if (set.empty())
+        {
+          writer.putString(name);
+          writer.putU64(0);
+          writer.putU64(0);
+          writer.endRecord();
+        }
+
+        for (std::size_t i = 0 ; i < set.containers() ; ++i)
+        {
+          const auto& container = set.container(i);
+
+          writer.putString(name);
+          writer.putU64(set.key(i));
+          writer.putU64(container.size());
+
+          if (container.isBitmap())
+            writer.putBytes(container.bits().data(), container.bits().size_bytes());
+          else
+            writer.putBytes(container.values().data(), container.values().size_bytes());
+
+          writer.endRecord();
+        }
+      }
+
+      writer.close();
+      return true;
+    }
+
+
+    // Loads sets written by save(), replacing sets with the same name. Throws on error.
+    std::size_t load (const fs::path& dir)
+    {
+      std::size_t nSets{0};
+
+      if (!fs::exists(dir))
+        return nSets;
+
+      ankerl::unordered_dense::set<std::string> loaded;
+
+      // in the order written, Roaring::restore() requires ascending keys and a set's records can span files
+      for (const auto& file : snapshot::dataFiles(dir))
+      {
+        snapshot::SnapshotReader reader{file};
+
+        while (reader.nextBlock())
+        {
+          for (std::uint32_t i = 0 ; i < reader.blockRecords() ; ++i)
+          {
+            std::string name {reader.getString()};
+            const auto key = reader.getU64();
+            const auto n = reader.getU64();
+
+            // the first record replaces an existing set
+            if (!loaded.contains(name))
+            {
+              m_sets.insert_or_assign(name, Roaring{});
+              loaded.insert(name);
+              ++nSets;
+            }
+
+            if (n > Container::ArrayMax)
+            {
+              const auto bytes = reader.getBytes(Container::Words * sizeof(std::uint64_t));
+              std::vector<std::uint64_t> bits(Container::Words);
+              std::memcpy(bits.data(), bytes.data(), bytes.size());
+
+              m_sets.at(name).restore(key, Container::ofBits(std::move(bits)));
+            }
+            else if (n)
+            {
+              const auto bytes = reader.getBytes(n * sizeof(std::uint16_t));
+              std::vector<std::uint16_t> values(n);
+              std::memcpy(values.data(), bytes.data(), bytes.size());
+
+              m_sets.at(name).restore(key, Container::ofValues(std::move(values)));
+            }
+          }
+        }
+      }
+
+      return nSets;
+    }
+
+
+  private:
+
+    static std::vector<std::uint64_t> toValues (const njson& items)
+    {
+      std::vector<std::uint64_t> values;
+      values.reserve(items.size());
+
+      for (const auto& item : items.array_range())
+        values.push_back(item.as<std::uint64_t>());
+
+      return values;
+    }
+
+
+    Response create(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::create.req.data();
+      static constexpr auto RspName = Cmds::create.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName); status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else if (const auto [it, created] = m_sets.try_emplace(request.at(ReqName).at("name").as_string()); !created)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Duplicate)};
+      else
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+    }
+
+
+    Response deleteSet(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::del.req.data();
+      static constexpr auto RspName = Cmds::del.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else
+      {
+        const auto erased = m_sets.erase(request.at(ReqName).at("name").as_string());
+        return Response{.rsp = createErrorResponse(RspName, erased ? RequestStatus::Ok : RequestStatus::NotExist)};
+      }
+    }
+
+
+    Response deleteAll(njson& request)
+    {
+      m_sets.clear();
+      return Response{.rsp = createErrorResponse(Cmds::deleteAll.rsp.data(), RequestStatus::Ok)};
+    }
+
+
+    Response exist(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::exist.req.data();
+      static constexpr auto RspName = Cmds::exist.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else
+      {
+        const auto exists = m_sets.contains(request.at(ReqName).at("name").as_string());
+        return Response{.rsp = createErrorResponse(RspName, exists ? RequestStatus::Ok : RequestStatus::NotExist)};
+      }
+    }
+
+
+    // Returns "added", the number of items which weren't already present
+    Response add(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::add.req.data();
+      static constexpr auto RspName = Cmds::add.rsp.data();
+
+      if (const auto status = validateItems<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      if (auto [exist, it] = getSet(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["added"] = it->second.add(toValues(body.at("items")));
+        return response;
+      }
+    }
+
+
+    // Returns "removed", the number of items which were present
+    Response remove(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::remove.req.data();
+      static constexpr auto RspName = Cmds::remove.rsp.data();
+
+      if (const auto status = validateItems<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      if (auto [exist, it] = getSet(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["removed"] = it->second.remove(toValues(body.at("items")));
+        return response;
+      }
+    }
+
+
+    Response contains(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::contains.req.data();
+      static constexpr auto RspName = Cmds::contains.rsp.data();
+
+      if (const auto status = validateItem<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      if (const auto [exist, it] = getSet(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["contains"] = it->second.contains(body.at("item").template as<std::uint64_t>());
+        return response;
+      }
+    }
+
+
+    Response length(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::len.req.data();
+      static constexpr auto RspName = Cmds::len.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else if (const auto [exist, it] = getSet(request.at(ReqName)); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["len"] = it->second.size();
+        return response;
+      }
+    }
+
+
+    // Returns "rank", the number of values less than "item"
+    Response rank(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::rank.req.data();
+      static constexpr auto RspName = Cmds::rank.rsp.data();
+
+      if (const auto status = validateItem<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      if (const auto [exist, it] = getSet(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["rank"] = it->second.rank(body.at("item").template as<std::uint64_t>());
+        return response;
+      }
+    }
+
+
+    // Returns "item", the value at "pos" in ascending order
+    Response select(njson& request)
+    {
+      static constexpr auto RspName = Cmds::select.rsp.data();
+
+      if (const auto status = validateSelect<Cmds>(request) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(Cmds::select.req);
+
+      if (const auto [exist, it] = getSet(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else if (const auto item = it->second.select(body.at("pos").template as<std::size_t>()); !item)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Bounds)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["item"] = *item;
+        return response;
+      }
+    }
+
+
+    // Values at positions [start, stop), or to the end, limited by arrays::maxResponseSize
+    Response getRange(njson& request)
+    {
+      static constexpr auto RspName = Cmds::getRange.rsp.data();
+
+      if (const auto status = validateGetRange<Cmds>(request) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(Cmds::getRange.req);
+      const auto [start, stop, hasStop, hasRng] = rangeFromRequest(body, "rng");
+
+      if (const auto [exist, it] = getSet(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else if (const auto& set = it->second; start >= set.size())
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Bounds)};
+      else
+      {
+        const auto end = std::min(hasStop ? stop : set.size(), start + Settings::get().arrays.maxRspSize);
+
+        njson items = njson::make_array();
+        items.reserve(std::min(end, set.size()) - start);
+        set.forEach(start, end, [&items](const std::uint64_t v){ items.push_back(v); });
+
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["items"] = std::move(items);
+        return response;
+      }
+    }
+
+
+    Response clear(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::clear.req.data();
+      static constexpr auto RspName = Cmds::clear.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else if (auto [exist, it] = getSet(request.at(ReqName)); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        it->second.clear();
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+      }
+    }
+
+
+    Response intersect(njson& request)
+    {
+      return setOperation(request, Cmds::intersect, Operation::Intersect);
+    }
+
+
+    Response unite(njson& request)
+    {
+      return setOperation(request, Cmds::unite, Operation::Union);
+    }
+
+
+    Response symmetricDiff(njson& request)
+    {
+      return setOperation(request, Cmds::symmetricDiff, Operation::Xor);
+    }
+
+
+    Response diff(njson& request)
+    {
+      return setOperation(request, Cmds::diff, Operation::Difference);
+    }
+
+
+    /*
+    INTERSECT, UNION, XOR and DIFF of "srcs". Returns "items", the result's values in ascending
+    order or, with "dest", stores the result in the set "dest" and returns "len", its size.
+    "dest" can be one of "srcs".
+    */
+    template<typename Cmd>
+    Response setOperation(njson& request, const Cmd, const Operation op)
+    {
+      static constexpr auto ReqName = Cmd::req.data();
+      static constexpr auto RspName = Cmd::rsp.data();
+
+      if (const auto status = validateSetOperation<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      std::vector<const Roaring *> sets;
+      sets.reserve(body.at("srcs").size());
+
+      for (const auto& src : body.at("srcs").array_range())
+      {
+        if (const auto it = m_sets.find(src.as_string()); it == m_sets.end())
+          return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+        else
+          sets.push_back(&it->second);
+      }
+
+      auto result = Roaring::apply(op, std::move(sets));
+
+      Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+
+      if (body.contains("dest"))
+      {
+        response.rsp[RspName]["len"] = result.size();
+        m_sets.insert_or_assign(body.at("dest").as_string(), std::move(result));
+      }
+      else
+      {
+        njson items = njson::make_array();
+        items.reserve(result.size());
+        result.forEach(0, result.size(), [&items](const std::uint64_t v){ items.push_back(v); });
+
+        response.rsp[RspName]["items"] = std::move(items);
+      }
+
+      return response;
+    }
+
+
+  private:
+
+    std::tuple<bool, Iterator> getSet (const njson& body)
+    {
+      const auto it = m_sets.find(body.at("name").as_string());
+      return {it != m_sets.end(), it};
+    }
+
+
+  private:
+    Sets m_sets;
+  };
+
+
+  using IntSetHandler = SetHandler<IntSetCmds>;
+}
+}
+
+#endif
@@ -0,0 +1,879 @@
+#ifndef NDB_CORE_ISETROARING_H
+#define NDB_CORE_ISETROARING_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace nemesis { namespace iset {
+
+/*
+A set of uint64 values as a roaring bitmap.
+
+A value's high 48 bits are its key, which selects a container, holding the low 16 bits:
+
+  - array: sorted uint16, 2 bytes per value, for up to 4096 values
+  - bitmap: 1024 uint64 words, 8KB however many of the 65536 values are set
+
+so a container is at most 2 bytes per value, and a dense one as little as 1 bit. A container
+converts when it passes 4096 values, either way. Keys are a sorted vector, binary searched.
+
+Set operations pair containers by key:
+
+  - bitmap with bitmap: a loop over the words which also counts the result. The kernel is
+    selected at runtime, from AVX-512 (with VPOPCNTDQ), AVX2 and scalar, as in ArrSetOps.h
+  - array with array: a merge, as std::set_intersection etc
+  - array with bitmap: tests, sets, clears or flips the array's bits in the bitmap
+
+rank() and select() use the cumulative sizes of containers, rebuilt when first needed after
+a change, so queries following a batch of writes cost O(containers) once.
+*/
+
+
+enum class Operation : std::uint8_t
+{
+  Intersect,
+  Union,
+  Xor,
+  Difference  // values in the first set which aren't in the second (and not)
+};
+
+
+namespace kernels {
+
+
+static constexpr std::size_t Words = 1024U;
+
+
+template<Operation Op>
+inline std::uint64_t combine (const std::uint64_t a, const std::uint64_t b) noexcept
+{
+  if constexpr (Op == Operation::Intersect)
+    return a & b;
+  else if constexpr (Op == Operation::Union)
+    return a | b;
+  else if constexpr (Op == Operation::Xor)
+    return a ^ b;
+  else
+    return a & ~b;
+}
+
+
+// out = a Op b, for Words words, returning the number of bits set in out
+template<Operation Op>
+inline std::uint32_t bitmapScalar (const std::uint64_t * a, const std::uint64_t * b, std::uint64_t * out) noexcept
+{
+  std::uint32_t n = 0;
+
+  for (std::size_t i = 0 ; i < Words ; ++i)
+  {
+    out[i] = combine<Op>(a[i], b[i]);
+    n += std::popcount(out[i]);
+  }
+
+  return n;
+}
+
+
+#if defined(__x86_64__)
+
+template<Operation Op>
+__attribute__((target("avx2,popcnt"))) inline std::uint32_t bitmapAvx2 (const std::uint64_t * a, const std::uint64_t * b, std::uint64_t * out) noexcept
+{
+  std::uint64_t n = 0;
+
+  for (std::size_t i = 0 ; i < Words ; i += 4)
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+    __m256i result;
+
+    if constexpr (Op == Operation::Intersect)
+      result = _mm256_and_si256(va, vb);
+    else if constexpr (Op == Operation::Union)
+      result = _mm256_or_si256(va, vb);
+    else if constexpr (Op == Operation::Xor)
+      result = _mm256_xor_si256(va, vb);
+    else
+      result = _mm256_andnot_si256(vb, va);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), result);
+
+    n += _mm_popcnt_u64(out[i]) + _mm_popcnt_u64(out[i+1]) + _mm_popcnt_u64(out[i+2]) + _mm_popcnt_u64(out[i+3]);
+  }
+
+  return static_cast<std::uint32_t>(n);
+}
+
+
+// GCC 12's avx512fintrin.h has a false -Wmaybe-uninitialized, or -Wuninitialized when less optimised
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+template<Operation Op>
+__attribute__((target("avx512f,avx512vpopcntdq"))) inline std::uint32_t bitmapAvx512 (const std::uint64_t * a, const std::uint64_t * b, std::uint64_t * out) noexcept
+{
+  __m512i counts = _mm512_setzero_si512();
+
+  for (std::size_t i = 0 ; i < Words ; i += 8)
+  {
+    const __m512i va = _mm512_loadu_si512(a + i);
+    const __m512i vb = _mm512_loadu_si512(b + i);
+    __m512i result;
+
+    if constexpr (Op == Operation::Intersect)
+      result = _mm512_and_si512(va, vb);
+    else if constexpr (Op == Operation::Union)
+      result = _mm512_or_si512(va, vb);
+    else if constexpr (Op == Operation::Xor)
+      result = _mm512_xor_si512(va, vb);
+    else
+      result = _mm512_andnot_si512(vb, va);
+
+    _mm512_storeu_si512(out + i, result);
+    counts = _mm512_add_epi64(counts, _mm512_popcnt_epi64(result));
+  }
+
+  return static_cast<std::uint32_t>(_mm512_reduce_add_epi64(counts));
+}
+#pragma GCC diagnostic pop
+
+#endif
+
+
+using BitmapFn = std::uint32_t (*)(const std::uint64_t *, const std::uint64_t *, std::uint64_t *);
+
+
+// indexed by Operation
+struct Kernel
+{
+  std::array<BitmapFn, 4> apply;
+  std::string_view name;
+};
+
+
+inline Kernel selectKernel ()
+{
+  #if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+      return Kernel{.apply = {bitmapAvx512<Operation::Intersect>, bitmapAvx512<Operation::Union>, bitmapAvx512<Operation::Xor>, bitmapAvx512<Operation::Difference>},
+                    .name = "avx512"};
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+      return Kernel{.apply = {bitmapAvx2<Operation::Intersect>, bitmapAvx2<Operation::Union>, bitmapAvx2<Operation::Xor>, bitmapAvx2<Operation::Difference>},
+                    .name = "avx2"};
+  #endif
+
+  return Kernel{.apply = {bitmapScalar<Operation::Intersect>, bitmapScalar<Operation::Union>, bitmapScalar<Operation::Xor>, bitmapScalar<Operation::Difference>},
+                .name = "scalar"};
+}
+
+
+inline const Kernel BitmapKernel = selectKernel();
+
+}
+
+
+// The low 16 bits of values with the same key, as an array or a bitmap
+class Container
+{
+public:
+  static constexpr std::size_t ArrayMax = 4096U;
+  static constexpr std::size_t Words = kernels::Words;
+
+
+  // 'values' must be sorted and unique
+  static Container ofValues (std::vector<std::uint16_t>&& values)
+  {
+    Container container;
+    container.m_size = static_cast<std::uint32_t>(values.size());
+    container.m_values = std::move(values);
+    container.normalize();
+    return container;
+  }
+
+
+  // 'bits' must be Words long
+  static Container ofBits (std::vector<std::uint64_t>&& bits)
+  {
+    Container container;
+    container.m_bits = std::move(bits);
+    container.recount();
+    container.normalize();
+    return container;
+  }
+
+
+  std::uint32_t size() const noexcept
+  {
+    return m_size;
+  }
+
+
+  bool empty() const noexcept
+  {
+    return m_size == 0;
+  }
+
+
+  bool isBitmap() const noexcept
+  {
+    return !m_bits.empty();
+  }
+
+
+  // the array, empty if a bitmap
+  std::span<const std::uint16_t> values() const noexcept
+  {
+    return m_values;
+  }
+
+
+  // the bitmap's words, empty if an array
+  std::span<const std::uint64_t> bits() const noexcept
+  {
+    return m_bits;
+  }
+
+
+  std::size_t memory() const noexcept
+  {
+    return sizeof(Container) + m_values.capacity() * sizeof(std::uint16_t) + m_bits.capacity() * sizeof(std::uint64_t);
+  }
+
+
+  bool contains(const std::uint16_t v) const noexcept
+  {
+    if (isBitmap())
+      return (m_bits[v >> 6] >> (v & 63)) & 1U;
+    else
+      return std::binary_search(m_values.cbegin(), m_values.cend(), v);
+  }
+
+
+  // false if already present
+  bool add(const std::uint16_t v)
+  {
+    if (isBitmap())
+    {
+      auto& word = m_bits[v >> 6];
+      const auto bit = std::uint64_t{1} << (v & 63);
+
+      if (word & bit)
+        return false;
+
+      word |= bit;
+    }
+    else
+    {
+      const auto it = std::lower_bound(m_values.begin(), m_values.end(), v);
+
+      if (it != m_values.end() && *it == v)
+        return false;
+
+      m_values.insert(it, v);
+    }
+
+    ++m_size;
+    normalize();
+    return true;
+  }
+
+
+  // false if not present
+  bool remove(const std::uint16_t v)
+  {
+    if (isBitmap())
+    {
+      auto& word = m_bits[v >> 6];
+      const auto bit = std::uint64_t{1} << (v & 63);
+
+      if (!(word & bit))
+        return false;
+
+      word &= ~bit;
+    }
+    else
+    {
+      const auto it = std::lower_bound(m_values.begin(), m_values.end(), v);
+
+      if (it == m_values.end() || *it != v)
+        return false;
+
+      m_values.erase(it);
+    }
+
+    --m_size;
+    normalize();
+    return true;
+  }
+
+
+  // number of values less than 'v'
+  std::uint32_t rank(const std::uint16_t v) const noexcept
+  {
+    if (!isBitmap())
+      return static_cast<std::uint32_t>(std::distance(m_values.cbegin(), std::lower_bound(m_values.cbegin(), m_values.cend(), v)));
+
+    std::uint32_t n = 0;
+    for (std::size_t w = 0 ; w < (v >> 6) ; ++w)
+      n += std::popcount(m_bits[w]);
+
+    return n + std::popcount(m_bits[v >> 6] & ((std::uint64_t{1} << (v & 63)) - 1));
+  }
+
+
+  // the value at position 'i', which must be less than size()
+  std::uint16_t select(std::uint32_t i) const noexcept
+  {
+    if (!isBitmap())
+      return m_values[i];
+
+    for (std::size_t w = 0 ; ; ++w)
+    {
+      if (const auto n = static_cast<std::uint32_t>(std::popcount(m_bits[w])); i >= n)
+        i -= n;
+      else
+      {
+        auto word = m_bits[w];
+        for ( ; i ; --i)
+          word &= word - 1;
+
+        return static_cast<std::uint16_t>(w * 64 + std::countr_zero(word));
+      }
+    }
+  }
+
+
+  // calls f(v) for 'n' values from position 'start', in order
+  template<typename F>
+  void forEach(std::uint32_t start, std::uint32_t n, F&& f) const
+  {
+    if (!isBitmap())
+    {
+      for (auto i = start ; i < start + n && i < m_size ; ++i)
+        f(m_values[i]);
+
+      return;
+    }
+
+    for (std::size_t w = 0 ; w < Words && n ; ++w)
+    {
+      for (auto word = m_bits[w] ; word && n ; word &= word - 1)
+      {
+        if (start)
+          --start;
+        else
+        {
+          f(static_cast<std::uint16_t>(w * 64 + std::countr_zero(word)));
+          --n;
+        }
+      }
+    }
+  }
+
+
+  static Container apply (const Operation op, const Container& a, const Container& b)
+  {
+    Container result;
+
+    if (a.isBitmap() && b.isBitmap())
+    {
+      result.m_bits.resize(Words);
+      result.m_size = kernels::BitmapKernel.apply[static_cast<std::size_t>(op)](a.m_bits.data(), b.m_bits.data(), result.m_bits.data());
+    }
+    else if (!a.isBitmap() && !b.isBitmap())
+    {
+      // merged into a buffer, so the result is allocated once, to its size, or not at all if empty
+      static thread_local std::vector<std::uint16_t> buffer(ArrayMax * 2);
+
+      const auto [aBegin, aEnd] = std::pair{a.m_values.cbegin(), a.m_values.cend()};
+      const auto [bBegin, bEnd] = std::pair{b.m_values.cbegin(), b.m_values.cend()};
+      auto end = buffer.begin();
+
+      switch (op)
+      {
+        case Operation::Intersect:
+          end = std::set_intersection(aBegin, aEnd, bBegin, bEnd, buffer.begin());
+        break;
+
+        case Operation::Union:
+          end = std::set_union(aBegin, aEnd, bBegin, bEnd, buffer.begin());
+        break;
+
+        case Operation::Xor:
+          end = std::set_symmetric_difference(aBegin, aEnd, bBegin, bEnd, buffer.begin());
+        break;
+
+        case Operation::Difference:
+          end = std::set_difference(aBegin, aEnd, bBegin, bEnd, buffer.begin());
+        break;
+      }
+
+      result.m_values.assign(buffer.begin(), end);
+      result.m_size = static_cast<std::uint32_t>(result.m_values.size());
+    }
+    else
+    {
+      const auto& array = a.isBitmap() ? b : a;
+      const auto& bitmap = a.isBitmap() ? a : b;
+
+      // an array result: the array's values filtered by the bitmap
+      auto filter = [&result, &array, &bitmap](const bool keepIfSet)
+      {
+        result.m_values.reserve(array.m_size);
+        std::copy_if(array.m_values.cbegin(), array.m_values.cend(), std::back_inserter(result.m_values), [&bitmap, keepIfSet](const std::uint16_t v)
+        {
+          return bitmap.contains(v) == keepIfSet;
+        });
+        result.m_size = static_cast<std::uint32_t>(result.m_values.size());
+      };
+
+      // a bitmap result: the bitmap with each of the array's bits changed by 'change(word, bit)'
+      auto modify = [&result, &array, &bitmap](auto&& change)
+      {
+        result.m_bits = bitmap.m_bits;
+
+        for (const auto v : array.m_values)
+          change(result.m_bits[v >> 6], std::uint64_t{1} << (v & 63));
+
+        result.recount();
+      };
+
+      switch (op)
+      {
+        case Operation::Intersect:
+          filter(true);
+        break;
+
+        case Operation::Union:
+          modify([](std::uint64_t& word, const std::uint64_t bit){ word |= bit; });
+        break;
+
+        case Operation::Xor:
+          modify([](std::uint64_t& word, const std::uint64_t bit){ word ^= bit; });
+        break;
+
+        case Operation::Difference:
+          if (a.isBitmap())
+            modify([](std::uint64_t& word, const std::uint64_t bit){ word &= ~bit; });
+          else
+            filter(false);
+        break;
+      }
+    }
+
+    result.normalize();
+    return result;
+  }
+
+
+private:
+
+  void recount() noexcept
+  {
+    m_size = 0;
+    for (const auto word : m_bits)
+      m_size += std::popcount(word);
+  }
+
+
+  // an array above ArrayMax becomes a bitmap, a bitmap at or below becomes an array
+  void normalize()
+  {
+    if (isBitmap() && m_size <= ArrayMax)
+    {
+      std::vector<std::uint16_t> values;
+      values.reserve(m_size);
+      forEach(0, m_size, [&values](const std::uint16_t v){ values.push_back(v); });
+
+      m_values = std::move(values);
+      m_bits = std::vector<std::uint64_t>{};
+    }
+    else if (!isBitmap() && m_size > ArrayMax)
+    {
+      m_bits.assign(Words, 0);
+
+      for (const auto v : m_values)
+        m_bits[v >> 6] |= std::uint64_t{1} << (v & 63);
+
+      m_values = std::vector<std::uint16_t>{};
+    }
+  }
+
+
+private:
+  std::vector<std::uint16_t> m_values;  // array
+  std::vector<std::uint64_t> m_bits;    // bitmap, Words long, or empty
+  std::uint32_t m_size{0};
+};
+
+
+class Roaring
+{
+public:
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+
+  bool empty() const noexcept
+  {
+    return m_size == 0;
+  }
+
+
+  // Bytes allocated for keys and containers, excluding the allocator's overhead
+  std::size_t memory() const noexcept
+  {
+    std::size_t bytes = m_keys.capacity() * sizeof(std::uint64_t) + (m_containers.capacity() - m_containers.size()) * sizeof(Container);
+
+    for (const auto& container : m_containers)
+      bytes += container.memory();
+
+    return bytes;
+  }
+
+
+  std::size_t containers() const noexcept
+  {
+    return m_keys.size();
+  }
+
+
+  std::uint64_t key(const std::size_t i) const noexcept
+  {
+    return m_keys[i];
+  }
+
+
+  const Container& container(const std::size_t i) const noexcept
+  {
+    return m_containers[i];
+  }
+
+
+  bool contains(const std::uint64_t v) const noexcept
+  {
+    const auto i = find(v >> 16);
+    return i < m_keys.size() && m_keys[i] == (v >> 16) && m_containers[i].contains(low(v));
+  }
+
+
+  // false if already present
+  bool add(const std::uint64_t v)
+  {
+    const auto i = findOrInsert(v >> 16);
+
+    if (!m_containers[i].add(low(v)))
+      return false;
+
+    ++m_size;
+    m_ranksValid = false;
+    return true;
+  }
+
+
+  // false if not present
+  bool remove(const std::uint64_t v)
+  {
+    const auto i = find(v >> 16);
+
+    if (i == m_keys.size() || m_keys[i] != (v >> 16) || !m_containers[i].remove(low(v)))
+      return false;
+
+    if (m_containers[i].empty())
+      erase(i);
+
+    --m_size;
+    m_ranksValid = false;
+    return true;
+  }
+
+
+  // Adds 'values', in any order, returning the number which weren't present. Values with the same key
+  // are combined with the container as a union, rather than inserted individually.
+  std::size_t add(std::vector<std::uint64_t> values)
+  {
+    return change(std::move(values), Operation::Union);
+  }
+
+
+  // Removes 'values', returning the number which were present
+  std::size_t remove(std::vector<std::uint64_t> values)
+  {
+    return change(std::move(values), Operation::Difference);
+  }
+
+
+  // number of values less than 'v'
+  std::size_t rank(const std::uint64_t v) const
+  {
+    buildRanks();
+
+    const auto i = find(v >> 16);
+    const std::size_t before = m_ranks[i];
+
+    return i < m_keys.size() && m_keys[i] == (v >> 16) ? before + m_containers[i].rank(low(v)) : before;
+  }
+
+
+  // the value at position 'pos' in ascending order, none if pos >= size()
+  std::optional<std::uint64_t> select(const std::size_t pos) const
+  {
+    if (pos >= m_size)
+      return std::nullopt;
+
+    const auto [i, offset] = locate(pos);
+    return (m_keys[i] << 16) | m_containers[i].select(static_cast<std::uint32_t>(offset));
+  }
+
+
+  // calls f(v) for values at positions [start, stop), in ascending order
+  template<typename F>
+  void forEach(const std::size_t start, std::size_t stop, F&& f) const
+  {
+    stop = std::min(stop, m_size);
+
+    if (start >= stop)
+      return;
+
+    auto [i, offset] = locate(start);
+
+    for (std::size_t n = stop - start ; n ; ++i, offset = 0)
+    {
+      const auto& container = m_containers[i];
+      const auto count = std::min<std::size_t>(n, container.size() - offset);
+      const auto high = m_keys[i] << 16;
+
+      container.forEach(static_cast<std::uint32_t>(offset), static_cast<std::uint32_t>(count), [&f, high](const std::uint16_t v){ f(high | v); });
+      n -= count;
+    }
+  }
+
+
+  void clear()
+  {
+    m_keys.clear();
+    m_containers.clear();
+    m_size = 0;
+    m_ranksValid = false;
+  }
+
+
+  // Used when loading: 'key' must be greater than those already restored
+  void restore(const std::uint64_t key, Container&& container)
+  {
+    if (container.empty())
+      return;
+
+    m_size += container.size();
+    m_keys.push_back(key);
+    m_containers.push_back(std::move(container));
+    m_ranksValid = false;
+  }
+
+
+  static Roaring apply (const Operation op, const Roaring& a, const Roaring& b)
+  {
+    Roaring result;
+
+    auto append = [&result](const std::uint64_t key, Container&& container)
+    {
+      result.restore(key, std::move(container));
+    };
+
+    if (op != Operation::Intersect)
+    {
+      const auto n = op == Operation::Difference ? a.m_keys.size() : a.m_keys.size() + b.m_keys.size();
+      result.m_keys.reserve(n);
+      result.m_containers.reserve(n);
+    }
+
+    std::size_t i = 0, j = 0;
+
+    while (i < a.m_keys.size() && j < b.m_keys.size())
+    {
+      if (a.m_keys[i] < b.m_keys[j])
+      {
+        if (op != Operation::Intersect)
+          append(a.m_keys[i], Container{a.m_containers[i]});
+        ++i;
+      }
+      else if (b.m_keys[j] < a.m_keys[i])
+      {
+        if (op == Operation::Union || op == Operation::Xor)
+          append(b.m_keys[j], Container{b.m_containers[j]});
+        ++j;
+      }
+      else
+      {
+        append(a.m_keys[i], Container::apply(op, a.m_containers[i], b.m_containers[j]));
+        ++i;
+        ++j;
+      }
+    }
+
+    for ( ; i < a.m_keys.size() && op != Operation::Intersect ; ++i)
+      append(a.m_keys[i], Container{a.m_containers[i]});
+
+    for ( ; j < b.m_keys.size() && (op == Operation::Union || op == Operation::Xor) ; ++j)
+      append(b.m_keys[j], Container{b.m_containers[j]});
+
+    return result;
+  }
+
+
+  /*
+  'op' over two or more sets, left to right: the first set without values in the others for
+  Difference, values in an odd number of sets for Xor. Intersect starts with the smallest
+  sets, and stops if the result is empty.
+  */
+  static Roaring apply (const Operation op, std::vector<const Roaring *> sets)
+  {
+    if (op == Operation::Intersect)
+      std::sort(sets.begin(), sets.end(), [](const Roaring * a, const Roaring * b){ return a->size() < b->size(); });
+
+    Roaring result = apply(op, *sets[0], *sets[1]);
+
+    for (std::size_t i = 2 ; i < sets.size() && !(op == Operation::Intersect && result.empty()) ; ++i)
+      result = apply(op, result, *sets[i]);
+
+    return result;
+  }
+
+
+private:
+
+  static std::uint16_t low(const std::uint64_t v) noexcept
+  {
+    return static_cast<std::uint16_t>(v & 0xFFFF);
+  }
+
+
+  // position of the first key not less than 'key'
+  std::size_t find(const std::uint64_t key) const noexcept
+  {
+    return std::distance(m_keys.cbegin(), std::lower_bound(m_keys.cbegin(), m_keys.cend(), key));
+  }
+
+
+  std::size_t findOrInsert(const std::uint64_t key)
+  {
+    const auto i = find(key);
+
+    if (i == m_keys.size() || m_keys[i] != key)
+    {
+      m_keys.insert(std::next(m_keys.begin(), i), key);
+      m_containers.insert(std::next(m_containers.begin(), i), Container{});
+    }
+
+    return i;
+  }
+
+
+  void erase(const std::size_t i)
+  {
+    m_keys.erase(std::next(m_keys.begin(), i));
+    m_containers.erase(std::next(m_containers.begin(), i));
+  }
+
+
+  // Union or Difference of the container of each key in 'values' with those values
+  std::size_t change(std::vector<std::uint64_t> values, const Operation op)
+  {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    const auto before = m_size;
+
+    for (auto it = values.cbegin() ; it != values.cend() ; )
+    {
+      const auto key = *it >> 16;
+      const auto itEnd = std::find_if(it, values.cend(), [key](const std::uint64_t v){ return (v >> 16) != key; });
+
+      std::vector<std::uint16_t> lows;
+      lows.reserve(std::distance(it, itEnd));
+      std::transform(it, itEnd, std::back_inserter(lows), low);
+
+      const auto changes = Container::ofValues(std::move(lows));
+      const auto i = find(key);
+
+      if (i < m_keys.size() && m_keys[i] == key)
+      {
+        auto& container = m_containers[i];
+
+        m_size -= container.size();
+        container = Container::apply(op, container, changes);
+        m_size += container.size();
+
+        if (container.empty())
+          erase(i);
+      }
+      else if (op == Operation::Union)
+      {
+        m_size += changes.size();
+        m_keys.insert(std::next(m_keys.begin(), i), key);
+        m_containers.insert(std::next(m_containers.begin(), i), std::move(changes));
+      }
+
+      it = itEnd;
+    }
+
+    m_ranksValid = false;
+    return op == Operation::Union ? m_size - before : before - m_size;
+  }
+
+
+  // m_ranks[i] is the number of values in containers before i
+  void buildRanks() const
+  {
+    if (m_ranksValid)
+      return;
+
+    m_ranks.resize(m_containers.size() + 1);
+    m_ranks[0] = 0;
+
+    for (std::size_t i = 0 ; i < m_containers.size() ; ++i)
+      m_ranks[i+1] = m_ranks[i] + m_containers[i].size();
+
+    m_ranksValid = true;
+  }
+
+
+  // the container of position 'pos', which must be less than size(), and the position within it
+  std::pair<std::size_t, std::size_t> locate(const std::size_t pos) const
+  {
+    buildRanks();
+
+    const auto i = std::distance(m_ranks.cbegin(), std::upper_bound(m_ranks.cbegin(), m_ranks.cend(), pos)) - 1;
+    return {i, pos - m_ranks[i]};
+  }
+
+
+private:
+  std::vector<std::uint64_t> m_keys;
+  std::vector<Container> m_containers;
+  std::size_t m_size{0};
+  mutable std::vector<std::uint64_t> m_ranks;
+  mutable bool m_ranksValid{false};
+};
+
+}
+}
+
+#endif
@@ -53,7 +53,10 @@ namespace nemesis { namespace kv {
 
   static RequestStatus validateSave(const njson& req)
   {
-    return isValid(kv::cmds::SaveRsp, req.at(kv::cmds::SaveReq), {{Param::required("name", JsonString)}});
+    return isValid(kv::cmds::SaveRsp, req.at(kv::cmds::SaveReq), {{Param::required("name", JsonString)},
+                                                                  {Param::optional("bg", JsonBool)},
+                                                                  {Param::optional("delta", JsonBool)},
+                                                                  {Param::optional("mmap", JsonBool)}});
   }
 
 
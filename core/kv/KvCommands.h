@@ -26,6 +26,8 @@ namespace nemesis { namespace kv { namespace cmds {
   const char ClearSetRsp[]    = "KV_CLEAR_SET_RSP";
   const char SaveReq[]        = "KV_SAVE";
   const char SaveRsp[]        = "KV_SAVE_RSP";
+  const char SaveStatusReq[]  = "KV_SAVE_STATUS";
+  const char SaveStatusRsp[]  = "KV_SAVE_STATUS_RSP";
   const char LoadReq[]        = "KV_LOAD";
   const char LoadRsp[]        = "KV_LOAD_RSP";
 }
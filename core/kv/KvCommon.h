@@ -27,6 +27,7 @@ namespace nemesis {  namespace kv {
     KvKeys,
     KvClearSet,
     KvSave,
+    KvSaveStatus,
     KvLoad,
     KvArrayAppend,
     InternalSessionMonitor,
@@ -3,8 +3,11 @@
 
 #include <functional>
 #include <string_view>
+#include <jsoncons_ext/cbor/cbor.hpp>
 #include <core/NemesisCommon.h>
 #include <core/CacheMap.h>
+#include <core/Snapshot.h>
+#include <core/ThreadPool.h>
 #include <core/kv/KvCommon.h>
 #include <core/kv/KvCommands.h>
 
@@ -88,7 +91,7 @@ public:
   }
 
 
-  static Response get (const CacheMap& map,  const njson& cmd)
+  static Response get (CacheMap& map,  const njson& cmd)
   {
     using Rsp = KvOnlyMeta<kvcmds::GetRsp>;
 
@@ -274,67 +277,142 @@ public:
   }
 
 
-  static Response saveKv (const CacheMap& map, const fs::path& path, const std::string_view name)
+  // progress is optional, incremented as keys are written (used by background saves)
+  static Response saveKv (const CacheMap& map, const fs::path& path, const snapshot::Codec codec, const std::string_view name, std::atomic_uint64_t * progress = nullptr)
   {
-    static const std::streamoff MaxDataFileSize = 10U * 1024U * 1024U;
+    return save(name, [&]()
+    {
+      if (!fs::create_directories(path))
+        return RequestStatus::SaveError;
 
-    auto start = NemesisClock::now();
+      snapshot::SnapshotWriter writer{path, codec};
+      std::vector<std::uint8_t> buffer;
 
-    RequestStatus status = RequestStatus::SaveComplete;
+      for(const auto& [k, v] : map.map())
+        putKv(writer, buffer, k, v, progress);
 
-    Response response;
-    response.rsp[kvcmds::SaveRsp]["name"] = name;
+      // not yet decoded from a mapped snapshot, already CBOR
+      map.forEachMapped([&](const std::string_view key, const std::span<const std::uint8_t> value)
+      {
+        writer.putString(key);
+        writer.putBlob(value);
+        writer.endRecord();
+      });
 
-    try
+      writer.close();
+
+      if (progress)
+        progress->store(writer.nRecords());
+
+      return RequestStatus::SaveComplete;
+    });
+  }
+
+
+  // Writes one file in the memory mapped layout (MmapSnapshot.h), which a load can map
+  // rather than decode. Not compressed, values are used in place.
+  static Response saveKvMmap (const CacheMap& map, const fs::path& path, const std::string_view name, std::atomic_uint64_t * progress = nullptr)
+  {
+    return save(name, [&]()
     {
       if (!fs::create_directories(path))
-        status = RequestStatus::SaveError;
-      else
+        return RequestStatus::SaveError;
+
+      snapshot::MmapWriter writer{path / "kv.mmap", map.count()};
+      std::vector<std::uint8_t> buffer;
+
+      auto onAdded = [&writer, progress]()
       {
-        std::string buffer; // vector<char> ?
-        buffer.reserve(MaxDataFileSize);
-
-        std::stringstream sstream{buffer};
-        std::size_t nFiles = 0;
-        
-        bool first = true;
-
-        for(const auto& [k, v] : map.map())
-        {   
-          if (!first)
-            sstream << ',';
-
-          first = false;
-
-          sstream << '"' << k << "\":" << v.to_string();
-          
-          if (sstream.tellp() >= MaxDataFileSize)
-          {
-            flushKvBuffer(path / std::to_string(nFiles), sstream);
-            ++nFiles;
-            first = true;
-          }         
-        }
+        if (progress && (writer.nRecords() % 1024U) == 0)
+          progress->store(writer.nRecords(), std::memory_order_relaxed);
+      };
 
-        // leftovers that didn't reach the file size
-        if (sstream.tellp() > 0)
-          flushKvBuffer(path / std::to_string(nFiles), sstream);
+      for(const auto& [k, v] : map.map())
+      {
+        buffer.clear();
+        jsoncons::cbor::encode_cbor(v, buffer);
+        writer.add(k, buffer);
+        onAdded();
       }
-    }
-    catch(const std::exception& e)
+
+      map.forEachMapped([&](const std::string_view key, const std::span<const std::uint8_t> value)
+      {
+        writer.add(key, value);
+        onAdded();
+      });
+
+      writer.close();
+
+      if (progress)
+        progress->store(writer.nRecords());
+
+      return RequestStatus::SaveComplete;
+    });
+  }
+
+
+  // Writes keys changed since the previous save to 'path', and removed keys to 'removedPath'.
+  static Response saveKvDelta ( const CacheMap& map, const CacheMap::Changes& changes, const fs::path& path, const fs::path& removedPath,
+                                const snapshot::Codec codec, const std::string_view name, std::atomic_uint64_t * progress = nullptr)
+  {
+    return save(name, [&]()
     {
-      status = RequestStatus::SaveError;
-    }
-    
+      if (!fs::create_directories(path) || !fs::create_directories(removedPath))
+        return RequestStatus::SaveError;
 
-    response.rsp[kvcmds::SaveRsp]["st"] = toUnderlying(status);
-    response.rsp[kvcmds::SaveRsp]["duration"] = chrono::duration_cast<chrono::milliseconds>(NemesisClock::now() - start).count();
+      snapshot::SnapshotWriter writer{path, codec};
+      std::vector<std::uint8_t> buffer;
 
-    return response;
+      for(const auto& k : changes.changed)
+      {
+        // a changed key is always in the map, never only mapped
+        if (const auto it = map.map().find(k); it != map.map().cend())
+          putKv(writer, buffer, k, it->second, progress);
+      }
+
+      writer.close();
+
+      snapshot::SnapshotWriter removedWriter{removedPath, codec};
+
+      for(const auto& k : changes.removed)
+      {
+        removedWriter.putString(k);
+        removedWriter.endRecord();
+      }
+
+      removedWriter.close();
+
+      if (progress)
+        progress->store(writer.nRecords());
+
+      return RequestStatus::SaveComplete;
+    });
+  }
+
+
+  // Removes keys listed in a delta save's removed files, returns the number removed
+  static std::size_t loadRemoved (CacheMap& map, const fs::path& removedRoot)
+  {
+    std::size_t nRemoved{0};
+
+    for (const auto& file : fs::directory_iterator{removedRoot})
+    {
+      snapshot::SnapshotReader reader{file.path()};
+
+      while (reader.nextBlock())
+      {
+        for (std::uint32_t i = 0 ; i < reader.blockRecords() ; ++i, ++nRemoved)
+          map.remove(cachedkey{reader.getString()});
+      }
+    }
+
+    return nRemoved;
   }
 
 
-  static Response loadKv (const std::string& loadName, CacheMap& map, const fs::path& dataRoot)
+  // Data files are read and decoded on a thread pool, each worker producing a batch per block.
+  // The batches are merged into the map on the calling thread, which runs concurrently with the workers.
+  static Response loadKv (const std::string& loadName, CacheMap& map, const fs::path& dataRoot, const std::size_t nKeysHint = 0)
   {
     RequestStatus status{RequestStatus::Loading};
     std::size_t nKeys{0};
@@ -350,12 +428,24 @@ public:
     {      
       const auto start = NemesisClock::now();
 
+      std::vector<fs::path> files;
       for (const auto& kvFile : fs::directory_iterator{dataRoot})
+        files.emplace_back(kvFile.path());
+
+      if (files.size() == 1U && map.count() == 0 && snapshot::MmapSnapshot::isMmapFile(files[0]))
       {
-        status = readKvFile(map, kvFile.path(), nKeys);
-        
-        if (status == RequestStatus::LoadError)
-          break;
+        // values are decoded when accessed or prefetched
+        map.attach(std::make_unique<snapshot::MmapSnapshot>(files[0]));
+        nKeys = map.count();
+        status = RequestStatus::LoadComplete;
+        PLOGI << "Mapped " << nKeys << " keys from " << files[0];
+      }
+      else
+      {
+        if (nKeysHint)
+          map.reserve(map.count() + nKeysHint);
+
+        status = readKvFiles(map, files, nKeys);
       }
 
       response.rsp[kvcmds::LoadRsp]["duration"] = chrono::duration_cast<chrono::milliseconds>(NemesisClock::now() - start).count();
@@ -375,17 +465,180 @@ public:
 
 private:
 
-  static void flushKvBuffer (const fs::path& path, std::stringstream& sstream)
+  template<typename WriteF>
+  static Response save (const std::string_view name, WriteF&& write)
   {
-    std::ofstream dataStream {path};
-    dataStream << "{ \"keys\":{" << sstream.str() << "}}";
+    const auto start = NemesisClock::now();
 
-    sstream.clear();
-    sstream.str(std::string{});
+    RequestStatus status = RequestStatus::SaveComplete;
+
+    // may run in a forked child, which must not log, so the caller logs a failure
+    try
+    {
+      status = write();
+    }
+    catch(const std::exception&)
+    {
+      status = RequestStatus::SaveError;
+    }
+
+    Response response;
+    response.rsp[kvcmds::SaveRsp]["name"] = name;
+    response.rsp[kvcmds::SaveRsp]["st"] = toUnderlying(status);
+    response.rsp[kvcmds::SaveRsp]["duration"] = chrono::duration_cast<chrono::milliseconds>(NemesisClock::now() - start).count();
+
+    return response;
   }
 
 
-  static RequestStatus readKvFile (CacheMap& map, const fs::path path, std::size_t& nKeys)
+  static void putKv (snapshot::SnapshotWriter& writer, std::vector<std::uint8_t>& buffer, const cachedkey& key, const cachedvalue& value, std::atomic_uint64_t * progress)
+  {
+    buffer.clear();
+    jsoncons::cbor::encode_cbor(value, buffer);
+
+    writer.putString(key);
+    writer.putBlob(buffer);
+    writer.endRecord();
+
+    if (progress && (writer.nRecords() % 1024U) == 0)
+      progress->store(writer.nRecords(), std::memory_order_relaxed);
+  }
+
+
+  using KvBatch = std::vector<std::pair<cachedkey, cachedvalue>>;
+  using KvBatchQueue = BoundedQueue<KvBatch>;
+
+
+  static RequestStatus readKvFiles (CacheMap& map, const std::vector<fs::path>& files, std::size_t& nKeys)
+  {
+    if (files.empty())
+      return RequestStatus::LoadComplete;
+
+    const std::size_t nWorkers = std::min<std::size_t>(files.size(), ThreadPool::defaultSize());
+
+    std::atomic_size_t nextFile{0};
+    std::atomic_bool failed{false};
+    KvBatchQueue queue {nWorkers * 4U, nWorkers};
+    ThreadPool pool {nWorkers};
+
+    PLOGD << "Loading " << files.size() << " files with " << nWorkers << " threads";
+
+    for (std::size_t i = 0 ; i < nWorkers ; ++i)
+    {
+      pool.submit([&]
+      {
+        for (auto f = nextFile++ ; f < files.size() && !failed ; f = nextFile++)
+        {
+          if (readKvFile(files[f], queue) != RequestStatus::LoadComplete)
+            failed = true;
+        }
+
+        queue.producerDone();
+      });
+    }
+
+    // merge
+    try
+    {
+      KvBatch batch;
+      while (queue.pop(batch))
+      {
+        nKeys += batch.size();
+
+        for (auto& [key, value] : batch)
+          map.set(std::move(key), std::move(value));
+      }
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << e.what();
+      failed = true;
+      queue.close(); // release workers waiting on a full queue
+    }
+    
+    return failed ? RequestStatus::LoadError : RequestStatus::LoadComplete;
+  }
+
+
+  static RequestStatus readKvFile (const fs::path& path, KvBatchQueue& queue)
+  {
+    // saves before the binary format are JSON
+    if (snapshot::MmapSnapshot::isMmapFile(path))
+      return readMmapKvFile(path, queue);
+    else if (!snapshot::SnapshotReader::isSnapshotFile(path))
+      return readJsonKvFile(path, queue);
+
+    RequestStatus status = RequestStatus::LoadComplete;
+
+    try
+    {
+      snapshot::SnapshotReader reader{path};
+
+      while (reader.nextBlock())
+      {
+        KvBatch batch;
+        batch.reserve(reader.blockRecords());
+
+        for (std::uint32_t i = 0 ; i < reader.blockRecords() ; ++i)
+        {
+          cachedkey key {reader.getString()};
+          const auto value = reader.getBlob();
+
+          batch.emplace_back(std::move(key), jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{value.data(), value.size()}));
+        }
+
+        if (!queue.push(std::move(batch)))
+          break;  // consumer failed
+      }
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << path << " : " << e.what();
+      status = RequestStatus::LoadError;
+    }
+    
+    return status;
+  }
+
+
+  // A mapped file loaded into a map which isn't empty, so decoded now
+  static RequestStatus readMmapKvFile (const fs::path& path, KvBatchQueue& queue)
+  {
+    static const std::size_t BatchSize = 4096U;
+
+    RequestStatus status = RequestStatus::LoadComplete;
+
+    try
+    {
+      snapshot::MmapSnapshot mapped{path};
+      KvBatch batch;
+
+      for (std::size_t slot = 0 ; slot < mapped.nSlots() ; ++slot)
+      {
+        if (mapped.isUsed(slot))
+        {
+          const auto record = mapped.record(slot);
+          batch.emplace_back(cachedkey{record.key}, jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{record.value.data(), record.value.size()}));
+
+          if (batch.size() == BatchSize && !queue.push(std::exchange(batch, KvBatch{})))
+            return status; // consumer failed
+        }
+      }
+
+      if (!batch.empty())
+        queue.push(std::move(batch));
+    }
+    catch(const std::exception& e)
+    {
+      PLOGE << path << " : " << e.what();
+      status = RequestStatus::LoadError;
+    }
+
+    return status;
+  }
+
+
+  static RequestStatus readJsonKvFile (const fs::path& path, KvBatchQueue& queue)
   {
     RequestStatus status = RequestStatus::LoadComplete;
 
@@ -395,11 +648,13 @@ private:
       
       if (const auto root = njson::parse(dataStream); root.is_object() && root.contains("keys") && root.at("keys").is_object())
       {
+        KvBatch batch;
+        batch.reserve(root.at("keys").size());
+
         for (const auto& item : root.at("keys").object_range())
-        {
-          map.set(item.key(), item.value());
-          ++nKeys;
-        }
+          batch.emplace_back(item.key(), item.value());
+
+        queue.push(std::move(batch));
       }      
     }
     catch(const std::exception& e)
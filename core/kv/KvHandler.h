@@ -8,6 +8,7 @@
 #include <core/NemesisCommon.h>
 #include <core/Persistance.h>
 #include <core/NemesisConfig.h>
+#include <core/ForkTask.h>
 #include <core/kv/KvCommon.h>
 #include <core/kv/KvExecutor.h>
 #include <core/kv/KvCommandValidate.h>
@@ -35,6 +36,13 @@ public:
 
 private:
 
+  struct DeltaBase
+  {
+    std::string name;
+    std::string dir;        // timestamp directory
+    std::size_t length{0};  // number of deltas since the last full save
+  };
+
   using HandlerPmrMap = ankerl::unordered_dense::pmr::map<KvQueryType, Handler>;
   using QueryTypePmrMap = ankerl::unordered_dense::pmr::map<std::string_view, KvQueryType>;
 
@@ -46,6 +54,7 @@ private:
     HandlerPmrMap h (
     {
       {KvQueryType::KvSave,         Handler{std::bind_front(&KvHandler::save,         std::ref(*this))}},
+      {KvQueryType::KvSaveStatus,   Handler{std::bind_front(&KvHandler::saveStatus,   std::ref(*this))}},
       {KvQueryType::KvLoad,         Handler{std::bind_front(&KvHandler::load,         std::ref(*this))}},
     }, 1, alloc);
     
@@ -152,6 +161,7 @@ private:
       {KeysReq,         KvQueryType::KvKeys},
       {ClearSetReq,     KvQueryType::KvClearSet},
       {SaveReq,         KvQueryType::KvSave},
+      {SaveStatusReq,   KvQueryType::KvSaveStatus},
       {LoadReq,         KvQueryType::KvLoad}
     }, 1, alloc); 
 
@@ -199,12 +209,12 @@ public:
   
 
   // Called when loading at startup
-  LoadResult internalLoad(const std::string& loadName, const fs::path& dataSetsRoot)
+  LoadResult internalLoad(const std::string& loadName, const PreLoadInfo& info)
   {
     const auto start = NemesisClock::now();
     
     // call doLoad(), which is used by KV_LOAD, grabbing from the rsp
-    const njson rsp = doLoad(loadName, dataSetsRoot);
+    const njson rsp = doLoad(loadName, info);
 
     LoadResult loadResult;
     loadResult.duration = NemesisClock::now() - start;
@@ -216,6 +226,127 @@ public:
   }
 
 
+  // Called before the server starts
+  void addPersister (Persister persister)
+  {
+    m_persisters.emplace_back(std::move(persister));
+  }
+
+
+  // Writes all data for a hot restart, in a forked child. Keys use the mapped layout so the
+  // new process can attach rather than decode. Not compressed: the directory is in memory.
+  bool saveHandoff (const fs::path& dir, ForkTask::Progress& progress) const
+  {
+    progress.total = m_map.count();
+
+    const auto rsp = KvExecutor::saveKvMmap(m_map, dir / "data", "handoff", &progress.done).rsp;
+
+    return rsp.at(SaveRsp).at("st") == toUnderlying(RequestStatus::SaveComplete) && savePersisters(dir, snapshot::Codec::None);
+  }
+
+
+  // Loads data written by saveHandoff(), called before the server starts
+  bool loadHandoff (const fs::path& dir)
+  {
+    std::vector<std::future<std::size_t>> persisterLoads;
+    ThreadPool pool {std::max<std::size_t>(1U, m_persisters.size())};
+
+    for (const auto& persister : m_persisters)
+      persisterLoads.emplace_back(pool.submit([&persister, &dir]{ return persister.load(dir / persister.dir); }));
+
+    const auto rsp = KvExecutor::loadKv("handoff", m_map, dir / "data").rsp;
+    bool loaded = rsp[LoadRsp]["st"] == toUnderlying(RequestStatus::LoadComplete);
+
+    for (std::size_t i = 0 ; i < persisterLoads.size() ; ++i)
+    {
+      try
+      {
+        persisterLoads[i].get();
+      }
+      catch (const std::exception& ex)
+      {
+        PLOGE << m_persisters[i].dir << " : " << ex.what();
+        loaded = false;
+      }
+    }
+
+    return loaded;
+  }
+
+
+  // Decodes up to 'n' keys from a mapped snapshot, returns true if more remain
+  bool prefetch (const std::size_t n)
+  {
+    return m_map.prefetch(n);
+  }
+
+
+  // Emits KV_SET requests which recreate the keys, used by WAL compaction
+  void dump (const std::function<void(const njson&)>& emit) const
+  {
+    static const std::size_t BatchSize = 1024U;
+
+    njson keys = njson::object();
+
+    auto emitKeys = [&emit, &keys]()
+    {
+      njson request;
+      request[SetReq]["keys"] = std::move(keys);
+      emit(request);
+      keys = njson::object();
+    };
+
+    for (const auto& [key, value] : m_map.map())
+    {
+      keys.try_emplace(key, value);
+
+      if (keys.size() == BatchSize)
+        emitKeys();
+    }
+
+    m_map.forEachMapped([&](const std::string_view key, const std::span<const std::uint8_t> value)
+    {
+      keys.try_emplace(cachedkey{key}, jsoncons::cbor::decode_cbor<njson>(jsoncons::byte_string_view{value.data(), value.size()}));
+
+      if (keys.size() == BatchSize)
+        emitKeys();
+    });
+
+    if (!keys.empty())
+      emitKeys();
+  }
+
+
+  bool contains (const cachedkey& key) const
+  {
+    return m_map.contains(key);
+  }
+
+
+  // Used by cluster slot migration. Checks up to 'maxScan' map positions below 'cursor', from the
+  // end, adding keys for which include(key) is true to 'keys', until there are 'maxKeys'. Returns
+  // the new cursor, 0 when all positions are checked; start with the max size_t.
+  // Scanning from the end means removing scanned keys, which moves the last key into the
+  // removed key's position, doesn't skip keys. Mapped keys must be prefetched first, so until
+  // then the cursor is returned unchanged.
+  std::size_t scanKeys (std::size_t cursor, const std::function<bool(std::string_view)>& include, njson& keys, const std::size_t maxKeys, const std::size_t maxScan) const
+  {
+    if (m_map.isMapped())
+      return cursor;
+
+    const auto& values = m_map.map().values();
+    cursor = std::min(cursor, values.size());
+
+    for (std::size_t scanned = 0 ; cursor && scanned < maxScan && keys.size() < maxKeys ; ++scanned)
+    {
+      if (const auto& [key, value] = values[--cursor]; include(key))
+        keys.try_emplace(key, value);
+    }
+
+    return cursor;
+  }
+
+
 private:
     
   Response validateAndExecute(const std::map<KvQueryType, ValidateExecute>::const_iterator it, const njson& request, const std::string_view reqName, const std::string_view rspName)
@@ -264,10 +395,7 @@ private:
         return response;
       }
       else
-      {
-        const auto [root, md, data, pathsValid] = getLoadPaths(fs::path{m_settings.persistPath} / loadName);        
-        return Response {.rsp = doLoad(loadName, data)};
-      }
+        return Response {.rsp = doLoad(loadName, info)};
     }
   }
   
@@ -275,58 +403,306 @@ private:
   Response doSave (const std::string_view queryRspName, njson& cmd)
   {
     const auto& name = cmd.at("name").as_string();
+    const bool background = cmd.contains("bg") && cmd.at("bg").as_bool();
+    const bool deltaRequested = cmd.contains("delta") && cmd.at("delta").as_bool();
+    const bool mmap = cmd.contains("mmap") && cmd.at("mmap").as_bool();
     const auto dataSetDir = std::to_string(KvSaveClock::now().time_since_epoch().count());
     const auto root = fs::path {m_settings.persistPath} / name / dataSetDir;
-    const auto metaPath = root / "md";
-    const auto dataPath = root / "data";
     
 
-    if (auto [preparedStatus, metaStream] = prepareSave(cmd, root); preparedStatus != RequestStatus::Ok)
+    if (background && pollBackgroundSave() == ForkTask::State::Running)
+    {
+      return Response{.rsp = createErrorResponse(queryRspName, RequestStatus::SaveInProgress)};
+    }
+    else if (auto [preparedStatus, metaStream] = prepareSave(cmd, root); preparedStatus != RequestStatus::Ok)
     {
       return Response{.rsp = createErrorResponse(queryRspName, preparedStatus)};
     }
     else
     {
       auto metaData = createInitialSaveMetaData(metaStream, name, false);
-      
-      KvSaveStatus metaDataStatus = KvSaveStatus::Pending;
-      Response response;
+      auto [delta, changes] = prepareDelta(name, deltaRequested);
 
-      try
+      if (deltaRequested)
       {
-        response = KvExecutor::saveKv(m_map, dataPath, name);
-        metaDataStatus = KvSaveStatus::Complete;
+        metaData["delta"] = delta;
+
+        if (delta)
+          metaData["prev"] = m_lastSave->dir;
       }
-      catch(const std::exception& e)
+
+      // writes the data, in this process or the child
+      auto write = [this, name, root, delta, mmap, changes = std::move(changes)](std::atomic_uint64_t * progress)
       {
-        PLOGE << e.what();
-        metaDataStatus = KvSaveStatus::Error;
-        response.rsp[queryRspName]["st"] = toUnderlying(RequestStatus::SaveError);
+        Response response;
+
+        if (delta)
+          response = KvExecutor::saveKvDelta(m_map, changes, root / "data", root / "removed", m_settings.persistCompression, name, progress);
+        else if (mmap)
+          response = KvExecutor::saveKvMmap(m_map, root / "data", name, progress);
+        else
+          response = KvExecutor::saveKv(m_map, root / "data", m_settings.persistCompression, name, progress);
+
+        // arrays and lists are always saved in full
+        if (response.rsp.at(SaveRsp).at("st") == toUnderlying(RequestStatus::SaveComplete) && !savePersisters(root, m_settings.persistCompression))
+          response.rsp[SaveRsp]["st"] = toUnderlying(RequestStatus::SaveError);
+
+        return response;
+      };
+
+      // the next delta is relative to this save
+      if (deltaRequested)
+        m_lastSave = DeltaBase{.name = name, .dir = dataSetDir, .length = delta ? m_lastSave->length + 1 : 0U};
+
+      Response response = background ? doBackgroundSave(queryRspName, name, root, metaStream, metaData, std::move(write)) : write(nullptr);
+
+      if (!background)
+      {
+        const bool saved = response.rsp.at(SaveRsp).at("st").as<int>() == toUnderlying(RequestStatus::SaveComplete);
+        completeSaveMetaData(metaStream, metaData, saved ? KvSaveStatus::Complete : KvSaveStatus::Error, m_map.count());
+
+        if (!saved)
+        {
+          PLOGE << "Save failed: " << name;
+          m_lastSave.reset();
+        }
       }
+      else if (response.rsp.at(queryRspName).at("st").as<int>() != toUnderlying(RequestStatus::SaveStarted))
+        m_lastSave.reset();
       
-      // update metdata
-      completeSaveMetaData(metaStream, metaData, metaDataStatus);
-      
+      if (deltaRequested)
+        response.rsp[queryRspName]["delta"] = delta;
+
       return response;
     }
   }
+
+
+  // A delta is only written if this process wrote or loaded the previous save for this name,
+  // otherwise, or when the delta chain is long or the delta large, a full save is written
+  // which becomes the base for the next delta.
+  std::tuple<bool, CacheMap::Changes> prepareDelta (const std::string& name, const bool deltaRequested)
+  {
+    static const std::size_t MaxChainLength = 8U;
+
+    if (!deltaRequested)
+      return {false, CacheMap::Changes{}};
+    else if (!m_map.isTracking())
+    {
+      m_map.startTracking();
+      return {false, CacheMap::Changes{}};
+    }
+    else
+    {
+      // a failed background save can't be the base for a delta
+      if (pollBackgroundSave() == ForkTask::State::Error && m_lastSave && m_lastSave->dir == m_bgSaveDir)
+        m_lastSave.reset();
+
+      auto changes = m_map.takeChanges();
+
+      const bool delta =  m_lastSave && m_lastSave->name == name &&
+                          m_lastSave->length < MaxChainLength &&
+                          m_bgSave.state() != ForkTask::State::Running &&
+                          !changes.cleared &&
+                          changes.size() <= m_map.count() / 2U;
+
+      return {delta, std::move(changes)};
+    }
+  }
+
+
+  // The save runs in a forked child, which has a copy-on-write snapshot of the map,
+  // so this returns immediately. Progress is queried with KV_SAVE_STATUS.
+  Response doBackgroundSave ( const std::string_view queryRspName, const std::string& name, const fs::path& root, std::ofstream& metaStream,
+                              njson& metaData, std::function<Response(std::atomic_uint64_t *)> write)
+  {
+    metaStream.close(); // flush before fork, the child rewrites the metadata when complete
+
+    auto save = [root, metaData, write = std::move(write)](ForkTask::Progress& progress) mutable
+    {
+      // runs in the child process
+      const auto rsp = write(&progress.done).rsp;
+      const bool saved = rsp.at(SaveRsp).at("st").as<int>() == toUnderlying(RequestStatus::SaveComplete);
+
+      std::ofstream stream {root / "md" / "md.json", std::ios_base::trunc | std::ios_base::out};
+      completeSaveMetaData(stream, metaData, saved ? KvSaveStatus::Complete : KvSaveStatus::Error, progress.total);
+      
+      return saved && stream.good();
+    };
+
+
+    Response response;
+    response.rsp[queryRspName]["name"] = name;
+
+    if (m_bgSave.start(save, m_map.count()))
+    {
+      PLOGI << "Background save started: " << name << ", fork: " << chrono::duration_cast<chrono::microseconds>(m_bgSave.forkDuration()).count() << "us";
+
+      m_bgSaveName = name;
+      m_bgSaveDir = root.filename().string();
+      response.rsp[queryRspName]["st"] = toUnderlying(RequestStatus::SaveStarted);
+    }
+    else
+    {
+      PLOGE << "Background save failed to start";
+      response.rsp[queryRspName]["st"] = toUnderlying(RequestStatus::SaveError);
+    }
+
+    return response;
+  }
+
+
+  // Reaps the background save's child, logging the result once: the child doesn't log
+  ForkTask::State pollBackgroundSave ()
+  {
+    const auto before = m_bgSave.state();
+    const auto state = m_bgSave.poll();
+
+    if (before == ForkTask::State::Running && state == ForkTask::State::Complete)
+      PLOGI << "Background save complete: " << m_bgSaveName << ", " << m_bgSave.done() << " keys in " << chrono::duration_cast<chrono::milliseconds>(m_bgSave.duration()).count() << "ms";
+    else if (before == ForkTask::State::Running && state == ForkTask::State::Error)
+      PLOGE << "Background save failed: " << m_bgSaveName << (m_bgSave.error().empty() ? "" : ", ") << m_bgSave.error();
+
+    return state;
+  }
+
+
+  Response saveStatus(njson& request)
+  {
+    if (!m_settings.persistEnabled)
+      return Response{.rsp = createErrorResponse(SaveStatusRsp, RequestStatus::CommandDisabled)};
+    
+    Response response;
+    auto& body = response.rsp[SaveStatusRsp];
+
+    switch (pollBackgroundSave())
+    {
+      case ForkTask::State::None:
+        body["st"] = toUnderlying(RequestStatus::NotExist);
+        return response;
+
+      case ForkTask::State::Running:
+        body["st"] = toUnderlying(RequestStatus::SaveInProgress);
+      break;
+
+      case ForkTask::State::Complete:
+        body["st"] = toUnderlying(RequestStatus::SaveComplete);
+      break;
+
+      case ForkTask::State::Error:
+        body["st"] = toUnderlying(RequestStatus::SaveError);
+      break;
+    }
+
+    body["name"] = m_bgSaveName;
+    body["keys"] = m_bgSave.total();
+    body["saved"] = m_bgSave.done();
+    body["duration"] = chrono::duration_cast<chrono::milliseconds>(m_bgSave.duration()).count();
+    // cost to clients: time blocked in fork() and copy-on-write faults taken by the event loop thread
+    body["forkDuration"] = chrono::duration_cast<chrono::microseconds>(m_bgSave.forkDuration()).count();
+    body["pageFaults"] = m_bgSave.pageFaults();
+
+    return response;
+  }
   
 
-  njson doLoad (const std::string& loadName, const fs::path& dataSetsRoot)
+  // May run in a forked child, so doesn't log
+  bool savePersisters (const fs::path& root, const snapshot::Codec codec) const
   {
-    PLOGI << "Loading from " << dataSetsRoot;
+    try
+    {
+      return std::all_of(m_persisters.cbegin(), m_persisters.cend(), [&root, codec](const Persister& persister)
+      {
+        return persister.save(root / persister.dir, codec);
+      });
+    }
+    catch (const std::exception&)
+    {
+      return false;
+    }
+  }
+
+
+  // Loads the save then any deltas in order. Deltas can remove keys.
+  // Arrays and lists are loaded from the most recent save, on other threads whilst keys load.
+  njson doLoad (const std::string& loadName, const PreLoadInfo& info)
+  {
+    const auto countBefore = m_map.count();
+    std::size_t duration = 0;
+    njson rsp;
+
+    std::vector<std::future<std::size_t>> persisterLoads;
+    ThreadPool pool {std::max<std::size_t>(1U, m_persisters.size())};
     
-    Response response = KvExecutor::loadKv (loadName, m_map, dataSetsRoot);
+    for (const auto& persister : m_persisters)
+      persisterLoads.emplace_back(pool.submit([&persister, root = info.chain.back()]{ return persister.load(root / persister.dir); }));
+
+    for (std::size_t i = 0 ; i < info.chain.size() ; ++i)
+    {
+      const auto& root = info.chain[i];
+
+      PLOGI << "Loading from " << root;
+
+      rsp = KvExecutor::loadKv (loadName, m_map, root / "data", i == 0 ? info.nKeys : 0U).rsp;
+      duration += rsp[LoadRsp]["duration"].as<std::size_t>();
+
+      if (rsp[LoadRsp]["st"] != toUnderlying(RequestStatus::LoadComplete))
+        break;
+      
+      try
+      {
+        if (fs::exists(root / "removed"))
+          KvExecutor::loadRemoved(m_map, root / "removed");
+      }
+      catch (const std::exception& ex)
+      {
+        PLOGE << ex.what();
+        rsp[LoadRsp]["st"] = toUnderlying(RequestStatus::LoadError);
+        break;
+      }
+    }
+
+    if (info.chain.size() > 1U)
+    {
+      rsp[LoadRsp]["keys"] = m_map.count() > countBefore ? m_map.count() - countBefore : 0U;
+      rsp[LoadRsp]["duration"] = duration;
+    }
+
+    for (std::size_t i = 0 ; i < persisterLoads.size() ; ++i)
+    {
+      try
+      {
+        if (const auto n = persisterLoads[i].get(); n)
+          PLOGI << "Loaded " << n << " from " << m_persisters[i].dir;
+      }
+      catch (const std::exception& ex)
+      {
+        PLOGE << m_persisters[i].dir << " : " << ex.what();
+        rsp[LoadRsp]["st"] = toUnderlying(RequestStatus::LoadError);
+      }
+    }
+
+    // when the map was empty, it now matches the save, so the next delta save can be relative to it
+    if (info.deltas && countBefore == 0 && rsp[LoadRsp]["st"] == toUnderlying(RequestStatus::LoadComplete))
+    {
+      m_map.startTracking();
+      m_lastSave = DeltaBase{.name = loadName, .dir = info.chain.back().filename().string(), .length = info.chain.size() - 1U};
+    }
 
     PLOGI << "Loading complete";
 
-    return response.rsp;
+    return rsp;
   }
 
 
 private:
   const Settings& m_settings;
   CacheMap m_map;
+  ForkTask m_bgSave;
+  std::string m_bgSaveName;
+  std::string m_bgSaveDir;
+  std::optional<DeltaBase> m_lastSave;  // the previous save with the delta option
+  std::vector<Persister> m_persisters;
 };
 
 }
@@ -7,6 +7,8 @@
 #include <ankerl/unordered_dense.h>
 #include <core/NemesisCommon.h>
 #include <core/NemesisConfig.h>
+#include <core/Snapshot.h>
+#include <core/SnapshotItems.h>
 #include <core/lst/LstCommon.h>
 #include <core/lst/LstCommands.h>
 #include <core/lst/LstCommandValidate.h>
@@ -166,6 +168,127 @@ namespace nemesis { namespace lst {
     }
 
 
+    // Emits requests which recreate the lists, used by WAL compaction
+    void dump (const std::function<void(const njson&)>& emit) const
+    {
+      static const std::size_t BatchSize = 1024U;
+
+      for (const auto& [name, list] : m_lists)
+      {
+        njson create;
+        create[Cmds::create.req.data()]["name"] = name;
+        emit(create);
+
+        njson items = njson::make_array();
+
+        auto emitItems = [&emit, &items, &name]()
+        {
+          njson request;
+          request[Cmds::add.req.data()]["name"] = name;
+          request[Cmds::add.req.data()]["items"] = std::move(items);
+          emit(request);
+          items = njson::make_array();
+        };
+
+        for (auto it = list.cbegin() ; it != list.cend() ; ++it)
+        {
+          items.push_back(*it);
+
+          if (items.size() == BatchSize)
+            emitItems();
+        }
+
+        if (!items.empty())
+          emitItems();
+      }
+    }
+
+
+    /*
+    Writes all lists to snapshot files in 'dir'. Can run in a forked child (background save).
+
+    A list is written in chunks, each a record:
+      name | n (u64) | items
+
+    An empty list has one record with n of 0.
+    */
+    bool save (const fs::path& dir, const snapshot::Codec codec) const
+    {
+      static const std::size_t ChunkSize = 4096U;
+
+      fs::create_directories(dir);
+
+      snapshot::SnapshotWriter writer{dir, codec};
+      std::vector<std::uint8_t> buffer;
+
+      for (const auto& [name, list] : m_lists)
+      {
+        auto it = list.cbegin();
+        std::size_t remaining = list.size();
+
+        do
+        {
+          const auto n = std::min<std::size_t>(ChunkSize, remaining);
+
+          writer.putString(name);
+          writer.putU64(n);
+
+          for (std::size_t i = 0 ; i < n ; ++i, ++it)
+            snapshot::putItem<T>(writer, *it, buffer);
+
+          writer.endRecord();
+          remaining -= n;
+
+        } while (remaining);
+      }
+
+      writer.close();
+      return true;
+    }
+
+
+    // Loads lists written by save(), replacing lists with the same name. Throws on error.
+    std::size_t load (const fs::path& dir)
+    {
+      std::size_t nLists{0};
+
+      if (!fs::exists(dir))
+        return nLists;
+
+      ankerl::unordered_dense::set<std::string> loaded;
+
+      // in the order written, a container's records can span files
+      for (const auto& file : snapshot::dataFiles(dir))
+      {
+        snapshot::SnapshotReader reader{file};
+
+        while (reader.nextBlock())
+        {
+          for (std::uint32_t i = 0 ; i < reader.blockRecords() ; ++i)
+          {
+            std::string name {reader.getString()};
+            const auto n = reader.getU64();
+
+            // the first chunk replaces an existing list
+            if (!loaded.contains(name))
+            {
+              m_lists.erase(name);
+              loaded.insert(name);
+              ++nLists;
+            }
+
+            auto& list = createList(name)->second;
+
+            for (std::uint64_t item = 0 ; item < n ; ++item)
+              list.append(snapshot::getItem<T>(reader));
+          }
+        }
+      }
+
+      return nLists;
+    }
+
+
   private:
 
     Response validateAndExecute(const std::map<LstQueryType, ValidateExecute>::const_iterator it, const njson& request, const std::string_view reqName)
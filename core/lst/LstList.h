@@ -47,6 +47,18 @@ namespace nemesis { namespace lst {
     }
 
 
+    ConstIt cbegin() const noexcept
+    {
+      return m_list.cbegin();
+    }
+
+
+    ConstIt cend() const noexcept
+    {
+      return m_list.cend();
+    }
+
+
     std::tuple<std::size_t, std::size_t> addHead(const njson& items)
     {
       return add(items);
@@ -70,6 +82,13 @@ namespace nemesis { namespace lst {
     }
 
 
+    // Used when loading a save
+    void append(T item)
+    {
+      m_list.push_back(std::move(item));
+    }
+
+
     void setRange(const njson& items, const std::size_t start)
     {
       auto itStart = getIterator(start);
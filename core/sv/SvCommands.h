@@ -7,6 +7,13 @@ namespace nemesis { namespace sv { namespace cmds {
   const char InfoIdent[] = "SV";
   const char InfoReq[] = "SV_INFO";  
   const char InfoRsp[] = "SV_INFO_RSP";
+
+  const char ClusterSlotsReq[]    = "SV_CLUSTER_SLOTS";
+  const char ClusterSlotsRsp[]    = "SV_CLUSTER_SLOTS_RSP";
+  const char ClusterMigrateReq[]  = "SV_CLUSTER_MIGRATE";
+  const char ClusterMigrateRsp[]  = "SV_CLUSTER_MIGRATE_RSP";
+  const char ClusterSetSlotReq[]  = "SV_CLUSTER_SETSLOT";
+  const char ClusterSetSlotRsp[]  = "SV_CLUSTER_SETSLOT_RSP";
 }
 }
 }
@@ -0,0 +1,361 @@
+#ifndef NDB_CORE_VECCOLLECTION_H
+#define NDB_CORE_VECCOLLECTION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <core/vec/VecDistance.h>
+
+
+namespace nemesis { namespace vec {
+
+
+enum class Metric : std::uint8_t
+{
+  Dot,
+  Cosine,
+  L2
+};
+
+
+enum class Quantization : std::uint8_t
+{
+  None,   // float32
+  Int8    // a byte per value and a float scale per vector
+};
+
+
+inline std::optional<Metric> toMetric (const std::string_view name)
+{
+  if (name == "dot")
+    return Metric::Dot;
+  else if (name == "cosine")
+    return Metric::Cosine;
+  else if (name == "l2")
+    return Metric::L2;
+  else
+    return std::nullopt;
+}
+
+
+inline std::optional<Quantization> toQuantization (const std::string_view name)
+{
+  if (name == "none")
+    return Quantization::None;
+  else if (name == "int8")
+    return Quantization::Int8;
+  else
+    return std::nullopt;
+}
+
+
+inline std::string_view toString (const Quantization quantization)
+{
+  return quantization == Quantization::Int8 ? "int8" : "none";
+}
+
+
+// A search result: for L2, score is the negated squared distance, so that higher is always better
+struct Match
+{
+  float score;
+  std::uint64_t id;
+};
+
+
+// higher score first, then lower id
+inline bool isBetter (const Match& a, const Match& b) noexcept
+{
+  return a.score > b.score || (a.score == b.score && a.id < b.id);
+}
+
+
+/*
+Up to Capacity vectors, stored contiguously. With Quantization::Int8, each value is
+round(value / scale), where a vector's scale is its largest absolute value / 127.
+
+norms are of the stored values (after quantization), for cosine and L2.
+*/
+struct Block
+{
+  static constexpr std::size_t Capacity = 1024U;
+
+  std::vector<float> values;          // Quantization::None, size() * dimensions
+  std::vector<std::int8_t> codes;     // Quantization::Int8, size() * dimensions
+  std::vector<float> scales;          // Quantization::Int8
+  std::vector<float> norms;
+
+  std::size_t size() const noexcept
+  {
+    return norms.size();
+  }
+};
+
+
+// The blocks of a collection when it was taken, which a search reads whilst the collection changes
+struct Snapshot
+{
+  std::vector<std::shared_ptr<const Block>> blocks;
+  std::size_t dimensions;
+  Quantization quantization;
+};
+
+
+/*
+A collection of vectors with the same number of dimensions. Each vector's id is its position,
+in the order added, so ids are stable until clear().
+
+Vectors are stored in blocks, each shared by the collection and by the snapshot() of searches
+running on other threads. A shared block isn't modified: the last block is copied before
+adding to it (copy on write), so the copy is at most one block whatever the collection's size.
+*/
+class Collection
+{
+public:
+  Collection (const std::size_t dimensions, const Quantization quantization) : m_dimensions(dimensions), m_quantization(quantization)
+  {
+  }
+
+
+  std::size_t dimensions() const noexcept
+  {
+    return m_dimensions;
+  }
+
+
+  Quantization quantization() const noexcept
+  {
+    return m_quantization;
+  }
+
+
+  std::size_t size() const noexcept
+  {
+    return m_size;
+  }
+
+
+  // 'vector' must have dimensions() values
+  void add (const std::span<const float> vector)
+  {
+    auto& block = writableBlock();
+
+    if (m_quantization == Quantization::None)
+    {
+      block.values.insert(block.values.end(), vector.begin(), vector.end());
+      block.norms.push_back(std::sqrt(dist::DistKernels.dot(vector, vector)));
+    }
+    else
+    {
+      float maxAbs = 0;
+      for (const auto value : vector)
+        maxAbs = std::max(maxAbs, std::abs(value));
+
+      const float scale = maxAbs / 127.0f;
+      float norm = 0;
+
+      for (const auto value : vector)
+      {
+        const auto code = scale == 0 ? 0 : static_cast<std::int8_t>(std::clamp(std::round(value / scale), -127.0f, 127.0f));
+        block.codes.push_back(code);
+        norm += (code * scale) * (code * scale);
+      }
+
+      block.scales.push_back(scale);
+      block.norms.push_back(std::sqrt(norm));
+    }
+
+    ++m_size;
+  }
+
+
+  // Adds a quantized vector, as saved: 'codes' must have dimensions() values
+  void addCodes (const std::span<const std::int8_t> codes, const float scale)
+  {
+    auto& block = writableBlock();
+
+    float norm = 0;
+    for (const auto code : codes)
+      norm += (code * scale) * (code * scale);
+
+    block.codes.insert(block.codes.end(), codes.begin(), codes.end());
+    block.scales.push_back(scale);
+    block.norms.push_back(std::sqrt(norm));
+    ++m_size;
+  }
+
+
+  // The vector as stored, so dequantized with Quantization::Int8. 'id' must be < size().
+  std::vector<float> get (const std::uint64_t id) const
+  {
+    const auto& block = *m_blocks[id / Block::Capacity];
+    const auto pos = id % Block::Capacity;
+
+    if (m_quantization == Quantization::None)
+    {
+      const auto it = std::next(block.values.cbegin(), pos * m_dimensions);
+      return std::vector<float>(it, std::next(it, m_dimensions));
+    }
+    else
+    {
+      std::vector<float> vector;
+      vector.reserve(m_dimensions);
+
+      for (std::size_t i = 0 ; i < m_dimensions ; ++i)
+        vector.push_back(block.codes[pos * m_dimensions + i] * block.scales[pos]);
+
+      return vector;
+    }
+  }
+
+
+  const std::vector<std::shared_ptr<Block>>& blocks() const noexcept
+  {
+    return m_blocks;
+  }
+
+
+  Snapshot snapshot() const
+  {
+    return Snapshot{.blocks = {m_blocks.cbegin(), m_blocks.cend()}, .dimensions = m_dimensions, .quantization = m_quantization};
+  }
+
+
+  void clear ()
+  {
+    m_blocks.clear();
+    m_size = 0;
+  }
+
+
+private:
+
+  // the block to add a vector to, copied if a snapshot shares it
+  Block& writableBlock ()
+  {
+    if (m_blocks.empty() || m_blocks.back()->size() == Block::Capacity)
+    {
+      auto block = std::make_shared<Block>();
+
+      if (m_quantization == Quantization::None)
+        block->values.reserve(Block::Capacity * m_dimensions);
+      else
+      {
+        block->codes.reserve(Block::Capacity * m_dimensions);
+        block->scales.reserve(Block::Capacity);
+      }
+
+      block->norms.reserve(Block::Capacity);
+      m_blocks.push_back(std::move(block));
+    }
+    else if (m_blocks.back().use_count() > 1)
+      m_blocks.back() = std::make_shared<Block>(*m_blocks.back());
+
+    return *m_blocks.back();
+  }
+
+
+private:
+  std::vector<std::shared_ptr<Block>> m_blocks;
+  std::size_t m_dimensions;
+  Quantization m_quantization;
+  std::size_t m_size{0};
+};
+
+
+/*
+The k best matches in blocks [blockStart, blockStop) of 'snapshot', best first.
+
+A heap of the best k so far, with the worst at the front, so most vectors are compared only
+with the front. With Quantization::Int8, L2 is from the norms and the dot product:
+|q - x|² = |q|² + |x|² - 2 q·x.
+*/
+inline std::vector<Match> search (const Snapshot& snapshot, const std::size_t blockStart, const std::size_t blockStop,
+                                  const std::span<const float> query, const Metric metric, const std::size_t k)
+{
+  const auto& kernels = dist::DistKernels;
+  const auto dimensions = snapshot.dimensions;
+  const auto queryNorm = std::sqrt(kernels.dot(query, query));
+
+  std::vector<Match> heap;
+  heap.reserve(k);
+
+  auto score = [&](const Block& block, const std::size_t pos) -> float
+  {
+    if (snapshot.quantization == Quantization::None)
+    {
+      const auto vector = std::span{block.values}.subspan(pos * dimensions, dimensions);
+
+      if (metric == Metric::L2)
+        return -kernels.l2(query, vector);
+
+      const auto dot = kernels.dot(query, vector);
+
+      if (metric == Metric::Dot)
+        return dot;
+      else
+        return queryNorm == 0 || block.norms[pos] == 0 ? 0 : dot / (queryNorm * block.norms[pos]);
+    }
+    else
+    {
+      const auto dot = kernels.dotCodes(query, std::span{block.codes}.subspan(pos * dimensions, dimensions)) * block.scales[pos];
+
+      if (metric == Metric::Dot)
+        return dot;
+      else if (metric == Metric::Cosine)
+        return queryNorm == 0 || block.norms[pos] == 0 ? 0 : dot / (queryNorm * block.norms[pos]);
+      else
+        return std::min(0.0f, -(queryNorm * queryNorm + block.norms[pos] * block.norms[pos] - 2 * dot));
+    }
+  };
+
+  for (auto b = blockStart ; b < blockStop ; ++b)
+  {
+    const auto& block = *snapshot.blocks[b];
+
+    for (std::size_t pos = 0 ; pos < block.size() ; ++pos)
+    {
+      const Match match {.score = score(block, pos), .id = b * Block::Capacity + pos};
+
+      if (heap.size() < k)
+      {
+        heap.push_back(match);
+        std::push_heap(heap.begin(), heap.end(), isBetter);
+      }
+      else if (isBetter(match, heap.front()))
+      {
+        std::pop_heap(heap.begin(), heap.end(), isBetter);
+        heap.back() = match;
+        std::push_heap(heap.begin(), heap.end(), isBetter);
+      }
+    }
+  }
+
+  std::sort_heap(heap.begin(), heap.end(), isBetter);
+  return heap;
+}
+
+
+// The k best of 'partials', each from search() of separate blocks, best first
+inline std::vector<Match> merge (const std::vector<std::vector<Match>>& partials, const std::size_t k)
+{
+  std::vector<Match> all;
+
+  for (const auto& partial : partials)
+    all.insert(all.end(), partial.cbegin(), partial.cend());
+
+  const auto n = std::min(k, all.size());
+  std::partial_sort(all.begin(), std::next(all.begin(), n), all.end(), isBetter);
+  all.resize(n);
+  return all;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef NDB_CORE_VECCMDVALIDATE_H
+#define NDB_CORE_VECCMDVALIDATE_H
+
+#include <algorithm>
+#include <string_view>
+#include <core/NemesisCommon.h>
+#include <core/vec/VecCommands.h>
+#include <core/vec/VecCommon.h>
+#include <core/vec/VecCollection.h>
+
+
+namespace nemesis { namespace vec {
+
+  using namespace nemesis::vec::cmds;
+
+
+  // each value a number, any of int, uint or double
+  inline bool isVector (const njson& vector)
+  {
+    if (!vector.is_array())
+      return false;
+
+    const auto values = vector.array_range();
+    return std::all_of(values.cbegin(), values.cend(), [](const njson& value){ return value.is_number(); });
+  }
+
+
+  // "dim" in [1, MaxDimensions] and an optional "quant", "none" or "int8"
+  template<typename Cmds>
+  RequestStatus validateCreate (const njson& request)
+  {
+    auto checkCreate = [](const njson& body) -> RequestStatus
+    {
+      if (const auto dim = body.at("dim").as<std::size_t>(); dim == 0 || dim > MaxDimensions)
+        return RequestStatus::ValueSize;
+      else if (body.contains("quant") && !toQuantization(body.at("quant").as_string_view()))
+        return RequestStatus::ValueTypeInvalid;
+      else
+        return RequestStatus::Ok;
+    };
+
+    return isValid(Cmds::create.rsp, request.at(Cmds::create.req), { {Param::required("name",   JsonString)},
+                                                                      {Param::required("dim",    JsonUInt)},
+                                                                      {Param::optional("quant",  JsonString)}}, checkCreate);
+  }
+
+
+  // commands with only "name"
+  template<typename Cmds>
+  RequestStatus validateName (const njson& request, const std::string_view reqName, const std::string_view rspName)
+  {
+    return isValid(rspName, request.at(reqName), { {Param::required("name", JsonString)} });
+  }
+
+
+  // "vectors", each an array of numbers. The number of dimensions is checked against the collection.
+  template<typename Cmds>
+  RequestStatus validateAdd (const njson& request)
+  {
+    auto checkVectors = [](const njson& body) -> RequestStatus
+    {
+      const auto vectors = body.at("vectors").array_range();
+      return std::all_of(vectors.cbegin(), vectors.cend(), isVector) ? RequestStatus::Ok : RequestStatus::ValueTypeInvalid;
+    };
+
+    return isValid(Cmds::add.rsp, request.at(Cmds::add.req), { {Param::required("name",    JsonString)},
+                                                               {Param::required("vectors", JsonArray)}}, checkVectors);
+  }
+
+
+  template<typename Cmds>
+  RequestStatus validateGet (const njson& request)
+  {
+    return isValid(Cmds::get.rsp, request.at(Cmds::get.req), { {Param::required("name", JsonString)},
+                                                               {Param::required("id",   JsonUInt)}});
+  }
+
+
+  // "vector", "k" in [1, MaxK] and an optional "metric", "dot", "cosine" or "l2"
+  template<typename Cmds>
+  RequestStatus validateSearch (const njson& request)
+  {
+    auto checkSearch = [](const njson& body) -> RequestStatus
+    {
+      if (!isVector(body.at("vector")))
+        return RequestStatus::ValueTypeInvalid;
+      else if (const auto k = body.at("k").as<std::size_t>(); k == 0 || k > MaxK)
+        return RequestStatus::ValueSize;
+      else if (body.contains("metric") && !toMetric(body.at("metric").as_string_view()))
+        return RequestStatus::ValueTypeInvalid;
+      else
+        return RequestStatus::Ok;
+    };
+
+    return isValid(Cmds::search.rsp, request.at(Cmds::search.req), { {Param::required("name",   JsonString)},
+                                                                     {Param::required("vector", JsonArray)},
+                                                                     {Param::required("k",      JsonUInt)},
+                                                                     {Param::optional("metric", JsonString)}}, checkSearch);
+  }
+}
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef NDB_CORE_VECCOMMANDS_H
+#define NDB_CORE_VECCOMMANDS_H
+
+#include <core/NemesisCommon.h>
+
+namespace nemesis { namespace vec { namespace cmds {
+
+  static constexpr FixedString Create     = "CREATE";  
+  static constexpr FixedString Delete     = "DELETE";
+  static constexpr FixedString DeleteAll  = "DELETE_ALL";
+  static constexpr FixedString Exist      = "EXIST";
+  static constexpr FixedString Add        = "ADD";
+  static constexpr FixedString Get        = "GET";
+  static constexpr FixedString Len        = "LEN";
+  static constexpr FixedString Clear      = "CLEAR";
+  static constexpr FixedString Search     = "SEARCH";
+  
+
+  static constexpr FixedString VecIdent   = "VEC";
+  static constexpr FixedString VecIdent_  = "VEC_";
+  static constexpr FixedString Rsp        = "_RSP";  
+
+
+  template<FixedString Ident, FixedString Cmd>
+  static consteval auto makeReq() -> decltype(Ident+Cmd)
+  {
+    return Ident+Cmd;
+  }
+
+  template<FixedString Ident, FixedString Cmd>
+  static consteval auto makeRsp() -> decltype(makeReq<Ident, Cmd>()+Rsp)
+  {
+    return makeReq<Ident, Cmd>()+Rsp;
+  }
+
+
+  template <FixedString Ident>
+  struct VecCmds
+  {
+    template<FixedString Name>
+    struct Cmd
+    {
+      static constexpr auto req = makeReq<Ident, Name>();
+      static constexpr auto rsp = makeRsp<Ident, Name>();
+    };
+
+    static constexpr Cmd<Create> create {};    
+    static constexpr Cmd<Delete> del{};
+    static constexpr Cmd<DeleteAll> deleteAll{}; 
+    static constexpr Cmd<Exist> exist{};
+    static constexpr Cmd<Add> add {};
+    static constexpr Cmd<Get> get{};
+    static constexpr Cmd<Len> len{};
+    static constexpr Cmd<Clear> clear{};
+    static constexpr Cmd<Search> search{};
+  };
+
+
+  // Float32 vectors, optionally int8 quantized
+  struct VectorCmds : public VecCmds<VecIdent_>
+  {
+  };
+
+}
+}
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef NDB_CORE_VECCOMMON_H
+#define NDB_CORE_VECCOMMON_H
+
+#include <core/NemesisCommon.h>
+
+
+namespace nemesis {  namespace vec {
+
+  enum class VecQueryType : std::uint8_t
+  { 
+    Create,
+    Delete,
+    DeleteAll,
+    Exist,
+    Add,
+    Get,
+    Len,
+    Clear,
+    Search,
+    MAX
+  };
+
+
+  static constexpr std::size_t MaxDimensions = 4096U;
+  static constexpr std::size_t MaxK = 1024U;
+  // a search of more values than this, dimensions * vectors, runs on the thread pool
+  static constexpr std::size_t SyncSearchValues = 1U << 18U;
+}
+}
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef NDB_CORE_VECDISTANCE_H
+#define NDB_CORE_VECDISTANCE_H
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+
+namespace nemesis { namespace vec { namespace dist {
+
+/*
+Distance kernels for vector search, on float32 vectors and int8 codes:
+
+  - dot: a · b
+  - l2: the squared euclidean distance, |a - b|²
+  - dotCodes: a · codes, the query against an int8 quantized vector, before the vector's scale is applied
+
+Each keeps 4 vector accumulators, so the latency of each FMA is hidden, then adds them. The
+result can differ from a sequential loop in the last bits.
+
+Kernels are selected at runtime, from AVX-512, AVX2 and scalar, as in ArrSetOps.h.
+*/
+
+
+using Values = std::span<const float>;
+using Codes = std::span<const std::int8_t>;
+
+
+// 'a' and 'b' must be the same size, as for all kernels
+inline float dotScalar (const Values a, const Values b)
+{
+  float total = 0;
+
+  for (std::size_t i = 0 ; i < a.size() ; ++i)
+    total += a[i] * b[i];
+
+  return total;
+}
+
+
+inline float l2Scalar (const Values a, const Values b)
+{
+  float total = 0;
+
+  for (std::size_t i = 0 ; i < a.size() ; ++i)
+  {
+    const auto d = a[i] - b[i];
+    total += d * d;
+  }
+
+  return total;
+}
+
+
+inline float dotCodesScalar (const Values a, const Codes codes)
+{
+  float total = 0;
+
+  for (std::size_t i = 0 ; i < a.size() ; ++i)
+    total += a[i] * codes[i];
+
+  return total;
+}
+
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2,fma"))) inline float sumLanes (const __m256 acc[4])
+{
+  float lanes[8];
+  _mm256_storeu_ps(lanes, _mm256_add_ps(_mm256_add_ps(acc[0], acc[1]), _mm256_add_ps(acc[2], acc[3])));
+  return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+}
+
+
+__attribute__((target("avx2,fma"))) inline float dotAvx2 (const Values a, const Values b)
+{
+  static constexpr std::size_t Width = 8U;
+
+  __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+      acc[n] = _mm256_fmadd_ps(_mm256_loadu_ps(a.data() + i + n * Width), _mm256_loadu_ps(b.data() + i + n * Width), acc[n]);
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+    acc[0] = _mm256_fmadd_ps(_mm256_loadu_ps(a.data() + i), _mm256_loadu_ps(b.data() + i), acc[0]);
+
+  return sumLanes(acc) + dotScalar(a.subspan(i), b.subspan(i));
+}
+
+
+__attribute__((target("avx2,fma"))) inline float l2Avx2 (const Values a, const Values b)
+{
+  static constexpr std::size_t Width = 8U;
+
+  __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+    {
+      const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a.data() + i + n * Width), _mm256_loadu_ps(b.data() + i + n * Width));
+      acc[n] = _mm256_fmadd_ps(d, d, acc[n]);
+    }
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+  {
+    const __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a.data() + i), _mm256_loadu_ps(b.data() + i));
+    acc[0] = _mm256_fmadd_ps(d, d, acc[0]);
+  }
+
+  return sumLanes(acc) + l2Scalar(a.subspan(i), b.subspan(i));
+}
+
+
+// int8 codes are widened to int32 then converted to float, 8 at a time
+__attribute__((target("avx2,fma"))) inline float dotCodesAvx2 (const Values a, const Codes codes)
+{
+  static constexpr std::size_t Width = 8U;
+
+  auto load = [&codes](const std::size_t i)
+  {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(codes.data() + i))));
+  };
+
+  __m256 acc[4] = {_mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps(), _mm256_setzero_ps()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+      acc[n] = _mm256_fmadd_ps(_mm256_loadu_ps(a.data() + i + n * Width), load(i + n * Width), acc[n]);
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+    acc[0] = _mm256_fmadd_ps(_mm256_loadu_ps(a.data() + i), load(i), acc[0]);
+
+  return sumLanes(acc) + dotCodesScalar(a.subspan(i), codes.subspan(i));
+}
+
+
+// GCC 12's avx512fintrin.h has a false -Wmaybe-uninitialized.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f"))) inline float sumLanes (const __m512 acc[4])
+{
+  float lanes[16];
+  _mm512_storeu_ps(lanes, _mm512_add_ps(_mm512_add_ps(acc[0], acc[1]), _mm512_add_ps(acc[2], acc[3])));
+
+  float total = 0;
+  for (const auto lane : lanes)
+    total += lane;
+
+  return total;
+}
+
+
+__attribute__((target("avx512f"))) inline float dotAvx512 (const Values a, const Values b)
+{
+  static constexpr std::size_t Width = 16U;
+
+  __m512 acc[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+      acc[n] = _mm512_fmadd_ps(_mm512_loadu_ps(a.data() + i + n * Width), _mm512_loadu_ps(b.data() + i + n * Width), acc[n]);
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+    acc[0] = _mm512_fmadd_ps(_mm512_loadu_ps(a.data() + i), _mm512_loadu_ps(b.data() + i), acc[0]);
+
+  return sumLanes(acc) + dotScalar(a.subspan(i), b.subspan(i));
+}
+
+
+__attribute__((target("avx512f"))) inline float l2Avx512 (const Values a, const Values b)
+{
+  static constexpr std::size_t Width = 16U;
+
+  __m512 acc[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+    {
+      const __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a.data() + i + n * Width), _mm512_loadu_ps(b.data() + i + n * Width));
+      acc[n] = _mm512_fmadd_ps(d, d, acc[n]);
+    }
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+  {
+    const __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a.data() + i), _mm512_loadu_ps(b.data() + i));
+    acc[0] = _mm512_fmadd_ps(d, d, acc[0]);
+  }
+
+  return sumLanes(acc) + l2Scalar(a.subspan(i), b.subspan(i));
+}
+
+
+__attribute__((target("avx512f"))) inline float dotCodesAvx512 (const Values a, const Codes codes)
+{
+  static constexpr std::size_t Width = 16U;
+
+  auto load = [&codes](const std::size_t i)
+  {
+    return _mm512_cvtepi32_ps(_mm512_cvtepi8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(codes.data() + i))));
+  };
+
+  __m512 acc[4] = {_mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps(), _mm512_setzero_ps()};
+
+  std::size_t i = 0;
+
+  for ( ; i + 4 * Width <= a.size() ; i += 4 * Width)
+  {
+    for (std::size_t n = 0 ; n < 4 ; ++n)
+      acc[n] = _mm512_fmadd_ps(_mm512_loadu_ps(a.data() + i + n * Width), load(i + n * Width), acc[n]);
+  }
+
+  for ( ; i + Width <= a.size() ; i += Width)
+    acc[0] = _mm512_fmadd_ps(_mm512_loadu_ps(a.data() + i), load(i), acc[0]);
+
+  return sumLanes(acc) + dotCodesScalar(a.subspan(i), codes.subspan(i));
+}
+
+#pragma GCC diagnostic pop
+
+#endif
+
+
+struct Kernels
+{
+  float (*dot)(const Values, const Values);
+  float (*l2)(const Values, const Values);
+  float (*dotCodes)(const Values, const Codes);
+  std::string_view name;
+};
+
+
+inline Kernels selectKernels ()
+{
+  #if defined(__x86_64__)
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f"))
+      return Kernels{.dot = dotAvx512, .l2 = l2Avx512, .dotCodes = dotCodesAvx512, .name = "avx512"};
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+      return Kernels{.dot = dotAvx2, .l2 = l2Avx2, .dotCodes = dotCodesAvx2, .name = "avx2"};
+  #endif
+
+  return Kernels{.dot = dotScalar, .l2 = l2Scalar, .dotCodes = dotCodesScalar, .name = "scalar"};
+}
+
+
+inline const Kernels DistKernels = selectKernels();
+
+}
+}
+}
+
+#endif
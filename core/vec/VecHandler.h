@@ -0,0 +1,613 @@
+#ifndef NDB_CORE_VECHANDLERS_H
+#define NDB_CORE_VECHANDLERS_H
+
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <tuple>
+#include <variant>
+#include <ankerl/unordered_dense.h>
+#include <core/NemesisCommon.h>
+#include <core/NemesisConfig.h>
+#include <core/Snapshot.h>
+#include <core/ThreadPool.h>
+#include <core/vec/VecCommon.h>
+#include <core/vec/VecCommands.h>
+#include <core/vec/VecCommandValidate.h>
+#include <core/vec/VecCollection.h>
+
+
+
+namespace nemesis { namespace vec {
+
+
+  using namespace nemesis::vec::cmds;
+
+
+  /*
+  Collections of vectors, searched by brute force for the k nearest to a query vector.
+
+  SEARCH is a scan of every vector. A large collection is searched on a thread pool, split
+  by blocks, so the event loop isn't blocked: see search(). Other commands, including a
+  SEARCH from the WAL or via handle(), run on the caller's thread.
+  */
+  template<typename Cmds>
+  class VecHandler
+  {
+    using Collections = ankerl::unordered_dense::map<std::string, Collection>;
+    using Iterator = Collections::iterator;
+    using HandlerPmrMap = ankerl::unordered_dense::pmr::map<VecQueryType, Handler>;
+    using QueryTypePmrMap = ankerl::unordered_dense::pmr::map<std::string_view, VecQueryType>;
+
+
+  public:
+
+    // A SEARCH which is running on the pool: 'response' is ready when the last block is searched
+    using PendingSearch = std::future<Response>;
+
+
+    template<class Alloc>
+    auto createLocalHandlers (Alloc& alloc)
+    {
+      // initialise with 1 bucket and pmr allocator
+      HandlerPmrMap h (
+      {
+        {VecQueryType::Create,      Handler{std::bind_front(&VecHandler<Cmds>::create,          std::ref(*this))}},
+        {VecQueryType::Delete,      Handler{std::bind_front(&VecHandler<Cmds>::deleteCollection, std::ref(*this))}},
+        {VecQueryType::DeleteAll,   Handler{std::bind_front(&VecHandler<Cmds>::deleteAll,       std::ref(*this))}},
+        {VecQueryType::Exist,       Handler{std::bind_front(&VecHandler<Cmds>::exist,           std::ref(*this))}},
+        {VecQueryType::Add,         Handler{std::bind_front(&VecHandler<Cmds>::add,             std::ref(*this))}},
+        {VecQueryType::Get,         Handler{std::bind_front(&VecHandler<Cmds>::get,             std::ref(*this))}},
+        {VecQueryType::Len,         Handler{std::bind_front(&VecHandler<Cmds>::length,          std::ref(*this))}},
+        {VecQueryType::Clear,       Handler{std::bind_front(&VecHandler<Cmds>::clear,           std::ref(*this))}},
+        {VecQueryType::Search,      Handler{std::bind_front(&VecHandler<Cmds>::searchNow,       std::ref(*this))}},
+      }, 1, alloc);
+
+      return h;
+    }
+
+
+    template<class Alloc>
+    auto createQueryTypeNameMap (Alloc& alloc)
+    {
+      QueryTypePmrMap map (
+      {
+        {Cmds::create.req,      VecQueryType::Create},
+        {Cmds::del.req,         VecQueryType::Delete},
+        {Cmds::deleteAll.req,   VecQueryType::DeleteAll},
+        {Cmds::exist.req,       VecQueryType::Exist},
+        {Cmds::add.req,         VecQueryType::Add},
+        {Cmds::get.req,         VecQueryType::Get},
+        {Cmds::len.req,         VecQueryType::Len},
+        {Cmds::clear.req,       VecQueryType::Clear},
+        {Cmds::search.req,      VecQueryType::Search},
+      }, 1, alloc);
+
+      return map;
+    }
+
+
+  public:
+
+    Response handle(const std::string_view& reqName, njson& request)
+    {
+      static PmrResource<typename HandlerPmrMap::value_type, 1024U> handlerPmrResource; // TODO buffer size
+      static PmrResource<typename HandlerPmrMap::value_type, 1024U> queryTypeNamePmrResource; // TODO buffer size
+      static const QueryTypePmrMap QueryNameToType{createQueryTypeNameMap(queryTypeNamePmrResource.getAlloc())};
+      static const HandlerPmrMap LocalHandlers{createLocalHandlers(handlerPmrResource.getAlloc())};
+
+      if (const auto itType = QueryNameToType.find(reqName) ; itType == QueryNameToType.cend())
+        return Response {.rsp = createErrorResponse(RequestStatus::CommandNotExist)};
+      else if (const auto localHandlerIt = LocalHandlers.find(itType->second) ; localHandlerIt != LocalHandlers.cend())
+      {
+        try
+        {
+          auto& handler = localHandlerIt->second;
+          return handler(request);
+        }
+        catch (const std::exception& ex)
+        {
+          PLOGE << ex.what() ;
+          return Response {.rsp = createErrorResponse(RequestStatus::Unknown)};
+        }
+      }
+      else
+        return Response {.rsp = createErrorResponse(RequestStatus::CommandNotExist)};
+    }
+
+
+    bool isSearch (const std::string_view reqName) const noexcept
+    {
+      return reqName == Cmds::search.req;
+    }
+
+
+    /*
+    SEARCH from a client. An invalid request or a small collection returns the response, otherwise
+    the search is split by blocks across the pool and this returns a future of the response.
+    The pool thread which completes the search calls 'onDone', which must be thread safe.
+    */
+    std::variant<Response, PendingSearch> search (njson& request, std::function<void()> onDone)
+    {
+      static constexpr auto RspName = Cmds::search.rsp.data();
+
+      const auto [status, it] = checkSearch(request);
+
+      if (status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& collection = it->second;
+
+      if (collection.size() * collection.dimensions() <= SyncSearchValues)
+        return searchNow(request);
+
+      if (!m_pool)
+        m_pool = std::make_unique<ThreadPool>();
+
+      const auto& body = request.at(Cmds::search.req);
+
+      auto state = std::make_shared<SearchState>();
+      state->snapshot = collection.snapshot();
+      state->query = toVector(body.at("vector"));
+      state->metric = metricOf(body);
+      state->k = body.at("k").template as<std::size_t>();
+      state->onDone = std::move(onDone);
+
+      const auto nBlocks = state->snapshot.blocks.size();
+      const auto nTasks = std::min(nBlocks, m_pool->size());
+
+      state->partials.resize(nTasks);
+      state->remaining = nTasks;
+
+      // contiguous runs of blocks, the first 'nBlocks % nTasks' tasks have one more
+      for (std::size_t task = 0, start = 0 ; task < nTasks ; ++task)
+      {
+        const auto stop = start + nBlocks / nTasks + (task < nBlocks % nTasks ? 1 : 0);
+
+        m_pool->submit([state, task, start, stop]
+        {
+          state->partials[task] = vec::search(state->snapshot, start, stop, state->query, state->metric, state->k);
+
+          // the last task to finish merges
+          if (state->remaining.fetch_sub(1) == 1)
+          {
+            try
+            {
+              state->promise.set_value(searchResponse(merge(state->partials, state->k), state->metric));
+            }
+            catch (const std::exception& ex)
+            {
+              PLOGE << ex.what();
+              state->promise.set_value(Response{.rsp = createErrorResponse(RspName, RequestStatus::Unknown)});
+            }
+
+            state->onDone();
+          }
+        });
+
+        start = stop;
+      }
+
+      return state->promise.get_future();
+    }
+
+
+    // Waits for searches running on the pool, i.e. before the event loop which they wake is destroyed
+    void stopSearches ()
+    {
+      m_pool.reset();
+    }
+
+
+    // Emits requests which recreate the collections, used by WAL compaction
+    void dump (const std::function<void(const njson&)>& emit) const
+    {
+      static const std::size_t BatchSize = 64U;
+
+      for (const auto& [name, collection] : m_collections)
+      {
+        njson create;
+        create[Cmds::create.req.data()]["name"] = name;
+        create[Cmds::create.req.data()]["dim"] = collection.dimensions();
+        create[Cmds::create.req.data()]["quant"] = toString(collection.quantization());
+        emit(create);
+
+        // int8 vectors are emitted dequantized, which quantize to the same codes
+        for (std::size_t start = 0 ; start < collection.size() ; start += BatchSize)
+        {
+          njson request;
+          auto& body = request[Cmds::add.req.data()];
+          body["name"] = name;
+          body["vectors"] = njson::make_array();
+
+          for (std::size_t id = start ; id < std::min(start + BatchSize, collection.size()) ; ++id)
+          {
+            const auto vector = collection.get(id);
+            body["vectors"].push_back(njson{jsoncons::json_array_arg, vector.cbegin(), vector.cend()});
+          }
+
+          emit(request);
+        }
+      }
+    }
+
+
+    /*
+    Writes all collections to snapshot files in 'dir'. Can run in a forked child (background save).
+
+    A collection is written a block per record:
+      name | dimensions (u64) | quantization (u64) | n (u64) | n * dimensions floats
+
+    or with Quantization::Int8:
+      name | dimensions (u64) | quantization (u64) | n (u64) | n scales (floats) | n * dimensions codes
+
+    An empty collection has one record with n of 0.
+    */
+    bool save (const fs::path& dir, const snapshot::Codec codec) const
+    {
+      fs::create_directories(dir);
+
+      snapshot::SnapshotWriter writer{dir, codec};
+
+      auto putHeader = [&writer](const std::string& name, const Collection& collection, const std::size_t n)
+      {
+        writer.putString(name);
+        writer.putU64(collection.dimensions());
+        writer.putU64(toUnderlying(collection.quantization()));
+        writer.putU64(n);
+      };
+
+      for (const auto& [name, collection] : m_collections)
+      {
+        if (collection.blocks().empty())
+        {
+          putHeader(name, collection, 0);
+          writer.endRecord();
+        }
+
+        for (const auto& block : collection.blocks())
+        {
+          putHeader(name, collection, block->size());
+
+          if (collection.quantization() == Quantization::None)
+            writer.putBytes(block->values.data(), block->values.size() * sizeof(float));
+          else
+          {
+            writer.putBytes(block->scales.data(), block->scales.size() * sizeof(float));
+            writer.putBytes(block->codes.data(), block->codes.size());
+          }
+
+          writer.endRecord();
+        }
+      }
+
+      writer.close();
+      return true;
+    }
+
+
+    // Loads collections written by save(), replacing collections with the same name. Throws on error.
+    std::size_t load (const fs::path& dir)
+    {
+      std::size_t nCollections{0};
+
+      if (!fs::exists(dir))
+        return nCollections;
+
+      ankerl::unordered_dense::set<std::string> loaded;
+      std::vector<float> values;
+
+      // in the order written, a vector's id is its position in its collection's records
+      for (const auto& file : snapshot::dataFiles(dir))
+      {
+        snapshot::SnapshotReader reader{file};
+
+        while (reader.nextBlock())
+        {
+          for (std::uint32_t i = 0 ; i < reader.blockRecords() ; ++i)
+          {
+            std::string name {reader.getString()};
+            const auto dimensions = reader.getU64();
+            const auto quantization = static_cast<Quantization>(reader.getU64());
+            const auto n = reader.getU64();
+
+            // the first record replaces an existing collection
+            if (!loaded.contains(name))
+            {
+              m_collections.insert_or_assign(name, Collection{dimensions, quantization});
+              loaded.insert(name);
+              ++nCollections;
+            }
+
+            auto& collection = m_collections.at(name);
+
+            if (quantization == Quantization::None)
+            {
+              const auto bytes = reader.getBytes(n * dimensions * sizeof(float));
+              values.resize(n * dimensions);
+              std::memcpy(values.data(), bytes.data(), bytes.size());
+
+              for (std::uint64_t v = 0 ; v < n ; ++v)
+                collection.add(std::span{values}.subspan(v * dimensions, dimensions));
+            }
+            else
+            {
+              const auto scaleBytes = reader.getBytes(n * sizeof(float));
+              values.resize(n);
+              std::memcpy(values.data(), scaleBytes.data(), scaleBytes.size());
+
+              const auto codes = reader.getBytes(n * dimensions);
+
+              for (std::uint64_t v = 0 ; v < n ; ++v)
+                collection.addCodes({reinterpret_cast<const std::int8_t *>(codes.data()) + v * dimensions, dimensions}, values[v]);
+            }
+          }
+        }
+      }
+
+      return nCollections;
+    }
+
+
+  private:
+
+    struct SearchState
+    {
+      Snapshot snapshot;
+      std::vector<float> query;
+      Metric metric;
+      std::size_t k;
+      std::vector<std::vector<Match>> partials;
+      std::atomic_size_t remaining;
+      std::promise<Response> promise;
+      std::function<void()> onDone;
+    };
+
+
+    static std::vector<float> toVector (const njson& values)
+    {
+      std::vector<float> vector;
+      vector.reserve(values.size());
+
+      for (const auto& value : values.array_range())
+        vector.push_back(value.as<float>());
+
+      return vector;
+    }
+
+
+    // "metric" has been validated, cosine if not set
+    static Metric metricOf (const njson& body)
+    {
+      return body.contains("metric") ? toMetric(body.at("metric").as_string_view()).value() : Metric::Cosine;
+    }
+
+
+    // "ids" and "scores", best first. For L2, the score is the distance.
+    static Response searchResponse (const std::vector<Match>& matches, const Metric metric)
+    {
+      static constexpr auto RspName = Cmds::search.rsp.data();
+
+      Response response;
+      response.rsp = njson{jsoncons::json_object_arg, {{RspName, njson::object()}}};
+
+      auto& body = response.rsp.at(RspName);
+      body["st"] = toUnderlying(RequestStatus::Ok);
+      body["ids"] = njson::make_array();
+      body["scores"] = njson::make_array();
+
+      for (const auto& match : matches)
+      {
+        body["ids"].push_back(match.id);
+        body["scores"].push_back(metric == Metric::L2 ? std::sqrt(-match.score) : match.score);
+      }
+
+      return response;
+    }
+
+
+    std::tuple<RequestStatus, Iterator> checkSearch (njson& request)
+    {
+      if (const auto status = validateSearch<Cmds>(request); status != RequestStatus::Ok)
+        return {status, m_collections.end()};
+
+      const auto& body = request.at(Cmds::search.req);
+
+      if (const auto [exist, it] = getCollection(body); !exist)
+        return {RequestStatus::NotExist, it};
+      else if (body.at("vector").size() != it->second.dimensions())
+        return {RequestStatus::ValueSize, it};
+      else
+        return {RequestStatus::Ok, it};
+    }
+
+
+    // SEARCH on this thread
+    Response searchNow (njson& request)
+    {
+      static constexpr auto RspName = Cmds::search.rsp.data();
+
+      if (const auto [status, it] = checkSearch(request); status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else
+      {
+        const auto& body = request.at(Cmds::search.req);
+        const auto snapshot = it->second.snapshot();
+        const auto metric = metricOf(body);
+
+        return searchResponse(vec::search(snapshot, 0, snapshot.blocks.size(), toVector(body.at("vector")), metric, body.at("k").template as<std::size_t>()), metric);
+      }
+    }
+
+
+    Response create(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::create.req.data();
+      static constexpr auto RspName = Cmds::create.rsp.data();
+
+      if (const auto status = validateCreate<Cmds>(request); status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      if (const auto& name = body.at("name").as_string(); m_collections.contains(name))
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Duplicate)};
+      else
+      {
+        const auto quantization = body.contains("quant") ? toQuantization(body.at("quant").as_string_view()).value() : Quantization::None;
+        m_collections.try_emplace(name, Collection{body.at("dim").template as<std::size_t>(), quantization});
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+      }
+    }
+
+
+    Response deleteCollection(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::del.req.data();
+      static constexpr auto RspName = Cmds::del.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else
+      {
+        const auto erased = m_collections.erase(request.at(ReqName).at("name").as_string());
+        return Response{.rsp = createErrorResponse(RspName, erased ? RequestStatus::Ok : RequestStatus::NotExist)};
+      }
+    }
+
+
+    Response deleteAll(njson& request)
+    {
+      m_collections.clear();
+      return Response{.rsp = createErrorResponse(Cmds::deleteAll.rsp.data(), RequestStatus::Ok)};
+    }
+
+
+    Response exist(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::exist.req.data();
+      static constexpr auto RspName = Cmds::exist.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else
+      {
+        const auto exists = m_collections.contains(request.at(ReqName).at("name").as_string());
+        return Response{.rsp = createErrorResponse(RspName, exists ? RequestStatus::Ok : RequestStatus::NotExist)};
+      }
+    }
+
+
+    // All vectors are checked before any are added. Returns "first", the id of the first vector added.
+    Response add(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::add.req.data();
+      static constexpr auto RspName = Cmds::add.rsp.data();
+
+      if (const auto status = validateAdd<Cmds>(request) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(ReqName);
+
+      if (auto [exist, it] = getCollection(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        auto& collection = it->second;
+        const auto vectors = body.at("vectors").array_range();
+
+        if (!std::all_of(vectors.cbegin(), vectors.cend(), [dimensions = collection.dimensions()](const njson& vector){ return vector.size() == dimensions; }))
+          return Response{.rsp = createErrorResponse(RspName, RequestStatus::ValueSize)};
+
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["first"] = collection.size();
+
+        for (const auto& vector : vectors)
+          collection.add(toVector(vector));
+
+        return response;
+      }
+    }
+
+
+    Response get(njson& request)
+    {
+      static constexpr auto RspName = Cmds::get.rsp.data();
+
+      if (const auto status = validateGet<Cmds>(request) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+
+      const auto& body = request.at(Cmds::get.req);
+
+      if (const auto [exist, it] = getCollection(body); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else if (const auto id = body.at("id").template as<std::uint64_t>(); id >= it->second.size())
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Bounds)};
+      else
+      {
+        const auto vector = it->second.get(id);
+
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["vector"] = njson{jsoncons::json_array_arg, vector.cbegin(), vector.cend()};
+        return response;
+      }
+    }
+
+
+    Response length(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::len.req.data();
+      static constexpr auto RspName = Cmds::len.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else if (const auto [exist, it] = getCollection(request.at(ReqName)); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        Response response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+        response.rsp[RspName]["len"] = it->second.size();
+        return response;
+      }
+    }
+
+
+    Response clear(njson& request)
+    {
+      static constexpr auto ReqName = Cmds::clear.req.data();
+      static constexpr auto RspName = Cmds::clear.rsp.data();
+
+      if (const auto status = validateName<Cmds>(request, ReqName, RspName) ; status != RequestStatus::Ok)
+        return Response{.rsp = createErrorResponse(RspName, status)};
+      else if (auto [exist, it] = getCollection(request.at(ReqName)); !exist)
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::NotExist)};
+      else
+      {
+        it->second.clear();
+        return Response{.rsp = createErrorResponse(RspName, RequestStatus::Ok)};
+      }
+    }
+
+
+  private:
+
+    std::tuple<bool, Iterator> getCollection (const njson& body)
+    {
+      const auto it = m_collections.find(body.at("name").as_string());
+      return {it != m_collections.end(), it};
+    }
+
+
+  private:
+    Collections m_collections;
+    std::unique_ptr<ThreadPool> m_pool;   // created by the first search which needs it, not used by save() so safe with fork()
+  };
+
+
+  using VectorHandler = VecHandler<VectorCmds>;
+}
+}
+
+#endif
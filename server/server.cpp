@@ -76,9 +76,23 @@ int main (int argc, char ** argv)
 
 
   if (settings.persistEnabled)
-    PLOGI << "Persist: Enabled (" << settings.persistPath << ')';
+    PLOGI << "Persist: Enabled (" << settings.persistPath << ", compression: " << nemesis::snapshot::toString(settings.persistCompression) << ')';
   else
     PLOGI << "Persist: Disabled";
+
+  if (settings.wal.enabled)
+  {
+    static const char * FsyncNames[] = {"always", "everysec", "no"};
+    PLOGI << "WAL: Enabled (fsync: " << FsyncNames[toUnderlying(settings.wal.fsync)] << ")";
+  }
+
+  if (settings.replication.role == nemesis::ReplicationRole::Primary)
+    PLOGI << "Replication: Primary (port: " << settings.replication.port << ')';
+  else if (settings.replication.role == nemesis::ReplicationRole::Replica)
+    PLOGI << "Replication: Replica (primary: " << settings.replication.primaryIp << ':' << settings.replication.primaryPort << ')';
+
+  if (settings.cluster.enabled)
+    PLOGI << "Cluster: Enabled (" << settings.cluster.nodes.size() << " nodes)";
   
   PLOGI << "Arrays Max Capacity: " << settings.arrays.maxCapacity << " elements";
   PLOGI << "Arrays Max Rsp Size: " << settings.arrays.maxRspSize << " elements";
@@ -1,7 +1,9 @@
 from unittest import IsolatedAsyncioTestCase
 from ndb.client import NdbClient
-from ndb.arrays import ObjArrays, IntArrays, SortedIntArrays, StringArrays, SortedStrArrays
+from ndb.arrays import ObjArrays, IntArrays, SortedIntArrays, StringArrays, SortedStrArrays, FloatArrays, SortedFloatArrays
 from ndb.lists import ObjLists
+from ndb.vectors import Vectors
+from ndb.intsets import IntSets
 from ndb.kv import KV
 from ndb.sv import SV
 
@@ -63,8 +65,36 @@ class SortedStrArrayTest(NDBTest):
     await self.arrays.delete_all()
 
 
+class FloatArrayTest(NDBTest):
+  async def asyncSetUp(self):
+    await super().asyncSetUp()
+    self.arrays = FloatArrays(self.client)
+    await self.arrays.delete_all()
+
+
+class SortedFloatArrayTest(NDBTest):
+  async def asyncSetUp(self):
+    await super().asyncSetUp()
+    self.arrays = SortedFloatArrays(self.client)
+    await self.arrays.delete_all()
+
+
 class ObjListTest(NDBTest):
   async def asyncSetUp(self):
     await super().asyncSetUp()
     self.lists = ObjLists(self.client)
-    await self.lists.delete_all() # TODO
\ No newline at end of file
+    await self.lists.delete_all() # TODO
+
+
+class VecTest(NDBTest):
+  async def asyncSetUp(self):
+    await super().asyncSetUp()
+    self.vectors = Vectors(self.client)
+    await self.vectors.delete_all()
+
+
+class IntSetTest(NDBTest):
+  async def asyncSetUp(self):
+    await super().asyncSetUp()
+    self.sets = IntSets(self.client)
+    await self.sets.delete_all()
@@ -0,0 +1,139 @@
+import asyncio
+import unittest
+from unittest import IsolatedAsyncioTestCase
+from ndb.client import NdbClient
+from ndb.cluster import ClusterKV, key_slot
+from ndb.common import ResponseError
+from ndb.kv import KV
+from ndb.sv import SV
+
+
+# Requires two nodes, see run_cluster.sh: 1987 owns slots 0-8191, 1990 owns 8192-16383
+
+NODE1 = '127.0.0.1:1987'
+NODE2 = '127.0.0.1:1990'
+
+ST_MOVED = 171
+ST_CROSS_SLOT = 173
+
+
+class Cluster(IsolatedAsyncioTestCase):
+  async def asyncSetUp(self):
+    self.node1 = NdbClient()
+    await self.node1.open(f'ws://{NODE1}')
+    self.node2 = NdbClient()
+    await self.node2.open(f'ws://{NODE2}')
+
+    await KV(self.node1).clear()
+    await KV(self.node2).clear()
+
+    self.kv = ClusterKV()
+    await self.kv.open(NODE1)
+
+
+  async def asyncTearDown(self):
+    await self.kv.close()
+
+
+  def ownerOf(self, slots: dict, slot: int) -> str:
+    for rng in slots['slots']:
+      if rng['start'] <= slot <= rng['end']:
+        return rng['node']
+
+
+  async def test_slots(self):
+    slots = await SV(self.node1).cluster_slots()
+    self.assertEqual(slots['self'], NODE1)
+    self.assertEqual(self.ownerOf(slots, 0), NODE1)
+    self.assertEqual(self.ownerOf(slots, 16383), NODE2)
+
+    # both nodes have the same map
+    self.assertEqual(slots['slots'], (await SV(self.node2).cluster_slots())['slots'])
+
+
+  async def test_keys_split(self):
+    for i in range(200):
+      await self.kv.set(f'key{i}', i)
+
+    for i in range(200):
+      self.assertEqual(await self.kv.get(f'key{i}'), i)
+
+    count1 = await KV(self.node1).count()
+    count2 = await KV(self.node2).count()
+    self.assertEqual(count1 + count2, 200)
+    self.assertGreater(count1, 0)
+    self.assertGreater(count2, 0)
+
+
+  async def test_moved(self):
+    key = 'foo' # slot 12182, node2
+    self.assertEqual(key_slot(key), 12182)
+
+    rsp = await self.node1.sendCmd('KV_SET', 'KV_SET_RSP', {'keys':{key:1}}, checkStatus=False)
+    self.assertEqual(rsp['KV_SET_RSP']['st'], ST_MOVED)
+    self.assertEqual(rsp['KV_SET_RSP']['slot'], 12182)
+    self.assertEqual(rsp['KV_SET_RSP']['node'], NODE2)
+
+    await KV(self.node2).set({key:1})
+    self.assertEqual(await KV(self.node2).get(key=key), 1)
+
+
+  async def test_cross_slot(self):
+    # 'a' is slot 15495 (node2), 'b' is 3300 (node1)
+    rsp = await self.node1.sendCmd('KV_GET', 'KV_GET_RSP', {'keys':['a', 'b']}, checkStatus=False)
+    self.assertEqual(rsp['KV_GET_RSP']['st'], ST_CROSS_SLOT)
+
+    # hash tags put keys in the same slot
+    self.assertEqual(key_slot('{user1}.name'), key_slot('{user1}.email'))
+
+
+  async def migrate(self, slot: int, source: NdbClient, target: str):
+    await SV(source).cluster_migrate(slot, target)
+
+    for _ in range(100):
+      slots = await SV(source).cluster_slots()
+      if 'migrating' not in slots:
+        break
+      await asyncio.sleep(0.05)
+
+    self.assertEqual(self.ownerOf(slots, slot), target)
+
+
+  async def test_migrate(self):
+    # keys in one slot, with a hash tag
+    keys = {f'{{tag}}.{i}':i for i in range(3000)}
+    slot = key_slot('{tag}')
+    source, sourceClient, target, targetClient = (NODE1, self.node1, NODE2, self.node2) if slot < 8192 else (NODE2, self.node2, NODE1, self.node1)
+
+    for k, v in keys.items():
+      await self.kv.set(k, v)
+
+    await self.migrate(slot, sourceClient, target)
+
+    # keys moved, both nodes know the new owner
+    self.assertEqual(await KV(targetClient).count(), len(keys))
+    self.assertEqual(await KV(sourceClient).count(), 0)
+    self.assertEqual(self.ownerOf(await SV(targetClient).cluster_slots(), slot), target)
+
+    rsp = await sourceClient.sendCmd('KV_GET', 'KV_GET_RSP', {'keys':['{tag}.1']}, checkStatus=False)
+    self.assertEqual(rsp['KV_GET_RSP']['st'], ST_MOVED)
+    self.assertEqual(rsp['KV_GET_RSP']['node'], target)
+
+    # the client follows the redirect
+    self.assertEqual(await self.kv.get('{tag}.2999'), 2999)
+
+    # and back, so other tests see the configured map
+    await self.migrate(slot, targetClient, source)
+    self.assertEqual(await KV(sourceClient).count(), len(keys))
+
+
+  async def test_migrate_invalid(self):
+    with self.assertRaises(ResponseError):
+      await SV(self.node1).cluster_migrate(16383, NODE2)  # not owned by node1
+
+    with self.assertRaises(ResponseError):
+      await SV(self.node1).cluster_migrate(0, '127.0.0.1:9999') # not a node
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,40 @@
+import unittest
+from base import FloatArrayTest
+from ndb.client import ResponseError
+
+
+class Array(FloatArrayTest):
+  async def test_create(self):
+    await self.arrays.create('a', 30)
+    self.assertEqual(await self.arrays.capacity('a'), 30)
+
+
+  async def test_set_get(self):
+    await self.arrays.create('a', 5)
+
+    await self.arrays.set('a', 1.5, 0)
+    await self.arrays.set('a', -0.25, 3)
+    self.assertEqual(await self.arrays.get('a', 0), 1.5)
+    self.assertEqual(await self.arrays.get('a', 3), -0.25)
+
+    # integers are accepted and stored as floats
+    await self.arrays.set('a', 7, 1)
+    self.assertEqual(await self.arrays.get('a', 1), 7.0)
+
+
+  async def test_set_rng(self):
+    items = [0.5, 1.0, 1.5, 2.0]
+    await self.arrays.create('a', 10)
+    await self.arrays.set_rng('a', items)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), items)
+
+
+  async def test_invalid_type(self):
+    await self.arrays.create('a', 5)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.set('a', 'x', 0)
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,170 @@
+import unittest
+from base import FloatArrayTest
+from ndb.client import ResponseError
+
+
+class Math(FloatArrayTest):
+  async def test_sum_avg(self):
+    items = [0.5, -1.25, 3.0, 2.75, 0.0, 1.0]
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    self.assertEqual(await self.arrays.sum('a'), sum(items))
+    self.assertEqual(await self.arrays.sum('a', 1, 4), sum(items[1:4]))
+    self.assertEqual(await self.arrays.avg('a'), sum(items) / len(items))
+
+
+  async def test_sum_long(self):
+    # longer than the SIMD width, with a remainder. Multiples of 0.25 are summed exactly
+    items = [((i * 7919) % 1000 - 500) * 0.25 for i in range(1003)]
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    self.assertEqual(await self.arrays.sum('a'), sum(items))
+    self.assertEqual(await self.arrays.sum('a', 3, 1000), sum(items[3:1000]))
+
+
+  async def test_min_max(self):
+    items = [float((i * 7919) % 1000) for i in range(100)]
+    items[40] = -5.5
+    items[75] = -5.5    # first occurrence is reported
+    items[60] = 5000.25
+
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    self.assertEqual(await self.arrays.min('a'), (-5.5, 40))
+    self.assertEqual(await self.arrays.max('a'), (5000.25, 60))
+    self.assertEqual(await self.arrays.min('a', 41), (-5.5, 75))
+
+
+  async def test_dot(self):
+    a = [float(i % 7) for i in range(100)]
+    b = [float(i % 5) - 2 for i in range(100)]
+    await self.arrays.create('a', len(a))
+    await self.arrays.create('b', len(b))
+    await self.arrays.set_rng('a', a)
+    await self.arrays.set_rng('b', b)
+
+    self.assertEqual(await self.arrays.dot('a', 'b'), sum(x * y for x, y in zip(a, b)))
+    self.assertEqual(await self.arrays.dot('a', 'b', 10, 20), sum(x * y for x, y in zip(a[10:20], b[10:20])))
+    self.assertEqual(await self.arrays.dot('a', 'a'), sum(x * x for x in a))
+
+
+  async def test_dot_different_capacity(self):
+    # limited to the smaller capacity
+    await self.arrays.create('a', 3)
+    await self.arrays.create('b', 5)
+    await self.arrays.set_rng('a', [1.0, 2.0, 3.0])
+    await self.arrays.set_rng('b', [4.0, 5.0, 6.0, 7.0, 8.0])
+
+    self.assertEqual(await self.arrays.dot('a', 'b'), 32.0)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.dot('a', 'b', 3)
+
+
+  async def test_scalar(self):
+    await self.arrays.create('a', 4)
+    await self.arrays.set_rng('a', [1.0, 2.0, 3.0, 4.0])
+
+    await self.arrays.add('a', 1.5)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [2.5, 3.5, 4.5, 5.5])
+
+    await self.arrays.sub('a', 0.5, start=1, stop=3)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [2.5, 3.0, 4.0, 5.5])
+
+    await self.arrays.mul('a', 2)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [5.0, 6.0, 8.0, 11.0])
+
+    await self.arrays.div('a', 4, start=2)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [5.0, 6.0, 2.0, 2.75])
+
+
+  async def test_array(self):
+    await self.arrays.create('a', 4)
+    await self.arrays.create('b', 4)
+    await self.arrays.set_rng('a', [1.0, 2.0, 3.0, 4.0])
+    await self.arrays.set_rng('b', [0.5, 0.5, 2.0, 2.0])
+
+    await self.arrays.add('a', src='b')
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [1.5, 2.5, 5.0, 6.0])
+
+    await self.arrays.mul('a', src='b', start=2)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [1.5, 2.5, 10.0, 12.0])
+
+    await self.arrays.div('a', src='b')
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [3.0, 5.0, 5.0, 6.0])
+
+    # the source can be the same array
+    await self.arrays.sub('a', src='a')
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [0.0, 0.0, 0.0, 0.0])
+
+
+  async def test_long(self):
+    items = [i * 0.5 for i in range(1003)]
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    await self.arrays.mul('a', 2)
+    self.assertListEqual(await self.arrays.get_rng('a', 0, len(items)), [x * 2 for x in items])
+
+
+  # a page is 512 items, unset pages are zero
+  async def test_paged(self):
+    await self.arrays.create('a', 3000, layout='paged')
+    await self.arrays.create('b', 3000, layout='paged')
+    await self.arrays.set('a', 4.0, pos=600)
+    await self.arrays.set('b', 2.0, pos=600)
+    await self.arrays.set('b', 1.5, pos=2500)
+
+    await self.arrays.mul('a', 3)
+    await self.arrays.add('a', src='b')
+    self.assertEqual(await self.arrays.get('a', 600), 14.0)
+    self.assertEqual(await self.arrays.get('a', 2500), 1.5)
+    self.assertEqual(await self.arrays.get('a', 10), 0.0)
+    self.assertEqual(await self.arrays.sum('a'), 15.5)
+    self.assertEqual(await self.arrays.dot('a', 'b'), 30.25)
+
+    await self.arrays.add('a', 1, start=2990)
+    self.assertEqual(await self.arrays.get_rng('a', 2989, 2992), [0.0, 1.0, 1.0])
+    self.assertEqual(await self.arrays.min('a'), (0.0, 0))
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.div('a', src='b')
+
+
+  async def test_divide_by_zero(self):
+    await self.arrays.create('a', 3)
+    await self.arrays.create('b', 3)
+    await self.arrays.set_rng('a', [1.0, 2.0, 3.0])
+    await self.arrays.set_rng('b', [1.0, 0.0, 1.0])
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.div('a', 0)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.div('a', src='b')
+
+    # unchanged
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 3), [1.0, 2.0, 3.0])
+
+
+  async def test_invalid(self):
+    await self.arrays.create('a', 3)
+
+    with self.assertRaises(ValueError):
+      await self.arrays.add('a')
+
+    with self.assertRaises(ValueError):
+      await self.arrays.add('a', 1.0, 'a')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.add('a', src='b')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.dot('a', 'b')
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,77 @@
+import asyncio
+import os
+import subprocess
+import unittest
+from unittest import IsolatedAsyncioTestCase
+from ndb.client import NdbClient
+from ndb.arrays import IntArrays
+from ndb.kv import KV
+
+
+# Requires a server on 1987, see run_handoff.sh. The test starts a
+# second server with --handoff, which takes over the data and the port.
+
+
+def server_pids() -> list:
+  out = subprocess.run(['pgrep', '-x', 'nemesisdb'], capture_output=True, text=True).stdout
+  return [int(pid) for pid in out.split()]
+
+
+class Handoff(IsolatedAsyncioTestCase):
+  async def connect(self) -> NdbClient:
+    client = NdbClient()
+    await client.open('ws://127.0.0.1:1987')
+    return client
+
+
+  async def test_handoff(self):
+    client = await self.connect()
+    kv = KV(client)
+    arrays = IntArrays(client)
+
+    await kv.clear()
+    await arrays.delete_all()
+
+    await kv.set({f'key{i}':{'i':i} for i in range(10000)})
+    await arrays.create('handed', 5)
+    await arrays.set_rng('handed', [1,2,3])
+
+    [oldPid] = server_pids()
+
+    newServer = subprocess.Popen([f'{os.environ["NDB_BIN_DIR"]}/nemesisdb', f'--config={os.environ["NDB_CONFIG"]}', '--handoff'],
+                                 cwd=os.environ['NDB_BIN_DIR'],
+                                 stdout=subprocess.DEVNULL)
+
+    # writes whilst the data is copied are sent to the new server, until
+    # the old server closes this connection
+    lastWrite = None
+    try:
+      for i in range(200):
+        await kv.set({'during':i})
+        lastWrite = i
+        await asyncio.sleep(0.005)
+    except Exception:
+      pass
+
+    # the old server exits when the new one is listening
+    for _ in range(100):
+      if oldPid not in server_pids():
+        break
+      await asyncio.sleep(0.1)
+
+    self.assertNotIn(oldPid, server_pids())
+    self.assertIsNone(newServer.poll())
+
+    client = await self.connect()
+    kv = KV(client)
+
+    self.assertEqual(await kv.count(), 10001)
+    self.assertEqual(await kv.get(key='key1234'), {'i':1234})
+    self.assertEqual(await kv.get(key='during'), 199)
+    self.assertEqual(await IntArrays(client).get_rng('handed', 0), [1,2,3])
+
+    await client.close()
+
+
+if __name__ == "__main__":
+  unittest.main()
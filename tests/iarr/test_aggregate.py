@@ -0,0 +1,115 @@
+import unittest
+from base import IArrayTest
+from ndb.client import ResponseError
+
+
+class Aggregate(IArrayTest):
+  async def test_sum_avg(self):
+    await self.arrays.create('a', 6)
+    await self.arrays.set_rng('a', [5, -3, 10, 7, 0, 2])
+
+    self.assertEqual(await self.arrays.sum('a'), 21)
+    self.assertEqual(await self.arrays.sum('a', 1, 4), 14)
+    self.assertEqual(await self.arrays.avg('a'), 3.5)
+    self.assertEqual(await self.arrays.avg('a', 2, 4), 8.5)
+
+
+  async def test_sum_long(self):
+    # longer than the SIMD width, with a remainder
+    items = [(i * 7919) % 1000 - 500 for i in range(1003)]
+
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    self.assertEqual(await self.arrays.sum('a'), sum(items))
+    self.assertEqual(await self.arrays.sum('a', 3, 1000), sum(items[3:1000]))
+
+
+  async def test_sum_overflow(self):
+    # exceeds int64, returned as a float
+    big = 2**63 - 1
+
+    await self.arrays.create('a', 3)
+    await self.arrays.set_rng('a', [big, big, big])
+
+    self.assertEqual(await self.arrays.sum('a'), float(3 * big))
+    self.assertEqual(await self.arrays.avg('a'), float(big))
+
+    await self.arrays.set_rng('a', [big, 1, -big], 0)
+    self.assertEqual(await self.arrays.sum('a'), 1)
+
+
+  async def test_min_max(self):
+    items = [(i * 7919) % 1000 for i in range(100)]
+    items[40] = -5
+    items[75] = -5    # first occurrence is reported
+    items[60] = 5000
+
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    self.assertEqual(await self.arrays.min('a'), (-5, 40))
+    self.assertEqual(await self.arrays.max('a'), (5000, 60))
+
+    # positions are within the array, not the range
+    self.assertEqual(await self.arrays.min('a', 41), (-5, 75))
+    expected = min(items[0:30])
+    self.assertEqual(await self.arrays.min('a', 0, 30), (expected, items.index(expected)))
+
+
+  async def test_count_eq(self):
+    items = [i % 3 for i in range(50)]
+
+    await self.arrays.create('a', len(items))
+    await self.arrays.set_rng('a', items)
+
+    self.assertEqual(await self.arrays.count_eq('a', 2), items.count(2))
+    self.assertEqual(await self.arrays.count_eq('a', 2, 10, 20), items[10:20].count(2))
+    self.assertEqual(await self.arrays.count_eq('a', 7), 0)
+
+
+  async def test_histogram(self):
+    await self.arrays.create('a', 10)
+    await self.arrays.set_rng('a', [-10, 0, 1, 4, 5, 9, 10, 11, 100, 3])
+
+    # [0, 10] in 4 buckets is width 3: [0,3), [3,6), [6,9), [9,11)
+    result = await self.arrays.histogram('a', 0, 10, 4)
+    self.assertDictEqual(result, {'counts':[2, 3, 0, 2], 'width':3, 'below':1, 'above':2})
+
+    result = await self.arrays.histogram('a', 0, 10, 1, 2, 6)
+    self.assertDictEqual(result, {'counts':[4], 'width':11, 'below':0, 'above':0})
+
+
+  async def test_stop_beyond_capacity(self):
+    # unset positions are 0, stop is limited to the capacity
+    await self.arrays.create('a', 5)
+    await self.arrays.set_rng('a', [1, 2, 3])
+
+    self.assertEqual(await self.arrays.sum('a', 0, 100), 6)
+    self.assertEqual(await self.arrays.count_eq('a', 0), 2)
+
+
+  async def test_invalid(self):
+    await self.arrays.create('a', 5)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.sum('a', 5)   # start out of bounds
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.sum('b')
+
+    with self.assertRaises(ValueError):
+      await self.arrays.sum('a', 2, 2)
+
+    with self.assertRaises(ValueError):
+      await self.arrays.histogram('a', 10, 0, 4)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.histogram('a', 0, 10, 100000)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.histogram('a', 0, 2**63, 4)   # above int64
+
+
+if __name__ == "__main__":
+  unittest.main()
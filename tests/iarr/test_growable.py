@@ -0,0 +1,105 @@
+import unittest
+from base import IArrayTest
+from ndb.client import ResponseError
+
+
+class Growable(IArrayTest):
+  async def test_create_empty(self):
+    await self.arrays.create('arr', 0, growable=True)
+    self.assertEqual(await self.arrays.capacity('arr'), 0)
+
+    # only a growable array can be empty
+    with self.assertRaises(ValueError):
+      await self.arrays.create('fixed', 0)
+
+
+  async def test_grow_set(self):
+    await self.arrays.create('arr', 2, growable=True)
+
+    for i in range(5):
+      await self.arrays.set('arr', i)
+
+    # doubles: 2, 4, 8
+    self.assertEqual(await self.arrays.capacity('arr'), 8)
+    self.assertEqual(await self.arrays.used('arr'), 5)
+    self.assertEqual(await self.arrays.get_rng('arr', 0), [0, 1, 2, 3, 4])
+
+
+  async def test_grow_set_pos(self):
+    await self.arrays.create('arr', 1, growable=True)
+    await self.arrays.set('arr', 7, pos=100)
+
+    self.assertEqual(await self.arrays.capacity('arr'), 101)
+    self.assertEqual(await self.arrays.get('arr', 100), 7)
+
+
+  async def test_grow_set_rng(self):
+    await self.arrays.create('arr', 2, growable=True)
+    await self.arrays.set_rng('arr', [1, 2, 3])
+    await self.arrays.set_rng('arr', [4, 5, 6, 7, 8, 9, 10], pos=3)
+
+    self.assertEqual(await self.arrays.capacity('arr'), 10)
+    self.assertEqual(await self.arrays.get_rng('arr', 0), [1, 2, 3, 4, 5, 6, 7, 8, 9, 10])
+
+
+  async def test_grown_aggregate(self):
+    await self.arrays.create('arr', 2, growable=True)
+    await self.arrays.set_rng('arr', [3, 1, 2, 4, 5])
+    await self.arrays.set('arr', 6, pos=6)
+
+    # capacity is 10, the range ends at the last value set rather than the capacity
+    self.assertEqual(await self.arrays.capacity('arr'), 10)
+    self.assertEqual(await self.arrays.avg('arr'), 3)
+    self.assertEqual(await self.arrays.count_eq('arr', 0), 1)
+    self.assertEqual(await self.arrays.min('arr'), (0, 5))
+    self.assertEqual(await self.arrays.max('arr', 0, 10), (6, 6))
+
+
+  async def test_max_capacity(self):
+    # maxCapacity is the ceiling
+    await self.arrays.create('arr', 1, growable=True)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.set('arr', 1, pos=100000)
+
+
+  async def test_fixed_does_not_grow(self):
+    await self.arrays.create('arr', 2)
+    await self.arrays.set_rng('arr', [1, 2])
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.set('arr', 3)
+
+    # set_rng beyond the capacity is rejected rather than partially written
+    await self.arrays.create('arr2', 3)
+    with self.assertRaises(ResponseError):
+      await self.arrays.set_rng('arr2', [1, 2, 3, 4])
+
+
+  async def test_reserve_shrink(self):
+    await self.arrays.create('arr', 2)
+    self.assertEqual(await self.arrays.reserve('arr', 10), 10)
+    self.assertEqual(await self.arrays.reserve('arr', 5), 10)   # doesn't reduce
+
+    await self.arrays.set_rng('arr', [1, 2, 3])
+    await self.arrays.set('arr', 9, pos=6)
+
+    # keeps the value set by position
+    self.assertEqual(await self.arrays.shrink('arr'), 7)
+    self.assertEqual(await self.arrays.get('arr', 6), 9)
+    self.assertEqual(await self.arrays.get_rng('arr', 0), [1, 2, 3])
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.reserve('arr', 100000)
+
+
+  async def test_shrink_empty(self):
+    await self.arrays.create('fixed', 10)
+    await self.arrays.create('growable', 10, growable=True)
+
+    self.assertEqual(await self.arrays.shrink('fixed'), 1)
+    self.assertEqual(await self.arrays.shrink('growable'), 0)
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,92 @@
+import unittest
+from base import IArrayTest
+from ndb.client import ResponseError
+
+
+# an int page is 512 items, so these cross pages
+class Paged(IArrayTest):
+  async def test_create(self):
+    await self.arrays.create('arr', 5000, layout='paged')
+    self.assertEqual(await self.arrays.capacity('arr'), 5000)
+    self.assertEqual(await self.arrays.used('arr'), 0)
+
+    with self.assertRaises(ValueError):
+      await self.arrays.create('arr2', 10, layout='blocked')
+
+
+  async def test_unset_is_zero(self):
+    await self.arrays.create('arr', 5000, layout='paged')
+    await self.arrays.set('arr', 7, pos=4000)
+
+    self.assertEqual(await self.arrays.get('arr', 4000), 7)
+    self.assertEqual(await self.arrays.get('arr', 10), 0)
+    self.assertEqual(await self.arrays.get('arr', 3999), 0)
+
+
+  async def test_set_rng(self):
+    items = list(range(1, 1201))
+
+    await self.arrays.create('arr', 5000, layout='paged')
+    await self.arrays.set_rng('arr', items, pos=500)
+
+    self.assertEqual(await self.arrays.get_rng('arr', 500, 1700), items)
+    self.assertEqual(await self.arrays.get('arr', 1024), 525)
+
+
+  async def test_aggregate(self):
+    items = [(i * 7919) % 1000 - 500 for i in range(2000)]
+    items[600] = -1000
+    items[1500] = -1000   # first occurrence is reported, in a later page
+    items[1100] = 2000
+
+    await self.arrays.create('arr', 3000, layout='paged')
+    await self.arrays.set_rng('arr', items)
+
+    self.assertEqual(await self.arrays.sum('arr'), sum(items))
+    self.assertEqual(await self.arrays.sum('arr', 100, 1900), sum(items[100:1900]))
+    self.assertEqual(await self.arrays.min('arr'), (-1000, 600))
+    self.assertEqual(await self.arrays.min('arr', 601), (-1000, 1500))
+    self.assertEqual(await self.arrays.max('arr'), (2000, 1100))
+    # unset positions in [2000, 3000) are 0
+    self.assertEqual(await self.arrays.count_eq('arr', 0), items.count(0) + 1000)
+
+    result = await self.arrays.histogram('arr', -500, 499, 10)
+    self.assertEqual(sum(result['counts']) + result['below'] + result['above'], 3000)
+    self.assertEqual(result['below'], 2)
+    self.assertEqual(result['above'], 1)
+
+
+  async def test_swap_clear(self):
+    await self.arrays.create('arr', 5000, layout='paged')
+    await self.arrays.set_rng('arr', [1, 2, 3, 4, 5])
+    await self.arrays.set('arr', 9, pos=4500)
+
+    await self.arrays.swap('arr', 0, 4500)
+    self.assertEqual(await self.arrays.get('arr', 0), 9)
+    self.assertEqual(await self.arrays.get('arr', 4500), 1)
+
+    # cleared items move to the end, as with the vector layout
+    await self.arrays.clear('arr', 1, 3)
+    self.assertEqual(await self.arrays.get_rng('arr', 0), [9, 4, 5])
+    self.assertEqual(await self.arrays.get('arr', 4498), 1)
+    self.assertEqual(await self.arrays.get('arr', 4998), 2)
+    self.assertEqual(await self.arrays.get('arr', 4999), 3)
+
+
+  async def test_growable_shrink(self):
+    await self.arrays.create('arr', 0, layout='paged', growable=True)
+    await self.arrays.set('arr', 3, pos=2000)
+    self.assertEqual(await self.arrays.capacity('arr'), 2001)
+
+    await self.arrays.reserve('arr', 8000)
+    self.assertEqual(await self.arrays.shrink('arr'), 2001)
+    self.assertEqual(await self.arrays.get('arr', 2000), 3)
+
+
+  async def test_invalid_layout(self):
+    with self.assertRaises(ResponseError):
+      await self.arrays.client.sendCmd(self.arrays.cmds.CREATE_REQ, self.arrays.cmds.CREATE_RSP, {'name':'arr', 'len':10, 'layout':'blocked'})
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,91 @@
+import random
+import unittest
+from base import IArrayTest
+from ndb.arrays import SortedIntArrays
+from ndb.client import ResponseError
+
+
+class Sort(IArrayTest):
+  async def test_sort(self):
+    for layout in self.arrays.layouts:
+      await self.arrays.create('arr', 10, layout=layout)
+      await self.arrays.set_rng('arr', [5, -3, 9, 0, -3, 12])
+      # beyond used, which doesn't move
+      await self.arrays.set('arr', 100, pos=8)
+
+      await self.arrays.sort('arr')
+      self.assertListEqual(await self.arrays.get_rng('arr', 0), [-3, -3, 0, 5, 9, 12])
+      self.assertEqual(await self.arrays.get('arr', 8), 100)
+
+      await self.arrays.sort('arr', desc=True)
+      self.assertListEqual(await self.arrays.get_rng('arr', 0), [12, 9, 5, 0, -3, -3])
+
+      await self.arrays.delete('arr')
+
+
+  async def test_sort_large(self):
+    # large enough to sort in parallel
+    items = [random.randint(-2**62, 2**62) for _ in range(100_000)]
+
+    await self.arrays.create('arr', len(items))
+    for i in range(0, len(items), 10_000):
+      await self.arrays.set_rng('arr', items[i:i+10_000])
+
+    await self.arrays.sort('arr')
+    self.assertListEqual(await self.arrays.get_rng('arr', 0, 1000), sorted(items)[:1000])
+    self.assertListEqual(await self.arrays.get_rng('arr', 99_000), sorted(items)[99_000:])
+
+
+  async def test_unique(self):
+    for layout in self.arrays.layouts:
+      await self.arrays.create('arr', 10, layout=layout)
+      await self.arrays.set_rng('arr', [4, 1, 4, 2, 1, 3])
+      await self.arrays.set('arr', 100, pos=8)
+
+      # the first of each is kept, in order
+      self.assertEqual(await self.arrays.unique('arr'), 4)
+      self.assertEqual(await self.arrays.used('arr'), 4)
+      self.assertListEqual(await self.arrays.get_rng('arr', 0), [4, 1, 2, 3])
+      # as clear(), items beyond used move down by the number removed
+      self.assertEqual(await self.arrays.get('arr', 6), 100)
+
+      await self.arrays.sort('arr')
+      self.assertEqual(await self.arrays.unique('arr'), 4)
+
+      await self.arrays.delete('arr')
+
+
+  async def test_to_sorted(self):
+    sorted_arrays = SortedIntArrays(self.client)
+    await sorted_arrays.delete_all()
+
+    await self.arrays.create('arr', 10)
+    await self.arrays.set_rng('arr', [3, 1, 3, 2])
+
+    self.assertEqual(await self.arrays.to_sorted('arr', 'sorted'), 4)
+    self.assertListEqual(await sorted_arrays.get_rng('sorted', 0), [1, 2, 3, 3])
+
+    # replaces dest
+    self.assertEqual(await self.arrays.to_sorted('arr', 'sorted', unique=True), 3)
+    self.assertListEqual(await sorted_arrays.get_rng('sorted', 0), [1, 2, 3])
+    self.assertTrue(await sorted_arrays.contains('sorted', [2]))
+
+    # source is unchanged
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), [3, 1, 3, 2])
+
+    await sorted_arrays.delete_all()
+
+
+  async def test_not_exist(self):
+    with self.assertRaises(ResponseError):
+      await self.arrays.sort('none')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.unique('none')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.to_sorted('none', 'sorted')
+
+
+if __name__ == "__main__":
+  unittest.main()
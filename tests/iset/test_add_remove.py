@@ -0,0 +1,103 @@
+import unittest
+from base import IntSetTest
+from ndb.client import ResponseError
+
+
+class AddRemove(IntSetTest):
+  async def test_create(self):
+    await self.sets.create('s')
+    self.assertTrue(await self.sets.exist('s'))
+    self.assertFalse(await self.sets.exist('t'))
+    self.assertEqual(await self.sets.length('s'), 0)
+
+    with self.assertRaises(ResponseError):
+      await self.sets.create('s')
+
+
+  async def test_add_remove(self):
+    await self.sets.create('s')
+    self.assertEqual(await self.sets.add('s', [5, 1, 3, 1]), 3)
+    self.assertEqual(await self.sets.add('s', 3), 0)
+    self.assertEqual(await self.sets.add('s', [2**64-1, 0]), 2)
+
+    self.assertEqual(await self.sets.length('s'), 5)
+    self.assertEqual(await self.sets.get_rng('s', 0), [0, 1, 3, 5, 2**64-1])
+
+    self.assertEqual(await self.sets.remove('s', [1, 4]), 1)
+    self.assertEqual(await self.sets.remove('s', 2**64-1), 1)
+    self.assertEqual(await self.sets.get_rng('s', 0), [0, 3, 5])
+
+
+  async def test_invalid(self):
+    await self.sets.create('s')
+
+    with self.assertRaises(ResponseError):
+      await self.sets.add('s', [-1])
+
+    with self.assertRaises(ResponseError):
+      await self.sets.add('s', ['a'])
+
+    with self.assertRaises(ResponseError):
+      await self.sets.add('t', [1])
+
+    self.assertEqual(await self.sets.length('s'), 0)
+
+
+  async def test_dense(self):
+    # more than 4096 values with the same high bits, stored as a bitmap
+    await self.sets.create('s')
+    self.assertEqual(await self.sets.add('s', list(range(0, 20000, 2))), 10000)
+    self.assertEqual(await self.sets.length('s'), 10000)
+
+    self.assertTrue(await self.sets.contains('s', 19998))
+    self.assertFalse(await self.sets.contains('s', 19999))
+
+    # and back to an array
+    self.assertEqual(await self.sets.remove('s', list(range(0, 18000, 2))), 9000)
+    self.assertEqual(await self.sets.get_rng('s', 0, 3), [18000, 18002, 18004])
+
+
+  async def test_rank_select(self):
+    await self.sets.create('s')
+    await self.sets.add('s', [10, 20, 30, 70000, 2**40])
+
+    self.assertEqual(await self.sets.rank('s', 0), 0)
+    self.assertEqual(await self.sets.rank('s', 20), 1)
+    self.assertEqual(await self.sets.rank('s', 21), 2)
+    self.assertEqual(await self.sets.rank('s', 2**41), 5)
+
+    self.assertEqual(await self.sets.select('s', 0), 10)
+    self.assertEqual(await self.sets.select('s', 3), 70000)
+    self.assertEqual(await self.sets.select('s', 4), 2**40)
+
+    with self.assertRaises(ResponseError):
+      await self.sets.select('s', 5)
+
+
+  async def test_get_rng(self):
+    await self.sets.create('s')
+    await self.sets.add('s', list(range(100)))
+
+    self.assertEqual(await self.sets.get_rng('s', 95), [95, 96, 97, 98, 99])
+    self.assertEqual(await self.sets.get_rng('s', 10, 13), [10, 11, 12])
+    self.assertEqual(await self.sets.get_rng('s', 98, 200), [98, 99])
+
+    with self.assertRaises(ResponseError):
+      await self.sets.get_rng('s', 100)
+
+
+  async def test_clear_delete(self):
+    await self.sets.create('s')
+    await self.sets.add('s', [1, 2, 3])
+    await self.sets.clear('s')
+    self.assertEqual(await self.sets.length('s'), 0)
+
+    await self.sets.delete('s')
+    self.assertFalse(await self.sets.exist('s'))
+
+    with self.assertRaises(ResponseError):
+      await self.sets.delete('s')
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,58 @@
+import unittest
+from base import IntSetTest
+from ndb.client import ResponseError
+
+
+class SetOperations(IntSetTest):
+  async def asyncSetUp(self):
+    await super().asyncSetUp()
+
+    # a mix of sparse (array) and dense (bitmap) containers
+    self.a = set(range(0, 100000, 3)) | {2**33, 2**33 + 1}
+    self.b = set(range(0, 100000, 5)) | {2**33}
+    self.c = set(range(50000, 60000))
+
+    for name, values in (('a', self.a), ('b', self.b), ('c', self.c)):
+      await self.sets.create(name)
+      await self.sets.add(name, list(values))
+
+
+  async def test_intersect(self):
+    self.assertEqual(await self.sets.intersect('a', 'b'), sorted(self.a & self.b))
+    self.assertEqual(await self.sets.intersect('a', 'b', 'c'), sorted(self.a & self.b & self.c))
+
+
+  async def test_union(self):
+    self.assertEqual(await self.sets.union('a', 'b'), sorted(self.a | self.b))
+    self.assertEqual(await self.sets.union('a', 'b', 'c'), sorted(self.a | self.b | self.c))
+
+
+  async def test_xor(self):
+    self.assertEqual(await self.sets.xor('a', 'b'), sorted(self.a ^ self.b))
+    self.assertEqual(await self.sets.xor('a', 'b', 'c'), sorted(self.a ^ self.b ^ self.c))
+
+
+  async def test_diff(self):
+    self.assertEqual(await self.sets.diff('a', 'b'), sorted(self.a - self.b))
+    self.assertEqual(await self.sets.diff('a', 'b', 'c'), sorted(self.a - self.b - self.c))
+
+
+  async def test_dest(self):
+    self.assertEqual(await self.sets.intersect('a', 'b', dest='ab'), len(self.a & self.b))
+    self.assertEqual(await self.sets.length('ab'), len(self.a & self.b))
+
+    # dest replaces an existing set, which can be a source
+    self.assertEqual(await self.sets.diff('ab', 'c', dest='ab'), len((self.a & self.b) - self.c))
+    self.assertEqual(await self.sets.get_rng('ab', 0), sorted((self.a & self.b) - self.c))
+
+
+  async def test_invalid(self):
+    with self.assertRaises(ValueError):
+      await self.sets.union('a')
+
+    with self.assertRaises(ResponseError):
+      await self.sets.union('a', 'x')
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -1,7 +1,11 @@
 import random
 import unittest
 import os
+import asyncio
 from base import KvTest
+from ndb.commands import StValues
+from ndb.arrays import IntArrays, SortedIntArrays, StringArrays
+from ndb.lists import ObjLists
 
 
 class SaveLoad(KvTest):
@@ -22,6 +26,116 @@ class SaveLoad(KvTest):
     self.assertEqual(loadedCount, len(input))
 
 
+  async def test_save_background(self):
+    input = {'a':0, 'b':'str', 'c':True, 'd':1.5}
+
+    await self.kv.set(input)
+
+    datasetName = 'kv_'+ str(random.randint(1000,999999))
+    
+    await self.kv.save(datasetName, bg=True)
+
+    # change after the save started, not in the saved data
+    await self.kv.set({'e':10})
+
+    while (status := await self.kv.save_status())['st'] == 126: # SaveInProgress
+      await asyncio.sleep(0.05)
+
+    self.assertEqual(status['st'], StValues.ST_SAVE_COMPLETE)
+    self.assertEqual(status['name'], datasetName)
+    self.assertEqual(status['keys'], len(input))
+    self.assertEqual(status['saved'], len(input))
+
+    await self.kv.clear()
+
+    loadedCount = await self.kv.load(datasetName)
+    self.assertEqual(loadedCount, len(input))
+    self.assertListEqual(await self.kv.contains(['e']), [])
+
+  async def test_save_delta(self):
+    await self.kv.clear()
+    await self.kv.set({'a':0, 'b':'str', 'c':True, 'd':1.5})
+    await self.kv.set({f'k{i}':i for i in range(10)}) # so the changes are small enough for a delta
+
+    datasetName = 'kv_'+ str(random.randint(1000,999999))
+    
+    # first is a full save
+    await self.kv.save(datasetName, delta=True)
+
+    await self.kv.set({'a':10, 'e':[1,2]})
+    await self.kv.rmv(['b'])
+
+    await self.kv.save(datasetName, delta=True)
+
+    await self.kv.clear()
+
+    # loads the full save then the delta
+    loadedCount = await self.kv.load(datasetName)
+    self.assertEqual(loadedCount, 14)
+
+    values = await self.kv.get(('a','b','c','d','e'))
+    self.assertDictEqual(values, {'a':10, 'c':True, 'd':1.5, 'e':[1,2]})
+
+
+  async def test_save_mmap(self):
+    await self.kv.clear()
+    await self.kv.set({'a':0, 'b':'str', 'c':True, 'd':1.5, 'e':[1,2], 'f':{'x':'y'}})
+
+    datasetName = 'kv_'+ str(random.randint(1000,999999))
+    await self.kv.save(datasetName, mmap=True)
+
+    await self.kv.clear()
+
+    # mapped, values decoded when accessed
+    loadedCount = await self.kv.load(datasetName)
+    self.assertEqual(loadedCount, 6)
+
+    values = await self.kv.get(('a','b','f','z'))
+    self.assertDictEqual(values, {'a':0, 'b':'str', 'f':{'x':'y'}})
+
+    await self.kv.set({'c':False})
+    await self.kv.rmv(['d'])
+    
+    self.assertEqual(await self.kv.count(), 5)
+
+    values = await self.kv.get(('c','d','e'))
+    self.assertDictEqual(values, {'c':False, 'e':[1,2]})
+
+
+  async def test_save_arrays_lists(self):
+    iarrays = IntArrays(self.client)
+    sarrays = SortedIntArrays(self.client)
+    strarrays = StringArrays(self.client)
+    lists = ObjLists(self.client)
+
+    for c in (iarrays, sarrays, strarrays, lists):
+      await c.delete_all()
+
+    await iarrays.create('ia', 5)
+    await iarrays.set_rng('ia', [10,20,30])
+    await sarrays.create('sa', 5)
+    await sarrays.set_rng('sa', [30,10,20])
+    await strarrays.create('stra', 3)
+    await strarrays.set_rng('stra', ['x','y'])
+    await lists.create('l')
+    await lists.add('l', [{'a':1}, {'b':2}])
+    await lists.create('empty')
+
+    datasetName = 'kv_'+ str(random.randint(1000,999999))
+    await self.kv.save(datasetName)
+
+    for c in (iarrays, sarrays, strarrays, lists):
+      await c.delete_all()
+
+    await self.kv.load(datasetName)
+
+    self.assertListEqual(await iarrays.get_rng('ia', 0), [10,20,30])
+    self.assertEqual(await iarrays.capacity('ia'), 5)
+    self.assertListEqual(await sarrays.get_rng('sa', 0), [10,20,30])
+    self.assertListEqual(await strarrays.get_rng('stra', 0), ['x','y'])
+    self.assertListEqual(await lists.get_rng('l', 0), [{'a':1}, {'b':2}])
+    self.assertTrue(await lists.exist('empty'))
+
 
 if __name__ == "__main__":
   unittest.main()
\ No newline at end of file
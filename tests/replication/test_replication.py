@@ -0,0 +1,106 @@
+import asyncio
+import unittest
+from unittest import IsolatedAsyncioTestCase
+from ndb.client import NdbClient
+from ndb.common import ResponseError
+from ndb.arrays import IntArrays
+from ndb.kv import KV
+from ndb.sv import SV
+
+
+# Requires a primary on 1987 and its replica on 1989, see run_replication.sh
+
+ST_READ_ONLY = 170
+
+
+class Replication(IsolatedAsyncioTestCase):
+  async def asyncSetUp(self):
+    self.primary = NdbClient()
+    await self.primary.open('ws://127.0.0.1:1987')
+
+    self.replica = NdbClient()
+    await self.replica.open('ws://127.0.0.1:1989')
+
+    self.primaryKv = KV(self.primary)
+    self.replicaKv = KV(self.replica)
+
+    await self.primaryKv.clear()
+    await self.primaryKv.set({'ready':True})
+    await self.waitFor(lambda: self.replicaKv.get(key='ready'), True)
+
+
+  # replication is asynchronous, so poll the replica
+  async def waitFor(self, get, expected, timeout = 5.0):
+    value = None
+    for _ in range(int(timeout / 0.05)):
+      value = await get()
+      if value == expected:
+        break
+      await asyncio.sleep(0.05)
+    self.assertEqual(value, expected)
+
+
+  async def test_kv(self):
+    await self.primaryKv.set({'a':1, 'b':'two', 'c':{'x':[1,2,3]}})
+    await self.waitFor(lambda: self.replicaKv.get(keys=('a','b','c')), {'a':1, 'b':'two', 'c':{'x':[1,2,3]}})
+
+    await self.primaryKv.rmv(('a',))
+    await self.waitFor(lambda: self.replicaKv.contains(('a','b')), ['b'])
+
+
+  async def test_order(self):
+    # the last write wins on the replica as it does on the primary
+    for i in range(500):
+      await self.primaryKv.set({'counter':i})
+
+    await self.waitFor(lambda: self.replicaKv.get(key='counter'), 499)
+
+
+  async def test_arrays(self):
+    primaryArrays = IntArrays(self.primary)
+    replicaArrays = IntArrays(self.replica)
+
+    await primaryArrays.delete_all()
+    await primaryArrays.create('replicated', 5)
+    await primaryArrays.set_rng('replicated', [5,4,3])
+
+    async def replicated():
+      try:
+        return await replicaArrays.get_rng('replicated', 0)
+      except ResponseError:
+        return None   # not created yet
+
+    await self.waitFor(replicated, [5,4,3])
+
+
+  async def test_replica_read_only(self):
+    with self.assertRaises(ResponseError) as ctx:
+      await self.replicaKv.set({'k':1})
+
+    self.assertEqual(ctx.exception.rsp['st'], ST_READ_ONLY)
+    self.assertIsNone(await self.primaryKv.get(key='k'))
+
+
+  async def test_info(self):
+    await self.primaryKv.set({'z':1})
+    await self.waitFor(lambda: self.replicaKv.get(key='z'), 1)
+
+    primaryInfo = (await SV(self.primary).info())['replication']
+    self.assertEqual(primaryInfo['role'], 'primary')
+    self.assertEqual(len(primaryInfo['replicas']), 1)
+    self.assertGreater(primaryInfo['seq'], 0)
+
+    async def replicaLag():
+      return (await SV(self.replica).info())['replication']['lag']
+
+    await self.waitFor(replicaLag, 0)
+
+    replicaInfo = (await SV(self.replica).info())['replication']
+    self.assertEqual(replicaInfo['role'], 'replica')
+    self.assertTrue(replicaInfo['connected'])
+    self.assertTrue(replicaInfo['synced'])
+    self.assertEqual(replicaInfo['seq'], replicaInfo['primarySeq'])
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -51,6 +51,18 @@ else
   python3 -m unittest -f
   cd - > /dev/null
 
+
+  echo "Float Array"
+  cd farr > /dev/null
+  python3 -m unittest -f
+  cd - > /dev/null
+
+
+  echo "Sorted Float Array"
+  cd sorted_farr > /dev/null
+  python3 -m unittest -f
+  cd - > /dev/null
+
   kill_server
   
 fi
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+if pgrep -x "nemesisdb" > /dev/null
+then
+  echo "FAIL: server already running"
+else
+  
+  # to find base.py
+  BASE=$(pwd)
+  # to find Py API
+  PY_API=$(pwd)/../apis/python
+  
+  export PYTHONPATH="$BASE:$PY_API"
+
+  source ./useful.sh  
+
+  # two cluster nodes, on 1987 and 1990
+  NODE1_CONFIG=$(pwd)/cluster/node1.jsonc
+  NODE2_CONFIG=$(pwd)/cluster/node2.jsonc
+
+  cd ../server/Release/bin/ > /dev/null
+  ./nemesisdb "--config=${NODE1_CONFIG}" > /dev/null &
+  ./nemesisdb "--config=${NODE2_CONFIG}" > /dev/null &
+  cd - > /dev/null
+
+  while [ "$(pgrep -c -x nemesisdb)" -lt 2 ]; do
+    sleep 0.5
+  done
+
+  sleep 1
+    
+  cd cluster > /dev/null
+  python3 -m unittest -f test_cluster
+  cd - > /dev/null
+
+  pkill nemesisdb
+  wait
+  
+fi
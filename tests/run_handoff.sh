@@ -0,0 +1,38 @@
+#!/bin/bash
+
+if pgrep -x "nemesisdb" > /dev/null
+then
+  echo "FAIL: server already running"
+else
+  
+  # to find base.py
+  BASE=$(pwd)
+  # to find Py API
+  PY_API=$(pwd)/../apis/python
+  
+  export PYTHONPATH="$BASE:$PY_API"
+
+  source ./useful.sh  
+
+  # the test starts the second server, which takes over from this one
+  export NDB_CONFIG=$(pwd)/server.jsonc
+  export NDB_BIN_DIR=$(pwd)/../server/Release/bin
+
+  cd ${NDB_BIN_DIR} > /dev/null
+  ./nemesisdb "--config=${NDB_CONFIG}" > /dev/null &
+  cd - > /dev/null
+
+  while ! pgrep -x nemesisdb > /dev/null; do
+    sleep 0.5
+  done
+
+  sleep 1
+    
+  cd handoff > /dev/null
+  python3 -m unittest -f test_handoff
+  cd - > /dev/null
+
+  pkill nemesisdb
+  wait
+  
+fi
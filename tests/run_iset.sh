@@ -0,0 +1,33 @@
+#!/bin/bash
+
+if pgrep -x "nemesisdb" > /dev/null
+then
+  echo "FAIL: server already running"
+else
+  
+  # to find base.py
+  BASE=$(pwd)
+  # to find Py API
+  PY_API=$(pwd)/../apis/python
+  
+  export PYTHONPATH="$BASE:$PY_API"
+
+  source ./useful.sh  
+
+  run_server
+  
+  if [ "$1" = "skip" ]; then
+    export NDB_SKIP_SAVELOAD=1
+  fi
+
+  
+  echo "Integer Sets"
+
+  cd iset > /dev/null
+  python3 -m unittest -f
+  cd - > /dev/null
+
+
+  kill_server
+  
+fi
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+if pgrep -x "nemesisdb" > /dev/null
+then
+  echo "FAIL: server already running"
+else
+  
+  # to find base.py
+  BASE=$(pwd)
+  # to find Py API
+  PY_API=$(pwd)/../apis/python
+  
+  export PYTHONPATH="$BASE:$PY_API"
+
+  source ./useful.sh  
+
+  # a primary on 1987 and a replica on 1989, in separate processes
+  PRIMARY_CONFIG=$(pwd)/replication/primary.jsonc
+  REPLICA_CONFIG=$(pwd)/replication/replica.jsonc
+
+  cd ../server/Release/bin/ > /dev/null
+  ./nemesisdb "--config=${PRIMARY_CONFIG}" > /dev/null &
+  ./nemesisdb "--config=${REPLICA_CONFIG}" > /dev/null &
+  cd - > /dev/null
+
+  while [ "$(pgrep -c -x nemesisdb)" -lt 2 ]; do
+    sleep 0.5
+  done
+
+  sleep 1
+    
+  cd replication > /dev/null
+  python3 -m unittest -f test_replication
+  cd - > /dev/null
+
+  pkill nemesisdb
+  wait
+  
+fi
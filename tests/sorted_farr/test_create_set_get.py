@@ -0,0 +1,49 @@
+import unittest
+from base import SortedFloatArrayTest
+from ndb.client import ResponseError
+
+
+class Array(SortedFloatArrayTest):
+  async def test_set_get(self):
+    await self.arrays.create('a', 10)
+
+    await self.arrays.set_rng('a', [2.5, -1.0, 0.25, 10])
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 4), [-1.0, 0.25, 2.5, 10.0])
+
+    await self.arrays.set('a', 1.0)
+    self.assertEqual(await self.arrays.get('a', 2), 1.0)
+
+
+  async def test_min_max(self):
+    await self.arrays.create('a', 10)
+    await self.arrays.set_rng('a', [2.5, -1.0, 0.25, 10.5])
+
+    self.assertListEqual(await self.arrays.min('a', 2), [-1.0, 0.25])
+    self.assertListEqual(await self.arrays.max('a'), [10.5])
+
+
+  async def test_value_range(self):
+    await self.arrays.create('a', 10)
+    await self.arrays.set_rng('a', [0.5, 1.5, 2.5, 3.5, 4.5])
+
+    self.assertEqual(await self.arrays.lower_bound('a', 2.0), 2)
+    self.assertEqual(await self.arrays.count_rng('a', 1.0, 3.5), 3)
+    self.assertListEqual(await self.arrays.find_rng('a', 1.0, 3.5), [1.5, 2.5, 3.5])
+
+
+  async def test_intersect(self):
+    await self.arrays.create('a', 5)
+    await self.arrays.create('b', 5)
+    await self.arrays.set_rng('a', [0.5, 1.5, 2.5])
+    await self.arrays.set_rng('b', [1.5, 2.5, 3.5])
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b'), [1.5, 2.5])
+
+
+  async def test_swap(self):
+    with self.assertRaises(NotImplementedError):
+      await self.arrays.swap('a', 0, 1)
+
+
+if __name__ == "__main__":
+  unittest.main()
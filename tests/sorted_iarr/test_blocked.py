@@ -0,0 +1,77 @@
+import unittest
+import random
+from base import SortedIntArrayTest
+from ndb.client import ResponseError
+
+
+class Blocked(SortedIntArrayTest):
+  async def createBlocked(self, name: str, data: list, capacity = None):
+    await self.arrays.create(name, capacity if capacity else len(data), layout='blocked')
+
+    # batches to keep requests small, unordered to insert throughout the array
+    for i in range(0, len(data), 250):
+      await self.arrays.set_rng(name, data[i:i+250])
+
+
+  async def test_set_get(self):
+    await self.arrays.create('a', 5, layout='blocked')
+
+    for v in [30, 10, 50, 20, 40]:
+      await self.arrays.set('a', v)
+
+    self.assertListEqual(await self.arrays.get_rng('a', 0), [10,20,30,40,50])
+    self.assertEqual(await self.arrays.get('a', 3), 40)
+    self.assertEqual(await self.arrays.used('a'), 5)
+
+    with self.assertRaises(ResponseError):  # full
+      await self.arrays.set('a', 60)
+
+
+  async def test_many(self):
+    # enough for several leaves
+    random.seed(7)
+    data = [random.randint(0, 9999) for _ in range(2000)]
+
+    await self.createBlocked('a', data)
+    expected = sorted(data)
+
+    self.assertEqual(await self.arrays.used('a'), len(data))
+    self.assertListEqual(await self.arrays.get_rng('a', 0, 500), expected[0:500])
+    self.assertListEqual(await self.arrays.get_rng('a', 1000, 1300), expected[1000:1300])
+    self.assertEqual(await self.arrays.get('a', 1999), expected[1999])
+    self.assertListEqual(await self.arrays.min('a', 3), expected[0:3])
+    self.assertListEqual(await self.arrays.max('a', 3), expected[-1:-4:-1])
+
+
+  async def test_clear(self):
+    random.seed(11)
+    data = [random.randint(0, 9999) for _ in range(1500)]
+    await self.createBlocked('a', data)
+    expected = sorted(data)
+
+    await self.arrays.clear('a', 100, 1100)
+    del expected[100:1100]
+
+    self.assertEqual(await self.arrays.used('a'), len(expected))
+    self.assertListEqual(await self.arrays.get_rng('a', 0), expected)
+
+    await self.arrays.set_rng('a', [5000, 1, 9999])
+    self.assertListEqual(await self.arrays.get_rng('a', 0), sorted(expected + [5000, 1, 9999]))
+
+
+  async def test_setops(self):
+    await self.createBlocked('a', list(range(0, 1200, 2)))
+    await self.arrays.create('b', 400)
+    await self.arrays.set_rng('b', list(range(0, 1200, 3)))
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b'), list(range(0, 1200, 6)))
+    self.assertListEqual(await self.arrays.diff('b', 'a'), [v for v in range(0, 1200, 3) if v % 2])
+
+
+  async def test_invalid_layout(self):
+    with self.assertRaises(ValueError): # caught by Py API
+      await self.arrays.create('a', 5, layout='tree')
+
+
+if __name__ == "__main__":
+  unittest.main()
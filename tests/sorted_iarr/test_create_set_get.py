@@ -59,6 +59,28 @@ class Array(SortedIntArrayTest):
       await self.arrays.set('arr7', "")
 
 
+  async def test_set_rng_merge(self):
+    await self.arrays.create('arr8', 20)
+
+    await self.arrays.set_rng('arr8', [50, 10, 30])
+    # before, between, equal to and after existing values
+    await self.arrays.set_rng('arr8', [60, 5, 30, 20, 40])
+    await self.arrays.set_rng('arr8', [1, 2, 100], sorted=True)
+
+    output = await self.arrays.get_rng('arr8', 0)
+    self.assertListEqual(output, [1,2,5,10,20,30,30,40,50,60,100])
+
+
+  async def test_set_rng_sorted_flag_wrong(self):
+    await self.arrays.create('arr9', 10)
+    await self.arrays.set_rng('arr9', [4, 8])
+
+    # not sorted, so the server sorts
+    await self.arrays.set_rng('arr9', [9, 1, 5], sorted=True)
+
+    output = await self.arrays.get_rng('arr9', 0)
+    self.assertListEqual(output, [1,4,5,8,9])
+
 
 if __name__ == "__main__":
   unittest.main()
\ No newline at end of file
@@ -0,0 +1,43 @@
+import unittest
+from base import SortedIntArrayTest
+from ndb.client import ResponseError
+
+
+class Growable(SortedIntArrayTest):
+  async def test_grow(self):
+    for layout in ('vector', 'blocked'):
+      name = 'arr_'+layout
+      await self.arrays.create(name, 1, layout=layout, growable=True)
+      await self.arrays.set_rng(name, [5, 3, 9])
+      await self.arrays.set(name, 1)
+
+      # 3 for the set_rng, then doubled
+      self.assertEqual(await self.arrays.capacity(name), 6)
+      self.assertEqual(await self.arrays.get_rng(name, 0), [1, 3, 5, 9])
+
+
+  async def test_grown_max(self):
+    await self.arrays.create('arr', 1, growable=True)
+    await self.arrays.set_rng('arr', [5, 3, 9])
+    await self.arrays.set('arr', 1)
+
+    # the largest set, not the unset capacity
+    self.assertListEqual(await self.arrays.max('arr', n=2), [9, 5])
+
+
+  async def test_reserve_shrink(self):
+    await self.arrays.create('arr', 100)
+    await self.arrays.set_rng('arr', [3, 1, 2])
+
+    self.assertEqual(await self.arrays.shrink('arr'), 3)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.set('arr', 4)
+
+    self.assertEqual(await self.arrays.reserve('arr', 4), 4)
+    await self.arrays.set('arr', 4)
+    self.assertEqual(await self.arrays.get_rng('arr', 0), [1, 2, 3, 4])
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -38,3 +38,39 @@ class Array(SortedIntArrayTest):
 
     with self.assertRaises(ValueError): # caught by Py API
       await self.arrays.intersect('a', 'a')
+
+
+  async def test_intersect_large(self):
+    # large enough for SIMD blocks, with duplicates and values either side of blocks
+    a_data = [v for v in range(0, 600, 3)] + [300]*5 + [301]*3
+    b_data = [v for v in range(0, 600, 2)] + [300]*2 + [301]*7
+
+    await self.arrays.create('a', len(a_data))
+    await self.arrays.create('b', len(b_data))
+    await self.arrays.set_rng('a', a_data)
+    await self.arrays.set_rng('b', b_data)
+
+    expected = []
+    remaining = sorted(b_data)
+    for v in sorted(a_data):
+      if v in remaining:
+        remaining.remove(v)
+        expected.append(v)
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b'), expected)
+    self.assertListEqual(await self.arrays.intersect('b', 'a'), expected)
+
+
+  async def test_intersect_skewed(self):
+    # sizes differ enough to search the larger array
+    large = [v*2 for v in range(400)]
+    small = [-1, 0, 1, 398, 400, 798, 801]
+
+    await self.arrays.create('large', len(large))
+    await self.arrays.create('small', len(small))
+    await self.arrays.set_rng('large', large)
+    await self.arrays.set_rng('small', small)
+
+    self.assertListEqual(await self.arrays.intersect('small', 'large'), [0, 398, 400, 798])
+    self.assertListEqual(await self.arrays.intersect('large', 'small'), [0, 398, 400, 798])
+
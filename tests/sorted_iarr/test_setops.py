@@ -0,0 +1,104 @@
+import unittest
+from base import SortedIntArrayTest
+from ndb.client import ResponseError
+
+
+class Array(SortedIntArrayTest):
+  async def createArrays(self, arrays: dict):
+    for name, data in arrays.items():
+      await self.arrays.create(name, len(data))
+      await self.arrays.set_rng(name, data)
+
+
+  async def test_intersect_many(self):
+    await self.createArrays({'a':[1,2,3,4,5,6], 'b':[2,3,4,6,8], 'c':[6,4,2,10]})
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b', 'c'), [2,4,6])
+    self.assertListEqual(await self.arrays.intersect('c', 'a', 'b'), [2,4,6])
+
+
+  async def test_intersect_many_empty(self):
+    await self.createArrays({'a':[1,2,3], 'b':[4,5,6], 'c':[1,2,3]})
+    self.assertListEqual(await self.arrays.intersect('a', 'b', 'c'), [])
+
+
+  async def test_union(self):
+    await self.createArrays({'a':[5,1,3], 'b':[2,3,4], 'c':[3,3,9]})
+
+    self.assertListEqual(await self.arrays.union('a', 'b'), [1,2,3,4,5])
+    # as std::set_union, a duplicate appears the most times it appears in any array
+    self.assertListEqual(await self.arrays.union('a', 'b', 'c'), [1,2,3,3,4,5,9])
+
+
+  async def test_diff(self):
+    await self.createArrays({'a':[1,2,3,4,5,6], 'b':[2,4], 'c':[6,7]})
+
+    self.assertListEqual(await self.arrays.diff('a', 'b'), [1,3,5,6])
+    self.assertListEqual(await self.arrays.diff('a', 'b', 'c'), [1,3,5])
+    self.assertListEqual(await self.arrays.diff('b', 'a'), [])
+
+
+  async def test_dest(self):
+    await self.createArrays({'a':[1,2,3,4], 'b':[3,4,5], 'c':[4,5,6]})
+
+    self.assertEqual(await self.arrays.union('a', 'b', 'c', dest='u'), 6)
+    self.assertListEqual(await self.arrays.get_rng('u', start=0), [1,2,3,4,5,6])
+
+    # dest is replaced, and may be a source
+    self.assertEqual(await self.arrays.intersect('u', 'b', dest='u'), 3)
+    self.assertListEqual(await self.arrays.get_rng('u', start=0), [3,4,5])
+
+    self.assertEqual(await self.arrays.diff('a', 'b', 'c', dest='d'), 2)
+    self.assertListEqual(await self.arrays.get_rng('d', start=0), [1,2])
+
+    # an empty result still creates dest
+    self.assertEqual(await self.arrays.intersect('a', 'b', 'c', dest='e'), 1)
+    self.assertEqual(await self.arrays.intersect('d', 'c', dest='e'), 0)
+    self.assertEqual(await self.arrays.used('e'), 0)
+
+
+  async def test_dest_growable(self):
+    await self.createArrays({'a':[1,2,3], 'b':[3,4]})
+
+    # a new dest is growable, with a capacity of the result
+    self.assertEqual(await self.arrays.union('a', 'b', dest='u'), 4)
+    self.assertEqual(await self.arrays.capacity('u'), 4)
+    await self.arrays.set('u', 9)
+    self.assertListEqual(await self.arrays.get_rng('u', start=0), [1,2,3,4,9])
+
+    # an existing dest keeps its capacity and growable flag
+    await self.arrays.create('d', 10, layout='blocked')
+    self.assertEqual(await self.arrays.intersect('a', 'b', dest='d'), 1)
+    self.assertEqual(await self.arrays.capacity('d'), 10)
+
+    await self.arrays.create('f', 2)
+    self.assertEqual(await self.arrays.union('a', 'b', dest='f'), 4)
+    self.assertEqual(await self.arrays.capacity('f'), 4)
+    with self.assertRaises(ResponseError):
+      await self.arrays.set('f', 9)
+
+
+  async def test_not_exist(self):
+    await self.createArrays({'a':[1,2,3], 'b':[2,3]})
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.union('a', 'b', 'x')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.diff('x', 'a', dest='d')
+
+    self.assertFalse(await self.arrays.exist('d'))
+
+
+  async def test_too_few(self):
+    await self.createArrays({'a':[1,2,3]})
+
+    with self.assertRaises(ValueError): # caught by Py API
+      await self.arrays.union('a')
+
+    with self.assertRaises(ValueError):
+      await self.arrays.diff('a')
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,69 @@
+import unittest
+from base import SortedIntArrayTest
+from ndb.client import ResponseError
+
+
+class ValueRange(SortedIntArrayTest):
+  async def createArrays(self, data: list):
+    for layout in ['vector', 'blocked']:
+      await self.arrays.create(layout, len(data) + 5, layout=layout)
+      await self.arrays.set_rng(layout, data)
+    return ['vector', 'blocked']
+
+
+  async def test_bounds(self):
+    for name in await self.createArrays([10,20,20,20,30,40]):
+      self.assertEqual(await self.arrays.lower_bound(name, 20), 1)
+      self.assertEqual(await self.arrays.upper_bound(name, 20), 4)
+      self.assertEqual(await self.arrays.lower_bound(name, 25), 4)
+      self.assertEqual(await self.arrays.upper_bound(name, 25), 4)
+      self.assertEqual(await self.arrays.lower_bound(name, 5), 0)
+      self.assertEqual(await self.arrays.lower_bound(name, 50), 6)
+      self.assertEqual(await self.arrays.upper_bound(name, 40), 6)
+      self.assertEqual(await self.arrays.lower_bound(name, -10), 0)
+
+
+  async def test_count_find(self):
+    for name in await self.createArrays([5,10,20,20,30,40,50]):
+      self.assertEqual(await self.arrays.count_rng(name, 10, 30), 4)
+      self.assertListEqual(await self.arrays.find_rng(name, 10, 30), [10,20,20,30])
+      self.assertListEqual(await self.arrays.find_rng(name, 11, 29), [20,20])
+      self.assertListEqual(await self.arrays.find_rng(name, 0, 100), [5,10,20,20,30,40,50])
+      self.assertListEqual(await self.arrays.find_rng(name, 41, 49), [])
+      self.assertListEqual(await self.arrays.find_rng(name, 60, 70), [])
+      # min > max
+      self.assertEqual(await self.arrays.count_rng(name, 30, 10), 0)
+      self.assertListEqual(await self.arrays.find_rng(name, 30, 10), [])
+
+
+  async def test_contains(self):
+    for name in await self.createArrays([1,3,5,7,9]):
+      self.assertListEqual(await self.arrays.contains(name, [1,2,9,10,-1,5]), [True,False,True,False,False,True])
+      self.assertListEqual(await self.arrays.contains(name, []), [])
+
+
+  async def test_empty(self):
+    await self.arrays.create('a', 5)
+    self.assertEqual(await self.arrays.lower_bound('a', 5), 0)
+    self.assertEqual(await self.arrays.count_rng('a', 0, 10), 0)
+    self.assertListEqual(await self.arrays.contains('a', [0]), [False])
+
+
+  async def test_invalid(self):
+    await self.arrays.create('a', 5)
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.lower_bound('a', 'x')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.count_rng('a', 0, 'x')
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.contains('a', [1, 'x'])
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.find_rng('b', 0, 1)
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,96 @@
+import random
+import unittest
+from base import SortedStrArrayTest
+from ndb.client import ResponseError
+from ndb.kv import KV
+
+
+# strings either side of the 8 byte inline prefix, and sharing it
+Data = ['pear', 'apple', 'customer:b', 'customer:a', 'customers', 'customer', 'banana', 'a', '', 'zz' * 20]
+
+
+class Arena(SortedStrArrayTest):
+  async def test_set(self):
+    await self.arrays.create('arr', 20, layout='arena')
+
+    for item in Data:
+      await self.arrays.set('arr', item)
+
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), sorted(Data))
+    self.assertEqual(await self.arrays.used('arr'), len(Data))
+
+
+  async def test_set_rng(self):
+    await self.arrays.create('arr', 20, layout='arena')
+    await self.arrays.set_rng('arr', Data[:5])
+    await self.arrays.set_rng('arr', Data[5:])
+
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), sorted(Data))
+    self.assertListEqual(await self.arrays.min('arr', 2), sorted(Data)[:2])
+    self.assertListEqual(await self.arrays.max('arr', 2), sorted(Data, reverse=True)[:2])
+
+
+  async def test_bounds(self):
+    items = sorted(Data)
+
+    await self.arrays.create('arr', 20, layout='arena')
+    await self.arrays.set_rng('arr', Data)
+
+    for item in ['customer:', 'customer:a', 'customerz', 'b', '']:
+      self.assertEqual(await self.arrays.lower_bound('arr', item), sum(1 for s in items if s < item))
+
+    self.assertListEqual(await self.arrays.contains('arr', ['customer', 'customer:c', 'zz' * 20]), [True, False, True])
+    self.assertEqual(await self.arrays.count_rng('arr', 'customer', 'customers'), 4)
+
+
+  async def test_clear(self):
+    await self.arrays.create('arr', 20, layout='arena')
+    await self.arrays.set_rng('arr', Data)
+    await self.arrays.clear('arr', 2, 5)
+
+    items = sorted(Data)
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), items[:2] + items[5:])
+
+
+  async def test_setops(self):
+    # with another layout
+    await self.arrays.create('a', 20, layout='arena')
+    await self.arrays.set_rng('a', Data)
+    await self.arrays.create('b', 5)
+    await self.arrays.set_rng('b', ['customer:a', 'customers', 'kiwi', 'pear'])
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b'), ['customer:a', 'customers', 'pear'])
+    self.assertListEqual(await self.arrays.union('a', 'b'), sorted(Data + ['kiwi']))
+    self.assertListEqual(await self.arrays.diff('b', 'a'), ['kiwi'])
+
+
+  async def test_save_load(self):
+    kv = KV(self.client)
+
+    await self.arrays.create('arr', 20, layout='arena')
+    await self.arrays.set_rng('arr', Data)
+
+    datasetName = 'sstrarr_arena_' + str(random.randint(1000,999999))
+    await kv.save(datasetName)
+
+    await self.arrays.delete_all()
+    await kv.load(datasetName)
+
+    items = sorted(Data)
+    self.assertEqual(await self.arrays.used('arr'), len(Data))
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), items)
+    self.assertEqual(await self.arrays.get('arr', 3), items[3])
+    self.assertEqual(await self.arrays.lower_bound('arr', 'customer:'), sum(1 for s in items if s < 'customer:'))
+
+    # still sorted after load
+    await self.arrays.set('arr', 'cherry')
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), sorted(Data + ['cherry']))
+
+
+  async def test_invalid_layout(self):
+    with self.assertRaises(ValueError):
+      await self.arrays.create('arr', 10, layout='paged')
+
+
+if __name__ == "__main__":
+  unittest.main()
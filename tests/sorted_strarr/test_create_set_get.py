@@ -21,5 +21,16 @@ class Array(SortedStrArrayTest):
     self.assertListEqual(output, ['a', 'b', 'z'])
 
 
+  async def test_blocked(self):
+    await self.arrays.create('blocked', 300, layout='blocked')
+
+    data = [f'item{v:03}' for v in range(300)]
+    await self.arrays.set_rng('blocked', list(reversed(data[:150])))
+    await self.arrays.set_rng('blocked', data[150:])
+
+    self.assertListEqual(await self.arrays.get_rng('blocked', 0), data)
+    self.assertEqual(await self.arrays.get('blocked', 200), data[200])
+
+
 if __name__ == "__main__":
   unittest.main()
\ No newline at end of file
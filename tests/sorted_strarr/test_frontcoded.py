@@ -0,0 +1,83 @@
+import unittest
+from base import SortedStrArrayTest
+
+
+# neighbours sharing prefixes of varying length, none, and all of another string
+Data = ['user:1001', 'user:1002', 'user:10', 'user:2', 'users', 'apple', 'app', '', 'zebra', 'user:1001x']
+
+
+class FrontCoded(SortedStrArrayTest):
+  async def test_set(self):
+    await self.arrays.create('arr', 20, layout='frontcoded')
+
+    for item in Data:
+      await self.arrays.set('arr', item)
+
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), sorted(Data))
+    self.assertEqual(await self.arrays.get('arr', 3), sorted(Data)[3])
+    self.assertEqual(await self.arrays.used('arr'), len(Data))
+
+
+  async def test_set_rng(self):
+    await self.arrays.create('arr', 20, layout='frontcoded')
+    await self.arrays.set_rng('arr', Data[:5])
+    await self.arrays.set_rng('arr', Data[5:])
+
+    self.assertListEqual(await self.arrays.get_rng('arr', 2, 6), sorted(Data)[2:6])
+    self.assertListEqual(await self.arrays.min('arr', 2), sorted(Data)[:2])
+    self.assertListEqual(await self.arrays.max('arr', 2), sorted(Data, reverse=True)[:2])
+
+
+  async def test_large(self):
+    # many leaves, inserted out of order
+    items = [f'key:{i:06}' for i in range(0, 5000, 2)]
+    others = [f'key:{i:06}' for i in range(1, 5000, 2)]
+
+    await self.arrays.create('arr', 5000, layout='frontcoded')
+    await self.arrays.set_rng('arr', items)
+
+    for item in others[:200]:
+      await self.arrays.set('arr', item)
+
+    expected = sorted(items + others[:200])
+    self.assertEqual(await self.arrays.used('arr'), len(expected))
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), expected)
+    self.assertEqual(await self.arrays.lower_bound('arr', 'key:000201'), expected.index('key:000201'))
+    self.assertListEqual(await self.arrays.prefix('arr', 'key:0001', 5), expected[expected.index('key:000100'):][:5])
+
+
+  async def test_bounds(self):
+    items = sorted(Data)
+
+    await self.arrays.create('arr', 20, layout='frontcoded')
+    await self.arrays.set_rng('arr', Data)
+
+    for item in ['user:', 'user:1001', 'user:1001y', 'b', '']:
+      self.assertEqual(await self.arrays.lower_bound('arr', item), sum(1 for s in items if s < item))
+      self.assertEqual(await self.arrays.upper_bound('arr', item), sum(1 for s in items if s <= item))
+
+    self.assertListEqual(await self.arrays.contains('arr', ['user:10', 'user:3', 'zebra']), [True, False, True])
+    self.assertListEqual(await self.arrays.find_rng('arr', 'user:1', 'user:2'), ['user:10', 'user:1001', 'user:1001x', 'user:1002', 'user:2'])
+
+
+  async def test_clear(self):
+    await self.arrays.create('arr', 20, layout='frontcoded')
+    await self.arrays.set_rng('arr', Data)
+    await self.arrays.clear('arr', 2, 5)
+
+    items = sorted(Data)
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), items[:2] + items[5:])
+
+
+  async def test_setops(self):
+    await self.arrays.create('a', 20, layout='frontcoded')
+    await self.arrays.set_rng('a', Data)
+    await self.arrays.create('b', 5)
+    await self.arrays.set_rng('b', ['user:10', 'users', 'kiwi'])
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b'), ['user:10', 'users'])
+    self.assertListEqual(await self.arrays.diff('b', 'a'), ['kiwi'])
+
+
+if __name__ == "__main__":
+  unittest.main()
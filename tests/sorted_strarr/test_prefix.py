@@ -0,0 +1,47 @@
+import unittest
+from base import SortedStrArrayTest
+
+
+Data = ['car', 'cart', 'carbon', 'care', 'cat', 'ca', 'dog', 'b', 'cb', '']
+
+
+class Prefix(SortedStrArrayTest):
+  async def test_prefix(self):
+    for layout in self.arrays.layouts:
+      with self.subTest(layout=layout):
+        await self.arrays.create(layout, 20, layout=layout)
+        await self.arrays.set_rng(layout, Data)
+
+        self.assertListEqual(await self.arrays.prefix(layout, 'car'), ['car', 'carbon', 'care', 'cart'])
+        self.assertListEqual(await self.arrays.prefix(layout, 'car', 2), ['car', 'carbon'])
+        self.assertListEqual(await self.arrays.prefix(layout, 'ca', 0), [])
+        self.assertListEqual(await self.arrays.prefix(layout, 'x'), [])
+        self.assertListEqual(await self.arrays.prefix(layout, ''), sorted(Data))
+        self.assertEqual(await self.arrays.count_prefix(layout, 'ca'), 6)
+        self.assertEqual(await self.arrays.count_prefix(layout, 'cart'), 1)
+
+
+  async def test_utf8(self):
+    # the prefix's successor increments its last byte, which is within a multi-byte character
+    items = ['café', 'caféine', 'cafe', 'cafê', 'cafÿ', 'caf']
+
+    await self.arrays.create('arr', 10)
+    await self.arrays.set_rng('arr', items)
+
+    self.assertListEqual(await self.arrays.prefix('arr', 'café'), ['café', 'caféine'])
+    self.assertListEqual(await self.arrays.prefix('arr', 'cafÿ'), ['cafÿ'])
+    self.assertEqual(await self.arrays.count_prefix('arr', 'caf'), 6)
+
+
+  async def test_invalid(self):
+    await self.arrays.create('arr', 10)
+
+    with self.assertRaises(ValueError):
+      await self.arrays.prefix('arr', 'a', -1)
+
+    with self.assertRaises(ValueError):
+      await self.arrays.prefix('', 'a')
+
+
+if __name__ == "__main__":
+  unittest.main()
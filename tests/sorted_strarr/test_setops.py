@@ -0,0 +1,38 @@
+import unittest
+from base import SortedStrArrayTest
+from ndb.client import ResponseError
+
+
+class Array(SortedStrArrayTest):
+  async def createArrays(self, arrays: dict):
+    for name, data in arrays.items():
+      await self.arrays.create(name, len(data))
+      await self.arrays.set_rng(name, data)
+
+
+  async def test_intersect(self):
+    await self.createArrays({'a':['d','a','c','b'], 'b':['b','c','e'], 'c':['c','b','z']})
+
+    self.assertListEqual(await self.arrays.intersect('a', 'b'), ['b','c'])
+    self.assertListEqual(await self.arrays.intersect('a', 'b', 'c'), ['b','c'])
+
+
+  async def test_union_diff(self):
+    await self.createArrays({'a':['apple','cherry'], 'b':['banana','cherry'], 'c':['date']})
+
+    self.assertListEqual(await self.arrays.union('a', 'b', 'c'), ['apple','banana','cherry','date'])
+    self.assertListEqual(await self.arrays.diff('a', 'b'), ['apple'])
+
+
+  async def test_dest(self):
+    await self.createArrays({'a':['x','y'], 'b':['y','z']})
+
+    self.assertEqual(await self.arrays.union('a', 'b', dest='u'), 3)
+    self.assertListEqual(await self.arrays.get_rng('u', start=0), ['x','y','z'])
+
+    with self.assertRaises(ResponseError):
+      await self.arrays.union('a', 'x', dest='u')
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -0,0 +1,26 @@
+import unittest
+from base import SortedStrArrayTest
+
+
+class ValueRange(SortedStrArrayTest):
+  async def test_value_range(self):
+    await self.arrays.create('a', 6)
+    await self.arrays.set_rng('a', ['pear', 'apple', 'fig', 'banana', 'plum', 'cherry'])
+
+    self.assertEqual(await self.arrays.lower_bound('a', 'c'), 2)
+    self.assertEqual(await self.arrays.upper_bound('a', 'fig'), 4)
+    self.assertEqual(await self.arrays.count_rng('a', 'b', 'g'), 3)
+    self.assertListEqual(await self.arrays.find_rng('a', 'p', 'q'), ['pear', 'plum'])
+    self.assertListEqual(await self.arrays.contains('a', ['fig', 'grape']), [True, False])
+
+
+  async def test_min_max(self):
+    await self.arrays.create('a', 3)
+    await self.arrays.set_rng('a', ['b', 'c', 'a'])
+
+    self.assertListEqual(await self.arrays.min('a', 2), ['a', 'b'])
+    self.assertListEqual(await self.arrays.max('a'), ['c'])
+
+
+if __name__ == "__main__":
+  unittest.main()
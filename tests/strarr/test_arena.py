@@ -0,0 +1,47 @@
+import unittest
+from base import StrArrayTest
+from ndb.client import ResponseError
+
+
+class Arena(StrArrayTest):
+  async def test_set_get(self):
+    long = 'x' * 100
+
+    await self.arrays.create('arr', 10, layout='arena')
+    await self.arrays.set_rng('arr', ['short', long, ''])
+    await self.arrays.set('arr', 'positioned', pos=8)
+
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), ['short', long, ''])
+    self.assertEqual(await self.arrays.get('arr', 8), 'positioned')
+    self.assertEqual(await self.arrays.get('arr', 5), '')
+
+    # overwrite, which leaves the old bytes until compacted
+    await self.arrays.set('arr', 'replaced string', pos=1)
+    self.assertEqual(await self.arrays.get('arr', 1), 'replaced string')
+
+
+  async def test_swap_clear(self):
+    await self.arrays.create('arr', 5, layout='arena')
+    await self.arrays.set_rng('arr', ['a', 'b' * 20, 'c', 'd' * 10])
+
+    await self.arrays.swap('arr', 0, 1)
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), ['b' * 20, 'a', 'c', 'd' * 10])
+
+    await self.arrays.clear('arr', 1, 3)
+    self.assertListEqual(await self.arrays.get_rng('arr', 0), ['b' * 20, 'd' * 10])
+
+
+  async def test_shrink(self):
+    await self.arrays.create('arr', 100, layout='arena')
+    await self.arrays.set('arr', 'last', pos=10)
+    self.assertEqual(await self.arrays.shrink('arr'), 11)
+    self.assertEqual(await self.arrays.get('arr', 10), 'last')
+
+
+  async def test_invalid_layout(self):
+    with self.assertRaises(ResponseError):
+      await self.arrays.client.sendCmd(self.arrays.cmds.CREATE_REQ, self.arrays.cmds.CREATE_RSP, {'name':'arr', 'len':10, 'layout':'blocked'})
+
+
+if __name__ == "__main__":
+  unittest.main()
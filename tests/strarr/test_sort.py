@@ -0,0 +1,57 @@
+import unittest
+from base import StrArrayTest
+from ndb.arrays import SortedStrArrays
+from ndb.client import ResponseError
+
+
+class Sort(StrArrayTest):
+  async def test_sort(self):
+    long = 'prefix_shared_' * 3
+
+    for layout in self.arrays.layouts:
+      await self.arrays.create('arr', 10, layout=layout)
+      await self.arrays.set_rng('arr', ['pear', long + 'b', 'apple', '', long + 'a', 'fig'])
+      await self.arrays.set('arr', 'beyond', pos=8)
+
+      await self.arrays.sort('arr')
+      self.assertListEqual(await self.arrays.get_rng('arr', 0), ['', 'apple', 'fig', 'pear', long + 'a', long + 'b'])
+      self.assertEqual(await self.arrays.get('arr', 8), 'beyond')
+
+      await self.arrays.sort('arr', desc=True)
+      self.assertListEqual(await self.arrays.get_rng('arr', 0), [long + 'b', long + 'a', 'pear', 'fig', 'apple', ''])
+
+      await self.arrays.delete('arr')
+
+
+  async def test_unique(self):
+    for layout in self.arrays.layouts:
+      await self.arrays.create('arr', 10, layout=layout)
+      await self.arrays.set_rng('arr', ['b', 'a', 'b', 'c', 'a'])
+
+      self.assertEqual(await self.arrays.unique('arr'), 3)
+      self.assertListEqual(await self.arrays.get_rng('arr', 0), ['b', 'a', 'c'])
+
+      await self.arrays.delete('arr')
+
+
+  async def test_to_sorted(self):
+    sorted_arrays = SortedStrArrays(self.client)
+    await sorted_arrays.delete_all()
+
+    await self.arrays.create('arr', 10, layout='arena')
+    await self.arrays.set_rng('arr', ['b', 'a', 'b', 'c'])
+
+    self.assertEqual(await self.arrays.to_sorted('arr', 'sorted', unique=True), 3)
+    self.assertListEqual(await sorted_arrays.get_rng('sorted', 0), ['a', 'b', 'c'])
+    self.assertEqual(await sorted_arrays.lower_bound('sorted', 'b'), 1)
+
+    await sorted_arrays.delete_all()
+
+
+  async def test_not_exist(self):
+    with self.assertRaises(ResponseError):
+      await self.arrays.to_sorted('none', 'sorted')
+
+
+if __name__ == "__main__":
+  unittest.main()
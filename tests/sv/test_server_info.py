@@ -7,6 +7,7 @@ class Info(SvTest):
     info = await self.sv.info()
     self.assertTrue('serverVersion' in info)
     self.assertTrue(info['persistEnabled'])
+    self.assertTrue('walEnabled' in info)
 
 
 if __name__ == "__main__":
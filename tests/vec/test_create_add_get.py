@@ -0,0 +1,74 @@
+import unittest
+from base import VecTest
+from ndb.client import ResponseError
+
+
+class CreateAddGet(VecTest):
+  async def test_create(self):
+    await self.vectors.create('v', 3)
+    self.assertTrue(await self.vectors.exist('v'))
+    self.assertFalse(await self.vectors.exist('w'))
+    self.assertEqual(await self.vectors.length('v'), 0)
+
+
+  async def test_create_duplicate(self):
+    await self.vectors.create('v', 3)
+    with self.assertRaises(ResponseError):
+      await self.vectors.create('v', 3)
+
+
+  async def test_create_invalid(self):
+    with self.assertRaises(ResponseError):
+      await self.vectors.create('v', 4097)
+
+    with self.assertRaises(ValueError):
+      await self.vectors.create('v', 3, quant='int4')
+
+
+  async def test_add_get(self):
+    await self.vectors.create('v', 3)
+    self.assertEqual(await self.vectors.add('v', [1.0, 2.0, 3.0]), 0)
+    self.assertEqual(await self.vectors.add('v', [[4.0, 5.0, 6.0], [-1.5, 0.0, 2.5]]), 1)
+
+    self.assertEqual(await self.vectors.length('v'), 3)
+    self.assertEqual(await self.vectors.get('v', 0), [1.0, 2.0, 3.0])
+    self.assertEqual(await self.vectors.get('v', 2), [-1.5, 0.0, 2.5])
+
+    with self.assertRaises(ResponseError):
+      await self.vectors.get('v', 3)
+
+
+  async def test_add_wrong_dimensions(self):
+    await self.vectors.create('v', 3)
+
+    # nothing is added if any vector is the wrong size
+    with self.assertRaises(ResponseError):
+      await self.vectors.add('v', [[1.0, 2.0, 3.0], [1.0, 2.0]])
+
+    self.assertEqual(await self.vectors.length('v'), 0)
+
+
+  async def test_add_int8(self):
+    await self.vectors.create('v', 4, quant='int8')
+    await self.vectors.add('v', [127.0, -63.5, 0.0, 1.0])
+
+    # stored as int8 codes with a scale of 1 (largest value / 127)
+    self.assertEqual(await self.vectors.get('v', 0), [127.0, -64.0, 0.0, 1.0])
+
+
+  async def test_clear_delete(self):
+    await self.vectors.create('v', 2)
+    await self.vectors.add('v', [[1.0, 2.0], [3.0, 4.0]])
+    await self.vectors.clear('v')
+    self.assertEqual(await self.vectors.length('v'), 0)
+    self.assertEqual(await self.vectors.add('v', [5.0, 6.0]), 0)
+
+    await self.vectors.delete('v')
+    self.assertFalse(await self.vectors.exist('v'))
+
+    with self.assertRaises(ResponseError):
+      await self.vectors.delete('v')
+
+
+if __name__ == "__main__":
+  unittest.main()
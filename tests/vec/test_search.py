@@ -0,0 +1,97 @@
+import math
+import random
+import unittest
+from base import VecTest
+from ndb.client import ResponseError
+
+
+def dot(a, b):
+  return sum(x * y for x, y in zip(a, b))
+
+
+def cosine(a, b):
+  return dot(a, b) / math.sqrt(dot(a, a) * dot(b, b))
+
+
+def l2(a, b):
+  return math.sqrt(sum((x - y) ** 2 for x, y in zip(a, b)))
+
+
+class Search(VecTest):
+  async def test_metrics(self):
+    vectors = [[1.0, 0.0], [0.0, 1.0], [3.0, 3.0], [-1.0, -1.0]]
+    await self.vectors.create('v', 2)
+    await self.vectors.add('v', vectors)
+
+    matches = await self.vectors.search('v', [2.0, 1.0], k=2, metric='dot')
+    self.assertEqual([id for id, _ in matches], [2, 0])
+    self.assertEqual(matches[0][1], 9.0)
+
+    matches = await self.vectors.search('v', [2.0, 1.0], k=4, metric='cosine')
+    self.assertEqual([id for id, _ in matches], [2, 0, 1, 3])
+    self.assertAlmostEqual(matches[0][1], cosine([2.0, 1.0], [3.0, 3.0]), places=5)
+
+    # l2 is the distance, ascending
+    matches = await self.vectors.search('v', [2.0, 1.0], k=2, metric='l2')
+    self.assertEqual([id for id, _ in matches], [0, 1])
+    self.assertAlmostEqual(matches[0][1], l2([2.0, 1.0], [1.0, 0.0]), places=5)
+
+
+  async def test_k_larger_than_collection(self):
+    await self.vectors.create('v', 2)
+    await self.vectors.add('v', [[1.0, 0.0], [0.0, 1.0]])
+    self.assertEqual(len(await self.vectors.search('v', [1.0, 1.0], k=10)), 2)
+
+
+  async def test_invalid(self):
+    await self.vectors.create('v', 2)
+
+    with self.assertRaises(ResponseError):
+      await self.vectors.search('v', [1.0, 1.0, 1.0])   # wrong dimensions
+
+    with self.assertRaises(ResponseError):
+      await self.vectors.search('w', [1.0, 1.0])        # not exist
+
+    with self.assertRaises(ResponseError):
+      await self.vectors.search('v', [1.0, 1.0], k=1025)
+
+
+  async def test_large(self):
+    # above the size searched on the event loop, so searched on the pool
+    rng = random.Random(1987)
+    dim = 512
+    vectors = [[rng.uniform(-1, 1) for _ in range(dim)] for _ in range(1100)]
+
+    await self.vectors.create('v', dim)
+    for i in range(0, len(vectors), 100):
+      await self.vectors.add('v', vectors[i:i+100])
+
+    query = vectors[700]
+    expected = sorted(range(len(vectors)), key=lambda i: -cosine(query, vectors[i]))[:10]
+    matches = await self.vectors.search('v', query, k=10)
+
+    self.assertEqual([id for id, _ in matches], expected)
+    self.assertAlmostEqual(matches[0][1], 1.0, places=5)
+
+    # the pool's search of a snapshot isn't affected by later adds
+    await self.vectors.add('v', query)
+    matches = await self.vectors.search('v', query, k=2)
+    self.assertEqual(sorted(id for id, _ in matches), [700, 1100])
+
+
+  async def test_int8(self):
+    rng = random.Random(7)
+    dim = 64
+    vectors = [[rng.uniform(-1, 1) for _ in range(dim)] for _ in range(200)]
+
+    await self.vectors.create('v', dim, quant='int8')
+    await self.vectors.add('v', vectors)
+
+    # quantization error is small enough that each vector is its own nearest
+    for id in (0, 57, 199):
+      matches = await self.vectors.search('v', vectors[id], k=1)
+      self.assertEqual(matches[0][0], id)
+
+
+if __name__ == "__main__":
+  unittest.main()